@@ -34,6 +34,11 @@ namespace UnrealBuildTool.Rules
 					"FoliageEdit",
                     "Foliage",
 					"HTTP",
+					"ImageWrapper",
+					"MeshDescription",
+					"StaticMeshDescription",
+					"MeshReductionInterface",
+					"MeshUtilitiesCommon",
 					"SQLiteCore",
 					"SQLiteSupport",
 
@@ -1,5 +1,6 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 #include "AssetImportDataHandler.h"
+#include "Utilities/ImportPolicy.h"
 
 TSharedPtr<FAssetDataHandler> FAssetDataHandler::AssetDataHandlerInst;
 
@@ -26,6 +27,11 @@ TSharedPtr<FAssetsData> FAssetDataHandler::GetAssetsData(const FString& AssetsIm
 	TArray<TSharedPtr<FJsonValue> > AssetsImportDataArray = ImportDataObject->GetArrayField(TEXT("Assets"));
 	for (TSharedPtr<FJsonValue> AssetDataObject : AssetsImportDataArray)
 	{
+		const TSharedPtr<FJsonObject>* ImportPolicyObject;
+		if (AssetDataObject->AsObject()->TryGetObjectField(TEXT("importPolicy"), ImportPolicyObject))
+		{
+			FImportPolicy::Get()->ApplyJson(*ImportPolicyObject);
+		}
 		TSharedPtr<FAssetTypeData> ParsedAssetData = GetAssetData(AssetDataObject->AsObject());
 		AssetsImportData->AllAssetsData.Add(ParsedAssetData);
 	}	
@@ -100,6 +106,8 @@ TSharedPtr<FAssetTypeData> FAssetDataHandler::GetAssetData(TSharedPtr<FJsonObjec
 	if (ParsedAssetData->AssetMetaInfo->Type == TEXT("3d"))
 	{
 		GetMulitpleMaterialIds(AssetDataObject->GetArrayField(TEXT("meta")), ParsedAssetData->AssetMetaInfo);
+		// Only used for generated LODs.
+		ParsedAssetData->PlantsLodScreenSizes = GetLodScreenSizes(AssetDataObject->GetArrayField(TEXT("meta")));
 	}
 
 	return ParsedAssetData;	
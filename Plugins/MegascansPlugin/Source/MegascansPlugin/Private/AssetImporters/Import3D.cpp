@@ -15,6 +15,8 @@
 #include "Runtime/Core/Public/Misc/MessageDialog.h"
 #include "Runtime/Core/Public/Internationalization/Text.h"
 #include "Engine/RendererSettings.h"
+#include "Utilities/ImportTrace.h"
+#include "Utilities/ImportPolicy.h"
 
 
 
@@ -38,10 +40,12 @@ void FImport3d::ImportAsset(TSharedPtr<FAssetTypeData> AssetImportData)
 
 	if (AssetImportData->MeshList.Num() == 0) return;
 
+	FImportTraceScope Trace(TEXT("Import3d"));
+	Trace.Arg(TEXT("name"), Asset3DParameters->BaseParams->AssetName).Arg(TEXT("lod"), AssetImportData->AssetMetaInfo->ActiveLOD);
+
 	if (AssetImportData->AssetMetaInfo->ActiveLOD == TEXT("high"))
 	{
-		EAppReturnType::Type ContinueImport = FMessageDialog::Open(EAppMsgType::OkCancel, FText(FText::FromString("You are about to import a high poly mesh. This may cause Unreal to stop responding. Press Ok to continue.")));
-		if (ContinueImport == EAppReturnType::Cancel) return;
+		if (!FImportPolicy::Get()->Confirm(EImportQuestion::HighPolyMesh, FText::FromString("You are about to import a high poly mesh. This may cause Unreal to stop responding. Press Ok to continue."))) return;
 	}
 
 	TArray<UMaterialInstanceConstant*> MaterialInstance;
@@ -119,6 +123,8 @@ void FImport3d::ImportMTS(TSharedPtr<FAssetTypeData> AssetImportData, TArray<UMa
 	}
 
 	if (MegascansSettings->bEnableLods && AssetImportData->LodList.Num() > 0) {
+		FImportTraceScope LodTrace(TEXT("ApplyLods"));
+		LodTrace.Arg(TEXT("lods"), static_cast<int64>(AssetImportData->LodList.Num()));
 		TArray<FString> LodPathList = ParseLodList(AssetImportData);
 		FString LodDestination = FPaths::Combine(Asset3DParameters->ParamsAssetType->MeshDestination, TEXT("Lods"));
 		int32 LodCounter = 1;
@@ -185,11 +191,15 @@ void FImport3d::ImportScatter(TSharedPtr<FAssetTypeData> AssetImportData, TArray
 			if (MaterialInstance[0] != nullptr)
 				ImportedMesh->SetMaterial(0, CastChecked<UMaterialInterface>(MaterialInstance[0]));
 
+			FImportTraceScope PostEditTrace(TEXT("PostEditChange"));
+			PostEditTrace.Arg(TEXT("asset"), ImportedMesh->GetName());
 			ImportedMesh->PostEditChange();
 		}
 	}
 
 	if (MegascansSettings->bEnableLods && AssetImportData->LodList.Num() > 0) {
+		FImportTraceScope LodTrace(TEXT("ApplyLods"));
+		LodTrace.Arg(TEXT("lods"), static_cast<int64>(AssetImportData->LodList.Num()));
 
 		TArray<FString> LodPathList = ParseLodList(AssetImportData);
 		FString LodDestination = FPaths::Combine(Asset3DParameters->ParamsAssetType->MeshDestination, TEXT("Lods"));
@@ -321,7 +331,8 @@ void FImport3d::ImportNormal(TSharedPtr<FAssetTypeData> AssetImportData, TArray<
 		if (FileExtension == TEXT("abc"))
 		{
 
-			MeshUtils->ApplyAbcLods(ImportedAsset, LodPathList, Asset3DParameters->ParamsAssetType->MeshDestination);
+			// The PostEditChange at the end builds the mesh once with the LODs.
+			MeshUtils->ApplyAbcLods(ImportedAsset, LodPathList, false);
 		}
 		else {
 
@@ -329,7 +340,7 @@ void FImport3d::ImportNormal(TSharedPtr<FAssetTypeData> AssetImportData, TArray<
 		}
 		//if (!AssetImportData->AssetMetaInfo->bIsModularWindow)
 		//{
-			MeshUtils->RemoveExtraMaterialSlot(ImportedAsset);
+			MeshUtils->RemoveExtraMaterialSlot(ImportedAsset, false);
 		//}
 
 		//else {
@@ -356,8 +367,42 @@ void FImport3d::ImportNormal(TSharedPtr<FAssetTypeData> AssetImportData, TArray<
 
 		//}
 	}
+	else if (MegascansSettings->bGenerateLods)
+	{
+		// A 3D asset is a single mesh, which the lodDistance metadata lists as variation 1. Payloads without it fall back
+		// to the variation with the most LODs, the lowest variation number on a tie, so the pick doesn't depend on map order.
+		TMap<FString, float> LodScreenSizes;
+		if (const TMap<FString, float>* FirstVariation = AssetImportData->PlantsLodScreenSizes.Find(TEXT("Var1")))
+		{
+			LodScreenSizes = *FirstVariation;
+		}
+		else
+		{
+			// Variation keys are "Var" and the variation number.
+			const TMap<FString, float>* Picked = nullptr;
+			int32 PickedNumber = 0;
+			for (const TPair<FString, TMap<FString, float>>& Variation : AssetImportData->PlantsLodScreenSizes)
+			{
+				const int32 VariationNumber = FCString::Atoi(*Variation.Key.RightChop(3));
+				if (Picked == nullptr || Variation.Value.Num() > Picked->Num() || (Variation.Value.Num() == Picked->Num() && VariationNumber < PickedNumber))
+				{
+					Picked = &Variation.Value;
+					PickedNumber = VariationNumber;
+				}
+			}
+			if (Picked != nullptr)
+			{
+				LodScreenSizes = *Picked;
+			}
+		}
+		MeshUtils->GenerateLods(ImportedAsset, MegascansSettings->GeneratedLodCount, LodScreenSizes);
+	}
 	ImportedAsset->MarkPackageDirty();
-	ImportedAsset->PostEditChange();
+	{
+		FImportTraceScope PostEditTrace(TEXT("PostEditChange"));
+		PostEditTrace.Arg(TEXT("asset"), ImportedAsset->GetName());
+		ImportedAsset->PostEditChange();
+	}
 	if (AssetImportData->AssetMetaInfo->bSavePackages)
 	{
 		AssetUtils::SavePackage(ImportedAsset);
@@ -14,6 +14,7 @@
 #include "Utilities/MiscUtils.h"
 #include "UI/MSSettings.h"
 #include "PerPlatformProperties.h"
+#include "Utilities/ImportTrace.h"
 
 TSharedPtr<FImportPlant> FImportPlant::ImportPlantInst;
 
@@ -34,6 +35,8 @@ void FImportPlant::ImportAsset(TSharedPtr<FAssetTypeData> AssetImportData)
 	const UMegascansSettings* MegascansSettings = GetDefault<UMegascansSettings>();
 	TSharedPtr<FAssetImportParams> AssetSetupParameters = FAssetImportParams::Get();
 	TSharedPtr<ImportParams3DPlantAsset> AssetPlantParameters = AssetSetupParameters->Get3DPlantParams(AssetImportData);	
+	FImportTraceScope Trace(TEXT("ImportPlant"));
+	Trace.Arg(TEXT("name"), AssetPlantParameters->BaseParams->AssetName).Arg(TEXT("variations"), static_cast<int64>(AssetImportData->MeshList.Num()));
 	PlantImportType ImportType = GetImportType(AssetImportData);
 	TMap<FString, FString> ImportedPlants = ImportPlants(AssetImportData, AssetPlantParameters);
 	FString LastLOD = "";
@@ -169,6 +172,8 @@ TMap<FString, FString> FImportPlant::ImportPlants(TSharedPtr<FAssetTypeData> Ass
 	
 	for (auto PlantVar : AssetImportData->MeshList)
 	{	
+		FImportTraceScope Trace(TEXT("ImportVariation"));
+		Trace.Arg(TEXT("name"), PlantVar->Name);
 
 		FString VariantPath = FMeshOps::Get()->ImportMesh(PlantVar->Path, AssetPlantParameters->ParamsAssetType->MeshDestination);
 		if (!UEditorAssetLibrary::DoesAssetExist(VariantPath)) continue;
@@ -203,7 +208,7 @@ TMap<FString, FString> FImportPlant::ImportPlants(TSharedPtr<FAssetTypeData> Ass
 
 			if (FileExtension == "abc")
 			{
-				FMeshOps::Get()->ApplyAbcLods(ImportedAsset, VarLodList, AssetPlantParameters->ParamsAssetType->MeshDestination);
+				FMeshOps::Get()->ApplyAbcLods(ImportedAsset, VarLodList);
 			}
 			else {
 
@@ -261,6 +266,8 @@ void FImportPlant::ApplyMaterial(PlantImportType ImportType, UMaterialInstanceCo
 			MeshSectionInfo.MaterialIndex = ImportedPlantMesh->StaticMaterials.Num() - 1;			
 			ImportedPlantMesh->GetSectionInfoMap().Set(ImportedPlantMesh->GetNumLODs() - 1, 0, MeshSectionInfo);
 			ImportedPlantMesh->Modify();
+			FImportTraceScope PostEditTrace(TEXT("PostEditChange"));
+			PostEditTrace.Arg(TEXT("asset"), ImportedPlantMesh->GetName());
 			ImportedPlantMesh->PostEditChange();
 			ImportedPlantMesh->MarkPackageDirty();
 
@@ -20,6 +20,8 @@
 #include "Editor.h"
 #include "PackageTools.h"
 #include "Utilities/MTSReader.h"
+#include "Utilities/ImportTrace.h"
+#include "Utilities/ImportMemory.h"
 TSharedPtr<FImportSurface> FImportSurface::ImportSurfaceInst;
 
 void FImportSurface::ImportAsset(TSharedPtr<FAssetTypeData> AssetImportData)
@@ -54,6 +56,8 @@ void FImportSurface::ImportAsset(TSharedPtr<FAssetTypeData> AssetImportData)
 
 UMaterialInstanceConstant* FImportSurface::ImportSurface(TSharedPtr<FAssetTypeData> AssetImportData, TSharedPtr<SurfaceParams> SurfaceImportParams)
 {
+	FImportTraceScope Trace(TEXT("ImportSurface"));
+	Trace.Arg(TEXT("name"), SurfaceImportParams->MaterialInstanceName);
 
 	// Create Material Instance
 	UMaterialInstanceConstant* MaterialInstance = CreateInstanceMaterial(AssetImportData,SurfaceImportParams);
@@ -77,9 +81,12 @@ UMaterialInstanceConstant* FImportSurface::ImportSurface(TSharedPtr<FAssetTypeDa
 
 
 	// Plug the imported textures into the Material Instance.
-	MInstanceApplyTextures(AllTextureMaps, MaterialInstance, SurfaceImportParams, AssetImportData);
-	if (SurfaceImportParams->bContainsPackedMaps) {
-		MInstanceApplyPackedMaps(PackedImportData, MaterialInstance,SurfaceImportParams, AssetImportData);
+	{
+		FImportTraceScope ApplyTrace(TEXT("ApplyTextures"));
+		MInstanceApplyTextures(AllTextureMaps, MaterialInstance, SurfaceImportParams, AssetImportData);
+		if (SurfaceImportParams->bContainsPackedMaps) {
+			MInstanceApplyPackedMaps(PackedImportData, MaterialInstance,SurfaceImportParams, AssetImportData);
+		}
 	}
 
 	//Force Save Material
@@ -115,6 +122,8 @@ TArray<TMap<FString, TextureData>> FImportSurface::ImportTextureMaps(TSharedPtr<
 
 		if (FilteredTextureTypes.Contains(TextureType)) continue;
 
+		FImportTraceScope Trace(TEXT("ImportTexture"));
+		Trace.Arg(TEXT("type"), TextureType).Arg(TEXT("resolution"), TextureMetaData->Resolution);
 		UAssetImportTask* TextureImportTask = CreateImportTask(TextureMetaData, SurfaceImportParams->TexturesDestination);
 		TextureData TextureImportData = ImportTexture(TextureImportTask);
 
@@ -152,7 +161,11 @@ TArray<TMap<FString, TextureData>> FImportSurface::ImportTextureMaps(TSharedPtr<
 		}
 		TextureImportData.TextureAsset->SetFlags(RF_Standalone);
 		TextureImportData.TextureAsset->MarkPackageDirty();
-		TextureImportData.TextureAsset->PostEditChange();
+		{
+			FImportTraceScope PostEditTrace(TEXT("PostEditChange"));
+			PostEditTrace.Arg(TEXT("asset"), TextureImportData.TextureAsset->GetName());
+			TextureImportData.TextureAsset->PostEditChange();
+		}
 		if (AssetImportData->AssetMetaInfo->bSavePackages)
 		{
 			AssetUtils::SavePackage(TextureImportData.TextureAsset);
@@ -171,7 +184,7 @@ UAssetImportTask* FImportSurface::CreateImportTask(TSharedPtr<FAssetTextureData>
 {
 	FString Filename;
 	Filename = FPaths::GetBaseFilename(TextureMetaData->NameOverride);
-	UAssetImportTask* TextureImportTask = NewObject<UAssetImportTask>();
+	UAssetImportTask* TextureImportTask = FImportMemory::Get()->AcquireImportTask();
 	TextureImportTask->bAutomated = true;
 	TextureImportTask->bSave = false;
 	TextureImportTask->Filename = TextureMetaData->Path;
@@ -215,6 +228,8 @@ TextureData FImportSurface::ImportTexture(UAssetImportTask* TextureImportTask)
 	IAssetTools& AssetTools = FModuleManager::GetModuleChecked<FAssetToolsModule>("AssetTools").Get();
 	ImportTasks.Add(TextureImportTask);
 
+	FImportTraceScope Trace(TEXT("ImportAssetTasks"));
+	Trace.FileArgs(TextureImportTask->Filename);
 	AssetTools.ImportAssetTasks(ImportTasks);
 	for (UAssetImportTask* ImpTask : ImportTasks)
 	{
@@ -253,6 +268,7 @@ TextureData FImportSurface::ImportTexture(UAssetImportTask* TextureImportTask)
 
 UMaterialInstanceConstant* FImportSurface::CreateInstanceMaterial(TSharedPtr<FAssetTypeData> AssetImportData, TSharedPtr<SurfaceParams> SurfaceImportParams)
 {
+	FImportTraceScope Trace(TEXT("CreateMaterialInstance"));
 	if (!UEditorAssetLibrary::DoesAssetExist(SurfaceImportParams->MasterMaterialPath)) return nullptr;
 	UMaterialInterface* MasterMaterial = CastChecked<UMaterialInterface>(LoadAsset(SurfaceImportParams->MasterMaterialPath));
 	IAssetTools& AssetTools = FModuleManager::GetModuleChecked<FAssetToolsModule>("AssetTools").Get();
@@ -416,6 +432,8 @@ TMap<FString, TSharedPtr<FAssetPackedTextures>> FImportSurface::ImportPackedMaps
 	TMap<FString, TSharedPtr<FAssetPackedTextures>> PackedImportedData;
 	for (TSharedPtr<FAssetPackedTextures> PackedData : AssetImportData->PackedTextures)
 	{
+		FImportTraceScope Trace(TEXT("ImportTexture"));
+		Trace.Arg(TEXT("type"), PackedData->PackedTextureData->Type).Arg(TEXT("resolution"), PackedData->PackedTextureData->Resolution);
 		UAssetImportTask* TextureImportTask = CreateImportTask(PackedData->PackedTextureData, TexturesDestination);
 		TextureData TextureImportData = ImportTexture(TextureImportTask);
 
@@ -15,10 +15,53 @@
 #include "Misc/Paths.h"
 #include "Utilities/MTSReader.h"
 #include "Utilities/MeshOp.h"
+#include "Utilities/ImportTrace.h"
+#include "Utilities/ImportPolicy.h"
+#include "Utilities/PackageSaveQueue.h"
+#include "Utilities/ImportMemory.h"
+#include "Utilities/ImportScheduler.h"
+#include "Utilities/AssetRegistryUpdate.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
 
 
 TSharedPtr<FAssetsImportController> FAssetsImportController::AssetsImportController;
 
+namespace
+{
+	// Parsing and building a mesh costs a lot more per MB of source than importing a texture.
+	const double MeshCostPerMB = 4.0;
+
+	// Every source file of an asset, and whether it is a mesh.
+	TArray<TPair<FString, bool>> GetSourceFiles(TSharedPtr<FAssetTypeData> AssetImportData)
+	{
+		TArray<TPair<FString, bool>> SourceFiles;
+		for (TSharedPtr<FAssetTextureData> TextureData : AssetImportData->TextureComponents) SourceFiles.Emplace(TextureData->Path, false);
+		for (TSharedPtr<FAssetPackedTextures> PackedData : AssetImportData->PackedTextures) SourceFiles.Emplace(PackedData->PackedTextureData->Path, false);
+		for (TSharedPtr<FAssetBillboardData> BillboardData : AssetImportData->BillboardTextures) SourceFiles.Emplace(BillboardData->Path, false);
+		for (TSharedPtr<FAssetMeshData> MeshData : AssetImportData->MeshList) SourceFiles.Emplace(MeshData->Path, true);
+		for (TSharedPtr<FAssetLodData> LodData : AssetImportData->LodList) SourceFiles.Emplace(LodData->Path, true);
+		return SourceFiles;
+	}
+
+	// Reads a source file once so the importer on the game thread finds it in the file cache.
+	void PrefetchSourceFile(const FString& Filename)
+	{
+		TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Filename));
+		if (!File) return;
+
+		TArray<uint8> Buffer;
+		Buffer.SetNumUninitialized(1024 * 1024);
+		int64 Remaining = File->Size();
+		while (Remaining > 0)
+		{
+			const int64 ChunkSize = FMath::Min<int64>(Remaining, Buffer.Num());
+			if (!File->Read(Buffer.GetData(), ChunkSize)) break;
+			Remaining -= ChunkSize;
+		}
+	}
+}
+
 
 // Get instance of the class
 TSharedPtr<FAssetsImportController> FAssetsImportController::Get()
@@ -37,13 +80,28 @@ void FAssetsImportController::DataReceived(const FString DataFromBridge)
 	
 	//UE_LOG(LogTemp, Error, TEXT("Data from Bridge :%s"), *DataFromBridge);
 	if (IsGarbageCollecting() || GIsSavingPackage) return;
+	FImportPolicy::Get()->Reset();
 	TArray<FDHIData> DHIAssetsData;
 	if (DHI::GetDHIJsonData(DataFromBridge, DHIAssetsData)) {
+		FImportTrace::Get()->BeginBatch(TEXT("DHI"));
+		FAssetRegistryUpdate::Get()->BeginBatch();
+		FString LastCharacterDestination;
 		for (FDHIData CharacterData : DHIAssetsData) {
-			DHI::CopyCharacter(CharacterData);	
+			FImportTraceScope Trace(TEXT("CopyCharacter"));
+			Trace.Arg(TEXT("name"), CharacterData.CharacterName);
+			const FString CharacterDestination = DHI::CopyCharacter(CharacterData);
+			if (!CharacterDestination.IsEmpty()) LastCharacterDestination = CharacterDestination;
 		}
+		FAssetRegistryUpdate::Get()->EndBatch();
+		// The content browser only shows the copied assets once the batch has scanned them.
+		if (!LastCharacterDestination.IsEmpty()) AssetUtils::FocusOnSelected(LastCharacterDestination);
+		FImportTrace::Get()->EndBatch();
+	}
+	else {
+		FImportTrace::Get()->BeginBatch(TEXT("Import"));
+		ImportAssets(DataFromBridge);
+		FImportTrace::Get()->EndBatch();
 	}
-	else ImportAssets(DataFromBridge);	
 }
 
 // Gets import preferences from a json file, parses the Bridge json and calls the appropriate import function based in asset type
@@ -51,113 +109,140 @@ void FAssetsImportController::ImportAssets(const FString& AssetsImportJson)
 {
 	
 	//---- Passing Json To Struct
-	FString JsonReceived = AssetsImportJson;
-	JsonReceived.RemoveFromStart("[");
-	JsonReceived.RemoveFromEnd("]");
-	FMTSHandler::Get()->GetMTSData(JsonReceived);
-
 	bool bSavePackages = false;
-	bool bSkipImportAll = false;
-	bool bImportAll = false;
-	bool bAllSkipOrImport = false;
-	bool bFbxSettingsChanged = false;
-	TSharedPtr<FAssetsData> AssetsImportData = FAssetDataHandler::Get()->GetAssetsData(AssetsImportJson);
+	TSharedPtr<FAssetsData> AssetsImportData;
+	{
+		FImportTraceScope Trace(TEXT("ParseJson"));
+		Trace.Arg(TEXT("bytes"), static_cast<int64>(AssetsImportJson.Len()));
+		FString JsonReceived = AssetsImportJson;
+		JsonReceived.RemoveFromStart("[");
+		JsonReceived.RemoveFromEnd("]");
+		FMTSHandler::Get()->GetMTSData(JsonReceived);
+		AssetsImportData = FAssetDataHandler::Get()->GetAssetsData(AssetsImportJson);
+		Trace.Arg(TEXT("assets"), static_cast<int64>(AssetsImportData->AllAssetsData.Num()));
+	}
 	
 	TSharedPtr<FMeshOps> MeshUtils = FMeshOps::Get();
 	MeshUtils->bCombineMeshes = false;
+	TSharedPtr<FImportPolicy> ImportPolicy = FImportPolicy::Get();
 
 	checkf(AssetsImportData->AllAssetsData.Num() > 0, TEXT("There was an error reading asset data."));	
-	const UMegascansSettings* MegascansSettings = GetDefault<UMegascansSettings>();
 	if (AssetsImportData->AllAssetsData.Num() > 10)
 	{
 		bSavePackages = true;
-		if (MegascansSettings->bBatchImportPrompt)
-		{			
-			EAppReturnType::Type ContinueImport = FMessageDialog::Open(EAppMsgType::OkCancel, FText(FText::FromString("You are about to download more than 10 assets. Press Ok to continue.")));
-			if (ContinueImport == EAppReturnType::Cancel) return;
-			
-		}
+		if (!ImportPolicy->Confirm(EImportQuestion::LargeBatch, FText::FromString("You are about to download more than 10 assets. Press Ok to continue."))) return;
 	}
+	TSharedPtr<FPackageSaveQueue> SaveQueue = FPackageSaveQueue::Get();
+	SaveQueue->BeginBatch(GetDefault<UMegascansSettings>()->SaveEveryNAssets);
+	TSharedPtr<FImportMemory> ImportMemory = FImportMemory::Get();
+	ImportMemory->BeginBatch();
 
-	TSharedPtr<FJsonObject> UIAnalytics = FAnalytics::Get()->GenerateAnalyticsJson();
-	FAnalytics::Get()->SendAnalytics(UIAnalytics);
+	{
+		FImportTraceScope Trace(TEXT("Analytics"));
+		TSharedPtr<FJsonObject> UIAnalytics = FAnalytics::Get()->GenerateAnalyticsJson();
+		FAnalytics::Get()->SendAnalytics(UIAnalytics);
+	}
 	
 
+	// While the game thread imports an asset, workers read the source files of the assets after it, biggest meshes
+	// first, and parse their Alembic LODs. Parsing waits for the import two assets back, so parsed LODs of at most
+	// two assets are held at a time. Factories, texture compression and mesh builds touch UObjects and stay in the
+	// game thread node of each asset.
+	const bool bParseAbcLods = GetDefault<UMegascansSettings>()->bEnableLods;
+	FImportScheduler Scheduler;
+	TArray<int32> ImportNodes;
 	for (TSharedPtr<FAssetTypeData> AssetImportData : AssetsImportData->AllAssetsData)
 	{
-		AssetImportData->AssetMetaInfo->bIsMTS = false;
-		AssetImportData->AssetMetaInfo->bIsUdim = false;
-
-		//AssetImportData->AssetMetaInfo->bSavePackages = bSavePackages;
-		AssetImportData->AssetMetaInfo->bSavePackages = false;
-		TSharedPtr<FAssetImportParams> AssetSetupParameters = FAssetImportParams::Get();
-		AssetRecord Record;
-		if (FAssetsDatabase::Get()->RecordExists(AssetImportData->AssetMetaInfo->Id, Record) && FPaths::DirectoryExists(FPaths::Combine(FPaths::ProjectContentDir(), Record.Path.Replace(TEXT("/Game"), TEXT("")))))
+		TSet<FString> AbcLods;
+		if (bParseAbcLods && AssetImportData->MeshList.Num() > 0 && FPaths::GetExtension(AssetImportData->MeshList[0]->Path) == TEXT("abc"))
 		{
-			if (bSkipImportAll)
-			{
-				continue;
-			}
-			if (!bAllSkipOrImport)
+			for (TSharedPtr<FAssetLodData> LodData : AssetImportData->LodList)
 			{
-				EAppReturnType::Type ReimportAssetDlg = FMessageDialog::Open(EAppMsgType::YesNoYesAllNoAll, FText(FText::FromString(FString::Printf(TEXT("The asset %s already exists at %s. Do you want to import this asset.?"), *AssetImportData->AssetMetaInfo->Name, *Record.Path))));
-				if (ReimportAssetDlg == EAppReturnType::No) {
-					continue;
-				}
-				if (ReimportAssetDlg == EAppReturnType::NoAll)
-				{
-					bSkipImportAll = true;
-					bAllSkipOrImport = true;
-					continue;
-				}
-				if (ReimportAssetDlg == EAppReturnType::YesAll)
-				{
-					bAllSkipOrImport = true;
-					bImportAll = true;
-				}
-			}
-
-
-		}
-		// Checks for MTS - UDIMS 
-		if (AssetImportData->MaterialList.Num() > 0) {
-			AssetImportData->AssetMetaInfo->bIsMTS = true;
-			if (AssetImportData->TextureSets[0]->bIsUdim) {
-				AssetImportData->AssetMetaInfo->bIsUdim = true;
+				if (FPaths::GetExtension(LodData->Path) == TEXT("abc")) AbcLods.Add(LodData->Path);
 			}
 		}
 
-		if (AssetImportData->AssetMetaInfo->Type == "3d")
+		TArray<int32> ImportDependencies;
+		double ImportCost = 1.0;
+		for (const TPair<FString, bool>& SourceFile : GetSourceFiles(AssetImportData))
 		{
-
-			if (AssetImportData->AssetMetaInfo->bIsMTS && !bFbxSettingsChanged && !AssetImportData->AssetMetaInfo->bIsModularWindow) {
-				EAppReturnType::Type CombineMesh = FMessageDialog::Open(EAppMsgType::YesNo, FText(FText::FromString("The asset you are trying to import contains multiple meshes.\nDo you want to import it as a single mesh?")));
-				if (CombineMesh == EAppReturnType::Yes) {
-					MeshUtils->bCombineMeshes = true;
-					bFbxSettingsChanged = true;
-				}
-				if (CombineMesh == EAppReturnType::No || CombineMesh == EAppReturnType::Cancel) {
-					//MeshUtils->SetFbxOptions();
-					bFbxSettingsChanged = true;
-				}
+			const double SourceMB = FMath::Max<int64>(IFileManager::Get().FileSize(*SourceFile.Key), 0) / (1024.0 * 1024.0);
+			const FString Filename = SourceFile.Key;
+			if (AbcLods.Contains(Filename))
+			{
+				const TArray<int32> ParseDependencies = ImportNodes.Num() >= 2 ? TArray<int32>{ ImportNodes.Last(1) } : TArray<int32>();
+				ImportDependencies.Add(Scheduler.AddNode(TEXT("ParseLod"), FPaths::GetCleanFilename(Filename), SourceMB * MeshCostPerMB, false, MeshUtils->PrepareAbcLod(Filename), ParseDependencies));
+				continue;
 			}
-
-			FImport3d::Get()->ImportAsset(AssetImportData);			
-		}
-		else if (AssetImportData->AssetMetaInfo->Type == "3dplant")
-		{
-			FImportPlant::Get()->ImportAsset(AssetImportData);
+			ImportCost += SourceFile.Value ? SourceMB * MeshCostPerMB : SourceMB;
+			ImportDependencies.Add(Scheduler.AddNode(TEXT("Prefetch"), FPaths::GetCleanFilename(Filename), SourceMB, false, [Filename]() { PrefetchSourceFile(Filename); }));
 		}
 
-		else if (AssetImportData->AssetMetaInfo->Type == "surface" || AssetImportData->AssetMetaInfo->Type == "atlas" || AssetImportData->AssetMetaInfo->Type == "brush")
-		{			
-			FImportSurface::Get()->ImportAsset(AssetImportData);
-		}
+		ImportNodes.Add(Scheduler.AddNode(TEXT("ImportAsset"), AssetImportData->AssetMetaInfo->Name, ImportCost, true, [this, AssetImportData, bSavePackages, AbcLods]()
+		{
+			ImportAsset(AssetImportData, bSavePackages);
+			// Applied LODs are already gone, this drops the ones the import didn't use.
+			FMeshOps::Get()->DropParsedAbcLods(AbcLods.Array());
+			FPackageSaveQueue::Get()->AssetImported();
+			FImportMemory::Get()->AssetImported();
+		}, ImportDependencies));
+	}
+	Scheduler.Run();
+	MeshUtils->ResetParsedAbcLods();
 
-	}	
+	SaveQueue->EndBatch();
+	ImportMemory->EndBatch();
 	AssetsImportData.Reset();	
 	FImport3d::Get().Reset();	
 	FImportPlant::Get().Reset();
 	FImportSurface::Get().Reset();
 	//FMTSHandler::Get()->MTSJson.materials.Reset();
-}
\ No newline at end of file
+}
+
+// Imports one asset of a batch, asking about already imported assets and combining meshes first.
+void FAssetsImportController::ImportAsset(TSharedPtr<FAssetTypeData> AssetImportData, bool bSavePackages)
+{
+	TSharedPtr<FImportPolicy> ImportPolicy = FImportPolicy::Get();
+	TSharedPtr<FMeshOps> MeshUtils = FMeshOps::Get();
+	FImportTraceScope AssetTrace(TEXT("ImportAsset"));
+	AssetTrace.Arg(TEXT("id"), AssetImportData->AssetMetaInfo->Id).Arg(TEXT("name"), AssetImportData->AssetMetaInfo->Name).Arg(TEXT("type"), AssetImportData->AssetMetaInfo->Type).Arg(TEXT("resolution"), AssetImportData->AssetMetaInfo->Resolution);
+	AssetImportData->AssetMetaInfo->bIsMTS = false;
+	AssetImportData->AssetMetaInfo->bIsUdim = false;
+
+	AssetImportData->AssetMetaInfo->bSavePackages = bSavePackages;
+	TSharedPtr<FAssetImportParams> AssetSetupParameters = FAssetImportParams::Get();
+	AssetRecord Record;
+	if (FAssetsDatabase::Get()->RecordExists(AssetImportData->AssetMetaInfo->Id, Record) && FPaths::DirectoryExists(FPaths::Combine(FPaths::ProjectContentDir(), Record.Path.Replace(TEXT("/Game"), TEXT("")))))
+	{
+		if (!ImportPolicy->Confirm(EImportQuestion::ReimportExisting, FText::FromString(FString::Printf(TEXT("The asset %s already exists at %s. Do you want to import this asset.?"), *AssetImportData->AssetMetaInfo->Name, *Record.Path))))
+		{
+			return;
+		}
+	}
+	// Checks for MTS - UDIMS 
+	if (AssetImportData->MaterialList.Num() > 0) {
+		AssetImportData->AssetMetaInfo->bIsMTS = true;
+		if (AssetImportData->TextureSets[0]->bIsUdim) {
+			AssetImportData->AssetMetaInfo->bIsUdim = true;
+		}
+	}
+
+	if (AssetImportData->AssetMetaInfo->Type == "3d")
+	{
+
+		if (AssetImportData->AssetMetaInfo->bIsMTS && !AssetImportData->AssetMetaInfo->bIsModularWindow) {
+			MeshUtils->bCombineMeshes = ImportPolicy->Confirm(EImportQuestion::CombineMeshes, FText::FromString("The asset you are trying to import contains multiple meshes.\nDo you want to import it as a single mesh?"));
+		}
+
+		FImport3d::Get()->ImportAsset(AssetImportData);			
+	}
+	else if (AssetImportData->AssetMetaInfo->Type == "3dplant")
+	{
+		FImportPlant::Get()->ImportAsset(AssetImportData);
+	}
+
+	else if (AssetImportData->AssetMetaInfo->Type == "surface" || AssetImportData->AssetMetaInfo->Type == "atlas" || AssetImportData->AssetMetaInfo->Type == "brush")
+	{			
+		FImportSurface::Get()->ImportAsset(AssetImportData);
+	}
+}
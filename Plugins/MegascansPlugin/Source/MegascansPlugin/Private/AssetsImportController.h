@@ -11,6 +11,7 @@ private:
 	FAssetsImportController() = default;
 	static TSharedPtr<FAssetsImportController> AssetsImportController;
 	void ImportAssets(const FString & AssetsImportJson);
+	void ImportAsset(TSharedPtr<struct FAssetTypeData> AssetImportData, bool bSavePackages);
 
 public:	
 	static TSharedPtr<FAssetsImportController> Get();
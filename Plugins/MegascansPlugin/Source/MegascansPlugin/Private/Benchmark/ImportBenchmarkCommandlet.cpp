@@ -0,0 +1,196 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#include "Benchmark/ImportBenchmarkCommandlet.h"
+#include "Benchmark/SyntheticPayload.h"
+#include "AssetsImportController.h"
+#include "AssetImportData.h"
+#include "UI/MSSettings.h"
+#include "Utilities/ImportTrace.h"
+#include "Utilities/ImportMemory.h"
+
+#include "EditorAssetLibrary.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Runtime/Engine/Classes/Engine/StaticMesh.h"
+#include "UnrealEd/Classes/Factories/FbxStaticMeshImportData.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+	FSyntheticPayloadOptions ParseBenchmarkOptions(const FString& Params)
+	{
+		FSyntheticPayloadOptions Options;
+		FParse::Value(*Params, TEXT("Surfaces="), Options.Surfaces);
+		FParse::Value(*Params, TEXT("Assets="), Options.Assets3d);
+		FParse::Value(*Params, TEXT("FbxAssets="), Options.FbxAssets3d);
+		FParse::Value(*Params, TEXT("Plants="), Options.Plants);
+		FParse::Value(*Params, TEXT("MTS="), Options.MTSAssets);
+		FParse::Value(*Params, TEXT("UDIM="), Options.UDIMAssets);
+		FParse::Value(*Params, TEXT("Resolution="), Options.Resolution);
+		FParse::Value(*Params, TEXT("Lods="), Options.Lods);
+		FParse::Value(*Params, TEXT("Variations="), Options.Variations);
+		FParse::Value(*Params, TEXT("Triangles="), Options.Triangles);
+		FParse::Value(*Params, TEXT("Seed="), Options.Seed);
+
+		Options.Resolution = FMath::Clamp(FMath::RoundUpToPowerOfTwo(FMath::Max(Options.Resolution, 64)), 64u, 8192u);
+		Options.Lods = FMath::Clamp(Options.Lods, 0, 7);
+		Options.Variations = FMath::Max(Options.Variations, 1);
+		Options.Triangles = FMath::Max(Options.Triangles, 64);
+		return Options;
+	}
+
+	double BenchmarkToMB(uint64 Bytes)
+	{
+		return Bytes / (1024.0 * 1024.0);
+	}
+
+	// OBJ meshes are imported rolled by 90 degrees and FBX meshes as they are. The import options are pooled across
+	// the batch, so a mesh with the other file type's rotation means they leaked from one file into the next.
+	int32 CountMisrotatedMeshes(const FString& DestinationPath, int32& OutMeshes)
+	{
+		int32 Misrotated = 0;
+		OutMeshes = 0;
+		for (const FString& AssetPath : UEditorAssetLibrary::ListAssets(DestinationPath, true))
+		{
+			UStaticMesh* Mesh = Cast<UStaticMesh>(UEditorAssetLibrary::LoadAsset(AssetPath));
+			UFbxStaticMeshImportData* ImportData = Mesh ? Cast<UFbxStaticMeshImportData>(Mesh->AssetImportData) : nullptr;
+			if (ImportData == nullptr) continue;
+
+			OutMeshes++;
+			const bool bObj = FPaths::GetExtension(ImportData->GetFirstFilename()).Equals(TEXT("obj"), ESearchCase::IgnoreCase);
+			const FRotator Expected = bObj ? FRotator(0, 0, 90) : FRotator::ZeroRotator;
+			if (!ImportData->ImportRotation.Equals(Expected))
+			{
+				UE_LOG(MSLiveLinkLog, Error, TEXT("%s was imported from %s with rotation %s, expected %s"), *AssetPath, *ImportData->GetFirstFilename(),
+					*ImportData->ImportRotation.ToString(), *Expected.ToString());
+				Misrotated++;
+			}
+		}
+		return Misrotated;
+	}
+
+	FAutoConsoleCommand BenchmarkCommand(
+		TEXT("Megascans.Benchmark"),
+		TEXT("Imports synthetic Megascans payloads and reports time, allocations and memory per stage. Takes the same arguments as the MegascansImportBenchmark commandlet, e.g. Megascans.Benchmark -Surfaces=8 -Runs=3"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			UMegascansImportBenchmarkCommandlet::RunBenchmark(FString::Join(Args, TEXT(" ")));
+		})
+	);
+}
+
+UMegascansImportBenchmarkCommandlet::UMegascansImportBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UMegascansImportBenchmarkCommandlet::Main(const FString& Params)
+{
+	return RunBenchmark(Params);
+}
+
+int32 UMegascansImportBenchmarkCommandlet::RunBenchmark(const FString& Params)
+{
+	const FSyntheticPayloadOptions BaseOptions = ParseBenchmarkOptions(Params);
+	int32 Runs = 1;
+	FParse::Value(*Params, TEXT("Runs="), Runs);
+	Runs = FMath::Max(Runs, 1);
+	const bool bKeep = FParse::Param(*Params, TEXT("Keep"));
+
+	// Every stage has to be traced, and the import policy answers every question so nothing waits for a click.
+	UMegascansSettings* MegascansSettings = GetMutableDefault<UMegascansSettings>();
+	TGuardValue<bool> TraceGuard(MegascansSettings->bTraceImports, true);
+	TGuardValue<bool> PromptGuard(MegascansSettings->bBatchImportPrompt, false);
+	TGuardValue<EMegascansImportAnswer> ReimportGuard(MegascansSettings->ReimportExistingAnswer, EMegascansImportAnswer::No);
+	TGuardValue<EMegascansImportAnswer> CombineGuard(MegascansSettings->CombineMeshesAnswer, FParse::Param(*Params, TEXT("CombineMeshes")) ? EMegascansImportAnswer::Yes : EMegascansImportAnswer::No);
+	TGuardValue<EMegascansImportAnswer> HighPolyGuard(MegascansSettings->HighPolyAnswer, EMegascansImportAnswer::Yes);
+	int32 MemoryBudgetMB = MegascansSettings->ImportMemoryBudgetMB;
+	FParse::Value(*Params, TEXT("MemoryBudgetMB="), MemoryBudgetMB);
+	TGuardValue<int32> MemoryBudgetGuard(MegascansSettings->ImportMemoryBudgetMB, MemoryBudgetMB);
+	FImportTrace::Get()->EnableMemoryTracking();
+
+	const FString BenchmarkName = FString::Printf(TEXT("Benchmark_%s"), *FDateTime::Now().ToString(TEXT("%Y%m%d_%H%M%S")));
+	const FString BenchmarkDirectory = FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir() / TEXT("MegascansBench"));
+
+	FString Csv = TEXT("Run,Stage,Count,TotalMs,SelfMs,MaxMs,MB,Allocations,PeakMB\n");
+	int32 Result = 0;
+
+	for (int32 Run = 1; Run <= Runs; Run++)
+	{
+		const FString RunId = FString::Printf(TEXT("%s_%d"), *BenchmarkName, Run);
+		const FString SourceDirectory = BenchmarkDirectory / RunId / TEXT("Source");
+		FString ExportPath = FPaths::ConvertRelativePathToFull(FPaths::ProjectContentDir() / TEXT("MegascansBench") / RunId);
+		FPaths::MakePlatformFilename(ExportPath);
+		const FString DestinationPath = FString::Printf(TEXT("/Game/MegascansBench/%s"), *RunId);
+
+		FSyntheticPayloadOptions Options = BaseOptions;
+		Options.Seed = BaseOptions.Seed + Run - 1;
+
+		const double GenerateStart = FPlatformTime::Seconds();
+		int64 SourceBytes = 0;
+		const FString Payload = SyntheticPayload::Generate(Options, SourceDirectory, ExportPath, SourceBytes);
+		UE_LOG(MSLiveLinkLog, Display, TEXT("Run %d/%d: generated %.1f MB of source files in %.2f s"), Run, Runs, BenchmarkToMB(SourceBytes), FPlatformTime::Seconds() - GenerateStart);
+
+		// Start each run from the same place so the memory numbers are comparable.
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+		const FPlatformMemoryStats StartStats = FPlatformMemory::GetStats();
+		const double ImportStart = FPlatformTime::Seconds();
+		FAssetsImportController::Get()->DataReceived(Payload);
+		const double WallMs = (FPlatformTime::Seconds() - ImportStart) * 1000.0;
+		const FPlatformMemoryStats EndStats = FPlatformMemory::GetStats();
+
+		const TArray<FImportStageSummary>& Summary = FImportTrace::Get()->GetLastSummary();
+		if (Summary.Num() == 0)
+		{
+			UE_LOG(MSLiveLinkLog, Error, TEXT("Run %d/%d: the import didn't produce a trace, check the log above for import errors"), Run, Runs);
+			Result = 1;
+		}
+
+		int64 TotalAllocations = 0;
+		for (const FImportStageSummary& Stage : Summary)
+		{
+			TotalAllocations += Stage.Allocations;
+			Csv += FString::Printf(TEXT("%d,%s,%d,%.3f,%.3f,%.3f,%.3f,%lld,%.1f\n"), Run, *Stage.Name, Stage.Count, Stage.TotalMs, Stage.SelfMs, Stage.MaxMs,
+				BenchmarkToMB(Stage.Bytes), Stage.Allocations, BenchmarkToMB(Stage.PeakUsedPhysical));
+		}
+		const uint64 BatchPeak = FImportMemory::Get()->GetPeakUsedPhysical();
+		Csv += FString::Printf(TEXT("%d,Batch,1,%.3f,%.3f,%.3f,%.3f,%lld,%.1f\n"), Run, WallMs, WallMs, WallMs, BenchmarkToMB(SourceBytes), TotalAllocations, BenchmarkToMB(BatchPeak));
+
+		UE_LOG(MSLiveLinkLog, Display, TEXT("Run %d/%d: imported in %.1f ms, %lld allocations, used memory %.1f MB -> %.1f MB, batch peak %.1f MB, %d garbage collections"), Run, Runs, WallMs, TotalAllocations,
+			BenchmarkToMB(StartStats.UsedPhysical), BenchmarkToMB(EndStats.UsedPhysical), BenchmarkToMB(BatchPeak), FImportMemory::Get()->GetCollections());
+
+		int32 Meshes = 0;
+		const int32 Misrotated = CountMisrotatedMeshes(DestinationPath, Meshes);
+		if (Misrotated > 0)
+		{
+			UE_LOG(MSLiveLinkLog, Error, TEXT("Run %d/%d: %d of %d static meshes were imported with the wrong rotation"), Run, Runs, Misrotated, Meshes);
+			Result = 1;
+		}
+
+		if (!bKeep)
+		{
+			UEditorAssetLibrary::DeleteDirectory(DestinationPath);
+			IFileManager::Get().DeleteDirectory(*(BenchmarkDirectory / RunId), false, true);
+		}
+	}
+
+	const FString CsvFilename = BenchmarkDirectory / BenchmarkName + TEXT(".csv");
+	if (FFileHelper::SaveStringToFile(Csv, *CsvFilename))
+	{
+		UE_LOG(MSLiveLinkLog, Display, TEXT("Benchmark results written to %s"), *CsvFilename);
+	}
+	else
+	{
+		UE_LOG(MSLiveLinkLog, Error, TEXT("Couldn't write benchmark results to %s"), *CsvFilename);
+		Result = 1;
+	}
+
+	return Result;
+}
@@ -0,0 +1,29 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ImportBenchmarkCommandlet.generated.h"
+
+/*
+* Imports synthetic Bridge payloads end to end and reports wall time, allocations and memory per import stage.
+*
+* UE4Editor-Cmd.exe <Project>.uproject -run=MegascansImportBenchmark [-Surfaces=4] [-Assets=4] [-FbxAssets=2] [-Plants=2] [-MTS=1] [-UDIM=1]
+*     [-Resolution=2048] [-Lods=4] [-Variations=3] [-Triangles=20000] [-Runs=1] [-Seed=1] [-CombineMeshes] [-MemoryBudgetMB=0] [-Keep]
+*
+* Results are logged and written to Saved/MegascansBench/<RunId>.csv. Imported assets and source files are
+* deleted after every run unless -Keep is given. -Assets imports 3D assets with OBJ meshes and -FbxAssets with FBX meshes,
+* the two alternate and every run fails if a static mesh ends up with the other file type's import rotation.
+* Megascans.Benchmark runs the same thing from the editor console.
+*/
+UCLASS()
+class UMegascansImportBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMegascansImportBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+	static int32 RunBenchmark(const FString& Params);
+};
@@ -0,0 +1,600 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#include "Benchmark/SyntheticPayload.h"
+#include "AssetImportData.h"
+
+#include "Async/ParallelFor.h"
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformAtomics.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+
+namespace
+{
+	enum class ESyntheticFileKind : uint8
+	{
+		Texture,
+		NormalMap,
+		Mesh,
+		FbxMesh,
+		Billboard
+	};
+
+	// A source file of the payload, written once all of the json is built.
+	struct FSyntheticFile
+	{
+		FString Filename;
+		ESyntheticFileKind Kind;
+		int32 Resolution;
+		int32 Triangles;
+		int32 Seed;
+		TArray<FString> Materials;
+	};
+
+	// Bridge names resolutions 1K, 2K... and uses the pixel size below that.
+	FString SyntheticResolutionName(int32 Resolution)
+	{
+		return (Resolution >= 1024) ? FString::Printf(TEXT("%dK"), Resolution / 1024) : FString::FromInt(Resolution);
+	}
+
+	uint32 SyntheticHash(uint32 X, uint32 Y, uint32 Seed)
+	{
+		uint32 Hash = X * 374761393u + Y * 668265263u + Seed * 2246822519u;
+		Hash = (Hash ^ (Hash >> 13)) * 1274126177u;
+		return Hash ^ (Hash >> 16);
+	}
+
+	// Low frequency shapes plus per pixel grain, so the JPGs end up close to the size of scanned maps.
+	bool WriteSyntheticTexture(const FSyntheticFile& File)
+	{
+		const int32 Size = File.Resolution;
+		TArray<uint8> Pixels;
+		Pixels.SetNumUninitialized(Size * Size * 4);
+		const float Frequency = 12.0f / Size;
+		for (int32 Y = 0; Y < Size; Y++)
+		{
+			uint8* Row = Pixels.GetData() + Y * Size * 4;
+			for (int32 X = 0; X < Size; X++)
+			{
+				const uint32 Hash = SyntheticHash(X, Y, File.Seed);
+				const float Shape = FMath::Sin(X * Frequency + File.Seed) * FMath::Cos(Y * Frequency * 1.3f);
+				const int32 Grain = static_cast<int32>(Hash & 63) - 32;
+				if (File.Kind == ESyntheticFileKind::NormalMap)
+				{
+					Row[X * 4 + 0] = static_cast<uint8>(FMath::Clamp(235 + Grain / 4, 0, 255));
+					Row[X * 4 + 1] = static_cast<uint8>(FMath::Clamp(128 + static_cast<int32>(Shape * 40.0f) + Grain, 0, 255));
+					Row[X * 4 + 2] = static_cast<uint8>(FMath::Clamp(128 + static_cast<int32>(Shape * 30.0f) + ((Hash >> 8) & 63) - 32, 0, 255));
+				}
+				else
+				{
+					const int32 Value = 128 + static_cast<int32>(Shape * 60.0f) + Grain;
+					Row[X * 4 + 0] = static_cast<uint8>(FMath::Clamp(Value - 20, 0, 255));
+					Row[X * 4 + 1] = static_cast<uint8>(FMath::Clamp(Value, 0, 255));
+					Row[X * 4 + 2] = static_cast<uint8>(FMath::Clamp(Value + 15 + static_cast<int32>((Hash >> 8) & 15), 0, 255));
+				}
+				Row[X * 4 + 3] = 255;
+			}
+		}
+
+		IImageWrapperModule& ImageWrapperModule = FModuleManager::GetModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+		TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::JPEG);
+		if (!ImageWrapper.IsValid() || !ImageWrapper->SetRaw(Pixels.GetData(), Pixels.Num(), Size, Size, ERGBFormat::BGRA, 8))
+		{
+			return false;
+		}
+		return FFileHelper::SaveArrayToFile(ImageWrapper->GetCompressed(90), *File.Filename);
+	}
+
+	// A noisy sphere split into bands from top to bottom, one band per material.
+	struct FSyntheticSphere
+	{
+		TArray<FVector> Positions;
+		TArray<FVector> Normals;
+		TArray<FVector2D> UVs;
+		// Three indices per triangle into all of the arrays above.
+		TArray<int32> Indices;
+		TArray<int32> TriangleMaterials;
+	};
+
+	void BuildSyntheticSphere(const FSyntheticFile& File, FSyntheticSphere& OutSphere)
+	{
+		const int32 Segments = FMath::Max(3, FMath::RoundToInt(FMath::Sqrt(static_cast<float>(File.Triangles))));
+		const int32 Rings = FMath::Max(2, File.Triangles / (2 * Segments));
+		const float Radius = 50.0f;
+
+		for (int32 Ring = 0; Ring <= Rings; Ring++)
+		{
+			const float Theta = PI * Ring / Rings;
+			for (int32 Segment = 0; Segment <= Segments; Segment++)
+			{
+				const float Phi = 2.0f * PI * Segment / Segments;
+				const FVector Normal(FMath::Sin(Theta) * FMath::Cos(Phi), FMath::Sin(Theta) * FMath::Sin(Phi), FMath::Cos(Theta));
+				const float Displacement = 1.0f + 0.08f * ((SyntheticHash(Ring, Segment % Segments, File.Seed) & 255) / 255.0f - 0.5f);
+				OutSphere.Positions.Add(Normal * Radius * Displacement);
+				OutSphere.Normals.Add(Normal);
+				OutSphere.UVs.Add(FVector2D(static_cast<float>(Segment) / Segments, 1.0f - static_cast<float>(Ring) / Rings));
+			}
+		}
+
+		const int32 Materials = FMath::Max(1, File.Materials.Num());
+		for (int32 Ring = 0; Ring < Rings; Ring++)
+		{
+			const int32 Material = Ring * Materials / Rings;
+			for (int32 Segment = 0; Segment < Segments; Segment++)
+			{
+				const int32 A = Ring * (Segments + 1) + Segment;
+				const int32 B = A + 1;
+				const int32 C = A + Segments + 1;
+				const int32 D = C + 1;
+				OutSphere.Indices.Append({ A, C, B, B, C, D });
+				OutSphere.TriangleMaterials.Append({ Material, Material });
+			}
+		}
+	}
+
+	FString SyntheticMaterialName(const FSyntheticFile& File, int32 Material)
+	{
+		return File.Materials.IsValidIndex(Material) ? File.Materials[Material] : FString(TEXT("Material"));
+	}
+
+	// One usemtl group per material.
+	bool WriteSyntheticMesh(const FSyntheticFile& File)
+	{
+		FSyntheticSphere Sphere;
+		BuildSyntheticSphere(File, Sphere);
+
+		FString Obj;
+		Obj.Reserve(Sphere.Positions.Num() * 96 + Sphere.Indices.Num() * 24);
+		Obj += TEXT("# Synthetic Megascans mesh\no SyntheticMesh\n");
+		for (int32 Vertex = 0; Vertex < Sphere.Positions.Num(); Vertex++)
+		{
+			const FVector& Position = Sphere.Positions[Vertex];
+			const FVector& Normal = Sphere.Normals[Vertex];
+			Obj += FString::Printf(TEXT("v %.4f %.4f %.4f\nvt %.5f %.5f\nvn %.4f %.4f %.4f\n"), Position.X, Position.Y, Position.Z, Sphere.UVs[Vertex].X, Sphere.UVs[Vertex].Y, Normal.X, Normal.Y, Normal.Z);
+		}
+		for (int32 Triangle = 0; Triangle < Sphere.TriangleMaterials.Num(); Triangle++)
+		{
+			const int32 Material = Sphere.TriangleMaterials[Triangle];
+			if (Triangle == 0 || Material != Sphere.TriangleMaterials[Triangle - 1])
+			{
+				Obj += TEXT("usemtl ") + SyntheticMaterialName(File, Material) + TEXT("\n");
+			}
+			// OBJ indices start at 1.
+			const int32 A = Sphere.Indices[Triangle * 3] + 1;
+			const int32 B = Sphere.Indices[Triangle * 3 + 1] + 1;
+			const int32 C = Sphere.Indices[Triangle * 3 + 2] + 1;
+			Obj += FString::Printf(TEXT("f %d/%d/%d %d/%d/%d %d/%d/%d\n"), A, A, A, B, B, B, C, C, C);
+		}
+		return FFileHelper::SaveStringToFile(Obj, *File.Filename);
+	}
+
+	// Appends an FBX ASCII array property, e.g. "Vertices: *3 { a: 0,0,0 }".
+	template <typename ValueType, typename FormatType>
+	void AppendSyntheticFbxArray(FString& Fbx, const TCHAR* Indent, const TCHAR* Name, const TArray<ValueType>& Values, FormatType Format)
+	{
+		Fbx += FString::Printf(TEXT("%s%s: *%d {\n%s\ta: "), Indent, Name, Values.Num(), Indent);
+		for (int32 Index = 0; Index < Values.Num(); Index++)
+		{
+			if (Index > 0) Fbx += TEXT(",");
+			Fbx += Format(Values[Index]);
+		}
+		Fbx += FString::Printf(TEXT("\n%s}\n"), Indent);
+	}
+
+	// The same sphere as an FBX 7.3 ASCII file, Z up like the Megascans FBX exports so it's imported without a rotation.
+	bool WriteSyntheticFbxMesh(const FSyntheticFile& File)
+	{
+		FSyntheticSphere Sphere;
+		BuildSyntheticSphere(File, Sphere);
+		const int32 Materials = FMath::Max(1, File.Materials.Num());
+
+		TArray<float> Coordinates;
+		TArray<float> NormalCoordinates;
+		TArray<float> UVCoordinates;
+		for (int32 Vertex = 0; Vertex < Sphere.Positions.Num(); Vertex++)
+		{
+			Coordinates.Append({ Sphere.Positions[Vertex].X, Sphere.Positions[Vertex].Y, Sphere.Positions[Vertex].Z });
+			NormalCoordinates.Append({ Sphere.Normals[Vertex].X, Sphere.Normals[Vertex].Y, Sphere.Normals[Vertex].Z });
+			UVCoordinates.Append({ Sphere.UVs[Vertex].X, Sphere.UVs[Vertex].Y });
+		}
+		// The last index of every polygon is stored as -(index + 1).
+		TArray<int32> PolygonVertexIndex = Sphere.Indices;
+		for (int32 Index = 2; Index < PolygonVertexIndex.Num(); Index += 3)
+		{
+			PolygonVertexIndex[Index] = -PolygonVertexIndex[Index] - 1;
+		}
+		const auto FormatFloat = [](float Value) { return FString::Printf(TEXT("%.5f"), Value); };
+		const auto FormatInt = [](int32 Value) { return FString::FromInt(Value); };
+
+		FString Fbx;
+		Fbx.Reserve(Sphere.Positions.Num() * 96 + Sphere.Indices.Num() * 16);
+		Fbx += TEXT("; FBX 7.3.0 project file\n");
+		Fbx += TEXT("FBXHeaderExtension:  {\n\tFBXHeaderVersion: 1003\n\tFBXVersion: 7300\n\tCreator: \"Synthetic Megascans mesh\"\n}\n");
+		Fbx += TEXT("GlobalSettings:  {\n\tVersion: 1000\n\tProperties70:  {\n");
+		Fbx += TEXT("\t\tP: \"UpAxis\", \"int\", \"Integer\", \"\",2\n\t\tP: \"UpAxisSign\", \"int\", \"Integer\", \"\",1\n");
+		Fbx += TEXT("\t\tP: \"FrontAxis\", \"int\", \"Integer\", \"\",1\n\t\tP: \"FrontAxisSign\", \"int\", \"Integer\", \"\",-1\n");
+		Fbx += TEXT("\t\tP: \"CoordAxis\", \"int\", \"Integer\", \"\",0\n\t\tP: \"CoordAxisSign\", \"int\", \"Integer\", \"\",1\n");
+		Fbx += TEXT("\t\tP: \"UnitScaleFactor\", \"double\", \"Number\", \"\",1\n\t}\n}\n");
+		Fbx += FString::Printf(TEXT("Definitions:  {\n\tVersion: 100\n\tCount: %d\n"), 3 + Materials);
+		Fbx += FString::Printf(TEXT("\tObjectType: \"GlobalSettings\" {\n\t\tCount: 1\n\t}\n\tObjectType: \"Model\" {\n\t\tCount: 1\n\t}\n\tObjectType: \"Geometry\" {\n\t\tCount: 1\n\t}\n\tObjectType: \"Material\" {\n\t\tCount: %d\n\t}\n}\n"), Materials);
+
+		Fbx += TEXT("Objects:  {\n\tGeometry: 1000, \"Geometry::SyntheticMesh\", \"Mesh\" {\n");
+		AppendSyntheticFbxArray(Fbx, TEXT("\t\t"), TEXT("Vertices"), Coordinates, FormatFloat);
+		AppendSyntheticFbxArray(Fbx, TEXT("\t\t"), TEXT("PolygonVertexIndex"), PolygonVertexIndex, FormatInt);
+		Fbx += TEXT("\t\tGeometryVersion: 124\n");
+		Fbx += TEXT("\t\tLayerElementNormal: 0 {\n\t\t\tVersion: 101\n\t\t\tName: \"\"\n\t\t\tMappingInformationType: \"ByVertice\"\n\t\t\tReferenceInformationType: \"Direct\"\n");
+		AppendSyntheticFbxArray(Fbx, TEXT("\t\t\t"), TEXT("Normals"), NormalCoordinates, FormatFloat);
+		Fbx += TEXT("\t\t}\n\t\tLayerElementUV: 0 {\n\t\t\tVersion: 101\n\t\t\tName: \"UVMap\"\n\t\t\tMappingInformationType: \"ByVertice\"\n\t\t\tReferenceInformationType: \"Direct\"\n");
+		AppendSyntheticFbxArray(Fbx, TEXT("\t\t\t"), TEXT("UV"), UVCoordinates, FormatFloat);
+		Fbx += TEXT("\t\t}\n\t\tLayerElementMaterial: 0 {\n\t\t\tVersion: 101\n\t\t\tName: \"\"\n\t\t\tMappingInformationType: \"ByPolygon\"\n\t\t\tReferenceInformationType: \"IndexToDirect\"\n");
+		AppendSyntheticFbxArray(Fbx, TEXT("\t\t\t"), TEXT("Materials"), Sphere.TriangleMaterials, FormatInt);
+		Fbx += TEXT("\t\t}\n\t\tLayer: 0 {\n\t\t\tVersion: 100\n");
+		for (const TCHAR* LayerElement : { TEXT("LayerElementNormal"), TEXT("LayerElementUV"), TEXT("LayerElementMaterial") })
+		{
+			Fbx += FString::Printf(TEXT("\t\t\tLayerElement:  {\n\t\t\t\tType: \"%s\"\n\t\t\t\tTypedIndex: 0\n\t\t\t}\n"), LayerElement);
+		}
+		Fbx += TEXT("\t\t}\n\t}\n");
+		Fbx += TEXT("\tModel: 2000, \"Model::SyntheticMesh\", \"Mesh\" {\n\t\tVersion: 232\n\t\tShading: T\n\t\tCulling: \"CullingOff\"\n\t}\n");
+		for (int32 Material = 0; Material < Materials; Material++)
+		{
+			Fbx += FString::Printf(TEXT("\tMaterial: %d, \"Material::%s\", \"\" {\n\t\tVersion: 102\n\t\tShadingModel: \"phong\"\n\t\tMultiLayer: 0\n\t}\n"), 3000 + Material, *SyntheticMaterialName(File, Material));
+		}
+		Fbx += TEXT("}\n");
+
+		// Materials are connected to the model in slot order.
+		Fbx += TEXT("Connections:  {\n\tC: \"OO\",2000,0\n\tC: \"OO\",1000,2000\n");
+		for (int32 Material = 0; Material < Materials; Material++)
+		{
+			Fbx += FString::Printf(TEXT("\tC: \"OO\",%d,2000\n"), 3000 + Material);
+		}
+		Fbx += TEXT("}\n");
+		return FFileHelper::SaveStringToFile(Fbx, *File.Filename);
+	}
+
+	// Two crossed quads, what plant billboard LODs look like.
+	bool WriteSyntheticBillboard(const FSyntheticFile& File)
+	{
+		FString Obj = TEXT("# Synthetic Megascans billboard\no SyntheticBillboard\n");
+		Obj += TEXT("v -50 0 0\nv 50 0 0\nv 50 0 100\nv -50 0 100\nv 0 -50 0\nv 0 50 0\nv 0 50 100\nv 0 -50 100\n");
+		Obj += TEXT("vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\nvn 0 -1 0\nvn 1 0 0\n");
+		Obj += TEXT("usemtl ") + (File.Materials.Num() > 0 ? File.Materials[0] : FString(TEXT("Billboard"))) + TEXT("\n");
+		Obj += TEXT("f 1/1/1 2/2/1 3/3/1\nf 1/1/1 3/3/1 4/4/1\nf 5/1/2 6/2/2 7/3/2\nf 5/1/2 7/3/2 8/4/2\n");
+		return FFileHelper::SaveStringToFile(Obj, *File.Filename);
+	}
+
+	TArray<TSharedPtr<FJsonValue>> MakeSyntheticStrings(const TArray<FString>& Strings)
+	{
+		TArray<TSharedPtr<FJsonValue>> Values;
+		for (const FString& String : Strings)
+		{
+			Values.Add(MakeShared<FJsonValueString>(String));
+		}
+		return Values;
+	}
+
+	// Builds the payload and the list of files it points to.
+	class FSyntheticPayloadBuilder
+	{
+	public:
+		FSyntheticPayloadBuilder(const FSyntheticPayloadOptions& InOptions, const FString& InSourceDirectory, const FString& InExportPath)
+			: Options(InOptions)
+			, SourceDirectory(InSourceDirectory)
+			, ExportPath(InExportPath)
+			, Resolution(SyntheticResolutionName(InOptions.Resolution))
+			, NextSeed(InOptions.Seed)
+		{
+		}
+
+		TArray<TSharedPtr<FJsonValue>> Assets;
+		TArray<FSyntheticFile> Files;
+
+		void AddSurface(int32 Index)
+		{
+			TSharedRef<FJsonObject> Asset = MakeAsset(TEXT("surface"), FString::Printf(TEXT("Synthetic Surface %02d"), Index));
+			AddTextures(Asset, GetDirectory(Asset), { TEXT("albedo"), TEXT("ao"), TEXT("displacement"), TEXT("normal"), TEXT("roughness"), TEXT("specular") }, TEXT(""), {});
+			Assets.Add(MakeShared<FJsonValueObject>(Asset));
+		}
+
+		void Add3d(int32 Index, bool bFbx = false)
+		{
+			TSharedRef<FJsonObject> Asset = MakeAsset(TEXT("3d"), FString::Printf(bFbx ? TEXT("Synthetic Fbx Rock %02d") : TEXT("Synthetic Rock %02d"), Index));
+			const FString Directory = GetDirectory(Asset);
+			AddTextures(Asset, Directory, { TEXT("albedo"), TEXT("ao"), TEXT("displacement"), TEXT("normal"), TEXT("roughness"), TEXT("specular") }, TEXT(""), {});
+			AddMeshes(Asset, Directory, Asset->GetStringField(TEXT("id")), { Asset->GetStringField(TEXT("id")) + TEXT("_Material") }, false, bFbx);
+			Assets.Add(MakeShared<FJsonValueObject>(Asset));
+		}
+
+		// Multiple texture sets, one material each. With bUdim the sets are the 1001 and 1002 tiles of one material.
+		void AddMultiTextureSet(int32 Index, bool bUdim)
+		{
+			const FString Kind = bUdim ? TEXT("Udim") : TEXT("Multiset");
+			TSharedRef<FJsonObject> Asset = MakeAsset(TEXT("3d"), FString::Printf(TEXT("Synthetic %s %02d"), *Kind, Index));
+			const FString Directory = GetDirectory(Asset);
+			const FString Id = Asset->GetStringField(TEXT("id"));
+			const TArray<FString> TextureSets = { TEXT("SetA"), TEXT("SetB") };
+			const TArray<FString> MapTypes = { TEXT("albedo"), TEXT("normal"), TEXT("roughness"), TEXT("ao") };
+
+			TArray<TSharedPtr<FJsonValue>> TextureSetValues;
+			TArray<TSharedPtr<FJsonValue>> MaterialValues;
+			TArray<FString> MaterialNames;
+			for (int32 SetIndex = 0; SetIndex < TextureSets.Num(); SetIndex++)
+			{
+				TSharedRef<FJsonObject> TextureSet = MakeShared<FJsonObject>();
+				TextureSet->SetStringField(TEXT("textureSetName"), TextureSets[SetIndex]);
+				TextureSet->SetStringField(TEXT("udimTile"), bUdim ? FString::FromInt(1001 + SetIndex) : FString());
+				TextureSetValues.Add(MakeShared<FJsonValueObject>(TextureSet));
+
+				if (bUdim && SetIndex > 0) continue;
+				const FString MaterialName = bUdim ? Id + TEXT("_Udim") : Id + TEXT("_") + TextureSets[SetIndex];
+				TSharedRef<FJsonObject> Material = MakeShared<FJsonObject>();
+				Material->SetStringField(TEXT("opacityType"), TEXT("Opaque"));
+				Material->SetStringField(TEXT("materialName"), MaterialName);
+				Material->SetStringField(TEXT("materialId"), FString::FromInt(SetIndex + 1));
+				Material->SetArrayField(TEXT("textureSets"), MakeSyntheticStrings(bUdim ? TextureSets : TArray<FString>{ TextureSets[SetIndex] }));
+				MaterialValues.Add(MakeShared<FJsonValueObject>(Material));
+				MaterialNames.Add(MaterialName);
+			}
+			Asset->SetArrayField(TEXT("textureSets"), TextureSetValues);
+			Asset->SetArrayField(TEXT("materials"), MaterialValues);
+
+			if (bUdim)
+			{
+				AddTextures(Asset, Directory, MapTypes, TEXT(""), TextureSets, true);
+			}
+			else
+			{
+				for (const FString& TextureSet : TextureSets)
+				{
+					AddTextures(Asset, Directory, MapTypes, TextureSet, { TextureSet });
+				}
+			}
+			AddMeshes(Asset, Directory, Id, MaterialNames, false);
+			Assets.Add(MakeShared<FJsonValueObject>(Asset));
+		}
+
+		void AddPlant(int32 Index)
+		{
+			TSharedRef<FJsonObject> Asset = MakeAsset(TEXT("3dplant"), FString::Printf(TEXT("Synthetic Plant %02d"), Index));
+			const FString Directory = GetDirectory(Asset);
+			AddTextures(Asset, Directory, { TEXT("albedo"), TEXT("normal"), TEXT("opacity"), TEXT("roughness"), TEXT("specular"), TEXT("translucency") }, TEXT(""), {});
+
+			TArray<TSharedPtr<FJsonValue>> ScreenSizes;
+			for (int32 Variation = 1; Variation <= Options.Variations; Variation++)
+			{
+				AddMeshes(Asset, Directory, FString::Printf(TEXT("Var%d"), Variation), { TEXT("Plant") }, true);
+
+				TArray<TSharedPtr<FJsonValue>> Distances;
+				for (int32 Lod = 0; Lod <= Options.Lods; Lod++)
+				{
+					TSharedRef<FJsonObject> Distance = MakeShared<FJsonObject>();
+					Distance->SetNumberField(TEXT("lod"), Lod);
+					Distance->SetNumberField(TEXT("lodDistance"), FMath::Pow(0.5f, Lod));
+					Distances.Add(MakeShared<FJsonValueObject>(Distance));
+				}
+				TSharedRef<FJsonObject> VariationSizes = MakeShared<FJsonObject>();
+				VariationSizes->SetNumberField(TEXT("variation"), Variation);
+				VariationSizes->SetArrayField(TEXT("distance"), Distances);
+				ScreenSizes.Add(MakeShared<FJsonValueObject>(VariationSizes));
+			}
+
+			TArray<TSharedPtr<FJsonValue>> Billboards;
+			for (const FString& Type : { FString(TEXT("albedo")), FString(TEXT("normal")), FString(TEXT("opacity")), FString(TEXT("translucency")) })
+			{
+				const FString TypeName = Type.Left(1).ToUpper() + Type.Mid(1);
+				const FString Filename = FPaths::Combine(Directory, TEXT("Textures"), TEXT("Billboard"), FString::Printf(TEXT("Billboard_%s_%s.jpg"), *Resolution, *TypeName));
+				AddFile(Filename, (Type == TEXT("normal")) ? ESyntheticFileKind::NormalMap : ESyntheticFileKind::Texture);
+				TSharedRef<FJsonObject> Billboard = MakeShared<FJsonObject>();
+				Billboard->SetStringField(TEXT("path"), Filename);
+				Billboard->SetStringField(TEXT("type"), Type);
+				Billboards.Add(MakeShared<FJsonValueObject>(Billboard));
+			}
+			Asset->SetArrayField(TEXT("components-billboard"), Billboards);
+
+			TSharedRef<FJsonObject> LodDistance = MakeShared<FJsonObject>();
+			LodDistance->SetStringField(TEXT("key"), TEXT("lodDistance"));
+			LodDistance->SetStringField(TEXT("name"), TEXT("Lod Distance"));
+			LodDistance->SetArrayField(TEXT("value"), ScreenSizes);
+			TSharedRef<FJsonObject> UseBillboard = MakeShared<FJsonObject>();
+			UseBillboard->SetStringField(TEXT("key"), TEXT("useBillboardMaterial"));
+			UseBillboard->SetStringField(TEXT("name"), TEXT("Use Billboard Material"));
+			UseBillboard->SetBoolField(TEXT("value"), false);
+			TArray<TSharedPtr<FJsonValue>> Meta;
+			Meta.Add(MakeShared<FJsonValueObject>(LodDistance));
+			Meta.Add(MakeShared<FJsonValueObject>(UseBillboard));
+			Asset->SetArrayField(TEXT("meta"), Meta);
+
+			Assets.Add(MakeShared<FJsonValueObject>(Asset));
+		}
+
+	private:
+		const FSyntheticPayloadOptions& Options;
+		FString SourceDirectory;
+		FString ExportPath;
+		FString Resolution;
+		int32 NextSeed;
+
+		TSharedRef<FJsonObject> MakeAsset(const FString& Type, const FString& Name)
+		{
+			const FString Id = TEXT("syn") + FGuid::NewGuid().ToString(EGuidFormats::Digits).Left(8).ToLower();
+			const FString Directory = FPaths::Combine(SourceDirectory, Type, Id);
+
+			TSharedRef<FJsonObject> Asset = MakeShared<FJsonObject>();
+			Asset->SetStringField(TEXT("category"), Type);
+			Asset->SetStringField(TEXT("type"), Type);
+			Asset->SetStringField(TEXT("id"), Id);
+			Asset->SetStringField(TEXT("name"), Name);
+			Asset->SetStringField(TEXT("path"), Directory);
+			Asset->SetStringField(TEXT("textureFormat"), TEXT("jpg"));
+			Asset->SetStringField(TEXT("meshFormat"), TEXT("obj"));
+			Asset->SetStringField(TEXT("activeLOD"), TEXT("lod0"));
+			Asset->SetStringField(TEXT("minLOD"), TEXT(""));
+			Asset->SetStringField(TEXT("exportPath"), ExportPath);
+			Asset->SetStringField(TEXT("namingConvention"), TEXT(""));
+			Asset->SetStringField(TEXT("folderNamingConvention"), TEXT(""));
+			Asset->SetStringField(TEXT("resolution"), Resolution);
+			Asset->SetBoolField(TEXT("isModularAsset"), false);
+			Asset->SetArrayField(TEXT("tags"), MakeSyntheticStrings({ TEXT("synthetic") }));
+			Asset->SetArrayField(TEXT("categories"), MakeSyntheticStrings({ Type }));
+			for (const TCHAR* Field : { TEXT("components"), TEXT("textureSets"), TEXT("meshList"), TEXT("materials"), TEXT("lodList"), TEXT("packedTextures"), TEXT("meta") })
+			{
+				Asset->SetArrayField(Field, TArray<TSharedPtr<FJsonValue>>());
+			}
+			return Asset;
+		}
+
+		static FString GetDirectory(const TSharedRef<FJsonObject>& Asset)
+		{
+			return Asset->GetStringField(TEXT("path"));
+		}
+
+		void AddFile(const FString& Filename, ESyntheticFileKind Kind, int32 Triangles = 0, const TArray<FString>& Materials = TArray<FString>())
+		{
+			FSyntheticFile& File = Files.AddDefaulted_GetRef();
+			File.Filename = Filename;
+			File.Kind = Kind;
+			File.Resolution = Options.Resolution;
+			File.Triangles = Triangles;
+			File.Seed = NextSeed++;
+			File.Materials = Materials;
+		}
+
+		void AddTextures(const TSharedRef<FJsonObject>& Asset, const FString& Directory, const TArray<FString>& MapTypes, const FString& TextureSet, const TArray<FString>& TextureSets, bool bUdim = false)
+		{
+			TArray<TSharedPtr<FJsonValue>> Components = Asset->GetArrayField(TEXT("components"));
+			const FString Id = Asset->GetStringField(TEXT("id"));
+			for (const FString& Type : MapTypes)
+			{
+				const FString TypeName = Type.Left(1).ToUpper() + Type.Mid(1);
+				const FString BaseName = TextureSet.IsEmpty() ? FString::Printf(TEXT("%s_%s_%s"), *Id, *Resolution, *TypeName) : FString::Printf(TEXT("%s_%s_%s_%s"), *Id, *TextureSet, *Resolution, *TypeName);
+				const FString Filename = FPaths::Combine(Directory, TEXT("Textures"), BaseName + (bUdim ? TEXT(".1001.jpg") : TEXT(".jpg")));
+				const ESyntheticFileKind Kind = (Type == TEXT("normal")) ? ESyntheticFileKind::NormalMap : ESyntheticFileKind::Texture;
+				AddFile(Filename, Kind);
+				if (bUdim)
+				{
+					AddFile(FPaths::Combine(Directory, TEXT("Textures"), BaseName + TEXT(".1002.jpg")), Kind);
+				}
+
+				TSharedRef<FJsonObject> Component = MakeShared<FJsonObject>();
+				Component->SetStringField(TEXT("format"), TEXT("jpg"));
+				Component->SetStringField(TEXT("type"), Type);
+				Component->SetStringField(TEXT("resolution"), Resolution);
+				Component->SetStringField(TEXT("name"), FPaths::GetCleanFilename(Filename));
+				Component->SetStringField(TEXT("nameOverride"), FPaths::GetCleanFilename(Filename));
+				Component->SetStringField(TEXT("path"), Filename);
+				Component->SetStringField(TEXT("uvChannel"), TEXT("0"));
+				Component->SetArrayField(TEXT("textureSets"), MakeSyntheticStrings(TextureSets));
+				Components.Add(MakeShared<FJsonValueObject>(Component));
+			}
+			Asset->SetArrayField(TEXT("components"), Components);
+		}
+
+		// LOD0 goes to the mesh list, the rest to the LOD list. Plants end with a billboard LOD like the scanned ones.
+		void AddMeshes(const TSharedRef<FJsonObject>& Asset, const FString& Directory, const FString& Prefix, const TArray<FString>& Materials, bool bBillboardLod, bool bFbx = false)
+		{
+			const FString Format = bFbx ? TEXT("fbx") : TEXT("obj");
+			if (bFbx)
+			{
+				Asset->SetStringField(TEXT("meshFormat"), Format);
+			}
+			TArray<TSharedPtr<FJsonValue>> MeshList = Asset->GetArrayField(TEXT("meshList"));
+			TArray<TSharedPtr<FJsonValue>> LodList = Asset->GetArrayField(TEXT("lodList"));
+			for (int32 Lod = 0; Lod <= Options.Lods; Lod++)
+			{
+				const FString Name = FString::Printf(TEXT("%s_LOD%d"), *Prefix, Lod);
+				const FString Filename = FPaths::Combine(Directory, Name + TEXT(".") + Format);
+				const bool bBillboard = bBillboardLod && Lod == Options.Lods && Lod > 0;
+				const ESyntheticFileKind Kind = bBillboard ? ESyntheticFileKind::Billboard : (bFbx ? ESyntheticFileKind::FbxMesh : ESyntheticFileKind::Mesh);
+				AddFile(Filename, Kind, FMath::Max(Options.Triangles >> Lod, 8), Materials);
+
+				TSharedRef<FJsonObject> Mesh = MakeShared<FJsonObject>();
+				Mesh->SetStringField(TEXT("format"), Format);
+				Mesh->SetStringField(TEXT("type"), TEXT("lod"));
+				Mesh->SetStringField(TEXT("name"), FPaths::GetCleanFilename(Filename));
+				Mesh->SetStringField(TEXT("nameOverride"), FPaths::GetCleanFilename(Filename));
+				Mesh->SetStringField(TEXT("path"), Filename);
+				if (Lod == 0)
+				{
+					Mesh->SetStringField(TEXT("resolution"), TEXT(""));
+					MeshList.Add(MakeShared<FJsonValueObject>(Mesh));
+				}
+				else
+				{
+					Mesh->SetStringField(TEXT("lod"), FString::Printf(TEXT("lod%d"), Lod));
+					Mesh->SetStringField(TEXT("lodObjectName"), Name);
+					LodList.Add(MakeShared<FJsonValueObject>(Mesh));
+				}
+			}
+			Asset->SetArrayField(TEXT("meshList"), MeshList);
+			Asset->SetArrayField(TEXT("lodList"), LodList);
+		}
+	};
+}
+
+FString SyntheticPayload::Generate(const FSyntheticPayloadOptions& Options, const FString& SourceDirectory, const FString& ExportPath, int64& OutSourceBytes)
+{
+	FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+	FSyntheticPayloadBuilder Builder(Options, SourceDirectory, ExportPath);
+	for (int32 Index = 1; Index <= Options.Surfaces; Index++) Builder.AddSurface(Index);
+	// OBJ and FBX assets alternate so the pooled import options see both kinds of files one after the other.
+	for (int32 Index = 1; Index <= FMath::Max(Options.Assets3d, Options.FbxAssets3d); Index++)
+	{
+		if (Index <= Options.Assets3d) Builder.Add3d(Index);
+		if (Index <= Options.FbxAssets3d) Builder.Add3d(Index, true);
+	}
+	for (int32 Index = 1; Index <= Options.Plants; Index++) Builder.AddPlant(Index);
+	for (int32 Index = 1; Index <= Options.MTSAssets; Index++) Builder.AddMultiTextureSet(Index, false);
+	for (int32 Index = 1; Index <= Options.UDIMAssets; Index++) Builder.AddMultiTextureSet(Index, true);
+
+	for (const FSyntheticFile& File : Builder.Files)
+	{
+		IFileManager::Get().MakeDirectory(*FPaths::GetPath(File.Filename), true);
+	}
+
+	volatile int64 SourceBytes = 0;
+	volatile int32 Failures = 0;
+	ParallelFor(Builder.Files.Num(), [&Builder, &SourceBytes, &Failures](int32 FileIndex)
+	{
+		const FSyntheticFile& File = Builder.Files[FileIndex];
+		bool bWritten = false;
+		switch (File.Kind)
+		{
+		case ESyntheticFileKind::Texture:
+		case ESyntheticFileKind::NormalMap:
+			bWritten = WriteSyntheticTexture(File);
+			break;
+		case ESyntheticFileKind::Mesh:
+			bWritten = WriteSyntheticMesh(File);
+			break;
+		case ESyntheticFileKind::Billboard:
+			bWritten = WriteSyntheticBillboard(File);
+			break;
+		}
+		if (bWritten)
+		{
+			FPlatformAtomics::InterlockedAdd(&SourceBytes, IFileManager::Get().FileSize(*File.Filename));
+		}
+		else
+		{
+			FPlatformAtomics::InterlockedIncrement(&Failures);
+		}
+	});
+	if (Failures > 0)
+	{
+		UE_LOG(MSLiveLinkLog, Error, TEXT("Couldn't write %d of the %d synthetic source files under %s"), Failures, Builder.Files.Num(), *SourceDirectory);
+	}
+	OutSourceBytes = SourceBytes;
+
+	FString Payload;
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Payload);
+	FJsonSerializer::Serialize(Builder.Assets, Writer);
+	return Payload;
+}
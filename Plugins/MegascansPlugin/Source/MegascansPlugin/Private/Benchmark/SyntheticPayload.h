@@ -0,0 +1,29 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+
+
+// What a synthetic Bridge export contains. Textures are noisy JPGs so they compress to realistic sizes,
+// meshes are displaced spheres written as OBJ, or as FBX for FbxAssets3d, every LOD halves the triangle count of the one before.
+struct FSyntheticPayloadOptions
+{
+	int32 Surfaces = 4;
+	int32 Assets3d = 4;
+	int32 FbxAssets3d = 2;
+	int32 Plants = 2;
+	int32 MTSAssets = 1;
+	int32 UDIMAssets = 1;
+	int32 Resolution = 2048;
+	int32 Lods = 4;
+	int32 Variations = 3;
+	int32 Triangles = 20000;
+	int32 Seed = 1;
+};
+
+namespace SyntheticPayload
+{
+	// Writes the source files under SourceDirectory and returns the Bridge json for them. Assets are exported to
+	// ExportPath, which has to be inside the project Content folder. Asset ids are unique per call so the
+	// already exists check never triggers.
+	FString Generate(const FSyntheticPayloadOptions& Options, const FString& SourceDirectory, const FString& ExportPath, int64& OutSourceBytes);
+}
@@ -4,7 +4,8 @@
 
 
 UMegascansSettings::UMegascansSettings(const FObjectInitializer& ObjectInitializer)
-	: Super(ObjectInitializer) , bCreateFoliage(true), bEnableLods(true), bBatchImportPrompt(false), bEnableDisplacement(false), bApplyToSelection(false)
+	: Super(ObjectInitializer) , bCreateFoliage(true), bEnableLods(true), bGenerateLods(false), GeneratedLodCount(3), bBatchImportPrompt(false), bEnableDisplacement(false), bApplyToSelection(false), bTraceImports(true), SaveEveryNAssets(10), ImportMemoryBudgetMB(0),
+	ReimportExistingAnswer(EMegascansImportAnswer::Ask), CombineMeshesAnswer(EMegascansImportAnswer::Ask), HighPolyAnswer(EMegascansImportAnswer::Ask), OverwriteCharacterAnswer(EMegascansImportAnswer::Ask)
 
 {
 	
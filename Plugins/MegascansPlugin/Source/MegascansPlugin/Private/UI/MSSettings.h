@@ -10,6 +10,14 @@
 #include "MSSettings.generated.h"
 
 
+UENUM()
+enum class EMegascansImportAnswer : uint8
+{
+	Ask,
+	Yes,
+	No
+};
+
 UCLASS(Config = Editor)
 class UMegascansSettings
 	: public UObject
@@ -27,6 +35,14 @@ public:
 	UPROPERTY(Config, DisplayName = "Enable LOD Setup", EditAnywhere, Category = "MegascansSettings")
 		bool bEnableLods;
 
+	/** Generate a LOD chain for 3D assets that are imported without LODs. */
+	UPROPERTY(Config, DisplayName = "Generate Missing LODs", EditAnywhere, Category = "MegascansSettings")
+		bool bGenerateLods;
+
+	/** Number of LODs to generate after LOD0, each with half the triangles of the one before. */
+	UPROPERTY(Config, DisplayName = "Generated LOD Count", EditAnywhere, Category = "MegascansSettings", meta = (ClampMin = "1", ClampMax = "7", EditCondition = "bGenerateLods"))
+		int32 GeneratedLodCount;
+
 	/** Ask for confirmation when importing more than 10 assets. */
 	UPROPERTY(Config, DisplayName = "Prompt Before Batch Import", EditAnywhere, Category = "MegascansSettings")
 		bool bBatchImportPrompt;
@@ -42,6 +58,34 @@ public:
 	/** Only import textures that are supported by the selected Master Material for the asset type. */
 	UPROPERTY(Config, DisplayName = "Import Master Material Textures", EditAnywhere, Category = "MegascansSettings")
 		bool bFilterMasterMaterialMaps;
+
+	/** Write a Chrome trace of each import batch to Saved/MegascansTraces and log the time spent per stage. */
+	UPROPERTY(Config, DisplayName = "Trace Imports", EditAnywhere, Category = "MegascansSettings")
+		bool bTraceImports;
+
+	/** Save the assets of large batch imports after this many assets instead of only at the end of the batch. 0 saves once at the end. */
+	UPROPERTY(Config, DisplayName = "Save Batch Imports Every N Assets", EditAnywhere, Category = "MegascansSettings", meta = (ClampMin = "0"))
+		int32 SaveEveryNAssets;
+
+	/** Collect garbage between the assets of a batch import when the editor uses more memory than this, in MB. 0 turns it off. */
+	UPROPERTY(Config, DisplayName = "Import Memory Budget (MB)", EditAnywhere, Category = "MegascansSettings", meta = (ClampMin = "0"))
+		int32 ImportMemoryBudgetMB;
+
+	/** Import an asset again when it already exists in the project. Ask shows a dialog, which is answered with No in unattended imports. */
+	UPROPERTY(Config, DisplayName = "Reimport Existing Assets", EditAnywhere, Category = "UnattendedImport")
+		EMegascansImportAnswer ReimportExistingAnswer;
+
+	/** Import assets with multiple meshes as a single mesh. Ask shows a dialog, which is answered with No in unattended imports. */
+	UPROPERTY(Config, DisplayName = "Combine Meshes", EditAnywhere, Category = "UnattendedImport")
+		EMegascansImportAnswer CombineMeshesAnswer;
+
+	/** Import high poly meshes. Ask shows a warning first, which is answered with Yes in unattended imports. */
+	UPROPERTY(Config, DisplayName = "Import High Poly Meshes", EditAnywhere, Category = "UnattendedImport")
+		EMegascansImportAnswer HighPolyAnswer;
+
+	/** Overwrite a MetaHuman that already exists in the project. Ask shows a dialog, which is answered with No in unattended imports. */
+	UPROPERTY(Config, DisplayName = "Overwrite Existing MetaHumans", EditAnywhere, Category = "UnattendedImport")
+		EMegascansImportAnswer OverwriteCharacterAnswer;
 	
 	/** Flip Green Channel of Normal maps upon import. */
 	/*
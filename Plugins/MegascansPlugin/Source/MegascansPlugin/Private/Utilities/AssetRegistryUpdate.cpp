@@ -0,0 +1,82 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#include "Utilities/AssetRegistryUpdate.h"
+#include "AssetImportData.h"
+#include "Utilities/ImportTrace.h"
+
+#include "AssetRegistryModule.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+
+TSharedPtr<FAssetRegistryUpdate> FAssetRegistryUpdate::AssetRegistryUpdateInst;
+
+TSharedPtr<FAssetRegistryUpdate> FAssetRegistryUpdate::Get()
+{
+	if (!AssetRegistryUpdateInst.IsValid())
+	{
+		AssetRegistryUpdateInst = MakeShareable(new FAssetRegistryUpdate);
+	}
+	return AssetRegistryUpdateInst;
+}
+
+void FAssetRegistryUpdate::BeginBatch()
+{
+	if (BatchDepth++ > 0) return;
+	Scans = 0;
+	ScannedFiles = 0;
+	ScanMs = 0.0;
+}
+
+void FAssetRegistryUpdate::EndBatch()
+{
+	if (BatchDepth == 0 || --BatchDepth > 0) return;
+	Flush();
+	if (Scans > 0)
+	{
+		UE_LOG(MSLiveLinkLog, Display, TEXT("Asset registry: %d scans of %d files in %.1f ms"), Scans, ScannedFiles, ScanMs);
+	}
+}
+
+void FAssetRegistryUpdate::AddFiles(const TArray<FString>& Filenames)
+{
+	for (const FString& Filename : Filenames)
+	{
+		if (FPackageName::IsPackageExtension(*FPaths::GetExtension(Filename, true)))
+		{
+			Files.Add(FPaths::ConvertRelativePathToFull(Filename));
+		}
+	}
+	if (BatchDepth == 0) Flush();
+}
+
+void FAssetRegistryUpdate::AddPath(const FString& PackagePath)
+{
+	Paths.Add(PackagePath);
+	if (BatchDepth == 0) Flush();
+}
+
+// Files are force rescanned, an overwritten package may already be in the registry with its old contents.
+void FAssetRegistryUpdate::Flush()
+{
+	if (Files.Num() == 0 && Paths.Num() == 0) return;
+
+	FImportTraceScope Trace(TEXT("AssetRegistryScan"));
+	Trace.Arg(TEXT("files"), static_cast<int64>(Files.Num())).Arg(TEXT("paths"), static_cast<int64>(Paths.Num()));
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	if (Files.Num() > 0)
+	{
+		AssetRegistry.ScanFilesSynchronous(Files.Array(), true);
+	}
+	if (Paths.Num() > 0)
+	{
+		AssetRegistry.ScanPathsSynchronous(Paths.Array(), true);
+	}
+
+	Scans++;
+	ScannedFiles += Files.Num();
+	ScanMs += (FPlatformTime::Seconds() - StartSeconds) * 1000.0;
+	Files.Reset();
+	Paths.Reset();
+}
@@ -0,0 +1,37 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+
+
+// Tells the asset registry about files the plugin wrote. Written files are scanned one by one instead of rescanning
+// the folders they are in, and inside a batch everything added is scanned once, at the end of the batch or when a
+// caller needs to look the new assets up. Outside of a batch files and paths are scanned right away.
+class FAssetRegistryUpdate
+{
+private:
+	FAssetRegistryUpdate() = default;
+	static TSharedPtr<FAssetRegistryUpdate> AssetRegistryUpdateInst;
+
+	TSet<FString> Files;
+	TSet<FString> Paths;
+	int32 BatchDepth = 0;
+	int32 Scans = 0;
+	int32 ScannedFiles = 0;
+	double ScanMs = 0.0;
+
+public:
+	static TSharedPtr<FAssetRegistryUpdate> Get();
+
+	void BeginBatch();
+	void EndBatch();
+
+	// Filenames on disk, everything that isn't a package is ignored.
+	void AddFiles(const TArray<FString>& Filenames);
+	// A package path like /Game/MSPresets, scanned recursively. For folders the plugin didn't write file by file.
+	void AddPath(const FString& PackagePath);
+	void Flush();
+
+	// Totals of the current or last batch.
+	int32 GetScans() const { return Scans; }
+	double GetScanMs() const { return ScanMs; }
+};
@@ -0,0 +1,292 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#include "Utilities/FileCopyEngine.h"
+#include "AssetImportData.h"
+#include "Utilities/ImportTrace.h"
+
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+#include "HAL/PlatformAtomics.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopedSlowTask.h"
+#include "Misc/SecureHash.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Templates/UniquePtr.h"
+
+namespace
+{
+	const int64 FileCopyBufferSize = 8 * 1024 * 1024;
+
+	FString GetFileCopyRelativePath(const FString& Directory, const TCHAR* Filename)
+	{
+		FString RelativePath = Filename;
+		FPaths::NormalizeFilename(RelativePath);
+		RelativePath.RemoveFromStart(Directory / TEXT(""));
+		return RelativePath;
+	}
+
+	bool HashCopiedFile(IPlatformFile& PlatformFile, const FString& Path, TArray<uint8>& Buffer, FString& OutHash)
+	{
+		TUniquePtr<IFileHandle> Reader(PlatformFile.OpenRead(*Path));
+		if (!Reader) return false;
+
+		FMD5 Md5;
+		for (int64 Remaining = Reader->Size(); Remaining > 0;)
+		{
+			const int64 ChunkSize = FMath::Min<int64>(Remaining, Buffer.Num());
+			if (!Reader->Read(Buffer.GetData(), ChunkSize)) return false;
+			Md5.Update(Buffer.GetData(), ChunkSize);
+			Remaining -= ChunkSize;
+		}
+		FMD5Hash Hash;
+		Hash.Set(Md5);
+		OutHash = LexToString(Hash);
+		return true;
+	}
+
+	bool CopyAndHashFile(IPlatformFile& PlatformFile, const FFileCopyJob& Job, TArray<uint8>& Buffer, FString& OutHash, volatile int64* ProcessedBytes)
+	{
+		PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Job.DestinationPath));
+		TUniquePtr<IFileHandle> Reader(PlatformFile.OpenRead(*Job.SourcePath));
+		TUniquePtr<IFileHandle> Writer(PlatformFile.OpenWrite(*Job.DestinationPath));
+		if (!Reader || !Writer) return false;
+
+		FMD5 Md5;
+		for (int64 Remaining = Reader->Size(); Remaining > 0;)
+		{
+			const int64 ChunkSize = FMath::Min<int64>(Remaining, Buffer.Num());
+			if (!Reader->Read(Buffer.GetData(), ChunkSize) || !Writer->Write(Buffer.GetData(), ChunkSize))
+			{
+				Writer.Reset();
+				PlatformFile.DeleteFile(*Job.DestinationPath);
+				return false;
+			}
+			Md5.Update(Buffer.GetData(), ChunkSize);
+			Remaining -= ChunkSize;
+			FPlatformAtomics::InterlockedAdd(ProcessedBytes, ChunkSize);
+		}
+		FMD5Hash Hash;
+		Hash.Set(Md5);
+		OutHash = LexToString(Hash);
+		return Writer->Flush();
+	}
+
+	bool RunFileCopyJob(FFileCopyJob& Job, volatile int64* ProcessedBytes)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		TArray<uint8> Buffer;
+		Buffer.SetNumUninitialized(FMath::Clamp<int64>(Job.Size, 1, FileCopyBufferSize));
+
+		if (Job.bHashCompare)
+		{
+			FString DestinationHash;
+			if (HashCopiedFile(PlatformFile, Job.SourcePath, Buffer, Job.Hash) && HashCopiedFile(PlatformFile, Job.DestinationPath, Buffer, DestinationHash) && Job.Hash == DestinationHash)
+			{
+				FPlatformAtomics::InterlockedAdd(ProcessedBytes, Job.Size);
+				return true;
+			}
+			Job.bCopy = true;
+		}
+		return CopyAndHashFile(PlatformFile, Job, Buffer, Job.Hash, ProcessedBytes);
+	}
+}
+
+void FFileCopyEngine::AddDirectory(const FString& SourceDirectory, const FString& DestinationDirectory)
+{
+	FString Source = FPaths::ConvertRelativePathToFull(SourceDirectory);
+	FPaths::NormalizeDirectoryName(Source);
+	FString Destination = FPaths::ConvertRelativePathToFull(DestinationDirectory);
+	FPaths::NormalizeDirectoryName(Destination);
+
+	FString ManifestPath;
+	const TMap<FString, FFileCopyManifestEntry>& Manifest = LoadManifest(Destination, ManifestPath);
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TMap<FString, FFileStatData> DestinationFiles;
+	PlatformFile.IterateDirectoryStatRecursively(*Destination, [&Destination, &DestinationFiles](const TCHAR* Filename, const FFileStatData& StatData)
+	{
+		if (!StatData.bIsDirectory)
+		{
+			DestinationFiles.Add(GetFileCopyRelativePath(Destination, Filename), StatData);
+		}
+		return true;
+	});
+
+	PlatformFile.IterateDirectoryStatRecursively(*Source, [this, &Source, &Destination, &ManifestPath, &Manifest, &DestinationFiles](const TCHAR* Filename, const FFileStatData& StatData)
+	{
+		if (StatData.bIsDirectory) return true;
+
+		FFileCopyJob Job;
+		Job.RelativePath = GetFileCopyRelativePath(Source, Filename);
+		Job.SourcePath = Source / Job.RelativePath;
+		Job.DestinationPath = Destination / Job.RelativePath;
+		Job.ManifestPath = ManifestPath;
+		Job.Size = StatData.FileSize;
+		Job.SourceTimeStamp = StatData.ModificationTime;
+
+		const FFileStatData* DestinationStat = DestinationFiles.Find(Job.RelativePath);
+		const FFileCopyManifestEntry* Entry = Manifest.Find(Job.RelativePath);
+		if (DestinationStat == nullptr || DestinationStat->FileSize != StatData.FileSize)
+		{
+			Job.bCopy = true;
+		}
+		else if (Entry != nullptr && Entry->Size == StatData.FileSize && Entry->SourceTimeStamp == StatData.ModificationTime && Entry->DestinationTimeStamp == DestinationStat->ModificationTime)
+		{
+			SkippedFiles++;
+			return true;
+		}
+		else
+		{
+			Job.bHashCompare = true;
+		}
+		Jobs.Add(MoveTemp(Job));
+		return true;
+	});
+}
+
+bool FFileCopyEngine::Run(const FText& ProgressMessage)
+{
+	if (Jobs.Num() == 0)
+	{
+		UE_LOG(MSLiveLinkLog, Display, TEXT("All %d files are up to date, nothing to copy"), SkippedFiles);
+		return true;
+	}
+
+	FImportTraceScope Trace(TEXT("CopyFiles"));
+	Trace.Arg(TEXT("files"), static_cast<int64>(Jobs.Num()));
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	// Biggest files first so one large file doesn't start last and leave the other workers idle.
+	Jobs.Sort([](const FFileCopyJob& A, const FFileCopyJob& B) { return A.Size > B.Size; });
+	int64 TotalBytes = 0;
+	for (const FFileCopyJob& Job : Jobs)
+	{
+		TotalBytes += Job.Size;
+	}
+
+	TArray<bool> Succeeded;
+	Succeeded.Init(false, Jobs.Num());
+	volatile int64 ProcessedBytes = 0;
+	FScopedSlowTask Progress(static_cast<float>(TotalBytes), ProgressMessage, true);
+	Progress.MakeDialog();
+
+	// The copies run off the game thread so it can keep the progress dialog responsive.
+	TFuture<void> CopyTask = Async(EAsyncExecution::ThreadPool, [this, &Succeeded, &ProcessedBytes]()
+	{
+		ParallelFor(Jobs.Num(), [this, &Succeeded, &ProcessedBytes](int32 JobIndex)
+		{
+			Succeeded[JobIndex] = RunFileCopyJob(Jobs[JobIndex], &ProcessedBytes);
+		});
+	});
+	int64 ReportedBytes = 0;
+	while (!CopyTask.WaitFor(FTimespan::FromMilliseconds(50)))
+	{
+		const int64 Processed = FPlatformAtomics::AtomicRead(&ProcessedBytes);
+		Progress.EnterProgressFrame(static_cast<float>(Processed - ReportedBytes));
+		ReportedBytes = Processed;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	int32 Failures = 0;
+	int32 BatchCopiedFiles = 0;
+	int64 BatchCopiedBytes = 0;
+	for (int32 JobIndex = 0; JobIndex < Jobs.Num(); JobIndex++)
+	{
+		const FFileCopyJob& Job = Jobs[JobIndex];
+		if (!Succeeded[JobIndex])
+		{
+			UE_LOG(MSLiveLinkLog, Error, TEXT("Couldn't copy %s to %s"), *Job.SourcePath, *Job.DestinationPath);
+			Failures++;
+			continue;
+		}
+		if (Job.bCopy)
+		{
+			CopiedFiles.Add(Job.DestinationPath);
+			BatchCopiedFiles++;
+			BatchCopiedBytes += Job.Size;
+		}
+		else
+		{
+			SkippedFiles++;
+		}
+
+		FFileCopyManifestEntry& Entry = Manifests.FindChecked(Job.ManifestPath).FindOrAdd(Job.RelativePath);
+		Entry.Size = Job.Size;
+		Entry.SourceTimeStamp = Job.SourceTimeStamp;
+		Entry.DestinationTimeStamp = PlatformFile.GetTimeStamp(*Job.DestinationPath);
+		Entry.Hash = Job.Hash;
+	}
+	CopiedBytes += BatchCopiedBytes;
+	Jobs.Reset();
+	SaveManifests();
+
+	Trace.Arg(TEXT("bytes"), BatchCopiedBytes);
+	UE_LOG(MSLiveLinkLog, Display, TEXT("Copied %d files (%.1f MB) in %.1f ms, %d files were up to date"),
+		BatchCopiedFiles, BatchCopiedBytes / (1024.0 * 1024.0), (FPlatformTime::Seconds() - StartSeconds) * 1000.0, SkippedFiles);
+	return Failures == 0;
+}
+
+TMap<FString, FFileCopyManifestEntry>& FFileCopyEngine::LoadManifest(const FString& DestinationDirectory, FString& OutManifestPath)
+{
+	OutManifestPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MegascansCopyManifests"), FString::Printf(TEXT("%08X.json"), FCrc::StrCrc32(*DestinationDirectory.ToLower())));
+	if (TMap<FString, FFileCopyManifestEntry>* LoadedManifest = Manifests.Find(OutManifestPath))
+	{
+		return *LoadedManifest;
+	}
+
+	TMap<FString, FFileCopyManifestEntry>& Manifest = Manifests.Add(OutManifestPath);
+	FString ManifestJson;
+	if (!FFileHelper::LoadFileToString(ManifestJson, *OutManifestPath)) return Manifest;
+
+	TSharedPtr<FJsonObject> ManifestObject;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ManifestJson);
+	const TSharedPtr<FJsonObject>* FilesObject = nullptr;
+	if (!FJsonSerializer::Deserialize(Reader, ManifestObject) || !ManifestObject.IsValid() || !ManifestObject->TryGetObjectField(TEXT("files"), FilesObject)) return Manifest;
+
+	for (const TPair<FString, TSharedPtr<FJsonValue>>& File : (*FilesObject)->Values)
+	{
+		const TSharedPtr<FJsonObject> EntryObject = File.Value->AsObject();
+		if (!EntryObject.IsValid()) continue;
+
+		// Time stamps are stored as tick strings, a JSON number can't hold them exactly.
+		FFileCopyManifestEntry& Entry = Manifest.Add(File.Key);
+		Entry.Size = static_cast<int64>(EntryObject->GetNumberField(TEXT("size")));
+		Entry.SourceTimeStamp = FDateTime(FCString::Atoi64(*EntryObject->GetStringField(TEXT("sourceTime"))));
+		Entry.DestinationTimeStamp = FDateTime(FCString::Atoi64(*EntryObject->GetStringField(TEXT("destinationTime"))));
+		Entry.Hash = EntryObject->GetStringField(TEXT("md5"));
+	}
+	return Manifest;
+}
+
+void FFileCopyEngine::SaveManifests()
+{
+	for (const TPair<FString, TMap<FString, FFileCopyManifestEntry>>& Manifest : Manifests)
+	{
+		TSharedPtr<FJsonObject> FilesObject = MakeShareable(new FJsonObject);
+		for (const TPair<FString, FFileCopyManifestEntry>& File : Manifest.Value)
+		{
+			TSharedPtr<FJsonObject> EntryObject = MakeShareable(new FJsonObject);
+			EntryObject->SetNumberField(TEXT("size"), static_cast<double>(File.Value.Size));
+			EntryObject->SetStringField(TEXT("sourceTime"), LexToString(File.Value.SourceTimeStamp.GetTicks()));
+			EntryObject->SetStringField(TEXT("destinationTime"), LexToString(File.Value.DestinationTimeStamp.GetTicks()));
+			EntryObject->SetStringField(TEXT("md5"), File.Value.Hash);
+			FilesObject->SetObjectField(File.Key, EntryObject);
+		}
+		TSharedPtr<FJsonObject> ManifestObject = MakeShareable(new FJsonObject);
+		ManifestObject->SetObjectField(TEXT("files"), FilesObject);
+
+		FString ManifestJson;
+		TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&ManifestJson);
+		FJsonSerializer::Serialize(ManifestObject.ToSharedRef(), Writer);
+		if (!FFileHelper::SaveStringToFile(ManifestJson, *Manifest.Key))
+		{
+			UE_LOG(MSLiveLinkLog, Warning, TEXT("Couldn't write the copy manifest %s"), *Manifest.Key);
+		}
+	}
+}
@@ -0,0 +1,55 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+#include "Misc/DateTime.h"
+
+
+// What a file looked like when it was last copied, kept per destination directory in Saved/MegascansCopyManifests.
+struct FFileCopyManifestEntry
+{
+	int64 Size = 0;
+	FDateTime SourceTimeStamp;
+	FDateTime DestinationTimeStamp;
+	FString Hash;
+};
+
+struct FFileCopyJob
+{
+	FString SourcePath;
+	FString DestinationPath;
+	FString ManifestPath;
+	FString RelativePath;
+	int64 Size = 0;
+	FDateTime SourceTimeStamp;
+	bool bHashCompare = false;
+	bool bCopy = false;
+	FString Hash;
+};
+
+// Mirrors directory trees, copying only the files that are new or changed. A file is unchanged when its size and time
+// stamps still match the manifest of the last copy, or when it has the same size and MD5 as the destination file.
+// Copies run in parallel with large buffers and hash the data on the way, so the next run can skip them by time stamp.
+class FFileCopyEngine
+{
+public:
+	// Compares the tree under SourceDirectory with DestinationDirectory and queues every file that has to be copied.
+	void AddDirectory(const FString& SourceDirectory, const FString& DestinationDirectory);
+
+	// Copies the queued files under one progress dialog and updates the manifests. Returns false if a copy failed.
+	bool Run(const FText& ProgressMessage);
+
+	// Full destination paths of the files written by Run.
+	const TArray<FString>& GetCopiedFiles() const { return CopiedFiles; }
+	int32 GetSkippedFiles() const { return SkippedFiles; }
+	int64 GetCopiedBytes() const { return CopiedBytes; }
+
+private:
+	TMap<FString, FFileCopyManifestEntry>& LoadManifest(const FString& DestinationDirectory, FString& OutManifestPath);
+	void SaveManifests();
+
+	TArray<FFileCopyJob> Jobs;
+	TMap<FString, TMap<FString, FFileCopyManifestEntry>> Manifests;
+	TArray<FString> CopiedFiles;
+	int32 SkippedFiles = 0;
+	int64 CopiedBytes = 0;
+};
@@ -0,0 +1,181 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#include "Utilities/ImportMemory.h"
+#include "AssetImportData.h"
+#include "UI/MSSettings.h"
+#include "Utilities/ImportTrace.h"
+
+#include "AbcImportSettings.h"
+#include "AssetImportTask.h"
+#include "HAL/PlatformMemory.h"
+#include "UnrealEd/Classes/Factories/FbxImportUI.h"
+#include "UObject/UObjectGlobals.h"
+#include "UObject/UnrealType.h"
+
+namespace
+{
+	double ImportMemoryToMB(uint64 Bytes)
+	{
+		return Bytes / (1024.0 * 1024.0);
+	}
+
+	// Pooled options carry whatever the last file set on them. Copies the class defaults back over every property,
+	// instanced subobjects like the FBX static mesh import data are kept and reset the same way.
+	void ResetToClassDefaults(UObject* Object)
+	{
+		const UObject* Defaults = Object->GetClass()->GetDefaultObject();
+		for (TFieldIterator<FProperty> It(Object->GetClass()); It; ++It)
+		{
+			if (!It->HasAnyPropertyFlags(CPF_InstancedReference))
+			{
+				It->CopyCompleteValue_InContainer(Object, Defaults);
+			}
+			else if (const FObjectProperty* ObjectProperty = CastField<FObjectProperty>(*It))
+			{
+				if (UObject* Subobject = ObjectProperty->GetObjectPropertyValue_InContainer(Object))
+				{
+					ResetToClassDefaults(Subobject);
+				}
+			}
+		}
+	}
+}
+
+TSharedPtr<FImportMemory> FImportMemory::ImportMemoryInst;
+
+TSharedPtr<FImportMemory> FImportMemory::Get()
+{
+	if (!ImportMemoryInst.IsValid())
+	{
+		ImportMemoryInst = MakeShareable(new FImportMemory);
+	}
+	return ImportMemoryInst;
+}
+
+void FImportMemory::BeginBatch()
+{
+	if (BatchDepth++ > 0) return;
+
+	BudgetBytes = static_cast<uint64>(FMath::Max(GetDefault<UMegascansSettings>()->ImportMemoryBudgetMB, 0)) * 1024 * 1024;
+	StartUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	PeakUsedPhysical = StartUsedPhysical;
+	Collections = 0;
+}
+
+void FImportMemory::EndBatch()
+{
+	if (BatchDepth == 0 || --BatchDepth > 0) return;
+
+	SampleMemory();
+	ReleaseObjects();
+	UE_LOG(MSLiveLinkLog, Display, TEXT("Import memory: %.1f MB at the start of the batch, %.1f MB peak, %d garbage collections"),
+		ImportMemoryToMB(StartUsedPhysical), ImportMemoryToMB(PeakUsedPhysical), Collections);
+}
+
+UAssetImportTask* FImportMemory::AcquireImportTask()
+{
+	if (BatchDepth == 0) return NewObject<UAssetImportTask>();
+
+	if (ImportTasksInUse == ImportTasks.Num())
+	{
+		UAssetImportTask* ImportTask = NewObject<UAssetImportTask>();
+		ImportTask->AddToRoot();
+		ImportTasks.Add(ImportTask);
+	}
+
+	UAssetImportTask* ImportTask = ImportTasks[ImportTasksInUse++];
+	ImportTask->Filename.Reset();
+	ImportTask->DestinationPath.Reset();
+	ImportTask->DestinationName.Reset();
+	ImportTask->bReplaceExisting = false;
+	ImportTask->bAutomated = false;
+	ImportTask->bSave = false;
+	ImportTask->Factory = nullptr;
+	ImportTask->Options = nullptr;
+	ImportTask->ImportedObjectPaths.Reset();
+	return ImportTask;
+}
+
+UFbxImportUI* FImportMemory::GetFbxImportUI()
+{
+	if (BatchDepth == 0) return NewObject<UFbxImportUI>();
+
+	if (FbxImportUI == nullptr)
+	{
+		FbxImportUI = NewObject<UFbxImportUI>();
+		FbxImportUI->AddToRoot();
+	}
+	else
+	{
+		ResetToClassDefaults(FbxImportUI);
+	}
+	return FbxImportUI;
+}
+
+UAbcImportSettings* FImportMemory::GetAbcImportSettings()
+{
+	if (BatchDepth == 0) return NewObject<UAbcImportSettings>();
+
+	if (AbcImportSettings == nullptr)
+	{
+		AbcImportSettings = NewObject<UAbcImportSettings>();
+		AbcImportSettings->AddToRoot();
+	}
+	else
+	{
+		ResetToClassDefaults(AbcImportSettings);
+	}
+	return AbcImportSettings;
+}
+
+void FImportMemory::AssetImported()
+{
+	if (BatchDepth == 0) return;
+
+	// The tasks stay for the next asset, but the factories and options they point to can go.
+	for (int32 TaskIndex = 0; TaskIndex < ImportTasksInUse; TaskIndex++)
+	{
+		ImportTasks[TaskIndex]->Factory = nullptr;
+		ImportTasks[TaskIndex]->Options = nullptr;
+		ImportTasks[TaskIndex]->ImportedObjectPaths.Reset();
+	}
+	ImportTasksInUse = 0;
+
+	SampleMemory();
+	const uint64 UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	if (BudgetBytes == 0 || UsedPhysical < BudgetBytes || IsGarbageCollecting()) return;
+
+	// Reachability runs now, objects are purged in time slices so one pass doesn't stall the batch. Whatever is left
+	// gets purged by the next collection or the next editor tick.
+	FImportTraceScope Trace(TEXT("CollectGarbage"));
+	Trace.Arg(TEXT("usedMB"), static_cast<int64>(ImportMemoryToMB(UsedPhysical)));
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, false);
+	IncrementalPurgeGarbage(true, 0.05f);
+	Collections++;
+	Trace.Arg(TEXT("freedMB"), static_cast<int64>(ImportMemoryToMB(UsedPhysical - FMath::Min(UsedPhysical, FPlatformMemory::GetStats().UsedPhysical))));
+}
+
+void FImportMemory::SampleMemory()
+{
+	PeakUsedPhysical = FMath::Max<uint64>(PeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+}
+
+void FImportMemory::ReleaseObjects()
+{
+	for (UAssetImportTask* ImportTask : ImportTasks)
+	{
+		ImportTask->RemoveFromRoot();
+	}
+	ImportTasks.Reset();
+	ImportTasksInUse = 0;
+
+	if (FbxImportUI != nullptr)
+	{
+		FbxImportUI->RemoveFromRoot();
+		FbxImportUI = nullptr;
+	}
+	if (AbcImportSettings != nullptr)
+	{
+		AbcImportSettings->RemoveFromRoot();
+		AbcImportSettings = nullptr;
+	}
+}
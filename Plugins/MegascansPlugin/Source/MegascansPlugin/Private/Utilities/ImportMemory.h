@@ -0,0 +1,49 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+
+class UAssetImportTask;
+class UFbxImportUI;
+class UAbcImportSettings;
+
+// Keeps the memory of an import batch bounded. Import tasks and import options are created once per batch and
+// reused instead of leaving a new set of objects for the garbage collector after every file, the references of an
+// asset are dropped once it is imported, and garbage is collected between assets when the process goes over the
+// memory budget in UMegascansSettings. Outside of a batch every call returns a new object like before.
+class FImportMemory
+{
+private:
+	FImportMemory() = default;
+	static TSharedPtr<FImportMemory> ImportMemoryInst;
+
+	void SampleMemory();
+	void ReleaseObjects();
+
+	TArray<UAssetImportTask*> ImportTasks;
+	int32 ImportTasksInUse = 0;
+	UFbxImportUI* FbxImportUI = nullptr;
+	UAbcImportSettings* AbcImportSettings = nullptr;
+
+	int32 BatchDepth = 0;
+	uint64 BudgetBytes = 0;
+	uint64 StartUsedPhysical = 0;
+	uint64 PeakUsedPhysical = 0;
+	int32 Collections = 0;
+
+public:
+	static TSharedPtr<FImportMemory> Get();
+
+	void BeginBatch();
+	void EndBatch();
+
+	UAssetImportTask* AcquireImportTask();
+	UFbxImportUI* GetFbxImportUI();
+	UAbcImportSettings* GetAbcImportSettings();
+
+	// Call between assets, the objects handed out for the last asset must not be used anymore.
+	void AssetImported();
+
+	// Highest used physical memory sampled during the current or last batch.
+	uint64 GetPeakUsedPhysical() const { return PeakUsedPhysical; }
+	int32 GetCollections() const { return Collections; }
+};
@@ -0,0 +1,122 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#include "Utilities/ImportPolicy.h"
+#include "AssetImportData.h"
+#include "Utilities/ImportTrace.h"
+
+#include "Dom/JsonObject.h"
+#include "Misc/App.h"
+#include "Misc/MessageDialog.h"
+
+namespace
+{
+	struct FImportQuestionInfo
+	{
+		const TCHAR* JsonKey;
+		EAppMsgType::Type DialogType;
+		bool bRememberAnswer;
+		bool bUnattendedAnswer;
+	};
+
+	// Indexed by EImportQuestion. Unattended answers never delete or overwrite anything that is already in the project.
+	const FImportQuestionInfo ImportQuestions[] =
+	{
+		{ TEXT("largeBatch"), EAppMsgType::OkCancel, false, true },
+		{ TEXT("reimportExisting"), EAppMsgType::YesNoYesAllNoAll, false, false },
+		{ TEXT("combineMeshes"), EAppMsgType::YesNo, true, false },
+		{ TEXT("highPoly"), EAppMsgType::OkCancel, false, true },
+		{ TEXT("overwriteCharacter"), EAppMsgType::YesNo, false, false },
+	};
+	static_assert(UE_ARRAY_COUNT(ImportQuestions) == (int32)EImportQuestion::Count, "ImportQuestions has to match EImportQuestion");
+
+	bool ParseImportAnswer(const FString& Value, EMegascansImportAnswer& OutAnswer)
+	{
+		if (Value.Equals(TEXT("ask"), ESearchCase::IgnoreCase)) OutAnswer = EMegascansImportAnswer::Ask;
+		else if (Value.Equals(TEXT("yes"), ESearchCase::IgnoreCase)) OutAnswer = EMegascansImportAnswer::Yes;
+		else if (Value.Equals(TEXT("no"), ESearchCase::IgnoreCase)) OutAnswer = EMegascansImportAnswer::No;
+		else return false;
+		return true;
+	}
+}
+
+TSharedPtr<FImportPolicy> FImportPolicy::ImportPolicyInst;
+
+FImportPolicy::FImportPolicy()
+{
+	Reset();
+}
+
+TSharedPtr<FImportPolicy> FImportPolicy::Get()
+{
+	if (!ImportPolicyInst.IsValid())
+	{
+		ImportPolicyInst = MakeShareable(new FImportPolicy);
+	}
+	return ImportPolicyInst;
+}
+
+void FImportPolicy::Reset()
+{
+	const UMegascansSettings* MegascansSettings = GetDefault<UMegascansSettings>();
+	SetAnswer(EImportQuestion::LargeBatch, MegascansSettings->bBatchImportPrompt ? EMegascansImportAnswer::Ask : EMegascansImportAnswer::Yes);
+	SetAnswer(EImportQuestion::ReimportExisting, MegascansSettings->ReimportExistingAnswer);
+	SetAnswer(EImportQuestion::CombineMeshes, MegascansSettings->CombineMeshesAnswer);
+	SetAnswer(EImportQuestion::HighPolyMesh, MegascansSettings->HighPolyAnswer);
+	SetAnswer(EImportQuestion::OverwriteCharacter, MegascansSettings->OverwriteCharacterAnswer);
+}
+
+void FImportPolicy::ApplyJson(const TSharedPtr<FJsonObject>& PolicyObject)
+{
+	if (!PolicyObject.IsValid()) return;
+
+	for (int32 Question = 0; Question < (int32)EImportQuestion::Count; Question++)
+	{
+		FString Value;
+		if (!PolicyObject->TryGetStringField(ImportQuestions[Question].JsonKey, Value)) continue;
+
+		EMegascansImportAnswer Answer;
+		if (ParseImportAnswer(Value, Answer))
+		{
+			Answers[Question] = Answer;
+		}
+		else
+		{
+			UE_LOG(MSLiveLinkLog, Warning, TEXT("Ignoring import policy %s: %s, expected ask, yes or no"), ImportQuestions[Question].JsonKey, *Value);
+		}
+	}
+}
+
+bool FImportPolicy::Confirm(EImportQuestion Question, const FText& Message)
+{
+	const FImportQuestionInfo& Info = ImportQuestions[(int32)Question];
+	EMegascansImportAnswer& Answer = Answers[(int32)Question];
+
+	if (Answer != EMegascansImportAnswer::Ask)
+	{
+		return Answer == EMegascansImportAnswer::Yes;
+	}
+
+	if (IsUnattended())
+	{
+		UE_LOG(MSLiveLinkLog, Display, TEXT("Unattended import answered %s with %s: %s"), Info.JsonKey, Info.bUnattendedAnswer ? TEXT("yes") : TEXT("no"), *Message.ToString());
+		return Info.bUnattendedAnswer;
+	}
+
+	EAppReturnType::Type DialogResult;
+	{
+		FImportTraceScope Trace(TEXT("Dialog"));
+		Trace.Arg(TEXT("question"), FString(Info.JsonKey));
+		DialogResult = FMessageDialog::Open(Info.DialogType, Message);
+	}
+
+	const bool bYes = DialogResult == EAppReturnType::Yes || DialogResult == EAppReturnType::YesAll || DialogResult == EAppReturnType::Ok;
+	if (Info.bRememberAnswer || DialogResult == EAppReturnType::YesAll || DialogResult == EAppReturnType::NoAll)
+	{
+		Answer = bYes ? EMegascansImportAnswer::Yes : EMegascansImportAnswer::No;
+	}
+	return bYes;
+}
+
+bool FImportPolicy::IsUnattended()
+{
+	return GIsRunningUnattendedScript || FApp::IsUnattended() || IsRunningCommandlet();
+}
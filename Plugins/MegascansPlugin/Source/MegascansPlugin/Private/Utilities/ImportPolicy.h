@@ -0,0 +1,45 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+#include "UI/MSSettings.h"
+
+class FJsonObject;
+
+// Questions an import batch can run into.
+enum class EImportQuestion : uint8
+{
+	LargeBatch,
+	ReimportExisting,
+	CombineMeshes,
+	HighPolyMesh,
+	OverwriteCharacter,
+	Count
+};
+
+// Answers the questions of an import batch up front, so it can run without anyone at the editor.
+// Starts from UMegascansSettings at the beginning of every Bridge batch and can be overridden by an "importPolicy"
+// object in the payload, e.g. "importPolicy": {"reimportExisting": "no", "combineMeshes": "yes", "highPoly": "yes"}.
+// Questions left on Ask show the old dialog, or take a non destructive default when the editor runs unattended.
+class FImportPolicy
+{
+private:
+	FImportPolicy();
+	static TSharedPtr<FImportPolicy> ImportPolicyInst;
+
+	EMegascansImportAnswer Answers[(int32)EImportQuestion::Count];
+
+public:
+	static TSharedPtr<FImportPolicy> Get();
+
+	void Reset();
+	void ApplyJson(const TSharedPtr<FJsonObject>& PolicyObject);
+
+	void SetAnswer(EImportQuestion Question, EMegascansImportAnswer Answer) { Answers[(int32)Question] = Answer; }
+	EMegascansImportAnswer GetAnswer(EImportQuestion Question) const { return Answers[(int32)Question]; }
+
+	// True when the answer is Yes. Only shows Message when the question is still on Ask in an attended editor.
+	// Yes to All and No to All, and the combine meshes answer, hold for the rest of the batch.
+	bool Confirm(EImportQuestion Question, const FText& Message);
+
+	static bool IsUnattended();
+};
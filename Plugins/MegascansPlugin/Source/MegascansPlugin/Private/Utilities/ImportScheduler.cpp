@@ -0,0 +1,238 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#include "Utilities/ImportScheduler.h"
+#include "AssetImportData.h"
+#include "Utilities/ImportTrace.h"
+
+#include "Async/Async.h"
+#include "Containers/Queue.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+
+namespace
+{
+	// Game thread work traces its own stages, worker nodes are traced here so they show up on their thread.
+	void TimeImportSchedulerNode(FImportSchedulerNode& Node)
+	{
+		Node.StartSeconds = FPlatformTime::Seconds();
+		Node.Work();
+		Node.EndSeconds = FPlatformTime::Seconds();
+	}
+
+	void RunImportSchedulerNode(FImportSchedulerNode& Node)
+	{
+		if (Node.bGameThread)
+		{
+			TimeImportSchedulerNode(Node);
+		}
+		else
+		{
+			FImportTraceScope Trace(Node.Stage);
+			Trace.Arg(TEXT("node"), Node.Label);
+			TimeImportSchedulerNode(Node);
+		}
+		// Whatever the work holds on to, e.g. parsed LODs, goes with the last user instead of at the end of the batch.
+		Node.Work = nullptr;
+	}
+
+	int32 PopHighestRank(const TArray<FImportSchedulerNode>& Nodes, TArray<int32>& Ready)
+	{
+		int32 Best = 0;
+		for (int32 ReadyIndex = 1; ReadyIndex < Ready.Num(); ReadyIndex++)
+		{
+			if (Nodes[Ready[ReadyIndex]].Rank > Nodes[Ready[Best]].Rank)
+			{
+				Best = ReadyIndex;
+			}
+		}
+		const int32 NodeIndex = Ready[Best];
+		Ready.RemoveAtSwap(Best);
+		return NodeIndex;
+	}
+}
+
+int32 FImportScheduler::AddNode(const TCHAR* Stage, const FString& Label, double EstimatedCost, bool bGameThread, TFunction<void()> Work, const TArray<int32>& Dependencies)
+{
+	const int32 NodeIndex = Nodes.Num();
+	FImportSchedulerNode& Node = Nodes.AddDefaulted_GetRef();
+	Node.Stage = Stage;
+	Node.Label = Label;
+	Node.EstimatedCost = EstimatedCost;
+	Node.bGameThread = bGameThread;
+	Node.Work = MoveTemp(Work);
+	for (int32 Dependency : Dependencies)
+	{
+		check(Dependency >= 0 && Dependency < NodeIndex);
+		Node.Dependencies.AddUnique(Dependency);
+	}
+	for (int32 Dependency : Node.Dependencies)
+	{
+		Nodes[Dependency].Dependents.Add(NodeIndex);
+	}
+	return NodeIndex;
+}
+
+void FImportScheduler::ComputeRanks()
+{
+	// Dependents always come after their dependencies, so one pass from the back sees every dependent's rank first.
+	for (int32 NodeIndex = Nodes.Num() - 1; NodeIndex >= 0; NodeIndex--)
+	{
+		FImportSchedulerNode& Node = Nodes[NodeIndex];
+		double LongestDependent = 0.0;
+		for (int32 Dependent : Node.Dependents)
+		{
+			LongestDependent = FMath::Max(LongestDependent, Nodes[Dependent].Rank);
+		}
+		Node.Rank = Node.EstimatedCost + LongestDependent;
+		Node.PendingDependencies = Node.Dependencies.Num();
+	}
+}
+
+void FImportScheduler::Run()
+{
+	if (Nodes.Num() == 0) return;
+	ComputeRanks();
+
+	TArray<int32> ReadyWorker;
+	TArray<int32> ReadyGame;
+	for (int32 NodeIndex = 0; NodeIndex < Nodes.Num(); NodeIndex++)
+	{
+		if (Nodes[NodeIndex].PendingDependencies == 0)
+		{
+			(Nodes[NodeIndex].bGameThread ? ReadyGame : ReadyWorker).Add(NodeIndex);
+		}
+	}
+
+	int32 Finished = 0;
+	int32 LastGameThreadNode = INDEX_NONE;
+	auto Release = [this, &Finished, &ReadyWorker, &ReadyGame](int32 NodeIndex)
+	{
+		Finished++;
+		for (int32 Dependent : Nodes[NodeIndex].Dependents)
+		{
+			if (--Nodes[Dependent].PendingDependencies == 0)
+			{
+				(Nodes[Dependent].bGameThread ? ReadyGame : ReadyWorker).Add(Dependent);
+			}
+		}
+	};
+
+	// Workers are limited so the order of the ready list still matters once the thread pool is busy.
+	const int32 MaxWorkers = FMath::Clamp(FPlatformMisc::NumberOfCoresIncludingHyperthreads() - 1, 1, 8);
+	TQueue<int32, EQueueMode::Mpsc> Completed;
+	FEvent* CompletedEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	TArray<TFuture<void>> Tasks;
+	int32 InFlight = 0;
+
+	const double StartSeconds = FPlatformTime::Seconds();
+	while (Finished < Nodes.Num())
+	{
+		int32 CompletedNode;
+		while (Completed.Dequeue(CompletedNode))
+		{
+			InFlight--;
+			Release(CompletedNode);
+		}
+
+		while (ReadyWorker.Num() > 0 && InFlight < MaxWorkers)
+		{
+			const int32 NodeIndex = PopHighestRank(Nodes, ReadyWorker);
+			FImportSchedulerNode* Node = &Nodes[NodeIndex];
+			InFlight++;
+			Tasks.Add(Async(EAsyncExecution::ThreadPool, [Node, NodeIndex, &Completed, CompletedEvent]()
+			{
+				RunImportSchedulerNode(*Node);
+				Completed.Enqueue(NodeIndex);
+				CompletedEvent->Trigger();
+			}));
+		}
+
+		if (ReadyGame.Num() > 0)
+		{
+			const int32 NodeIndex = PopHighestRank(Nodes, ReadyGame);
+			Nodes[NodeIndex].PreviousGameThreadNode = LastGameThreadNode;
+			LastGameThreadNode = NodeIndex;
+			RunImportSchedulerNode(Nodes[NodeIndex]);
+			Release(NodeIndex);
+		}
+		else if (InFlight > 0)
+		{
+			CompletedEvent->Wait(10);
+		}
+		else if (ReadyWorker.Num() == 0)
+		{
+			UE_LOG(MSLiveLinkLog, Error, TEXT("Import schedule stopped with %d of %d nodes left, their dependencies never finished"), Nodes.Num() - Finished, Nodes.Num());
+			break;
+		}
+	}
+	WallMs = (FPlatformTime::Seconds() - StartSeconds) * 1000.0;
+
+	// A worker may still be between queueing its node and triggering the event, the event can't go back to the pool before it's done.
+	for (TFuture<void>& Task : Tasks)
+	{
+		Task.Wait();
+	}
+	FPlatformProcess::ReturnSynchEventToPool(CompletedEvent);
+
+	Report();
+}
+
+void FImportScheduler::Report()
+{
+	TArray<double> PathMs;
+	TArray<int32> PathPrevious;
+	PathMs.SetNumZeroed(Nodes.Num());
+	PathPrevious.Init(INDEX_NONE, Nodes.Num());
+
+	// Everything a node waited for, its dependencies and the game thread node before it, finished before it started,
+	// so in order of start time every node comes after all of them.
+	TArray<int32> StartOrder;
+	for (int32 NodeIndex = 0; NodeIndex < Nodes.Num(); NodeIndex++)
+	{
+		StartOrder.Add(NodeIndex);
+	}
+	StartOrder.StableSort([this](int32 A, int32 B) { return Nodes[A].StartSeconds < Nodes[B].StartSeconds; });
+
+	TotalWorkMs = 0.0;
+	CriticalPathMs = 0.0;
+	double GameThreadMs = 0.0;
+	int32 WorkerNodes = 0;
+	int32 CriticalPathEnd = INDEX_NONE;
+	for (int32 NodeIndex : StartOrder)
+	{
+		const FImportSchedulerNode& Node = Nodes[NodeIndex];
+		const double NodeMs = FMath::Max(Node.EndSeconds - Node.StartSeconds, 0.0) * 1000.0;
+		TotalWorkMs += NodeMs;
+		if (Node.bGameThread) GameThreadMs += NodeMs;
+		else WorkerNodes++;
+
+		TArray<int32> WaitedFor = Node.Dependencies;
+		if (Node.PreviousGameThreadNode != INDEX_NONE)
+		{
+			WaitedFor.Add(Node.PreviousGameThreadNode);
+		}
+		for (int32 Previous : WaitedFor)
+		{
+			if (PathMs[Previous] > PathMs[NodeIndex])
+			{
+				PathMs[NodeIndex] = PathMs[Previous];
+				PathPrevious[NodeIndex] = Previous;
+			}
+		}
+		PathMs[NodeIndex] += NodeMs;
+		if (PathMs[NodeIndex] > CriticalPathMs)
+		{
+			CriticalPathMs = PathMs[NodeIndex];
+			CriticalPathEnd = NodeIndex;
+		}
+	}
+
+	TArray<FString> CriticalPath;
+	for (int32 NodeIndex = CriticalPathEnd; NodeIndex != INDEX_NONE; NodeIndex = PathPrevious[NodeIndex])
+	{
+		CriticalPath.Insert(FString::Printf(TEXT("%s %s"), Nodes[NodeIndex].Stage, *Nodes[NodeIndex].Label), 0);
+	}
+
+	UE_LOG(MSLiveLinkLog, Display, TEXT("Import schedule: %d nodes, %d on worker threads. Wall %.1f ms, total work %.1f ms, game thread %.1f ms (%.0f%% of the critical path), critical path %.1f ms: %s"),
+		Nodes.Num(), WorkerNodes, WallMs, TotalWorkMs, GameThreadMs, CriticalPathMs > 0.0 ? GameThreadMs * 100.0 / CriticalPathMs : 0.0, CriticalPathMs, *FString::Join(CriticalPath, TEXT(" > ")));
+}
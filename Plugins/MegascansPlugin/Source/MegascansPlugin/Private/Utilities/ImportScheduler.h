@@ -0,0 +1,50 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+
+
+// A unit of work of an import batch. Work that creates or touches UObjects has to run on the game thread,
+// everything else may run on a worker thread.
+struct FImportSchedulerNode
+{
+	const TCHAR* Stage;
+	FString Label;
+	double EstimatedCost;
+	bool bGameThread;
+	TFunction<void()> Work;
+	TArray<int32> Dependencies;
+
+	TArray<int32> Dependents;
+	int32 PendingDependencies = 0;
+	double Rank = 0.0;
+	double StartSeconds = 0.0;
+	double EndSeconds = 0.0;
+	// The game thread node that ran right before this one, the game thread can't start a node before that finished.
+	int32 PreviousGameThreadNode = INDEX_NONE;
+};
+
+// Runs a dependency graph of import work. Worker nodes run concurrently on the thread pool, game thread nodes run one
+// at a time on the calling thread. Ready nodes start in order of their estimated critical path, the cost of the node
+// plus the most expensive chain of nodes waiting on it, so the long chains (large meshes) get going first.
+// After Run the measured total work and critical path are logged. The critical path counts the game thread as a chain
+// of its nodes in the order they ran, so with most of an import on the game thread it is close to the game thread time.
+class FImportScheduler
+{
+public:
+	// Dependencies have to be added before the nodes that depend on them.
+	int32 AddNode(const TCHAR* Stage, const FString& Label, double EstimatedCost, bool bGameThread, TFunction<void()> Work, const TArray<int32>& Dependencies = TArray<int32>());
+	void Run();
+
+	double GetWallMs() const { return WallMs; }
+	double GetTotalWorkMs() const { return TotalWorkMs; }
+	double GetCriticalPathMs() const { return CriticalPathMs; }
+
+private:
+	void ComputeRanks();
+	void Report();
+
+	TArray<FImportSchedulerNode> Nodes;
+	double WallMs = 0.0;
+	double TotalWorkMs = 0.0;
+	double CriticalPathMs = 0.0;
+};
@@ -0,0 +1,398 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#include "Utilities/ImportTrace.h"
+#include "AssetImportData.h"
+#include "UI/MSSettings.h"
+
+#include "HAL/FileManager.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformAtomics.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/PlatformTLS.h"
+#include "HAL/ThreadManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/JsonWriter.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+
+namespace
+{
+	// Forwards to the allocator it wraps and counts the calls that hand out memory.
+	class FMallocCountingProxy : public FMalloc
+	{
+	public:
+		explicit FMallocCountingProxy(FMalloc* InMalloc)
+			: UsedMalloc(InMalloc)
+		{
+		}
+
+		uint64 GetAllocations() const { return static_cast<uint64>(FPlatformAtomics::AtomicRead(&Allocations)); }
+
+		virtual void* Malloc(SIZE_T Size, uint32 Alignment) override
+		{
+			FPlatformAtomics::InterlockedIncrement(&Allocations);
+			return UsedMalloc->Malloc(Size, Alignment);
+		}
+		virtual void* TryMalloc(SIZE_T Size, uint32 Alignment) override
+		{
+			FPlatformAtomics::InterlockedIncrement(&Allocations);
+			return UsedMalloc->TryMalloc(Size, Alignment);
+		}
+		virtual void* Realloc(void* Ptr, SIZE_T NewSize, uint32 Alignment) override
+		{
+			if (Ptr == nullptr) FPlatformAtomics::InterlockedIncrement(&Allocations);
+			return UsedMalloc->Realloc(Ptr, NewSize, Alignment);
+		}
+		virtual void* TryRealloc(void* Ptr, SIZE_T NewSize, uint32 Alignment) override
+		{
+			if (Ptr == nullptr) FPlatformAtomics::InterlockedIncrement(&Allocations);
+			return UsedMalloc->TryRealloc(Ptr, NewSize, Alignment);
+		}
+		virtual void Free(void* Ptr) override { UsedMalloc->Free(Ptr); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return UsedMalloc->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return UsedMalloc->GetAllocationSize(Original, SizeOut); }
+		virtual void Trim(bool bTrimThreadCaches) override { UsedMalloc->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { UsedMalloc->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { UsedMalloc->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void InitializeStatsMetadata() override { UsedMalloc->InitializeStatsMetadata(); }
+		virtual void UpdateStats() override { UsedMalloc->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { UsedMalloc->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { UsedMalloc->DumpAllocatorStats(Ar); }
+		virtual bool IsInternallyThreadSafe() const override { return UsedMalloc->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return UsedMalloc->ValidateHeap(); }
+		virtual const TCHAR* GetDescriptiveName() override { return UsedMalloc->GetDescriptiveName(); }
+
+	private:
+		FMalloc* UsedMalloc;
+		volatile int64 Allocations = 0;
+	};
+
+	FMallocCountingProxy* GImportAllocationCounter = nullptr;
+
+	uint64 GetImportAllocations()
+	{
+		return GImportAllocationCounter ? GImportAllocationCounter->GetAllocations() : 0;
+	}
+}
+
+TSharedPtr<FImportTrace> FImportTrace::ImportTraceInst;
+
+TSharedPtr<FImportTrace> FImportTrace::Get()
+{
+	if (!ImportTraceInst.IsValid())
+	{
+		ImportTraceInst = MakeShareable(new FImportTrace);
+	}
+	return ImportTraceInst;
+}
+
+void FImportTrace::BeginBatch(const FString& Name)
+{
+	FScopeLock Lock(&SpansLock);
+	if (BatchDepth++ > 0) return;
+
+	const UMegascansSettings* MegascansSettings = GetDefault<UMegascansSettings>();
+	bActive = MegascansSettings->bTraceImports;
+	BatchName = Name;
+	BatchStartCycles = FPlatformTime::Cycles64();
+	Spans.Empty();
+	OpenSpans.Empty();
+}
+
+void FImportTrace::EnableMemoryTracking()
+{
+	check(IsInGameThread());
+	if (GImportAllocationCounter == nullptr)
+	{
+		// Never removed again, memory handed out through the proxy may be freed at any later point.
+		GImportAllocationCounter = new FMallocCountingProxy(GMalloc);
+		GMalloc = GImportAllocationCounter;
+	}
+	bTrackMemory = true;
+}
+
+void FImportTrace::EndBatch()
+{
+	{
+		FScopeLock Lock(&SpansLock);
+		if (BatchDepth == 0 || --BatchDepth > 0) return;
+		if (!bActive) return;
+		bActive = false;
+
+		// Spans left open by an early return end with the batch.
+		const uint64 EndCycles = FPlatformTime::Cycles64();
+		for (FImportTraceSpan& Span : Spans)
+		{
+			if (Span.EndCycles == 0) Span.EndCycles = EndCycles;
+		}
+		OpenSpans.Empty();
+	}
+
+	if (Spans.Num() == 0) return;
+
+	const FString TraceDirectory = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MegascansTraces"));
+	const FString Filename = FPaths::Combine(TraceDirectory, BatchName + TEXT("_") + FDateTime::Now().ToString() + TEXT(".json"));
+	if (WriteChromeTrace(Filename))
+	{
+		UE_LOG(MSLiveLinkLog, Display, TEXT("Import trace written to %s"), *FPaths::ConvertRelativePathToFull(Filename));
+	}
+	Summarize();
+	LogSummary();
+	Spans.Empty();
+}
+
+int32 FImportTrace::BeginSpan(const TCHAR* Name, const TCHAR* Category)
+{
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	const uint32 ThreadId = FPlatformTLS::GetCurrentThreadId();
+
+	FScopeLock Lock(&SpansLock);
+	if (!bActive) return INDEX_NONE;
+
+	TArray<int32>& ThreadSpans = OpenSpans.FindOrAdd(ThreadId);
+	FImportTraceSpan& Span = Spans.AddDefaulted_GetRef();
+	Span.Name = Name;
+	Span.Category = Category;
+	Span.ThreadId = ThreadId;
+	Span.StartCycles = StartCycles;
+	Span.EndCycles = 0;
+	Span.StartAllocations = bTrackMemory ? GetImportAllocations() : 0;
+	Span.EndAllocations = Span.StartAllocations;
+	Span.EndUsedPhysical = 0;
+	Span.Parent = ThreadSpans.Num() > 0 ? ThreadSpans.Last() : INDEX_NONE;
+
+	const int32 SpanIndex = Spans.Num() - 1;
+	ThreadSpans.Add(SpanIndex);
+	return SpanIndex;
+}
+
+void FImportTrace::EndSpan(int32 SpanIndex)
+{
+	const uint64 EndCycles = FPlatformTime::Cycles64();
+	const uint64 EndAllocations = bTrackMemory ? GetImportAllocations() : 0;
+	const uint64 EndUsedPhysical = bTrackMemory ? FPlatformMemory::GetStats().UsedPhysical : 0;
+
+	FScopeLock Lock(&SpansLock);
+	if (!bActive || !Spans.IsValidIndex(SpanIndex)) return;
+
+	FImportTraceSpan& Span = Spans[SpanIndex];
+	Span.EndCycles = EndCycles;
+	Span.EndAllocations = EndAllocations;
+	Span.EndUsedPhysical = EndUsedPhysical;
+	if (TArray<int32>* ThreadSpans = OpenSpans.Find(Span.ThreadId))
+	{
+		ThreadSpans->RemoveSingle(SpanIndex);
+	}
+}
+
+void FImportTrace::AddArg(int32 SpanIndex, const TCHAR* Key, const FString& Value)
+{
+	FScopeLock Lock(&SpansLock);
+	if (!bActive || !Spans.IsValidIndex(SpanIndex)) return;
+	Spans[SpanIndex].Args.Emplace(Key, Value);
+}
+
+void FImportTrace::AddArg(int32 SpanIndex, const TCHAR* Key, int64 Value)
+{
+	FScopeLock Lock(&SpansLock);
+	if (!bActive || !Spans.IsValidIndex(SpanIndex)) return;
+	Spans[SpanIndex].NumberArgs.Emplace(Key, Value);
+}
+
+bool FImportTrace::WriteChromeTrace(const FString& Filename)
+{
+	FString TraceJson;
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&TraceJson);
+
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("displayTimeUnit"), TEXT("ms"));
+	Writer->WriteArrayStart(TEXT("traceEvents"));
+
+	TSet<uint32> ThreadIds;
+	for (const FImportTraceSpan& Span : Spans)
+	{
+		ThreadIds.Add(Span.ThreadId);
+	}
+	for (uint32 ThreadId : ThreadIds)
+	{
+		const FString& ThreadName = FThreadManager::GetThreadName(ThreadId);
+
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("name"), TEXT("thread_name"));
+		Writer->WriteValue(TEXT("ph"), TEXT("M"));
+		Writer->WriteValue(TEXT("pid"), 1);
+		Writer->WriteValue(TEXT("tid"), static_cast<int64>(ThreadId));
+		Writer->WriteObjectStart(TEXT("args"));
+		Writer->WriteValue(TEXT("name"), ThreadName.IsEmpty() ? FString::Printf(TEXT("Thread %u"), ThreadId) : ThreadName);
+		Writer->WriteObjectEnd();
+		Writer->WriteObjectEnd();
+	}
+
+	for (const FImportTraceSpan& Span : Spans)
+	{
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("name"), Span.Name);
+		Writer->WriteValue(TEXT("cat"), Span.Category);
+		Writer->WriteValue(TEXT("ph"), TEXT("X"));
+		Writer->WriteValue(TEXT("ts"), FPlatformTime::ToMilliseconds64(Span.StartCycles - BatchStartCycles) * 1000.0);
+		Writer->WriteValue(TEXT("dur"), FPlatformTime::ToMilliseconds64(Span.EndCycles - Span.StartCycles) * 1000.0);
+		Writer->WriteValue(TEXT("pid"), 1);
+		Writer->WriteValue(TEXT("tid"), static_cast<int64>(Span.ThreadId));
+		if (Span.Args.Num() > 0 || Span.NumberArgs.Num() > 0 || bTrackMemory)
+		{
+			Writer->WriteObjectStart(TEXT("args"));
+			if (bTrackMemory)
+			{
+				Writer->WriteValue(TEXT("allocations"), static_cast<int64>(Span.EndAllocations - Span.StartAllocations));
+			}
+			for (const TPair<FString, FString>& Arg : Span.Args)
+			{
+				Writer->WriteValue(Arg.Key, Arg.Value);
+			}
+			for (const TPair<FString, int64>& Arg : Span.NumberArgs)
+			{
+				Writer->WriteValue(Arg.Key, Arg.Value);
+			}
+			Writer->WriteObjectEnd();
+		}
+		Writer->WriteObjectEnd();
+
+		if (bTrackMemory && Span.EndUsedPhysical > 0)
+		{
+			Writer->WriteObjectStart();
+			Writer->WriteValue(TEXT("name"), TEXT("Memory"));
+			Writer->WriteValue(TEXT("ph"), TEXT("C"));
+			Writer->WriteValue(TEXT("ts"), FPlatformTime::ToMilliseconds64(Span.EndCycles - BatchStartCycles) * 1000.0);
+			Writer->WriteValue(TEXT("pid"), 1);
+			Writer->WriteObjectStart(TEXT("args"));
+			Writer->WriteValue(TEXT("UsedMB"), Span.EndUsedPhysical / (1024.0 * 1024.0));
+			Writer->WriteObjectEnd();
+			Writer->WriteObjectEnd();
+		}
+	}
+
+	Writer->WriteArrayEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(Filename), true);
+	if (!FFileHelper::SaveStringToFile(TraceJson, *Filename))
+	{
+		UE_LOG(MSLiveLinkLog, Warning, TEXT("Couldn't write import trace %s"), *Filename);
+		return false;
+	}
+	return true;
+}
+
+void FImportTrace::Summarize()
+{
+	// Self time leaves out the nested spans so stages called from each other aren't counted twice.
+	TArray<double> SelfMs;
+	SelfMs.SetNumUninitialized(Spans.Num());
+	for (int32 SpanIndex = 0; SpanIndex < Spans.Num(); SpanIndex++)
+	{
+		SelfMs[SpanIndex] = FPlatformTime::ToMilliseconds64(Spans[SpanIndex].EndCycles - Spans[SpanIndex].StartCycles);
+	}
+	for (int32 SpanIndex = 0; SpanIndex < Spans.Num(); SpanIndex++)
+	{
+		const int32 Parent = Spans[SpanIndex].Parent;
+		if (Parent != INDEX_NONE)
+		{
+			SelfMs[Parent] -= FPlatformTime::ToMilliseconds64(Spans[SpanIndex].EndCycles - Spans[SpanIndex].StartCycles);
+		}
+	}
+
+	TMap<FString, FImportStageSummary> Stages;
+	uint64 BatchEndCycles = BatchStartCycles;
+	for (int32 SpanIndex = 0; SpanIndex < Spans.Num(); SpanIndex++)
+	{
+		const FImportTraceSpan& Span = Spans[SpanIndex];
+		const double DurationMs = FPlatformTime::ToMilliseconds64(Span.EndCycles - Span.StartCycles);
+		FImportStageSummary& Stage = Stages.FindOrAdd(Span.Name);
+		Stage.Name = Span.Name;
+		Stage.Count++;
+		Stage.TotalMs += DurationMs;
+		Stage.SelfMs += FMath::Max(SelfMs[SpanIndex], 0.0);
+		Stage.MaxMs = FMath::Max(Stage.MaxMs, DurationMs);
+		Stage.Allocations += static_cast<int64>(Span.EndAllocations - Span.StartAllocations);
+		Stage.PeakUsedPhysical = FMath::Max(Stage.PeakUsedPhysical, Span.EndUsedPhysical);
+		for (const TPair<FString, int64>& Arg : Span.NumberArgs)
+		{
+			if (Arg.Key == TEXT("bytes")) Stage.Bytes += Arg.Value;
+		}
+		BatchEndCycles = FMath::Max(BatchEndCycles, Span.EndCycles);
+	}
+
+	LastSummary.Reset();
+	Stages.GenerateValueArray(LastSummary);
+	LastSummary.Sort([](const FImportStageSummary& A, const FImportStageSummary& B) { return A.SelfMs > B.SelfMs; });
+	LastBatchMs = FPlatformTime::ToMilliseconds64(BatchEndCycles - BatchStartCycles);
+}
+
+void FImportTrace::LogSummary()
+{
+	UE_LOG(MSLiveLinkLog, Display, TEXT("Import batch %s took %.1f ms"), *BatchName, LastBatchMs);
+	if (bTrackMemory)
+	{
+		UE_LOG(MSLiveLinkLog, Display, TEXT("%-24s %6s %12s %12s %12s %10s %12s %10s"), TEXT("Stage"), TEXT("Count"), TEXT("Total ms"), TEXT("Self ms"), TEXT("Max ms"), TEXT("MB"), TEXT("Allocs"), TEXT("Peak MB"));
+	}
+	else
+	{
+		UE_LOG(MSLiveLinkLog, Display, TEXT("%-24s %6s %12s %12s %12s %10s"), TEXT("Stage"), TEXT("Count"), TEXT("Total ms"), TEXT("Self ms"), TEXT("Max ms"), TEXT("MB"));
+	}
+	for (const FImportStageSummary& Stage : LastSummary)
+	{
+		if (bTrackMemory)
+		{
+			UE_LOG(MSLiveLinkLog, Display, TEXT("%-24s %6d %12.1f %12.1f %12.1f %10.1f %12lld %10.1f"), *Stage.Name, Stage.Count, Stage.TotalMs, Stage.SelfMs, Stage.MaxMs, Stage.Bytes / (1024.0 * 1024.0), Stage.Allocations, Stage.PeakUsedPhysical / (1024.0 * 1024.0));
+		}
+		else
+		{
+			UE_LOG(MSLiveLinkLog, Display, TEXT("%-24s %6d %12.1f %12.1f %12.1f %10.1f"), *Stage.Name, Stage.Count, Stage.TotalMs, Stage.SelfMs, Stage.MaxMs, Stage.Bytes / (1024.0 * 1024.0));
+		}
+	}
+}
+
+FImportTraceScope::FImportTraceScope(const TCHAR* Name, const TCHAR* Category)
+	: SpanIndex(FImportTrace::Get()->BeginSpan(Name, Category))
+{
+}
+
+FImportTraceScope::~FImportTraceScope()
+{
+	if (SpanIndex != INDEX_NONE)
+	{
+		FImportTrace::Get()->EndSpan(SpanIndex);
+	}
+}
+
+FImportTraceScope& FImportTraceScope::Arg(const TCHAR* Key, const FString& Value)
+{
+	if (SpanIndex != INDEX_NONE)
+	{
+		FImportTrace::Get()->AddArg(SpanIndex, Key, Value);
+	}
+	return *this;
+}
+
+FImportTraceScope& FImportTraceScope::Arg(const TCHAR* Key, int64 Value)
+{
+	if (SpanIndex != INDEX_NONE)
+	{
+		FImportTrace::Get()->AddArg(SpanIndex, Key, Value);
+	}
+	return *this;
+}
+
+FImportTraceScope& FImportTraceScope::FileArgs(const FString& Filename)
+{
+	if (SpanIndex != INDEX_NONE)
+	{
+		FImportTrace::Get()->AddArg(SpanIndex, TEXT("file"), FPaths::GetCleanFilename(Filename));
+		FImportTrace::Get()->AddArg(SpanIndex, TEXT("format"), FPaths::GetExtension(Filename));
+		FImportTrace::Get()->AddArg(SpanIndex, TEXT("bytes"), IFileManager::Get().FileSize(*Filename));
+	}
+	return *this;
+}
@@ -0,0 +1,97 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+
+// A timed stage of an import batch with the attributes added while it was open.
+struct FImportTraceSpan
+{
+	FString Name;
+	FString Category;
+	uint32 ThreadId;
+	uint64 StartCycles;
+	uint64 EndCycles;
+	int32 Parent;
+	uint64 StartAllocations;
+	uint64 EndAllocations;
+	uint64 EndUsedPhysical;
+	TArray<TPair<FString, FString>> Args;
+	TArray<TPair<FString, int64>> NumberArgs;
+};
+
+// Totals of all spans with the same name in a batch. Allocations and peak memory are only recorded with memory tracking on.
+struct FImportStageSummary
+{
+	FString Name;
+	int32 Count = 0;
+	double TotalMs = 0.0;
+	double SelfMs = 0.0;
+	double MaxMs = 0.0;
+	int64 Bytes = 0;
+	int64 Allocations = 0;
+	uint64 PeakUsedPhysical = 0;
+};
+
+// Collects the spans of one Bridge batch. At the end of the batch they are written to
+// Saved/MegascansTraces as Chrome trace JSON (chrome://tracing or ui.perfetto.dev) and a summary per stage is logged.
+class FImportTrace
+{
+private:
+	FImportTrace() = default;
+	static TSharedPtr<FImportTrace> ImportTraceInst;
+
+	bool WriteChromeTrace(const FString& Filename);
+	void Summarize();
+	void LogSummary();
+
+	FCriticalSection SpansLock;
+	TArray<FImportTraceSpan> Spans;
+	TMap<uint32, TArray<int32>> OpenSpans;
+	FString BatchName;
+	uint64 BatchStartCycles = 0;
+	int32 BatchDepth = 0;
+	bool bActive = false;
+	bool bTrackMemory = false;
+
+	TArray<FImportStageSummary> LastSummary;
+	double LastBatchMs = 0.0;
+
+public:
+	static TSharedPtr<FImportTrace> Get();
+
+	// Batches don't nest, an inner batch becomes part of the outer one.
+	void BeginBatch(const FString& Name);
+	void EndBatch();
+	bool IsActive() const { return bActive; }
+
+	// Counts allocations and samples memory at the start and end of every span. The allocation counter wraps GMalloc
+	// and stays installed for the rest of the session, so this is meant for benchmark runs.
+	void EnableMemoryTracking();
+
+	// Stage totals of the last finished batch, slowest self time first.
+	const TArray<FImportStageSummary>& GetLastSummary() const { return LastSummary; }
+	double GetLastBatchMs() const { return LastBatchMs; }
+
+	int32 BeginSpan(const TCHAR* Name, const TCHAR* Category);
+	void EndSpan(int32 SpanIndex);
+	void AddArg(int32 SpanIndex, const TCHAR* Key, const FString& Value);
+	void AddArg(int32 SpanIndex, const TCHAR* Key, int64 Value);
+};
+
+// Traces the enclosing scope as a span of the current batch, does nothing outside of a batch.
+class FImportTraceScope
+{
+public:
+	explicit FImportTraceScope(const TCHAR* Name, const TCHAR* Category = TEXT("import"));
+	~FImportTraceScope();
+
+	bool IsActive() const { return SpanIndex != INDEX_NONE; }
+	FImportTraceScope& Arg(const TCHAR* Key, const FString& Value);
+	FImportTraceScope& Arg(const TCHAR* Key, int64 Value);
+	// Source file name, extension and size in bytes.
+	FImportTraceScope& FileArgs(const FString& Filename);
+
+private:
+	int32 SpanIndex;
+};
@@ -7,6 +7,16 @@
 #include "IAssetTools.h"
 #include "FbxMeshUtils.h"
 #include "AbcImportSettings.h"
+#include "AbcImporter.h"
+#include "Async/ParallelFor.h"
+#include "StaticMeshAttributes.h"
+#include "StaticMeshOperations.h"
+#include "OverlappingCorners.h"
+#include "IMeshReductionInterfaces.h"
+#include "IMeshReductionManagerModule.h"
+#include "HAL/PlatformTime.h"
+#include "UObject/Package.h"
+#include "UObject/StrongObjectPtr.h"
 #include "Utilities/MiscUtils.h"
 #include "Runtime/Core/Public/Misc/Paths.h"
 
@@ -19,12 +29,30 @@
 #include "Runtime/Foliage/Public/FoliageType_InstancedStaticMesh.h"
 #include "Runtime/AssetRegistry/Public/AssetRegistryModule.h"
 #include "PerPlatformProperties.h"
+#include "Utilities/ImportTrace.h"
+#include "Utilities/ImportMemory.h"
 
 
 
 
 TSharedPtr<FMeshOps> FMeshOps::MeshOpsInst;
 
+namespace
+{
+	// Sections of a LOD use the material slot with the same name if there is one, like SetLodFromStaticMesh does.
+	void MapLodSectionsToMaterialSlots(UStaticMesh* SourceMesh, int32 LodIndex, const FMeshDescription& LodDescription)
+	{
+		FStaticMeshConstAttributes LodAttributes(LodDescription);
+		TPolygonGroupAttributesConstRef<FName> SlotNames = LodAttributes.GetPolygonGroupMaterialSlotNames();
+		int32 SectionIndex = 0;
+		for (const FPolygonGroupID PolygonGroupID : LodDescription.PolygonGroups().GetElementIDs())
+		{
+			const int32 MaterialIndex = SourceMesh->StaticMaterials.IndexOfByPredicate([&SlotNames, PolygonGroupID](const FStaticMaterial& Material) { return Material.ImportedMaterialSlotName == SlotNames[PolygonGroupID]; });
+			SourceMesh->GetSectionInfoMap().Set(LodIndex, SectionIndex++, FMeshSectionInfo(FMath::Max(MaterialIndex, 0)));
+		}
+	}
+}
+
 TSharedPtr<FMeshOps> FMeshOps::Get()
 {
 	if (!MeshOpsInst.IsValid())
@@ -51,10 +79,8 @@ FString FMeshOps::ImportMesh(const FString& MeshPath, const FString& Destination
 		UFbxImportUI* ImportOptions;
 		ImportOptions = GetFbxOptions();
 
-		if (FileExtension == TEXT("obj"))
-		{
-			ImportOptions->StaticMeshImportData->ImportRotation = FRotator(0, 0, 90);
-		}
+		// Set on both branches, the options are pooled during a batch and an FBX mustn't inherit the OBJ rotation.
+		ImportOptions->StaticMeshImportData->ImportRotation = (FileExtension == TEXT("obj")) ? FRotator(0, 0, 90) : FRotator::ZeroRotator;
 
 		AssetPath = ImportFile(ImportOptions, Destination, AssetName, MeshPath);
 	}
@@ -69,36 +95,201 @@ FString FMeshOps::ImportMesh(const FString& MeshPath, const FString& Destination
 
 void FMeshOps::ApplyLods(const TArray<FString>& LodList, UStaticMesh* SourceMesh)
 {
+	FImportTraceScope Trace(TEXT("ApplyLods"));
+	Trace.Arg(TEXT("lods"), static_cast<int64>(LodList.Num()));
 	int32 LodCounter = 1;
 	for (FString LodPath : LodList)
 	{
 		if (LodCounter > 7) continue;
+		FImportTraceScope LodTrace(TEXT("ImportLod"));
+		LodTrace.FileArgs(LodPath).Arg(TEXT("lod"), static_cast<int64>(LodCounter));
 		FbxMeshUtils::ImportStaticMeshLOD(SourceMesh, LodPath, LodCounter);
 		
 		LodCounter++;
 	}
 }
 
-void FMeshOps::ApplyAbcLods(UStaticMesh* SourceMesh, const TArray<FString>& LodPathList, const FString& AssetDestination)
+// An Alembic LOD file read by its own importer. The importer keeps using the settings until the mesh is created.
+struct FParsedAbcLod
 {
-	FString LodDestination = FPaths::Combine(AssetDestination, TEXT("Lods"));
-	int32 LodCounter = 1;
+	TStrongObjectPtr<UAbcImportSettings> Settings;
+	TUniquePtr<FAbcImporter> Importer;
 
-	for (FString LodPath : LodPathList)
+	void Parse(const FString& LodPath)
 	{
-		if (LodCounter > 7) continue;
-		FString ImportedLodPath = ImportMesh(LodPath, LodDestination, "");
-		UStaticMesh* ImportedLod = CastChecked<UStaticMesh>(LoadAsset(ImportedLodPath));
-		UEditorStaticMeshLibrary::SetLodFromStaticMesh(SourceMesh, LodCounter, ImportedLod, 0, true);
-		LodCounter++;
+		TUniquePtr<FAbcImporter> LodImporter = MakeUnique<FAbcImporter>();
+		if (LodImporter->OpenAbcFileForImport(LodPath) != AbcImportError_NoError) return;
+		if (LodImporter->ImportTrackData(1, Settings.Get()) != AbcImportError_NoError) return;
+		Importer = MoveTemp(LodImporter);
+	}
+};
+
+TFunction<void()> FMeshOps::PrepareAbcLod(const FString& LodPath)
+{
+	// The importer may adjust its settings while reading, so every file gets a copy.
+	TSharedPtr<FParsedAbcLod, ESPMode::ThreadSafe> ParsedLod = MakeShared<FParsedAbcLod, ESPMode::ThreadSafe>();
+	ParsedLod->Settings.Reset(DuplicateObject<UAbcImportSettings>(GetAbcSettings(), GetTransientPackage()));
+	ParsedAbcLods.Add(LodPath, ParsedLod);
+	return [ParsedLod, LodPath]()
+	{
+		ParsedLod->Parse(LodPath);
+	};
+}
+
+void FMeshOps::DropParsedAbcLods(const TArray<FString>& LodPaths)
+{
+	for (const FString& LodPath : LodPaths)
+	{
+		ParsedAbcLods.Remove(LodPath);
+	}
+}
+
+void FMeshOps::ResetParsedAbcLods()
+{
+	ParsedAbcLods.Reset();
+}
+
+// Alembic LODs are read on worker threads, each file with its own importer, and copied straight into the source
+// models of SourceMesh. LODs the batch scheduler read ahead with PrepareAbcLod are taken as they are. The meshes the
+// importer creates live in the transient package, so there are no LOD assets to register and delete, and SourceMesh
+// is built once for all LODs.
+void FMeshOps::ApplyAbcLods(UStaticMesh* SourceMesh, const TArray<FString>& LodPathList, bool bPostEditChange)
+{
+	FImportTraceScope Trace(TEXT("ApplyLods"));
+	Trace.Arg(TEXT("lods"), static_cast<int64>(LodPathList.Num()));
+	const int32 NumLods = FMath::Min(LodPathList.Num(), MAX_STATIC_MESH_LODS - 1);
+
+	TArray<TSharedPtr<FParsedAbcLod, ESPMode::ThreadSafe>> ParsedLods;
+	TArray<int32> LodsToParse;
+	for (int32 LodIndex = 0; LodIndex < NumLods; LodIndex++)
+	{
+		TSharedPtr<FParsedAbcLod, ESPMode::ThreadSafe> ParsedLod;
+		if (ParsedAbcLods.RemoveAndCopyValue(LodPathList[LodIndex], ParsedLod) && ParsedLod->Importer.IsValid())
+		{
+			ParsedLods.Add(ParsedLod);
+			continue;
+		}
+		ParsedLod = MakeShared<FParsedAbcLod, ESPMode::ThreadSafe>();
+		ParsedLod->Settings.Reset(DuplicateObject<UAbcImportSettings>(GetAbcSettings(), GetTransientPackage()));
+		ParsedLods.Add(ParsedLod);
+		LodsToParse.Add(LodIndex);
+	}
+
+	ParallelFor(LodsToParse.Num(), [&LodPathList, &ParsedLods, &LodsToParse](int32 ParseIndex)
+	{
+		const int32 LodIndex = LodsToParse[ParseIndex];
+		FImportTraceScope LodTrace(TEXT("ParseLod"));
+		LodTrace.FileArgs(LodPathList[LodIndex]).Arg(TEXT("lod"), static_cast<int64>(LodIndex + 1));
+		ParsedLods[LodIndex]->Parse(LodPathList[LodIndex]);
+	});
+
+	SourceMesh->Modify();
+	for (int32 LodIndex = 0; LodIndex < NumLods; LodIndex++)
+	{
+		const int32 TargetLod = LodIndex + 1;
+		if (!ParsedLods[LodIndex]->Importer.IsValid())
+		{
+			UE_LOG(MSLiveLinkLog, Error, TEXT("Couldn't read LOD %d of %s from %s, skipping the remaining LODs"), TargetLod, *SourceMesh->GetName(), *LodPathList[LodIndex]);
+			break;
+		}
+
+		FImportTraceScope LodTrace(TEXT("SetLodMeshDescription"));
+		LodTrace.Arg(TEXT("lod"), static_cast<int64>(TargetLod));
+		const TArray<UStaticMesh*> LodMeshes = ParsedLods[LodIndex]->Importer->ImportAsStaticMesh(GetTransientPackage(), RF_Transient);
+		const FMeshDescription* LodDescription = LodMeshes.Num() > 0 ? LodMeshes[0]->GetMeshDescription(0) : nullptr;
+		if (LodDescription == nullptr)
+		{
+			UE_LOG(MSLiveLinkLog, Error, TEXT("%s has no mesh for LOD %d of %s, skipping the remaining LODs"), *LodPathList[LodIndex], TargetLod, *SourceMesh->GetName());
+			break;
+		}
+
+		if (SourceMesh->GetNumSourceModels() <= TargetLod)
+		{
+			SourceMesh->SetNumSourceModels(TargetLod + 1);
+		}
+		SourceMesh->GetSourceModel(TargetLod).BuildSettings = SourceMesh->GetSourceModel(0).BuildSettings;
+		SourceMesh->CreateMeshDescription(TargetLod, *LodDescription);
+		SourceMesh->CommitMeshDescription(TargetLod);
+
+		MapLodSectionsToMaterialSlots(SourceMesh, TargetLod, *LodDescription);
+	}
+
+	if (bPostEditChange)
+	{
+		FImportTraceScope PostEditTrace(TEXT("PostEditChange"));
+		PostEditTrace.Arg(TEXT("asset"), SourceMesh->GetName());
+		SourceMesh->PostEditChange();
+	}
+	SourceMesh->MarkPackageDirty();
+}
+
+// Every generated LOD is reduced from LOD0 on a worker thread, LOD n to 1/2^n of its triangles. They are committed
+// without a build, the PostEditChange of the caller builds them together with LOD0. That build also runs the vertex
+// cache optimization of the index buffers of every LOD.
+void FMeshOps::GenerateLods(UStaticMesh* SourceMesh, int32 NumLods, const TMap<FString, float>& LodScreenSizes)
+{
+	const FMeshDescription* BaseDescription = SourceMesh->GetMeshDescription(0);
+	IMeshReduction* MeshReduction = FModuleManager::Get().LoadModuleChecked<IMeshReductionManagerModule>("MeshReductionInterface").GetStaticMeshReductionInterface();
+	if (BaseDescription == nullptr || MeshReduction == nullptr)
+	{
+		UE_LOG(MSLiveLinkLog, Warning, TEXT("Can't generate LODs for %s, there is no mesh reduction available"), *SourceMesh->GetName());
+		return;
 	}
-	UEditorAssetLibrary::DeleteDirectory(LodDestination);
+	NumLods = FMath::Clamp(NumLods, 1, MAX_STATIC_MESH_LODS - 1);
+
+	FImportTraceScope Trace(TEXT("GenerateLods"));
+	Trace.Arg(TEXT("asset"), SourceMesh->GetName()).Arg(TEXT("lods"), static_cast<int64>(NumLods));
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	FOverlappingCorners OverlappingCorners;
+	FStaticMeshOperations::FindOverlappingCorners(OverlappingCorners, *BaseDescription, THRESH_POINTS_ARE_SAME);
+
+	TArray<FMeshDescription> LodDescriptions;
+	LodDescriptions.SetNum(NumLods);
+	ParallelFor(NumLods, [&LodDescriptions, BaseDescription, &OverlappingCorners, MeshReduction](int32 LodIndex)
+	{
+		FMeshReductionSettings ReductionSettings;
+		ReductionSettings.PercentTriangles = FMath::Pow(0.5f, LodIndex + 1);
+		float MaxDeviation = 0.0f;
+		FStaticMeshAttributes(LodDescriptions[LodIndex]).Register();
+		MeshReduction->ReduceMeshDescription(LodDescriptions[LodIndex], MaxDeviation, *BaseDescription, OverlappingCorners, ReductionSettings);
+	});
+
+	// Metadata screen sizes win, the rest keeps the triangle density on screen roughly constant.
+	const bool bUseMetadata = !(LodScreenSizes.Contains(TEXT("lod0")) && LodScreenSizes[TEXT("lod0")] == 0);
+	TArray<FString> TriangleCounts;
+	TriangleCounts.Add(FString::FromInt(BaseDescription->Triangles().Num()));
+
+	SourceMesh->Modify();
+	SourceMesh->SetNumSourceModels(NumLods + 1);
+	SourceMesh->bAutoComputeLODScreenSize = false;
+	SourceMesh->GetSourceModel(0).ScreenSize = FPerPlatformFloat(1.0f);
+	for (int32 LodIndex = 0; LodIndex < NumLods; LodIndex++)
+	{
+		const int32 TargetLod = LodIndex + 1;
+		const float* MetadataScreenSize = bUseMetadata ? LodScreenSizes.Find(FString::Printf(TEXT("lod%d"), TargetLod)) : nullptr;
+		FStaticMeshSourceModel& SourceModel = SourceMesh->GetSourceModel(TargetLod);
+		SourceModel.BuildSettings = SourceMesh->GetSourceModel(0).BuildSettings;
+		SourceModel.ReductionSettings = FMeshReductionSettings();
+		SourceModel.ScreenSize = FPerPlatformFloat(MetadataScreenSize ? *MetadataScreenSize : FMath::Sqrt(FMath::Pow(0.5f, TargetLod)));
+
+		TriangleCounts.Add(FString::FromInt(LodDescriptions[LodIndex].Triangles().Num()));
+		SourceMesh->CreateMeshDescription(TargetLod, MoveTemp(LodDescriptions[LodIndex]));
+		SourceMesh->CommitMeshDescription(TargetLod);
+		MapLodSectionsToMaterialSlots(SourceMesh, TargetLod, *SourceMesh->GetMeshDescription(TargetLod));
+	}
+	SourceMesh->MarkPackageDirty();
+
+	const double ElapsedMs = (FPlatformTime::Seconds() - StartSeconds) * 1000.0;
+	Trace.Arg(TEXT("triangles"), FString::Join(TriangleCounts, TEXT("/")));
+	UE_LOG(MSLiveLinkLog, Display, TEXT("Generated %d LODs for %s in %.1f ms, triangles per LOD %s"), NumLods, *SourceMesh->GetName(), ElapsedMs, *FString::Join(TriangleCounts, TEXT(" / ")));
 }
 
 void FMeshOps::CreateFoliageAsset(const FString& FoliagePath, UStaticMesh* SourceAsset, const FString& FoliageAssetName, bool bSavePackage)
 {
 	
 	if (SourceAsset == nullptr) return;
+	FImportTraceScope Trace(TEXT("CreateFoliageAsset"));
 	FString FoliageTypePath = FPaths::Combine(FoliagePath, TEXT("Foliage/"));
 	//IAssetTools& AssetTools = FModuleManager::GetModuleChecked<FAssetToolsModule>("AssetTools").Get();
 	FString PackageName = FoliageTypePath;
@@ -141,7 +332,7 @@ TArray<FString> FMeshOps::ImportLodsAsStaticMesh(const TArray<FString> & LodList
 
 UFbxImportUI* FMeshOps::GetFbxOptions()
 {
-	UFbxImportUI* DefaultImportOptions = NewObject<UFbxImportUI>();
+	UFbxImportUI* DefaultImportOptions = FImportMemory::Get()->GetFbxImportUI();
 
 	DefaultImportOptions->StaticMeshImportData->bCombineMeshes = bCombineMeshes;
 	DefaultImportOptions->StaticMeshImportData->bGenerateLightmapUVs = false;
@@ -155,7 +346,7 @@ UFbxImportUI* FMeshOps::GetFbxOptions()
 	return DefaultImportOptions;
 }
 
-void FMeshOps::RemoveExtraMaterialSlot(UStaticMesh* SourceMesh)
+void FMeshOps::RemoveExtraMaterialSlot(UStaticMesh* SourceMesh, bool bPostEditChange)
 {
 
 	for (int i = 1; i < SourceMesh->GetNumLODs(); i++)
@@ -175,7 +366,12 @@ void FMeshOps::RemoveExtraMaterialSlot(UStaticMesh* SourceMesh)
 	}
 
 	SourceMesh->Modify();
-	SourceMesh->PostEditChange();
+	if (bPostEditChange)
+	{
+		FImportTraceScope Trace(TEXT("PostEditChange"));
+		Trace.Arg(TEXT("asset"), SourceMesh->GetName());
+		SourceMesh->PostEditChange();
+	}
 	SourceMesh->MarkPackageDirty();
 
 }
@@ -189,7 +385,7 @@ FString FMeshOps::ImportFile(T * ImportOptions, const FString & Destination, con
 
 	FString ImportedMeshPath = TEXT("");
 	TArray< UAssetImportTask*> ImportTasks;
-	UAssetImportTask* MeshImportTask = NewObject<UAssetImportTask>();
+	UAssetImportTask* MeshImportTask = FImportMemory::Get()->AcquireImportTask();
 	MeshImportTask->bAutomated = true;
 	MeshImportTask->bSave = false;
 	MeshImportTask->Filename = Source;
@@ -206,6 +402,8 @@ FString FMeshOps::ImportFile(T * ImportOptions, const FString & Destination, con
 
 	IAssetTools& AssetTools = FModuleManager::GetModuleChecked<FAssetToolsModule>("AssetTools").Get();
 
+	FImportTraceScope Trace(TEXT("ImportAssetTasks"));
+	Trace.FileArgs(Source);
 	AssetTools.ImportAssetTasks(ImportTasks);
 
 	for (UAssetImportTask* ImpTask : ImportTasks)
@@ -218,7 +416,7 @@ FString FMeshOps::ImportFile(T * ImportOptions, const FString & Destination, con
 
 UAbcImportSettings* FMeshOps::GetAbcSettings()
 {
-	UAbcImportSettings* AlembicOptions = NewObject<UAbcImportSettings>();
+	UAbcImportSettings* AlembicOptions = FImportMemory::Get()->GetAbcImportSettings();
 	AlembicOptions->ImportType = EAlembicImportType::StaticMesh;
 	AlembicOptions->StaticMeshSettings.bMergeMeshes = false;
 	AlembicOptions->MaterialSettings.bCreateMaterials = false;
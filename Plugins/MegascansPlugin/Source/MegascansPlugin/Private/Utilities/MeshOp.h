@@ -6,6 +6,7 @@
 class UFbxImportUI;
 class UStaticMesh;
 class UAbcImportSettings;
+struct FParsedAbcLod;
 
 
 class FMeshOps
@@ -20,14 +21,23 @@ private:
 	template<class T> FString ImportFile(T* ImportOptions, const FString& Destination, const FString& AssetName, const FString& Source);
 	UAbcImportSettings* GetAbcSettings();
 
+	// Alembic LODs read ahead of their import, by source file.
+	TMap<FString, TSharedPtr<FParsedAbcLod, ESPMode::ThreadSafe>> ParsedAbcLods;
+
 public:
 	static TSharedPtr<FMeshOps> Get();
 	FString ImportMesh(const FString& MeshPath, const FString& Destination, const FString& AssetName = TEXT(""));
 	void ApplyLods(const TArray<FString>& LodList, UStaticMesh* SourceMesh);
 	TArray<FString> ImportLodsAsStaticMesh(const TArray<FString>& LodList, const FString& AssetDestination);
-	void ApplyAbcLods(UStaticMesh* SourceMesh, const TArray<FString>& LodPathList, const FString& AssetDestination);
+	void ApplyAbcLods(UStaticMesh* SourceMesh, const TArray<FString>& LodPathList, bool bPostEditChange = true);
+	// Game thread. Returns work that reads the Alembic LOD on any thread, ApplyAbcLods takes the result instead of reading the file again.
+	TFunction<void()> PrepareAbcLod(const FString& LodPath);
+	// Drops LODs read ahead that no ApplyAbcLods used, for the given files or all of them.
+	void DropParsedAbcLods(const TArray<FString>& LodPaths);
+	void ResetParsedAbcLods();
+	void GenerateLods(UStaticMesh* SourceMesh, int32 NumLods, const TMap<FString, float>& LodScreenSizes);
 	void CreateFoliageAsset(const FString& FoliagePath, UStaticMesh* SourceAsset, const FString& FoliageAssetName, bool bSavePackage = false);
-	void RemoveExtraMaterialSlot(UStaticMesh* SourceMesh);
+	void RemoveExtraMaterialSlot(UStaticMesh* SourceMesh, bool bPostEditChange = true);
 	//void SetFbxOptions(bool bCombineMeshes = false, bool bGenerateLightmapUVs = false, bool bAutoGenerateCollision = false, bool bImportMesh = true, bool bImportAnimations = false, bool bImportMaterials = false, bool bImportAsSkeletal = false);
 	void LodDistanceTest(UStaticMesh* SourceMesh);
 	bool bCombineMeshes = false;
@@ -20,7 +20,6 @@
 #include "Runtime/Core/Public/Misc/MessageDialog.h"
 #include "Runtime/Core/Public/Internationalization/Text.h"
 
-#include "PackageTools.h"
 
 #include <regex>
 #include <ostream>
@@ -31,6 +30,11 @@
 #include "EditorAssetLibrary.h"
 #include "GenericPlatform/GenericPlatformFile.h"
 #include "Misc/FileHelper.h"
+#include "Utilities/ImportTrace.h"
+#include "Utilities/ImportPolicy.h"
+#include "Utilities/PackageSaveQueue.h"
+#include "Utilities/FileCopyEngine.h"
+#include "Utilities/AssetRegistryUpdate.h"
 
 
 
@@ -113,34 +117,22 @@ bool CopyMaterialPreset(const FString & MaterialName)
 	MaterialDestinationPath = FPaths::Combine(MaterialDestinationPath, GetMSPresetsName());
 	MaterialDestinationPath = FPaths::Combine(MaterialDestinationPath, MaterialName);
 	
+	// The preset is looked up right after this, so it has to be in the registry even inside a batch.
 	if (!PlatformFile.DirectoryExists(*MaterialDestinationPath))
 	{
-		
-		if (!PlatformFile.CreateDirectoryTree(*MaterialDestinationPath))
-		{
-			
-			return false;
-		}
-
-		if (!PlatformFile.CopyDirectoryTree(*MaterialDestinationPath, *MaterialSourceFolderPath, true))
+		FFileCopyEngine CopyEngine;
+		CopyEngine.AddDirectory(MaterialSourceFolderPath, MaterialDestinationPath);
+		if (!CopyEngine.Run(FText::FromString(TEXT("Importing : ") + MaterialName)))
 		{
-			
 			return false;
 		}
-
+		FAssetRegistryUpdate::Get()->AddFiles(CopyEngine.GetCopiedFiles());
 	}
-
-	
-	FAssetRegistryModule& AssetRegistryModule = FModuleManager::GetModuleChecked<FAssetRegistryModule>("AssetRegistry");
-	TArray<FString> MaterialBasePath;
-	FString BasePath = FPaths::Combine(FPaths::ProjectContentDir(), GetMSPresetsName());
-	MaterialBasePath.Add("/Game/MSPresets");
-	MaterialBasePath.Add(FPaths::Combine(TEXT("/Game/MSPresets"), MaterialName));
-	if (PlatformFile.DirectoryExists(*FPaths::Combine(TEXT("/Game/MSPresets"), MaterialName, TEXT("Functions"))))
+	else
 	{
-		MaterialBasePath.Add(FPaths::Combine(TEXT("/Game/MSPresets"), MaterialName, TEXT("Functions")));
+		FAssetRegistryUpdate::Get()->AddPath(FPaths::Combine(TEXT("/Game/MSPresets"), MaterialName));
 	}
-	AssetRegistryModule.Get().ScanPathsSynchronous(MaterialBasePath, true);
+	FAssetRegistryUpdate::Get()->Flush();
 	return true;
 	
 }
@@ -242,14 +234,10 @@ void SaveAsset(const FString& AssetPath)
 
 void DeleteExtraMesh(const FString& BasePath)
 {
-	TArray<FString> AssetBasePath;
-	AssetBasePath.Add(BasePath);
-	FAssetRegistryModule& AssetRegistryModule = FModuleManager::GetModuleChecked<FAssetRegistryModule>("AssetRegistry");
-	AssetRegistryModule.Get().ScanPathsSynchronous(AssetBasePath, true);
 	FString ExtraMeshName = TEXT("StaticMesh_0");
 	FString AssetPath = FPaths::Combine(BasePath, ExtraMeshName);
 	
-	AssetRegistryModule.Get().ScanPathsSynchronous(AssetBasePath, true);
+	FAssetRegistryUpdate::Get()->AddPath(BasePath);
 }
 
 
@@ -558,6 +546,7 @@ FString SanitizeName(const FString& InputName)
 
 	void AssetUtils::FocusOnSelected(const FString& Path)
 	{
+		if (IsRunningCommandlet()) return;
 		TArray<FString> Folders;
 		Folders.Add(Path);
 		FContentBrowserModule& ContentBrowserModule = FModuleManager::LoadModuleChecked<FContentBrowserModule>("ContentBrowser");
@@ -577,10 +566,7 @@ FString SanitizeName(const FString& InputName)
 
 	void AssetUtils::SavePackage(UObject* SourceObject)
 	{
-		TArray<UObject*> InputObjects;
-		InputObjects.Add(SourceObject);
-		UPackageTools::SavePackagesForObjects(InputObjects);
-
+		FPackageSaveQueue::Get()->Add(SourceObject);
 	}
 
 bool DHI::GetDHIJsonData(const FString & JsonStringData, TArray<FDHIData> & DHIAssetsData)
@@ -612,13 +598,9 @@ bool DHI::GetDHIJsonData(const FString & JsonStringData, TArray<FDHIData> & DHIA
 	
 }
 
-void DHI::CopyCharacter(const FDHIData & CharacterSourceData, bool OverWriteExisting)
+FString DHI::CopyCharacter(const FDHIData & CharacterSourceData, bool OverWriteExisting)
 {	
 
-	FAssetRegistryModule& AssetRegistryModule = FModuleManager::GetModuleChecked<FAssetRegistryModule>("AssetRegistry");
-	TArray<FString> AssetsBasePath;
-	AssetsBasePath.Add(TEXT("/Game/MetaHumans"));
-
 	FString CommonDestinationPath = FPaths::ProjectContentDir();
 	FString MetaHumansRoot = FPaths::Combine(CommonDestinationPath, TEXT("MetaHumans"));
 	CommonDestinationPath = FPaths::Combine(MetaHumansRoot, TEXT("Common"));
@@ -630,91 +612,27 @@ void DHI::CopyCharacter(const FDHIData & CharacterSourceData, bool OverWriteExis
 
 	if (PlatformFile.DirectoryExists(*CharacterDestination))
 	{
-		EAppReturnType::Type ContinueImport = FMessageDialog::Open(EAppMsgType::YesNo, FText(FText::FromString("The character you are trying to import already exists. Do you want to overwrite it.")));
-		if (ContinueImport == EAppReturnType::No) return;
+		if (!FImportPolicy::Get()->Confirm(EImportQuestion::OverwriteCharacter, FText::FromString("The character you are trying to import already exists. Do you want to overwrite it."))) return FString();
 
 	}
 	
-	TArray<FString> SourceCommonFiles;
-	PlatformFile.FindFilesRecursively(SourceCommonFiles, *CharacterSourceData.CommonPath, NULL);
-	TArray<FString> ExistingAssets = UEditorAssetLibrary::ListAssets(TEXT("/Game/MetaHumans/Common"));
-
-	FString ProjectCommonPath = FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectContentDir(), TEXT("MetaHumans"), TEXT("Common")));
-	FString SourceCommonPath = CharacterSourceData.CommonPath;
-	FPaths::NormalizeDirectoryName(SourceCommonPath);
-	
-	TArray<FString> ProjectCommonFiles;
-	PlatformFile.FindFilesRecursively(ProjectCommonFiles, *ProjectCommonPath, TEXT("uasset"));	
-	TArray<FString> ExistingAssetStrippedPaths;	
-
-	for (FString ProjectCommonFile : ProjectCommonFiles)
+	// Common files are shared by every character, so only the ones that are missing or changed get copied.
+	FFileCopyEngine CopyEngine;
+	CopyEngine.AddDirectory(CharacterSourceData.CommonPath, CommonDestinationPath);
+	CopyEngine.AddDirectory(CharacterSourceData.CharacterPath, CharacterDestination);
 	{
-		ExistingAssetStrippedPaths.Add(ProjectCommonFile.Replace(*ProjectCommonPath, TEXT("")));
-		
-	}	
-
-	TArray<FString> FilesToCopy;
-	for (FString FileToCopy : SourceCommonFiles)
-	{
-		
-		FString NormalizedSourceFile = FileToCopy;
-		FPaths::NormalizeFilename(NormalizedSourceFile);
-		FString StrippedSourcePath = NormalizedSourceFile.Replace(*SourceCommonPath, TEXT(""));
-
-		
-
-		if (!ExistingAssetStrippedPaths.Contains(StrippedSourcePath))
-		{	
-			
-			FString CommonFileDestination = FPaths::Combine(CommonDestinationPath, FileToCopy.Replace(*CharacterSourceData.CommonPath, TEXT("")));
-		
-			FString FileDirectory = FPaths::GetPath(CommonFileDestination);
-		
-			PlatformFile.CreateDirectoryTree(*FileDirectory);
-		
-			FString CommonCopyMsg = TEXT("Importing Common Assets.");
-			FText CommonCopyMsgDialogMessage = FText::FromString(CommonCopyMsg);
-			FScopedSlowTask AssetLoadprogress(1.0f, CommonCopyMsgDialogMessage, true);
-			AssetLoadprogress.MakeDialog();
-			AssetLoadprogress.EnterProgressFrame(1.0f);
-			PlatformFile.CopyFile(*CommonFileDestination, *FileToCopy);
-			
-		
-		}		
+		FImportTraceScope Trace(TEXT("CopyCharacterFiles"));
+		Trace.Arg(TEXT("character"), CharacterName);
+		if (!CopyEngine.Run(FText::FromString(TEXT("Importing : ") + CharacterName)))
+		{
+			UE_LOG(MSLiveLinkLog, Error, TEXT("Couldn't copy the files of character %s"), *CharacterName);
+			return FString();
+		}
 	}
 
-	
-	
-	AssetRegistryModule.Get().ScanPathsSynchronous(AssetsBasePath, true);
-	
-	PlatformFile.CreateDirectoryTree(*MetaHumansRoot);
-
-	AssetRegistryModule.Get().ScanPathsSynchronous(AssetsBasePath, true);
-	
-	PlatformFile.CreateDirectoryTree(*CharacterDestination);	
-	AssetsBasePath.Add("/Game/MetaHumans/" + CharacterSourceData.CharacterName);
-	
-	AssetRegistryModule.Get().ScanPathsSynchronous(AssetsBasePath, true);
-
-	FString CharacterCopyMsg = TEXT("Importing : ") + CharacterName;
-	FText CharacterCopyMsgDialogMessage = FText::FromString(CharacterCopyMsg);
-	FScopedSlowTask CharacterLoadprogress(1.0f, CharacterCopyMsgDialogMessage, true);
-	CharacterLoadprogress.MakeDialog();
-	CharacterLoadprogress.EnterProgressFrame(1.0f);
-	PlatformFile.CopyDirectoryTree(*CharacterDestination, *CharacterSourceData.CharacterPath, true);
-
-	
-	AssetRegistryModule.Get().ScanPathsSynchronous(AssetsBasePath, true);	
-	
-	FString BPName = TEXT("BP_") + CharacterSourceData.CharacterName;
-	BPName += TEXT(".") + BPName;
-	FString BPPath = FPaths::Combine(TEXT("/Game/MetaHumans/"), CharacterSourceData.CharacterName, BPName);
-
-	FAssetData CharacterAssetData = AssetRegistryModule.Get().GetAssetByObjectPath(FName(*BPPath));
-	UObject* CharacterObject = CharacterAssetData.GetAsset();
-	
-	AssetUtils::FocusOnSelected(CharacterDestination);	
-	
+	// Only the files that were written need scanning, unchanged ones are already in the registry.
+	FAssetRegistryUpdate::Get()->AddFiles(CopyEngine.GetCopiedFiles());
+	return CharacterDestination;
 }
 
 
@@ -54,5 +54,6 @@ namespace PathUtils
 
 namespace DHI {
 	bool GetDHIJsonData(const FString& JsonStringData, TArray<FDHIData>& DHIAssetsData);
-	void CopyCharacter(const FDHIData& CharacterSourcePath, bool OverWriteExisting = false);
+	// Returns the folder the character was copied to, empty if it wasn't. The copied files are only queued for the asset registry.
+	FString CopyCharacter(const FDHIData& CharacterSourcePath, bool OverWriteExisting = false);
 }
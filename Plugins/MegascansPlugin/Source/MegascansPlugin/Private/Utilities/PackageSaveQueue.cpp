@@ -0,0 +1,107 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#include "Utilities/PackageSaveQueue.h"
+#include "AssetImportData.h"
+#include "Utilities/ImportTrace.h"
+
+#include "FileHelpers.h"
+#include "HAL/FileManager.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+
+TSharedPtr<FPackageSaveQueue> FPackageSaveQueue::PackageSaveQueueInst;
+
+TSharedPtr<FPackageSaveQueue> FPackageSaveQueue::Get()
+{
+	if (!PackageSaveQueueInst.IsValid())
+	{
+		PackageSaveQueueInst = MakeShareable(new FPackageSaveQueue);
+	}
+	return PackageSaveQueueInst;
+}
+
+void FPackageSaveQueue::BeginBatch(int32 InFlushEveryAssets)
+{
+	if (BatchDepth++ > 0) return;
+	FlushEveryAssets = FMath::Max(InFlushEveryAssets, 0);
+	AssetsSinceFlush = 0;
+}
+
+void FPackageSaveQueue::EndBatch()
+{
+	if (BatchDepth == 0 || --BatchDepth > 0) return;
+	Flush();
+}
+
+void FPackageSaveQueue::Add(UObject* SourceObject)
+{
+	if (SourceObject == nullptr) return;
+
+	UPackage* Package = SourceObject->GetOutermost();
+	if (BatchDepth == 0)
+	{
+		SavePackages({ Package });
+		return;
+	}
+	Packages.AddUnique(Package);
+}
+
+void FPackageSaveQueue::AssetImported()
+{
+	if (BatchDepth == 0 || FlushEveryAssets == 0) return;
+	if (++AssetsSinceFlush >= FlushEveryAssets)
+	{
+		Flush();
+	}
+}
+
+void FPackageSaveQueue::Flush()
+{
+	AssetsSinceFlush = 0;
+	TArray<UPackage*> PackagesToSave;
+	for (const TWeakObjectPtr<UPackage>& Package : Packages)
+	{
+		if (Package.IsValid() && Package->IsDirty())
+		{
+			PackagesToSave.Add(Package.Get());
+		}
+	}
+	Packages.Reset();
+	SavePackages(PackagesToSave);
+}
+
+// Writable packages are serialized one after the other with their file writes running in the background, and the
+// writes are waited on once for the whole group. Read only packages, usually ones under source control, go through
+// the editor's checkout and save so the user still gets to check them out.
+void FPackageSaveQueue::SavePackages(const TArray<UPackage*>& PackagesToSave)
+{
+	if (PackagesToSave.Num() == 0) return;
+
+	FImportTraceScope Trace(TEXT("SavePackages"));
+	Trace.Arg(TEXT("packages"), static_cast<int64>(PackagesToSave.Num()));
+
+	TArray<UPackage*> ReadOnlyPackages;
+	int32 Failures = 0;
+	for (UPackage* Package : PackagesToSave)
+	{
+		const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), Package->ContainsMap() ? FPackageName::GetMapPackageExtension() : FPackageName::GetAssetPackageExtension());
+		if (IFileManager::Get().IsReadOnly(*Filename))
+		{
+			ReadOnlyPackages.Add(Package);
+			continue;
+		}
+		if (!UPackage::SavePackage(Package, nullptr, RF_Standalone, *Filename, GError, nullptr, false, true, SAVE_NoError | SAVE_Async))
+		{
+			Failures++;
+		}
+	}
+	UPackage::WaitForAsyncFileWrites();
+
+	if (ReadOnlyPackages.Num() > 0)
+	{
+		FEditorFileUtils::PromptForCheckoutAndSave(ReadOnlyPackages, false, false);
+	}
+	if (Failures > 0)
+	{
+		UE_LOG(MSLiveLinkLog, Error, TEXT("Couldn't save %d of %d imported packages"), Failures, PackagesToSave.Num());
+	}
+}
@@ -0,0 +1,34 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class UPackage;
+
+// Collects the packages an import batch wants saved and saves them together, at the end of the batch
+// or every few assets so a large batch doesn't keep everything dirty in memory. Outside of a batch
+// packages are saved right away.
+class FPackageSaveQueue
+{
+private:
+	FPackageSaveQueue() = default;
+	static TSharedPtr<FPackageSaveQueue> PackageSaveQueueInst;
+
+	TArray<TWeakObjectPtr<UPackage>> Packages;
+	int32 BatchDepth = 0;
+	int32 FlushEveryAssets = 0;
+	int32 AssetsSinceFlush = 0;
+
+public:
+	static TSharedPtr<FPackageSaveQueue> Get();
+
+	// FlushEveryAssets of 0 saves only at the end of the batch.
+	void BeginBatch(int32 InFlushEveryAssets);
+	void EndBatch();
+
+	void Add(UObject* SourceObject);
+	void AssetImported();
+	void Flush();
+
+	static void SavePackages(const TArray<UPackage*>& PackagesToSave);
+};
@@ -29,7 +29,9 @@ public class LivestreamingCamera : ModuleRules
                 "CoreUObject",
                 "Engine",
                 "RenderCore",
+                "Renderer",
                 "USpout",
+                "Json",
 				// ... add private dependencies that you statically link with here ...	
 			}
         );
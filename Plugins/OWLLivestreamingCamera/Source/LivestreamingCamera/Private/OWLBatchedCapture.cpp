@@ -0,0 +1,410 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#include "OWLBatchedCapture.h"
+#include "OWLLivestreamingCamera.h"
+#include "OWLRenderTargetPool.h"
+#include "LivestreamingCameraModule.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "CanvasTypes.h"
+#include "SceneView.h"
+#include "LegacyScreenPercentageDriver.h"
+#include "RendererInterface.h"
+#include "RenderCore.h"
+#include "RHI.h"
+
+DECLARE_CYCLE_STAT(TEXT("Batched Capture Submit"), STAT_OWLBatchedCaptureSubmit, STATGROUP_OWLLivestreaming);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Capture Views"), STAT_OWLBatchedCaptureViews, STATGROUP_OWLLivestreaming);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Capture Families"), STAT_OWLBatchedCaptureFamilies, STATGROUP_OWLLivestreaming);
+
+static TAutoConsoleVariable<int32> CVarBatchedCaptureEnable(
+	TEXT("OWL.BatchedCapture.Enable"),
+	1,
+	TEXT("0: every livestreaming camera renders its own scene capture. 1: cameras with batched capture enabled share one view family."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarBatchedCaptureMaxAtlasWidth(
+	TEXT("OWL.BatchedCapture.MaxAtlasWidth"),
+	8192,
+	TEXT("Width at which the batched capture atlas starts a new row of views."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorldAndArgs BatchedCaptureBenchmarkCommand(
+	TEXT("OWL.BatchedCapture.Benchmark"),
+	TEXT("Spawns 2, 4 and 8 livestreaming cameras at the current view and logs frame timings with and without batched capture. Arguments: [FramesPerRun=120]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (World == nullptr || !World->HasBegunPlay()) return;
+		if (UOWLBatchedCaptureSubsystem* Subsystem = World->GetSubsystem<UOWLBatchedCaptureSubsystem>())
+		{
+			Subsystem->StartBenchmark(Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 120);
+		}
+	}));
+
+struct UOWLBatchedCaptureSubsystem::FBenchmarkState
+{
+	struct FRun
+	{
+		int32 NumCameras;
+		bool bBatched;
+	};
+
+	TArray<FRun> Runs;
+	int32 RunIndex = -1;
+	int32 FramesPerRun = 120;
+	int32 Frame = 0;
+	double GPUMs = 0.0;
+	double RenderThreadMs = 0.0;
+	double GameThreadMs = 0.0;
+	TArray<TWeakObjectPtr<AOWLLivestreamingCamera>> SpawnedCameras;
+
+	static constexpr int32 WarmupFrames = 30;
+};
+
+void UOWLBatchedCaptureSubsystem::RegisterCamera(AOWLLivestreamingCamera* Camera)
+{
+	Cameras.AddUnique(Camera);
+}
+
+void UOWLBatchedCaptureSubsystem::UnregisterCamera(AOWLLivestreamingCamera* Camera)
+{
+	Cameras.Remove(Camera);
+	SetBatched(Camera, false);
+}
+
+void UOWLBatchedCaptureSubsystem::SetBatched(AOWLLivestreamingCamera* Camera, bool bBatched)
+{
+	const bool bWasBatched = BatchedCameras.Contains(Camera);
+	if (bWasBatched == bBatched) return;
+
+	if (bBatched) BatchedCameras.Add(Camera);
+	else BatchedCameras.Remove(Camera);
+	Camera->SetCapturedByBatch(bBatched);
+}
+
+uint32 UOWLBatchedCaptureSubsystem::GetBatchKey(AOWLLivestreamingCamera* Camera)
+{
+	const USceneCaptureComponent2D* Capture = Camera->CaptureComponent;
+	uint32 Key = (uint32)Capture->CaptureSource.GetValue();
+	Key |= (uint32)Capture->ShowFlags.TemporalAA << 8;
+	Key |= (uint32)Capture->ShowFlags.MotionBlur << 9;
+	Key |= (uint32)Capture->bUseRayTracingIfEnabled << 10;
+	Key |= (uint32)Capture->TextureTarget->RenderTargetFormat << 16;
+	return Key;
+}
+
+bool UOWLBatchedCaptureSubsystem::CanBatch(AOWLLivestreamingCamera* Camera)
+{
+	const USceneCaptureComponent2D* Capture = Camera->CaptureComponent;
+	return Camera->BatchedCaptureEnabled
+		&& Camera->GetCameraEnabled()
+		&& Camera->GetCaptureMode() == ELivestreamCaptureMode::CM_Standard
+		&& Capture->TextureTarget != nullptr
+		&& Capture->bCaptureEveryFrame
+		&& Capture->CompositeMode == SCCM_Overwrite
+		&& Capture->ProjectionType == ECameraProjectionMode::Perspective
+		&& !Capture->bEnableClipPlane;
+}
+
+// Shelf packing, views are laid out in rows no wider than OWL.BatchedCapture.MaxAtlasWidth
+void UOWLBatchedCaptureSubsystem::PackAtlas(FBatch& Batch)
+{
+	Batch.Cameras.Sort([](const AOWLLivestreamingCamera& A, const AOWLLivestreamingCamera& B)
+	{
+		return A.CaptureComponent->TextureTarget->SizeY > B.CaptureComponent->TextureTarget->SizeY;
+	});
+
+	const int32 MaxWidth = FMath::Max(CVarBatchedCaptureMaxAtlasWidth.GetValueOnGameThread(), 256);
+	FIntPoint Cursor = FIntPoint::ZeroValue;
+	int32 RowHeight = 0;
+	Batch.Offsets.Reset();
+	Batch.AtlasSize = FIntPoint::ZeroValue;
+	for (AOWLLivestreamingCamera* Camera : Batch.Cameras)
+	{
+		const FIntPoint Size(Camera->CaptureComponent->TextureTarget->SizeX, Camera->CaptureComponent->TextureTarget->SizeY);
+		if (Cursor.X > 0 && Cursor.X + Size.X > MaxWidth)
+		{
+			Cursor.X = 0;
+			Cursor.Y += RowHeight;
+			RowHeight = 0;
+		}
+		Batch.Offsets.Add(Cursor);
+		Cursor.X += Size.X;
+		RowHeight = FMath::Max(RowHeight, Size.Y);
+		Batch.AtlasSize.X = FMath::Max(Batch.AtlasSize.X, Cursor.X);
+		Batch.AtlasSize.Y = FMath::Max(Batch.AtlasSize.Y, Cursor.Y + RowHeight);
+	}
+}
+
+void UOWLBatchedCaptureSubsystem::RenderBatch(const FBatch& Batch, UTextureRenderTarget2D* Atlas)
+{
+	SCOPE_CYCLE_COUNTER(STAT_OWLBatchedCaptureSubmit);
+
+	UWorld* World = GetWorld();
+	FTextureRenderTargetResource* AtlasResource = Atlas->GameThread_GetRenderTargetResource();
+	if (World == nullptr || World->Scene == nullptr || AtlasResource == nullptr) return;
+
+	// family wide settings are the same for every camera of the batch, take them from the first one
+	const USceneCaptureComponent2D* FirstCapture = Batch.Cameras[0]->CaptureComponent;
+	FSceneViewFamilyContext ViewFamily(FSceneViewFamily::ConstructionValues(AtlasResource, World->Scene, FirstCapture->ShowFlags)
+		.SetRealtimeUpdate(true)
+		.SetWorldTimes(World->GetTimeSeconds(), World->GetDeltaSeconds(), World->GetRealTimeSeconds()));
+	ViewFamily.SceneCaptureSource = FirstCapture->CaptureSource;
+	ViewFamily.SceneCaptureCompositeMode = SCCM_Overwrite;
+	ViewFamily.bWorldIsPaused = World->IsPaused();
+	ViewFamily.SetScreenPercentageInterface(new FLegacyScreenPercentageDriver(ViewFamily, 1.0f, false));
+
+	struct FAtlasCopy
+	{
+		FIntPoint Offset;
+		FIntPoint Size;
+		FTextureRenderTargetResource* Target;
+	};
+	TArray<FAtlasCopy> Copies;
+
+	for (int32 Index = 0; Index < Batch.Cameras.Num(); ++Index)
+	{
+		USceneCaptureComponent2D* Capture = Batch.Cameras[Index]->CaptureComponent;
+		UTextureRenderTarget2D* Target = Capture->TextureTarget;
+		const FIntPoint Size(Target->SizeX, Target->SizeY);
+		const FIntPoint Offset = Batch.Offsets[Index];
+		const FVector Location = Capture->GetComponentLocation();
+
+		FSceneViewInitOptions ViewInitOptions;
+		ViewInitOptions.SetViewRectangle(FIntRect(Offset, Offset + Size));
+		ViewInitOptions.ViewFamily = &ViewFamily;
+		ViewInitOptions.ViewActor = Batch.Cameras[Index];
+		ViewInitOptions.ViewOrigin = Location;
+		// swap axis st. x=z,y=x,z=y (unreal coord space) so that z is up
+		ViewInitOptions.ViewRotationMatrix = FInverseRotationMatrix(Capture->GetComponentRotation()) * FMatrix(
+			FPlane(0, 0, 1, 0),
+			FPlane(1, 0, 0, 0),
+			FPlane(0, 1, 0, 0),
+			FPlane(0, 0, 0, 1));
+
+		const float HalfFOV = FMath::DegreesToRadians(FMath::Max(0.001f, Capture->FOVAngle)) * 0.5f;
+		ViewInitOptions.ProjectionMatrix = FReversedZPerspectiveMatrix(HalfFOV, HalfFOV, 1.0f, (float)Size.X / (float)Size.Y, GNearClippingPlane, GNearClippingPlane);
+		ViewInitOptions.FOV = Capture->FOVAngle;
+		ViewInitOptions.DesiredFOV = Capture->FOVAngle;
+		ViewInitOptions.bUseFieldOfViewForLOD = Capture->bUseFieldOfViewForLOD;
+		ViewInitOptions.LODDistanceFactor = FMath::Clamp(Capture->LODDistanceFactor, 0.01f, 100.0f);
+		ViewInitOptions.SceneViewStateInterface = Capture->GetViewState(0);
+		ViewInitOptions.StereoPass = eSSP_FULL;
+		ViewInitOptions.BackgroundColor = FLinearColor::Black;
+		ViewInitOptions.OverrideFarClippingPlaneDistance = Capture->MaxViewDistanceOverride;
+
+		FSceneView* View = new FSceneView(ViewInitOptions);
+		View->bIsSceneCapture = true;
+		View->bSceneCaptureUsesRayTracing = Capture->bUseRayTracingIfEnabled;
+		View->bCameraCut = false;
+
+		for (const TWeakObjectPtr<UPrimitiveComponent>& Component : Capture->HiddenComponents)
+		{
+			if (Component.IsValid()) View->HiddenPrimitives.Add(Component->ComponentId);
+		}
+		for (AActor* Actor : Capture->HiddenActors)
+		{
+			if (Actor == nullptr) continue;
+			for (UActorComponent* Component : Actor->GetComponents())
+			{
+				if (UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Component)) View->HiddenPrimitives.Add(Primitive->ComponentId);
+			}
+		}
+		if (Capture->PrimitiveRenderMode == ESceneCapturePrimitiveRenderMode::PRM_UseShowOnlyList)
+		{
+			View->ShowOnlyPrimitives.Emplace();
+			for (const TWeakObjectPtr<UPrimitiveComponent>& Component : Capture->ShowOnlyComponents)
+			{
+				if (Component.IsValid()) View->ShowOnlyPrimitives->Add(Component->ComponentId);
+			}
+			for (AActor* Actor : Capture->ShowOnlyActors)
+			{
+				if (Actor == nullptr) continue;
+				for (UActorComponent* Component : Actor->GetComponents())
+				{
+					if (UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Component)) View->ShowOnlyPrimitives->Add(Primitive->ComponentId);
+				}
+			}
+		}
+
+		View->StartFinalPostprocessSettings(Location);
+		View->OverridePostProcessSettings(Capture->PostProcessSettings, Capture->PostProcessBlendWeight);
+		View->EndFinalPostprocessSettings(ViewInitOptions);
+		ViewFamily.Views.Add(View);
+
+		Copies.Add({ Offset, Size, Target->GameThread_GetRenderTargetResource() });
+	}
+
+	FCanvas Canvas(AtlasResource, nullptr, World, World->FeatureLevel, FCanvas::CDM_DeferDrawing, 1.0f);
+	GetRendererModule().BeginRenderingViewFamily(&Canvas, &ViewFamily);
+
+	ENQUEUE_RENDER_COMMAND(OWLCopyBatchedCaptures)([AtlasResource, Copies](FRHICommandListImmediate& RHICmdList)
+	{
+		FRHITexture* AtlasTexture = AtlasResource->GetRenderTargetTexture();
+		RHICmdList.Transition(FRHITransitionInfo(AtlasTexture, ERHIAccess::Unknown, ERHIAccess::CopySrc));
+		for (const FAtlasCopy& Copy : Copies)
+		{
+			if (Copy.Target == nullptr) continue;
+			FRHITexture* TargetTexture = Copy.Target->GetRenderTargetTexture();
+			FRHICopyTextureInfo CopyInfo;
+			CopyInfo.Size = FIntVector(Copy.Size.X, Copy.Size.Y, 1);
+			CopyInfo.SourcePosition = FIntVector(Copy.Offset.X, Copy.Offset.Y, 0);
+			RHICmdList.Transition(FRHITransitionInfo(TargetTexture, ERHIAccess::Unknown, ERHIAccess::CopyDest));
+			RHICmdList.CopyTexture(AtlasTexture, TargetTexture, CopyInfo);
+			RHICmdList.Transition(FRHITransitionInfo(TargetTexture, ERHIAccess::CopyDest, ERHIAccess::SRVMask));
+		}
+		RHICmdList.Transition(FRHITransitionInfo(AtlasTexture, ERHIAccess::CopySrc, ERHIAccess::SRVMask));
+	});
+}
+
+void UOWLBatchedCaptureSubsystem::ReleaseAtlases(int32 FirstAtlas)
+{
+	UOWLRenderTargetPool* Pool = GetWorld() != nullptr ? GetWorld()->GetSubsystem<UOWLRenderTargetPool>() : nullptr;
+	for (int32 Index = FirstAtlas; Index < Atlases.Num(); ++Index)
+	{
+		if (Pool != nullptr) Pool->Return(Atlases[Index]);
+	}
+	if (FirstAtlas < Atlases.Num()) Atlases.SetNum(FirstAtlas);
+}
+
+void UOWLBatchedCaptureSubsystem::Deinitialize()
+{
+	ReleaseAtlases(0);
+	Super::Deinitialize();
+}
+
+void UOWLBatchedCaptureSubsystem::Tick(float DeltaTime)
+{
+	TickBenchmark();
+
+	Cameras.RemoveAll([](const TWeakObjectPtr<AOWLLivestreamingCamera>& Camera) { return !Camera.IsValid(); });
+	for (auto It = BatchedCameras.CreateIterator(); It; ++It)
+	{
+		if (!It->IsValid()) It.RemoveCurrent();
+	}
+
+	// group cameras by the settings that have to match within a view family
+	TMap<uint32, FBatch> BatchesByKey;
+	const bool bBatchingEnabled = CVarBatchedCaptureEnable.GetValueOnGameThread() != 0;
+	for (const TWeakObjectPtr<AOWLLivestreamingCamera>& Camera : Cameras)
+	{
+		if (bBatchingEnabled && CanBatch(Camera.Get())) BatchesByKey.FindOrAdd(GetBatchKey(Camera.Get())).Cameras.Add(Camera.Get());
+		else SetBatched(Camera.Get(), false);
+	}
+
+	// views are set up from component transforms, make sure this frame's moves have reached the render thread
+	if (BatchesByKey.Num() > 0) GetWorld()->SendAllEndOfFrameUpdates();
+
+	UOWLRenderTargetPool* Pool = GetWorld()->GetSubsystem<UOWLRenderTargetPool>();
+	int32 NumAtlases = 0;
+	uint32 NumViews = 0;
+	for (TPair<uint32, FBatch>& Pair : BatchesByKey)
+	{
+		FBatch& Batch = Pair.Value;
+		// a single camera gains nothing from the atlas copy, leave it on its own scene capture
+		if (Batch.Cameras.Num() < 2 || Pool == nullptr)
+		{
+			for (AOWLLivestreamingCamera* Camera : Batch.Cameras) SetBatched(Camera, false);
+			continue;
+		}
+
+		PackAtlas(Batch);
+		const ETextureRenderTargetFormat Format = Batch.Cameras[0]->CaptureComponent->TextureTarget->RenderTargetFormat;
+		if (Atlases.Num() <= NumAtlases) Atlases.Add(nullptr);
+		UTextureRenderTarget2D*& Atlas = Atlases[NumAtlases];
+		if (Atlas != nullptr && (Atlas->SizeX != Batch.AtlasSize.X || Atlas->SizeY != Batch.AtlasSize.Y || Atlas->RenderTargetFormat != Format))
+		{
+			Pool->Return(Atlas);
+			Atlas = nullptr;
+		}
+		if (Atlas == nullptr) Atlas = Pool->Lease(this, Batch.AtlasSize, Format, 2.2f);
+		if (Atlas == nullptr) continue;
+		NumAtlases++;
+
+		for (AOWLLivestreamingCamera* Camera : Batch.Cameras) SetBatched(Camera, true);
+		RenderBatch(Batch, Atlas);
+		NumViews += Batch.Cameras.Num();
+	}
+	ReleaseAtlases(NumAtlases);
+
+	SET_DWORD_STAT(STAT_OWLBatchedCaptureViews, NumViews);
+	SET_DWORD_STAT(STAT_OWLBatchedCaptureFamilies, NumAtlases);
+}
+
+void UOWLBatchedCaptureSubsystem::StartBenchmark(int32 FramesPerRun)
+{
+	if (Benchmark.IsValid())
+	{
+		UE_LOG(LivestreamingCameraLog, Warning, TEXT("Batched capture benchmark is already running"))
+		return;
+	}
+
+	Benchmark = MakeShared<FBenchmarkState>();
+	Benchmark->FramesPerRun = FramesPerRun;
+	for (const int32 NumCameras : { 2, 4, 8 })
+	{
+		Benchmark->Runs.Add({ NumCameras, false });
+		Benchmark->Runs.Add({ NumCameras, true });
+	}
+	UE_LOG(LivestreamingCameraLog, Display, TEXT("Batched capture benchmark: %d runs of %d frames"), Benchmark->Runs.Num(), FramesPerRun)
+}
+
+void UOWLBatchedCaptureSubsystem::TickBenchmark()
+{
+	if (!Benchmark.IsValid()) return;
+	FBenchmarkState& State = *Benchmark;
+	UWorld* World = GetWorld();
+
+	if (State.RunIndex >= 0)
+	{
+		if (++State.Frame > FBenchmarkState::WarmupFrames)
+		{
+			State.GPUMs += FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles());
+			State.RenderThreadMs += FPlatformTime::ToMilliseconds(GRenderThreadTime);
+			State.GameThreadMs += FPlatformTime::ToMilliseconds(GGameThreadTime);
+		}
+		if (State.Frame < FBenchmarkState::WarmupFrames + State.FramesPerRun) return;
+
+		const FBenchmarkState::FRun& Run = State.Runs[State.RunIndex];
+		UE_LOG(LivestreamingCameraLog, Display, TEXT("  %d cameras %-9s  GPU %6.2f ms  render thread %6.2f ms  game thread %6.2f ms"),
+			Run.NumCameras, Run.bBatched ? TEXT("batched") : TEXT("separate"),
+			State.GPUMs / State.FramesPerRun, State.RenderThreadMs / State.FramesPerRun, State.GameThreadMs / State.FramesPerRun)
+		for (const TWeakObjectPtr<AOWLLivestreamingCamera>& Camera : State.SpawnedCameras)
+		{
+			if (Camera.IsValid()) Camera->Destroy();
+		}
+		State.SpawnedCameras.Reset();
+	}
+
+	if (++State.RunIndex >= State.Runs.Num())
+	{
+		UE_LOG(LivestreamingCameraLog, Display, TEXT("Batched capture benchmark finished"))
+		Benchmark.Reset();
+		return;
+	}
+
+	FVector ViewLocation = FVector::ZeroVector;
+	FRotator ViewRotation = FRotator::ZeroRotator;
+	if (APlayerController* PlayerController = World->GetFirstPlayerController()) PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+	const FBenchmarkState::FRun& Run = State.Runs[State.RunIndex];
+	for (int32 Index = 0; Index < Run.NumCameras; ++Index)
+	{
+		// fan the cameras out around the view so they don't all see the same primitives
+		const FRotator Rotation = ViewRotation + FRotator(0.0f, 360.0f * Index / Run.NumCameras, 0.0f);
+		AOWLLivestreamingCamera* Camera = World->SpawnActorDeferred<AOWLLivestreamingCamera>(AOWLLivestreamingCamera::StaticClass(), FTransform(Rotation, ViewLocation));
+		if (Camera == nullptr) continue;
+		Camera->CameraName = FString::Printf(TEXT("OWLBatchedCaptureBenchmark%d"), Index);
+		Camera->BatchedCaptureEnabled = Run.bBatched;
+		Camera->FinishSpawning(FTransform(Rotation, ViewLocation));
+		State.SpawnedCameras.Add(Camera);
+	}
+	State.Frame = 0;
+	State.GPUMs = State.RenderThreadMs = State.GameThreadMs = 0.0;
+}
+
+TStatId UOWLBatchedCaptureSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOWLBatchedCaptureSubsystem, STATGROUP_Tickables);
+}
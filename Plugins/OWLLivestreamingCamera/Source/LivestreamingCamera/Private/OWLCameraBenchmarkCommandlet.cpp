@@ -0,0 +1,401 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#include "OWLCameraBenchmarkCommandlet.h"
+#include "OWLLivestreamingCamera.h"
+#include "LivestreamingCameraModule.h"
+#include "USpout/Public/SpoutInterface.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/DirectionalLight.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/SceneCaptureComponent.h"
+#include "GameFramework/WorldSettings.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+#include "Dom/JsonObject.h"
+#include "RenderingThread.h"
+#include "RHI.h"
+
+namespace
+{
+	// bumped whenever the result layout changes, baselines of another version aren't compared
+	constexpr int32 ResultVersion = 1;
+
+	struct FBenchmarkRun
+	{
+		int32 NumCameras = 0;
+		FIntPoint Resolution = FIntPoint::ZeroValue;
+
+		// per camera and frame
+		double GameMs = 0.0;
+		double RenderThreadMs = 0.0;
+		double GPUMs = 0.0;
+		double BytesSent = 0.0;
+
+		// memory taken by spawning the cameras, and growth while they ran
+		double MemoryPerCameraMB = 0.0;
+		double MemoryGrowthMB = 0.0;
+
+		FString GetKey() const { return FString::Printf(TEXT("%d@%dx%d"), NumCameras, Resolution.X, Resolution.Y); }
+	};
+
+	struct FRenderFrameTiming
+	{
+		uint64 StartCycles = 0;
+		uint64 EndCycles = 0;
+	};
+
+	double GetUsedMemoryMB()
+	{
+		return FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0);
+	}
+
+	// What the engine loop does around a frame, minus the viewport: tick the world, render its scene captures and
+	// run the frame on the render thread. Returns game thread ms, render thread ms comes back through RenderTiming.
+	double TickFrame(UWorld* World, float DeltaSeconds, const TSharedRef<FRenderFrameTiming, ESPMode::ThreadSafe>& RenderTiming)
+	{
+		GFrameCounter++;
+		ENQUEUE_RENDER_COMMAND(OWLBenchmarkBeginFrame)(
+			[RenderTiming](FRHICommandListImmediate& RHICmdList) {
+				GFrameNumberRenderThread++;
+				RHICmdList.BeginFrame();
+				RenderTiming->StartCycles = FPlatformTime::Cycles64();
+			});
+
+		const double StartTime = FPlatformTime::Seconds();
+		World->Tick(LEVELTICK_All, DeltaSeconds);
+		World->SendAllEndOfFrameUpdates();
+		USceneCaptureComponent::UpdateDeferredCaptures(World->Scene);
+		const double GameMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		ENQUEUE_RENDER_COMMAND(OWLBenchmarkEndFrame)(
+			[RenderTiming](FRHICommandListImmediate& RHICmdList) {
+				RenderTiming->EndCycles = FPlatformTime::Cycles64();
+				RHICmdList.EndFrame();
+			});
+		FlushRenderingCommands();
+		return GameMs;
+	}
+
+	UWorld* CreateGeneratedWorld()
+	{
+		UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("OWLCameraBenchmark"));
+
+		// a grid of cubes in front of the cameras so every view has geometry, shadows and some overdraw
+		UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+		for (int32 X = -10; X <= 10; ++X)
+		{
+			for (int32 Y = -10; Y <= 10; ++Y)
+			{
+				AStaticMeshActor* Actor = World->SpawnActor<AStaticMeshActor>(FVector(X * 300.0f, Y * 300.0f, 0.0f), FRotator(0.0f, X * Y * 7.0f, 0.0f));
+				Actor->GetStaticMeshComponent()->SetMobility(EComponentMobility::Movable);
+				Actor->GetStaticMeshComponent()->SetStaticMesh(Cube);
+				Actor->SetActorScale3D(FVector(1.0f, 1.0f, 1.0f + (X + Y + 20) % 5));
+			}
+		}
+		ADirectionalLight* Light = World->SpawnActor<ADirectionalLight>(FVector::ZeroVector, FRotator(-45.0f, 30.0f, 0.0f));
+		Light->SetMobility(EComponentMobility::Movable);
+		return World;
+	}
+
+	UWorld* LoadWorld(const FString& MapName)
+	{
+		UPackage* Package = LoadPackage(nullptr, *MapName, LOAD_None);
+		UWorld* World = Package != nullptr ? UWorld::FindWorldInPackage(Package) : nullptr;
+		if (World == nullptr) return nullptr;
+
+		World->WorldType = EWorldType::Game;
+		World->AddToRoot();
+		if (!World->bIsWorldInitialized)
+		{
+			World->InitWorld(UWorld::InitializationValues().AllowAudioPlayback(false).CreateNavigation(false).CreateAISystem(false));
+		}
+		World->UpdateWorldComponents(true, false);
+		return World;
+	}
+
+	TArray<FIntPoint> ParseResolutions(const FString& Value)
+	{
+		TArray<FString> Entries;
+		Value.ParseIntoArray(Entries, TEXT(","));
+		TArray<FIntPoint> Resolutions;
+		for (const FString& Entry : Entries)
+		{
+			FString Width, Height;
+			if (Entry.Split(TEXT("x"), &Width, &Height) && FCString::Atoi(*Width) > 0 && FCString::Atoi(*Height) > 0)
+			{
+				Resolutions.Add(FIntPoint(FCString::Atoi(*Width), FCString::Atoi(*Height)));
+			}
+		}
+		return Resolutions;
+	}
+
+	TArray<int32> ParseCounts(const FString& Value)
+	{
+		TArray<FString> Entries;
+		Value.ParseIntoArray(Entries, TEXT(","));
+		TArray<int32> Counts;
+		for (const FString& Entry : Entries)
+		{
+			if (FCString::Atoi(*Entry) > 0) Counts.Add(FCString::Atoi(*Entry));
+		}
+		return Counts;
+	}
+
+	TSharedRef<FJsonObject> RunToJson(const FBenchmarkRun& Run)
+	{
+		TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+		Object->SetNumberField(TEXT("Cameras"), Run.NumCameras);
+		Object->SetNumberField(TEXT("Width"), Run.Resolution.X);
+		Object->SetNumberField(TEXT("Height"), Run.Resolution.Y);
+		Object->SetNumberField(TEXT("GameMsPerCamera"), Run.GameMs);
+		Object->SetNumberField(TEXT("RenderThreadMsPerCamera"), Run.RenderThreadMs);
+		Object->SetNumberField(TEXT("GPUMsPerCamera"), Run.GPUMs);
+		Object->SetNumberField(TEXT("BytesPerFramePerCamera"), Run.BytesSent);
+		Object->SetNumberField(TEXT("MemoryPerCameraMB"), Run.MemoryPerCameraMB);
+		Object->SetNumberField(TEXT("MemoryGrowthMB"), Run.MemoryGrowthMB);
+		return Object;
+	}
+
+	bool WriteResults(const FString& OutputBase, const TArray<FBenchmarkRun>& Runs, const FString& MapName, int32 Frames, bool bDelta)
+	{
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetNumberField(TEXT("Version"), ResultVersion);
+		Root->SetStringField(TEXT("RHI"), GDynamicRHI != nullptr ? GDynamicRHI->GetName() : TEXT("None"));
+		Root->SetStringField(TEXT("Map"), MapName);
+		Root->SetNumberField(TEXT("Frames"), Frames);
+		Root->SetBoolField(TEXT("DeltaTransport"), bDelta);
+		TArray<TSharedPtr<FJsonValue>> Results;
+		for (const FBenchmarkRun& Run : Runs)
+		{
+			Results.Add(MakeShared<FJsonValueObject>(RunToJson(Run)));
+		}
+		Root->SetArrayField(TEXT("Results"), Results);
+
+		FString Json;
+		FJsonSerializer::Serialize(Root, TJsonWriterFactory<>::Create(&Json));
+
+		FString Csv = TEXT("Cameras,Width,Height,GameMsPerCamera,RenderThreadMsPerCamera,GPUMsPerCamera,BytesPerFramePerCamera,MemoryPerCameraMB,MemoryGrowthMB\n");
+		for (const FBenchmarkRun& Run : Runs)
+		{
+			Csv += FString::Printf(TEXT("%d,%d,%d,%.4f,%.4f,%.4f,%.0f,%.2f,%.2f\n"), Run.NumCameras, Run.Resolution.X, Run.Resolution.Y,
+				Run.GameMs, Run.RenderThreadMs, Run.GPUMs, Run.BytesSent, Run.MemoryPerCameraMB, Run.MemoryGrowthMB);
+		}
+
+		const bool bWritten = FFileHelper::SaveStringToFile(Json, *(OutputBase + TEXT(".json"))) && FFileHelper::SaveStringToFile(Csv, *(OutputBase + TEXT(".csv")));
+		if (bWritten) UE_LOG(LivestreamingCameraLog, Display, TEXT("Camera benchmark results written to %s.json/.csv"), *OutputBase)
+		else UE_LOG(LivestreamingCameraLog, Error, TEXT("Couldn't write camera benchmark results to %s"), *OutputBase)
+		return bWritten;
+	}
+
+	// Returns the number of regressed values, or INDEX_NONE if the baseline couldn't be read
+	int32 CompareWithBaseline(const FString& BaselinePath, const TArray<FBenchmarkRun>& Runs, float Tolerance)
+	{
+		FString Json;
+		TSharedPtr<FJsonObject> Root;
+		if (!FFileHelper::LoadFileToString(Json, *BaselinePath) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Root) || !Root.IsValid())
+		{
+			UE_LOG(LivestreamingCameraLog, Error, TEXT("Couldn't read camera benchmark baseline %s"), *BaselinePath)
+			return INDEX_NONE;
+		}
+		if (Root->GetIntegerField(TEXT("Version")) != ResultVersion)
+		{
+			UE_LOG(LivestreamingCameraLog, Error, TEXT("Camera benchmark baseline %s has result version %d, expected %d"), *BaselinePath, Root->GetIntegerField(TEXT("Version")), ResultVersion)
+			return INDEX_NONE;
+		}
+
+		TMap<FString, TSharedPtr<FJsonObject>> Baseline;
+		for (const TSharedPtr<FJsonValue>& Value : Root->GetArrayField(TEXT("Results")))
+		{
+			const TSharedPtr<FJsonObject>& Object = Value->AsObject();
+			Baseline.Add(FString::Printf(TEXT("%d@%dx%d"), Object->GetIntegerField(TEXT("Cameras")), Object->GetIntegerField(TEXT("Width")), Object->GetIntegerField(TEXT("Height"))), Object);
+		}
+
+		// timings below this are dominated by noise, relative changes of them don't count
+		constexpr double MinimumMs = 0.05;
+		int32 Regressions = 0;
+		for (const FBenchmarkRun& Run : Runs)
+		{
+			const TSharedPtr<FJsonObject>* Previous = Baseline.Find(Run.GetKey());
+			if (Previous == nullptr)
+			{
+				UE_LOG(LivestreamingCameraLog, Warning, TEXT("  %s: not in baseline"), *Run.GetKey())
+				continue;
+			}
+
+			const TSharedRef<FJsonObject> Current = RunToJson(Run);
+			for (const TCHAR* Field : { TEXT("GameMsPerCamera"), TEXT("RenderThreadMsPerCamera"), TEXT("GPUMsPerCamera"), TEXT("BytesPerFramePerCamera"), TEXT("MemoryPerCameraMB") })
+			{
+				const double Before = (*Previous)->GetNumberField(Field);
+				const double After = Current->GetNumberField(Field);
+				const bool bTiming = FCString::Strstr(Field, TEXT("Ms")) != nullptr;
+				if (bTiming && FMath::Max(Before, After) < MinimumMs) continue;
+
+				const bool bRegressed = After > Before * (1.0 + Tolerance) && After - Before > (bTiming ? MinimumMs : 0.0);
+				if (bRegressed)
+				{
+					UE_LOG(LivestreamingCameraLog, Error, TEXT("  %s: %s regressed from %.4f to %.4f (%+.1f%%)"), *Run.GetKey(), Field, Before, After, Before > 0.0 ? (After / Before - 1.0) * 100.0 : 100.0)
+					Regressions++;
+				}
+				else
+				{
+					UE_LOG(LivestreamingCameraLog, Display, TEXT("  %s: %s %.4f -> %.4f"), *Run.GetKey(), Field, Before, After)
+				}
+			}
+		}
+		return Regressions;
+	}
+}
+
+UOWLCameraBenchmarkCommandlet::UOWLCameraBenchmarkCommandlet()
+{
+	IsClient = true;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+	ShowErrorCount = true;
+}
+
+int32 UOWLCameraBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString MapName;
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	FString CountsParam = TEXT("1,2,4");
+	FParse::Value(*Params, TEXT("Cameras="), CountsParam);
+	FString ResolutionsParam = TEXT("1280x720,1920x1080,3840x2160");
+	FParse::Value(*Params, TEXT("Resolutions="), ResolutionsParam);
+	int32 Frames = 300;
+	FParse::Value(*Params, TEXT("Frames="), Frames);
+	int32 WarmupFrames = 30;
+	FParse::Value(*Params, TEXT("Warmup="), WarmupFrames);
+	FString OutputBase = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / (TEXT("OWLCameraBenchmark_") + FDateTime::Now().ToString(TEXT("%Y%m%d_%H%M%S")));
+	FParse::Value(*Params, TEXT("Output="), OutputBase);
+	FString BaselinePath;
+	FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+	float Tolerance = 0.1f;
+	FParse::Value(*Params, TEXT("Tolerance="), Tolerance);
+	const bool bDelta = FParse::Param(*Params, TEXT("Delta"));
+
+	const TArray<int32> CameraCounts = ParseCounts(CountsParam);
+	const TArray<FIntPoint> Resolutions = ParseResolutions(ResolutionsParam);
+	Frames = FMath::Max(Frames, 1);
+	WarmupFrames = FMath::Max(WarmupFrames, 0);
+	if (FPaths::GetExtension(OutputBase) == TEXT("json") || FPaths::GetExtension(OutputBase) == TEXT("csv")) OutputBase = FPaths::GetBaseFilename(OutputBase, false);
+	if (CameraCounts.Num() == 0 || Resolutions.Num() == 0)
+	{
+		UE_LOG(LivestreamingCameraLog, Error, TEXT("Camera benchmark: no camera counts or resolutions to run, check -Cameras and -Resolutions"))
+		return 1;
+	}
+
+	UWorld* World = MapName.IsEmpty() ? CreateGeneratedWorld() : LoadWorld(MapName);
+	if (World == nullptr)
+	{
+		UE_LOG(LivestreamingCameraLog, Error, TEXT("Camera benchmark: couldn't load %s"), *MapName)
+		return 1;
+	}
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	// there is no game mode to start play, begin play on the actors directly
+	World->GetWorldSettings()->NotifyBeginPlay();
+
+	UE_LOG(LivestreamingCameraLog, Display, TEXT("Camera benchmark on %s with %s, %d frames per run%s"), MapName.IsEmpty() ? TEXT("generated level") : *MapName,
+		GDynamicRHI != nullptr ? GDynamicRHI->GetName() : TEXT("no RHI"), Frames, bDelta ? TEXT(", delta transport") : TEXT(""))
+
+	const float DeltaSeconds = 1.0f / 60.0f;
+	const TSharedRef<FRenderFrameTiming, ESPMode::ThreadSafe> RenderTiming = MakeShared<FRenderFrameTiming, ESPMode::ThreadSafe>();
+	TArray<FBenchmarkRun> Runs;
+	for (const FIntPoint& Resolution : Resolutions)
+	{
+		for (const int32 NumCameras : CameraCounts)
+		{
+			FBenchmarkRun& Run = Runs.AddDefaulted_GetRef();
+			Run.NumCameras = NumCameras;
+			Run.Resolution = Resolution;
+
+			CollectGarbage(RF_NoFlags);
+			const double MemoryBeforeSpawn = GetUsedMemoryMB();
+
+			TArray<AOWLLivestreamingCamera*> Cameras;
+			for (int32 Index = 0; Index < NumCameras; ++Index)
+			{
+				// fan the cameras out over the level so they don't all see the same primitives
+				const FTransform Transform(FRotator(-10.0f, 360.0f * Index / NumCameras, 0.0f), FVector(0.0f, 0.0f, 400.0f));
+				AOWLLivestreamingCamera* Camera = World->SpawnActorDeferred<AOWLLivestreamingCamera>(AOWLLivestreamingCamera::StaticClass(), Transform);
+				Camera->CameraName = FString::Printf(TEXT("OWLCameraBenchmark%d"), Index);
+				Camera->UseCustomStreamResolution = true;
+				Camera->CustomStreamResolution = Resolution;
+				Camera->DeltaTransportEnabled = bDelta;
+				Camera->FinishSpawning(Transform);
+				Cameras.Add(Camera);
+			}
+
+			for (int32 Frame = 0; Frame < WarmupFrames; ++Frame)
+			{
+				TickFrame(World, DeltaSeconds, RenderTiming);
+			}
+			const double MemoryAfterWarmup = GetUsedMemoryMB();
+			for (AOWLLivestreamingCamera* Camera : Cameras)
+			{
+				USpoutInterface::ResetDeltaStats(Camera->CameraName);
+			}
+
+			for (int32 Frame = 0; Frame < Frames; ++Frame)
+			{
+				Run.GameMs += TickFrame(World, DeltaSeconds, RenderTiming);
+				Run.RenderThreadMs += FPlatformTime::ToMilliseconds64(RenderTiming->EndCycles - RenderTiming->StartCycles);
+				Run.GPUMs += FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles());
+			}
+			Run.MemoryGrowthMB = GetUsedMemoryMB() - MemoryAfterWarmup;
+			Run.MemoryPerCameraMB = (MemoryAfterWarmup - MemoryBeforeSpawn) / NumCameras;
+
+			// delta senders count what they copied, full senders copy the whole output every frame
+			for (AOWLLivestreamingCamera* Camera : Cameras)
+			{
+				FSpoutDeltaStats Stats;
+				if (USpoutInterface::GetDeltaStats(Camera->CameraName, Stats))
+				{
+					// tile comparison readbacks are bandwidth the delta transport spends too
+					Run.BytesSent += double(Stats.BytesSent + Stats.ReadbackBytes) / Frames;
+				}
+				else if (USpoutInterface::IsSpoutOpen() && Camera->GetOutputRenderTarget() != nullptr)
+				{
+					const UTextureRenderTarget2D* Output = Camera->GetOutputRenderTarget();
+					Run.BytesSent += double(Output->SizeX) * Output->SizeY * GPixelFormats[Output->GetFormat()].BlockBytes;
+				}
+				Camera->Destroy();
+			}
+
+			const double Scale = 1.0 / (double(Frames) * NumCameras);
+			Run.GameMs *= Scale;
+			Run.RenderThreadMs *= Scale;
+			Run.GPUMs *= Scale;
+			Run.BytesSent /= NumCameras;
+			UE_LOG(LivestreamingCameraLog, Display, TEXT("  %d x %d, %d cameras: game %.3f ms, render thread %.3f ms, GPU %.3f ms, %.2f MB sent per camera and frame, %.1f MB per camera, %+.1f MB growth"),
+				Resolution.X, Resolution.Y, NumCameras, Run.GameMs, Run.RenderThreadMs, Run.GPUMs, Run.BytesSent / (1024.0 * 1024.0), Run.MemoryPerCameraMB, Run.MemoryGrowthMB)
+		}
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+	FlushRenderingCommands();
+
+	int32 Result = WriteResults(OutputBase, Runs, MapName, Frames, bDelta) ? 0 : 1;
+	if (!BaselinePath.IsEmpty())
+	{
+		UE_LOG(LivestreamingCameraLog, Display, TEXT("Comparing with baseline %s, tolerance %.0f%%"), *BaselinePath, Tolerance * 100.0f)
+		const int32 Regressions = CompareWithBaseline(BaselinePath, Runs, Tolerance);
+		if (Regressions != 0)
+		{
+			UE_LOG(LivestreamingCameraLog, Error, TEXT("Camera benchmark: %s"), Regressions > 0 ? *FString::Printf(TEXT("%d regressions"), Regressions) : TEXT("baseline comparison failed"))
+			Result = 1;
+		}
+	}
+	return Result;
+}
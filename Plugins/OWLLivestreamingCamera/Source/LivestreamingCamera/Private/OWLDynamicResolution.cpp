@@ -0,0 +1,180 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#include "OWLDynamicResolution.h"
+#include "OWLLivestreamingCamera.h"
+#include "LivestreamingCameraModule.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/Engine.h"
+#include "Engine/GameViewportClient.h"
+#include "UnrealClient.h"
+#include "RHI.h"
+
+DECLARE_FLOAT_COUNTER_STAT(TEXT("DynRes GPU Frame (ms)"), STAT_OWLDynResGPUFrameMs, STATGROUP_OWLLivestreaming);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("DynRes GPU Budget (ms)"), STAT_OWLDynResBudgetMs, STATGROUP_OWLLivestreaming);
+DECLARE_DWORD_COUNTER_STAT(TEXT("DynRes Cameras Reduced"), STAT_OWLDynResCamerasReduced, STATGROUP_OWLLivestreaming);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("DynRes Lowest Scale"), STAT_OWLDynResLowestScale, STATGROUP_OWLLivestreaming);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("DynRes Step Downs"), STAT_OWLDynResStepDowns, STATGROUP_OWLLivestreaming);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("DynRes Step Ups"), STAT_OWLDynResStepUps, STATGROUP_OWLLivestreaming);
+
+static TAutoConsoleVariable<float> CVarDynResGPUBudgetMs(
+	TEXT("OWL.DynamicResolution.GPUBudgetMs"),
+	16.6f,
+	TEXT("GPU frame time budget in ms that livestreaming cameras in adaptive resolution mode are scaled against."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarDynResStep(
+	TEXT("OWL.DynamicResolution.Step"),
+	0.1f,
+	TEXT("Resolution scale change per controller decision. Scales are quantised to this step so pooled render targets can be reused."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarDynResHeadroom(
+	TEXT("OWL.DynamicResolution.Headroom"),
+	0.85f,
+	TEXT("Fraction of the budget the GPU frame must drop under before resolution is raised again."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarDynResSettleFrames(
+	TEXT("OWL.DynamicResolution.SettleFrames"),
+	15,
+	TEXT("Frames to wait after a resolution change before the next decision, so the GPU timing reflects the change."),
+	ECVF_Default);
+
+void UOWLDynamicResolutionController::RegisterCamera(AOWLLivestreamingCamera* Camera)
+{
+	Cameras.AddUnique(Camera);
+}
+
+void UOWLDynamicResolutionController::UnregisterCamera(AOWLLivestreamingCamera* Camera)
+{
+	Cameras.Remove(Camera);
+}
+
+float UOWLDynamicResolutionController::GetGPUBudgetMs() const
+{
+	return FMath::Max(CVarDynResGPUBudgetMs.GetValueOnGameThread(), 1.0f);
+}
+
+float UOWLDynamicResolutionController::EstimateCameraGPUMs(AOWLLivestreamingCamera* Camera, float TotalPixels) const
+{
+	if (TotalPixels <= 0.0f) return 0.0f;
+	const FIntPoint Size = Camera->GetEffectiveOutputSize();
+	const float Scale = Camera->GetResolutionScale();
+	return SmoothedGPUFrameMs * (Size.X * Size.Y * Scale * Scale) / TotalPixels;
+}
+
+bool UOWLDynamicResolutionController::StepCamera(AOWLLivestreamingCamera* Camera, float Direction, const TCHAR* Reason)
+{
+	const float Step = FMath::Clamp(CVarDynResStep.GetValueOnGameThread(), 0.01f, 0.5f);
+	const float OldScale = Camera->GetResolutionScale();
+	const float NewScale = FMath::Clamp(OldScale + Direction * Step, FMath::Clamp(Camera->MinResolutionScale, 0.1f, 1.0f), 1.0f);
+	if (FMath::IsNearlyEqual(OldScale, NewScale)) return false;
+
+	Camera->SetResolutionScale(NewScale);
+	UE_LOG(LivestreamingCameraLog, Verbose, TEXT("Dynamic resolution: %s %.2f -> %.2f (%s, GPU %.2f ms / budget %.2f ms)"),
+		*Camera->CameraName, OldScale, Camera->GetResolutionScale(), Reason, SmoothedGPUFrameMs, GetGPUBudgetMs())
+	if (Direction < 0.0f)
+	{
+		INC_DWORD_STAT(STAT_OWLDynResStepDowns);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_OWLDynResStepUps);
+	}
+	return true;
+}
+
+void UOWLDynamicResolutionController::Tick(float DeltaTime)
+{
+	Cameras.RemoveAll([](const TWeakObjectPtr<AOWLLivestreamingCamera>& Camera) { return !Camera.IsValid(); });
+
+	const float GPUFrameMs = FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles());
+	SmoothedGPUFrameMs = SmoothedGPUFrameMs > 0.0f ? FMath::Lerp(SmoothedGPUFrameMs, GPUFrameMs, 0.1f) : GPUFrameMs;
+	const float BudgetMs = GetGPUBudgetMs();
+
+	TArray<AOWLLivestreamingCamera*> Adaptive;
+	float TotalPixels = 0.0f;
+	for (const TWeakObjectPtr<AOWLLivestreamingCamera>& Camera : Cameras)
+	{
+		if (!Camera->DynamicResolutionEnabled || !Camera->GetCameraEnabled()) continue;
+		Adaptive.Add(Camera.Get());
+		const FIntPoint Size = Camera->GetEffectiveOutputSize();
+		TotalPixels += Size.X * Size.Y * FMath::Square(Camera->GetResolutionScale());
+	}
+	UWorld* World = GetWorld();
+	if (World != nullptr && World->GetGameViewport() != nullptr && World->GetGameViewport()->Viewport != nullptr)
+	{
+		const FIntPoint ViewportSize = World->GetGameViewport()->Viewport->GetSizeXY();
+		TotalPixels += ViewportSize.X * ViewportSize.Y;
+	}
+
+	if (++FramesSinceLastChange >= CVarDynResSettleFrames.GetValueOnGameThread() && Adaptive.Num() > 0)
+	{
+		bool bChanged = false;
+
+		// cameras with their own budget are held to it regardless of priority
+		for (AOWLLivestreamingCamera* Camera : Adaptive)
+		{
+			if (Camera->DynamicResolutionGPUBudgetMs > 0.0f && EstimateCameraGPUMs(Camera, TotalPixels) > Camera->DynamicResolutionGPUBudgetMs)
+			{
+				bChanged |= StepCamera(Camera, -1.0f, TEXT("over camera budget"));
+			}
+		}
+
+		if (!bChanged && SmoothedGPUFrameMs > BudgetMs)
+		{
+			// preview feeds degrade first: lowest priority, then the camera with the most pixels left to give
+			Adaptive.Sort([](const AOWLLivestreamingCamera& A, const AOWLLivestreamingCamera& B)
+			{
+				if (A.DynamicResolutionPriority != B.DynamicResolutionPriority) return A.DynamicResolutionPriority < B.DynamicResolutionPriority;
+				return A.GetResolutionScale() > B.GetResolutionScale();
+			});
+			for (AOWLLivestreamingCamera* Camera : Adaptive)
+			{
+				if (StepCamera(Camera, -1.0f, TEXT("over frame budget")))
+				{
+					bChanged = true;
+					break;
+				}
+			}
+		}
+		else if (!bChanged && SmoothedGPUFrameMs < BudgetMs * CVarDynResHeadroom.GetValueOnGameThread())
+		{
+			// the program feed gets its quality back first
+			Adaptive.Sort([](const AOWLLivestreamingCamera& A, const AOWLLivestreamingCamera& B)
+			{
+				if (A.DynamicResolutionPriority != B.DynamicResolutionPriority) return A.DynamicResolutionPriority > B.DynamicResolutionPriority;
+				return A.GetResolutionScale() < B.GetResolutionScale();
+			});
+			for (AOWLLivestreamingCamera* Camera : Adaptive)
+			{
+				const bool bWithinOwnBudget = Camera->DynamicResolutionGPUBudgetMs <= 0.0f
+					|| EstimateCameraGPUMs(Camera, TotalPixels) < Camera->DynamicResolutionGPUBudgetMs * CVarDynResHeadroom.GetValueOnGameThread();
+				if (bWithinOwnBudget && StepCamera(Camera, 1.0f, TEXT("under frame budget")))
+				{
+					bChanged = true;
+					break;
+				}
+			}
+		}
+
+		if (bChanged) FramesSinceLastChange = 0;
+	}
+
+	uint32 CamerasReduced = 0;
+	float LowestScale = 1.0f;
+	for (AOWLLivestreamingCamera* Camera : Adaptive)
+	{
+		if (Camera->GetResolutionScale() < 1.0f) CamerasReduced++;
+		LowestScale = FMath::Min(LowestScale, Camera->GetResolutionScale());
+	}
+	SET_FLOAT_STAT(STAT_OWLDynResGPUFrameMs, SmoothedGPUFrameMs);
+	SET_FLOAT_STAT(STAT_OWLDynResBudgetMs, BudgetMs);
+	SET_DWORD_STAT(STAT_OWLDynResCamerasReduced, CamerasReduced);
+	SET_FLOAT_STAT(STAT_OWLDynResLowestScale, LowestScale);
+}
+
+TStatId UOWLDynamicResolutionController::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOWLDynamicResolutionController, STATGROUP_Tickables);
+}
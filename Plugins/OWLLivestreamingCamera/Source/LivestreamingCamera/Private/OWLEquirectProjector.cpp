@@ -0,0 +1,296 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#include "OWLEquirectProjector.h"
+#include "LivestreamingCameraModule.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/ParallelFor.h"
+#include "Misc/AutomationTest.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Rows per ParallelFor task, enough work per task to hide the scheduling cost
+	constexpr int32 RowsPerTask = 16;
+
+	// Bilinear blend of four BGRA8 texels with 8 bit fixed point weights, one channel at a time
+	FORCEINLINE uint32 BlendTexelsScalar(uint32 T00, uint32 T01, uint32 T10, uint32 T11, uint32 WeightX, uint32 WeightY)
+	{
+		uint32 Result = 0;
+		for (uint32 Shift = 0; Shift < 32; Shift += 8)
+		{
+			const uint32 Top = (((T00 >> Shift) & 0xFF) * (256 - WeightX) + ((T01 >> Shift) & 0xFF) * WeightX) >> 8;
+			const uint32 Bottom = (((T10 >> Shift) & 0xFF) * (256 - WeightX) + ((T11 >> Shift) & 0xFF) * WeightX) >> 8;
+			Result |= ((Top * (256 - WeightY) + Bottom * WeightY) >> 8) << Shift;
+		}
+		return Result;
+	}
+
+	// Same blend as BlendTexelsScalar, all four channels at once where SSE2 is available
+	FORCEINLINE uint32 BlendTexels(uint32 T00, uint32 T01, uint32 T10, uint32 T11, uint32 WeightX, uint32 WeightY)
+	{
+#if PLATFORM_CPU_X86_FAMILY
+		// top and bottom rows side by side in 16 bit lanes, both blended horizontally in one go
+		const __m128i Zero = _mm_setzero_si128();
+		const __m128i Left = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(T00), _mm_cvtsi32_si128(T10)), Zero);
+		const __m128i Right = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(T01), _mm_cvtsi32_si128(T11)), Zero);
+		const __m128i WX = _mm_set1_epi16((int16)WeightX);
+		const __m128i InvWX = _mm_set1_epi16((int16)(256 - WeightX));
+		const __m128i Rows = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(Left, InvWX), _mm_mullo_epi16(Right, WX)), 8);
+
+		const __m128i Bottom = _mm_srli_si128(Rows, 8);
+		const __m128i WY = _mm_set1_epi16((int16)WeightY);
+		const __m128i InvWY = _mm_set1_epi16((int16)(256 - WeightY));
+		const __m128i Blended = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(Rows, InvWY), _mm_mullo_epi16(Bottom, WY)), 8);
+		return (uint32)_mm_cvtsi128_si32(_mm_packus_epi16(Blended, Zero));
+#else
+		return BlendTexelsScalar(T00, T01, T10, T11, WeightX, WeightY);
+#endif
+	}
+
+	// Texel footprint along one axis for a face coordinate in [0, 1], clamped to the face edge
+	FORCEINLINE void GetFootprint(float Coordinate, int32 FaceSize, int32& OutTexel, uint8& OutWeight, uint8& OutStep)
+	{
+		const float Texel = Coordinate * FaceSize - 0.5f;
+		const int32 Texel0 = FMath::FloorToInt(Texel);
+		if (Texel0 < 0)
+		{
+			// a single texel face has no neighbour to step to
+			OutTexel = 0;
+			OutWeight = 0;
+			OutStep = FaceSize > 1 ? 1 : 0;
+		}
+		else if (Texel0 >= FaceSize - 1)
+		{
+			OutTexel = FaceSize - 1;
+			OutWeight = 0;
+			OutStep = 0;
+		}
+		else
+		{
+			OutTexel = Texel0;
+			OutWeight = (uint8)FMath::Clamp(FMath::RoundToInt((Texel - Texel0) * 256.0f), 0, 255);
+			OutStep = 1;
+		}
+	}
+}
+
+FOWLEquirectProjector::FOWLEquirectProjector(int32 InFaceSize, int32 InOutputWidth, int32 InOutputHeight)
+	: FaceSize(FMath::Max(InFaceSize, 1))
+	, OutputWidth(FMath::Max(InOutputWidth, 1))
+	, OutputHeight(FMath::Max(InOutputHeight, 1))
+{
+	LookupTable.SetNumUninitialized(OutputWidth * OutputHeight);
+
+	for (int32 Y = 0; Y < OutputHeight; ++Y)
+	{
+		const float V = (Y + 0.5f) / OutputHeight;
+		for (int32 X = 0; X < OutputWidth; ++X)
+		{
+			const float U = (X + 0.5f) / OutputWidth;
+
+			int32 Face;
+			float FaceU, FaceV;
+			GetFaceCoordinates(GetDirection(U, V), Face, FaceU, FaceV);
+
+			int32 TexelX, TexelY;
+			FLookupEntry& Entry = LookupTable[Y * OutputWidth + X];
+			GetFootprint(FaceU, FaceSize, TexelX, Entry.WeightX, Entry.StepX);
+			GetFootprint(FaceV, FaceSize, TexelY, Entry.WeightY, Entry.StepY);
+			Entry.TexelIndex = uint32(Face * FaceSize + TexelY) * FaceSize + TexelX;
+		}
+	}
+}
+
+FVector FOWLEquirectProjector::GetDirection(float U, float V)
+{
+	const float Longitude = (U - 0.5f) * 2.0f * PI;
+	const float Latitude = (0.5f - V) * PI;
+	const float CosLatitude = FMath::Cos(Latitude);
+	return FVector(CosLatitude * FMath::Cos(Longitude), CosLatitude * FMath::Sin(Longitude), FMath::Sin(Latitude));
+}
+
+void FOWLEquirectProjector::GetFaceCoordinates(const FVector& Direction, int32& OutFace, float& OutU, float& OutV)
+{
+	const float AbsX = FMath::Abs(Direction.X);
+	const float AbsY = FMath::Abs(Direction.Y);
+	const float AbsZ = FMath::Abs(Direction.Z);
+
+	// face selection and orientation as defined for D3D cube maps
+	float MajorAxis, S, T;
+	if (AbsX >= AbsY && AbsX >= AbsZ)
+	{
+		MajorAxis = AbsX;
+		OutFace = Direction.X > 0.0f ? 0 : 1;
+		S = Direction.X > 0.0f ? -Direction.Z : Direction.Z;
+		T = -Direction.Y;
+	}
+	else if (AbsY >= AbsZ)
+	{
+		MajorAxis = AbsY;
+		OutFace = Direction.Y > 0.0f ? 2 : 3;
+		S = Direction.X;
+		T = Direction.Y > 0.0f ? Direction.Z : -Direction.Z;
+	}
+	else
+	{
+		MajorAxis = AbsZ;
+		OutFace = Direction.Z > 0.0f ? 4 : 5;
+		S = Direction.Z > 0.0f ? Direction.X : -Direction.X;
+		T = -Direction.Y;
+	}
+
+	OutU = FMath::Clamp((S / MajorAxis + 1.0f) * 0.5f, 0.0f, 1.0f);
+	OutV = FMath::Clamp((T / MajorAxis + 1.0f) * 0.5f, 0.0f, 1.0f);
+}
+
+void FOWLEquirectProjector::ProjectRows(const uint32* Faces, uint32* Output, int32 FirstRow, int32 NumRows) const
+{
+	const int32 LastRow = FMath::Min(FirstRow + NumRows, OutputHeight);
+	const uint32 RowStep = FaceSize;
+	for (int32 Y = FirstRow; Y < LastRow; ++Y)
+	{
+		const FLookupEntry* Entry = LookupTable.GetData() + Y * OutputWidth;
+		uint32* OutputRow = Output + Y * OutputWidth;
+		for (int32 X = 0; X < OutputWidth; ++X, ++Entry)
+		{
+			const uint32* Texel = Faces + Entry->TexelIndex;
+			const uint32* TexelBelow = Texel + Entry->StepY * RowStep;
+			OutputRow[X] = BlendTexels(Texel[0], Texel[Entry->StepX], TexelBelow[0], TexelBelow[Entry->StepX], Entry->WeightX, Entry->WeightY);
+		}
+	}
+}
+
+void FOWLEquirectProjector::Project(const uint32* Faces, uint32* Output, bool bParallel) const
+{
+	if (!bParallel)
+	{
+		ProjectRows(Faces, Output, 0, OutputHeight);
+		return;
+	}
+
+	const int32 NumTasks = FMath::DivideAndRoundUp(OutputHeight, RowsPerTask);
+	ParallelFor(NumTasks, [this, Faces, Output](int32 Task)
+	{
+		ProjectRows(Faces, Output, Task * RowsPerTask, RowsPerTask);
+	});
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOWLEquirectProjectorTest, "OWL.Equirect.VectorMatchesScalar", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FOWLEquirectProjectorTest::RunTest(const FString& Parameters)
+{
+	// the fixed point blend fits 16 bit lanes without overflow, so both kernels must agree bit for bit
+	FRandomStream Random(29);
+	int32 BlendMismatches = 0;
+	for (uint32 WeightY = 0; WeightY < 256; ++WeightY)
+	{
+		for (uint32 WeightX = 0; WeightX < 256; WeightX += 3)
+		{
+			const uint32 T00 = (uint32)Random.GetUnsignedInt();
+			const uint32 T01 = (uint32)Random.GetUnsignedInt();
+			const uint32 T10 = WeightY & 1 ? 0xFFFFFFFF : (uint32)Random.GetUnsignedInt();
+			const uint32 T11 = WeightX & 1 ? 0x00000000 : (uint32)Random.GetUnsignedInt();
+			BlendMismatches += BlendTexels(T00, T01, T10, T11, WeightX, WeightY) != BlendTexelsScalar(T00, T01, T10, T11, WeightX, WeightY);
+		}
+	}
+	TestEqual(TEXT("Blended texels differing between the vector and scalar kernels"), BlendMismatches, 0);
+
+	// whole projection through the lookup table against a per pixel scalar reference on a fixed cube, and on a cube of
+	// single texel faces where every footprint has to stay on its one texel
+	const int32 Width = 128;
+	const int32 Height = 64;
+	for (const int32 FaceSize : { 32, 1 })
+	{
+		TArray<uint32> Faces;
+		Faces.SetNumUninitialized(6 * FaceSize * FaceSize);
+		for (int32 Index = 0; Index < Faces.Num(); ++Index)
+		{
+			Faces[Index] = (uint32)Random.GetUnsignedInt();
+		}
+		TArray<uint32> Output;
+		Output.SetNumZeroed(Width * Height);
+		const FOWLEquirectProjector Projector(FaceSize, Width, Height);
+		Projector.Project(Faces.GetData(), Output.GetData(), true);
+
+		int32 PixelMismatches = 0;
+		int32 FootprintsOffFace = 0;
+		for (int32 Y = 0; Y < Height; ++Y)
+		{
+			for (int32 X = 0; X < Width; ++X)
+			{
+				int32 Face;
+				float FaceU, FaceV;
+				FOWLEquirectProjector::GetFaceCoordinates(FOWLEquirectProjector::GetDirection((X + 0.5f) / Width, (Y + 0.5f) / Height), Face, FaceU, FaceV);
+
+				int32 TexelX, TexelY;
+				uint8 WeightX, WeightY, StepX, StepY;
+				GetFootprint(FaceU, FaceSize, TexelX, WeightX, StepX);
+				GetFootprint(FaceV, FaceSize, TexelY, WeightY, StepY);
+				FootprintsOffFace += TexelX + StepX >= FaceSize || TexelY + StepY >= FaceSize;
+				const uint32* Texel = Faces.GetData() + (Face * FaceSize + TexelY) * FaceSize + TexelX;
+				const uint32* TexelBelow = Texel + StepY * FaceSize;
+				PixelMismatches += Output[Y * Width + X] != BlendTexelsScalar(Texel[0], Texel[StepX], TexelBelow[0], TexelBelow[StepX], WeightX, WeightY);
+			}
+		}
+		TestEqual(FString::Printf(TEXT("Projected pixels differing from the scalar reference with %d texel faces"), FaceSize), PixelMismatches, 0);
+		TestEqual(FString::Printf(TEXT("Footprints reaching past the face edge with %d texel faces"), FaceSize), FootprintsOffFace, 0);
+	}
+
+	// the centre column looks down +X, face 0
+	int32 CentreFace;
+	float CentreU, CentreV;
+	FOWLEquirectProjector::GetFaceCoordinates(FOWLEquirectProjector::GetDirection(0.5f, 0.5f), CentreFace, CentreU, CentreV);
+	TestEqual(TEXT("Face sampled by the centre of the image"), CentreFace, 0);
+	TestTrue(TEXT("Centre of the image samples the centre of the +X face"), FMath::IsNearlyEqual(CentreU, 0.5f, 1e-4f) && FMath::IsNearlyEqual(CentreV, 0.5f, 1e-4f));
+	return true;
+}
+
+#endif
+
+static FAutoConsoleCommand EquirectBenchmarkCommand(
+	TEXT("OWL.Equirect.BenchmarkCPU"),
+	TEXT("Times the CPU cube to equirectangular projection. Arguments: [Width=4096] [Height=2048] [Iterations=20]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		const int32 Width = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 4) : 4096;
+		const int32 Height = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 2) : 2048;
+		const int32 Iterations = Args.Num() > 2 ? FMath::Max(FCString::Atoi(*Args[2]), 1) : 20;
+		const int32 FaceSize = Width / 4;
+
+		// distinct gradient per face so a broken lookup shows up when the output is inspected
+		TArray<uint32> Faces;
+		Faces.SetNumUninitialized(6 * FaceSize * FaceSize);
+		for (int32 Index = 0; Index < Faces.Num(); ++Index)
+		{
+			const int32 Face = Index / (FaceSize * FaceSize);
+			const int32 X = Index % FaceSize;
+			const int32 Y = (Index / FaceSize) % FaceSize;
+			Faces[Index] = 0xFF000000 | ((Face * 40) << 16) | ((Y * 255 / FaceSize) << 8) | (X * 255 / FaceSize);
+		}
+		TArray<uint32> Output;
+		Output.SetNumUninitialized(Width * Height);
+
+		double StartTime = FPlatformTime::Seconds();
+		const FOWLEquirectProjector Projector(FaceSize, Width, Height);
+		const double BuildMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		const double Megapixels = Width * Height / 1000000.0;
+		for (const bool bParallel : { false, true })
+		{
+			Projector.Project(Faces.GetData(), Output.GetData(), bParallel);
+			StartTime = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				Projector.Project(Faces.GetData(), Output.GetData(), bParallel);
+			}
+			const double FrameMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+			UE_LOG(LivestreamingCameraLog, Display, TEXT("Equirect CPU %d x %d from %d faces (%s): %.2f ms/frame, %.1f Mpix/s"),
+				Width, Height, FaceSize, bParallel ? TEXT("parallel") : TEXT("single thread"), FrameMs, Megapixels / (FrameMs / 1000.0))
+		}
+		UE_LOG(LivestreamingCameraLog, Display, TEXT("Equirect lookup table: %.2f ms to build, %.1f MB"), BuildMs, Projector.GetLookupTableBytes() / (1024.0 * 1024.0))
+	}));
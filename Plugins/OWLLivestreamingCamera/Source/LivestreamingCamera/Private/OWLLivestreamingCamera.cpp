@@ -2,6 +2,12 @@
 
 #include "OWLLivestreamingCamera.h"
 #include "LivestreamingCameraModule.h"
+#include "OWLRenderTargetPool.h"
+#include "OWLDynamicResolution.h"
+#include "OWLBatchedCapture.h"
+#include "Engine/Canvas.h"
+#include "CanvasItem.h"
+#include "CubemapUnwrapUtils.h"
 #include "USpout/Public/SpoutInterface.h"
 #include "UObject/ConstructorHelpers.h"
 #include "Components/PostProcessComponent.h"
@@ -22,6 +28,10 @@ AOWLLivestreamingCamera::AOWLLivestreamingCamera(const FObjectInitializer& Objec
 	DummyRoot = CreateDefaultSubobject<USceneComponent>(TEXT("RootComponent"));
 	RootComponent = DummyRoot;
 	CaptureComponent = CreateCaptureComponent(ObjectInitializer);
+	CubeCaptureComponent = CreateDefaultSubobject<USceneCaptureComponentCube>(TEXT("CaptureComponentCubeCamera"));
+	CubeCaptureComponent->SetupAttachment(DummyRoot);
+	CubeCaptureComponent->bCaptureRotation = true;
+	CubeCaptureComponent->bAutoActivate = false;
 	CameraName = GetFName().ToString();
 
 	// set up a default camera for when this camera component is possessed
@@ -75,9 +85,36 @@ void AOWLLivestreamingCamera::SetCameraEnabled(bool NewCameraEnabled)
 	if (!NewCameraEnabled)
 	{
 		USpoutInterface::CloseSender(CameraName);
-		CaptureComponent->Deactivate();
+		ActivateCaptureComponents();
+		ReturnRenderTarget();
 	}
-	else CaptureComponent->Activate(false);
+	else
+	{
+		if (HasActorBegunPlay() || IsActorBeginningPlay()) LeaseRenderTarget(GetEffectiveOutputSize());
+		ActivateCaptureComponents();
+	}
+}
+
+void AOWLLivestreamingCamera::SetCaptureMode(ELivestreamCaptureMode NewCaptureMode)
+{
+	CaptureMode = NewCaptureMode;
+	ActivateCaptureComponents();
+	UpdateScaledCaptureTarget();
+}
+
+ELivestreamCaptureMode AOWLLivestreamingCamera::GetCaptureMode()
+{
+	return CaptureMode;
+}
+
+// Only the capture component of the current mode renders, and only while the camera is enabled
+void AOWLLivestreamingCamera::ActivateCaptureComponents()
+{
+	if (CameraEnabled && !IsCapturing360() && !bCapturedByBatch) CaptureComponent->Activate(false);
+	else CaptureComponent->Deactivate();
+
+	if (CameraEnabled && IsCapturing360()) CubeCaptureComponent->Activate(false);
+	else CubeCaptureComponent->Deactivate();
 }
 
 bool AOWLLivestreamingCamera::GetCameraEnabled()
@@ -85,6 +122,68 @@ bool AOWLLivestreamingCamera::GetCameraEnabled()
 	return CameraEnabled;
 }
 
+void AOWLLivestreamingCamera::SetDeltaTransportEnabled(bool NewDeltaTransportEnabled)
+{
+	DeltaTransportEnabled = NewDeltaTransportEnabled;
+}
+
+bool AOWLLivestreamingCamera::GetDeltaTransportEnabled()
+{
+	return DeltaTransportEnabled;
+}
+
+float AOWLLivestreamingCamera::GetDeltaBandwidthSaved()
+{
+	FSpoutDeltaStats Stats;
+	if (!USpoutInterface::GetDeltaStats(CameraName, Stats)) return 0.0f;
+	return Stats.GetSavedFraction();
+}
+
+void AOWLLivestreamingCamera::SetDynamicResolutionEnabled(bool NewDynamicResolutionEnabled)
+{
+	DynamicResolutionEnabled = NewDynamicResolutionEnabled;
+	if (!DynamicResolutionEnabled) SetResolutionScale(1.0f);
+
+	UOWLDynamicResolutionController* Controller = GetWorld() != nullptr ? GetWorld()->GetSubsystem<UOWLDynamicResolutionController>() : nullptr;
+	if (Controller == nullptr || !(HasActorBegunPlay() || IsActorBeginningPlay())) return;
+	if (DynamicResolutionEnabled) Controller->RegisterCamera(this);
+	else Controller->UnregisterCamera(this);
+}
+
+void AOWLLivestreamingCamera::SetBatchedCaptureEnabled(bool NewBatchedCaptureEnabled)
+{
+	BatchedCaptureEnabled = NewBatchedCaptureEnabled;
+
+	UOWLBatchedCaptureSubsystem* Subsystem = GetWorld() != nullptr ? GetWorld()->GetSubsystem<UOWLBatchedCaptureSubsystem>() : nullptr;
+	if (Subsystem == nullptr || !(HasActorBegunPlay() || IsActorBeginningPlay())) return;
+	if (BatchedCaptureEnabled) Subsystem->RegisterCamera(this);
+	else Subsystem->UnregisterCamera(this);
+}
+
+bool AOWLLivestreamingCamera::GetBatchedCaptureEnabled()
+{
+	return BatchedCaptureEnabled;
+}
+
+void AOWLLivestreamingCamera::SetCapturedByBatch(bool bNewCapturedByBatch)
+{
+	bCapturedByBatch = bNewCapturedByBatch;
+	ActivateCaptureComponents();
+}
+
+float AOWLLivestreamingCamera::GetResolutionScale() const
+{
+	return ResolutionScale;
+}
+
+void AOWLLivestreamingCamera::SetResolutionScale(float NewResolutionScale)
+{
+	NewResolutionScale = FMath::Clamp(NewResolutionScale, 0.1f, 1.0f);
+	if (FMath::IsNearlyEqual(NewResolutionScale, ResolutionScale)) return;
+	ResolutionScale = NewResolutionScale;
+	UpdateScaledCaptureTarget();
+}
+
 void AOWLLivestreamingCamera::SetFOVAngle(float NewFOVAngle)
 {
 	FOVAngle = NewFOVAngle;
@@ -191,6 +290,7 @@ void AOWLLivestreamingCamera::SetPrimitiveRenderMode(ESceneCapturePrimitiveRende
 {
 	PrimitiveRenderMode = NewPrimitiveRenderMode;
 	CaptureComponent->PrimitiveRenderMode = PrimitiveRenderMode;
+	CubeCaptureComponent->PrimitiveRenderMode = PrimitiveRenderMode;
 }
 
 ESceneCapturePrimitiveRenderMode AOWLLivestreamingCamera::GetPrimitiveRenderMode()
@@ -213,6 +313,7 @@ void AOWLLivestreamingCamera::SetbCaptureEveryFrame(uint8 NewbCaptureEveryFrame)
 {
 	bCaptureEveryFrame = NewbCaptureEveryFrame;
 	CaptureComponent->bCaptureEveryFrame = bCaptureEveryFrame;
+	CubeCaptureComponent->bCaptureEveryFrame = bCaptureEveryFrame;
 }
 
 uint8 AOWLLivestreamingCamera::GetbCaptureEveryFrame()
@@ -224,6 +325,7 @@ void AOWLLivestreamingCamera::SetbCaptureOnMovement(uint8 NewbCaptureOnMovement)
 {
 	bCaptureOnMovement = NewbCaptureOnMovement;
 	CaptureComponent->bCaptureOnMovement = bCaptureOnMovement;
+	CubeCaptureComponent->bCaptureOnMovement = bCaptureOnMovement;
 }
 
 uint8 AOWLLivestreamingCamera::GetbCaptureOnMovement()
@@ -246,6 +348,7 @@ void AOWLLivestreamingCamera::SetHiddenActors(TArray<AActor*> NewHiddenActors)
 {
 	HiddenActors = NewHiddenActors;
 	CaptureComponent->HiddenActors = HiddenActors;
+	CubeCaptureComponent->HiddenActors = HiddenActors;
 }
 
 TArray<AActor*> AOWLLivestreamingCamera::GetHiddenActors()
@@ -257,6 +360,7 @@ void AOWLLivestreamingCamera::SetShowOnlyActors(TArray<AActor*> NewShowOnlyActor
 {
 	ShowOnlyActors = NewShowOnlyActors;
 	CaptureComponent->ShowOnlyActors = ShowOnlyActors;
+	CubeCaptureComponent->ShowOnlyActors = ShowOnlyActors;
 }
 
 TArray<AActor*> AOWLLivestreamingCamera::GetShowOnlyActors()
@@ -268,6 +372,7 @@ void AOWLLivestreamingCamera::SetLODDistanceFactor(float NewLODDistanceFactor)
 {
 	LODDistanceFactor = NewLODDistanceFactor;
 	CaptureComponent->LODDistanceFactor = LODDistanceFactor;
+	CubeCaptureComponent->LODDistanceFactor = LODDistanceFactor;
 }
 
 float AOWLLivestreamingCamera::GetLODDistanceFactor()
@@ -279,6 +384,7 @@ void AOWLLivestreamingCamera::SetMaxViewDistanceOverride(float NewMaxViewDistanc
 {
 	MaxViewDistanceOverride = NewMaxViewDistanceOverride;
 	CaptureComponent->MaxViewDistanceOverride = MaxViewDistanceOverride;
+	CubeCaptureComponent->MaxViewDistanceOverride = MaxViewDistanceOverride;
 }
 
 float AOWLLivestreamingCamera::GetMaxViewDistanceOverride()
@@ -308,10 +414,120 @@ USceneCaptureComponent2DNoMesh* AOWLLivestreamingCamera::CreateCaptureComponent(
 void AOWLLivestreamingCamera::ResizeToMatchStreamResolution(FIntPoint OutputSize)
 {
 	if (GetWorld() == nullptr || !GetWorld()->HasBegunPlay()) return;
+	if (OutputRenderTarget == nullptr) return;
 	// no need to recreate RT if we are already in the right resolution
-	if (CaptureComponent->TextureTarget->SizeX == OutputSize.X && CaptureComponent->TextureTarget->SizeY == OutputSize.Y) return;
+	if (OutputRenderTarget->SizeX == OutputSize.X && OutputRenderTarget->SizeY == OutputSize.Y) return;
 	UE_LOG(LivestreamingCameraLog, Warning, TEXT("Setting output texture to %d x %d"), OutputSize.X, OutputSize.Y)
-	CaptureComponent->TextureTarget->ResizeTarget(OutputSize.X, OutputSize.Y);
+	// swap for a pooled render target of the new size rather than reallocating this one
+	ReturnRenderTarget();
+	LeaseRenderTarget(OutputSize);
+}
+
+void AOWLLivestreamingCamera::LeaseRenderTarget(FIntPoint OutputSize)
+{
+	if (OutputRenderTarget != nullptr) return;
+	UOWLRenderTargetPool* Pool = GetWorld() != nullptr ? GetWorld()->GetSubsystem<UOWLRenderTargetPool>() : nullptr;
+	if (Pool == nullptr) return;
+	OutputRenderTarget = Pool->Lease(this, OutputSize, RenderTargetFormat, 2.2f);
+	CaptureComponent->TextureTarget = OutputRenderTarget;
+	UpdateScaledCaptureTarget();
+}
+
+void AOWLLivestreamingCamera::ReturnRenderTarget()
+{
+	UOWLRenderTargetPool* Pool = GetWorld() != nullptr ? GetWorld()->GetSubsystem<UOWLRenderTargetPool>() : nullptr;
+	if (Pool != nullptr)
+	{
+		Pool->Return(OutputRenderTarget);
+		Pool->Return(ScaledCaptureTarget);
+	}
+	OutputRenderTarget = nullptr;
+	ScaledCaptureTarget = nullptr;
+	CaptureComponent->TextureTarget = nullptr;
+	CubeCaptureComponent->TextureTarget = nullptr;
+	if (CubeRenderTarget != nullptr) CubeRenderTarget->ReleaseResource();
+	CubeRenderTarget = nullptr;
+}
+
+// Points the capture at a reduced size render target while scaled down, or straight at the output otherwise
+void AOWLLivestreamingCamera::UpdateScaledCaptureTarget()
+{
+	if (OutputRenderTarget == nullptr) return;
+	UOWLRenderTargetPool* Pool = GetWorld() != nullptr ? GetWorld()->GetSubsystem<UOWLRenderTargetPool>() : nullptr;
+	if (Pool == nullptr) return;
+	UpdateCubeCaptureTarget();
+
+	const FIntPoint ScaledSize(
+		FMath::Max(FMath::RoundToInt(OutputRenderTarget->SizeX * ResolutionScale), 1),
+		FMath::Max(FMath::RoundToInt(OutputRenderTarget->SizeY * ResolutionScale), 1));
+
+	if (ScaledCaptureTarget != nullptr && (ResolutionScale >= 1.0f || IsCapturing360() || ScaledCaptureTarget->SizeX != ScaledSize.X || ScaledCaptureTarget->SizeY != ScaledSize.Y))
+	{
+		Pool->Return(ScaledCaptureTarget);
+		ScaledCaptureTarget = nullptr;
+	}
+	if (ResolutionScale < 1.0f && ScaledCaptureTarget == nullptr && !IsCapturing360())
+	{
+		ScaledCaptureTarget = Pool->Lease(this, ScaledSize, RenderTargetFormat, 2.2f);
+	}
+	CaptureComponent->TextureTarget = ScaledCaptureTarget != nullptr ? ScaledCaptureTarget : OutputRenderTarget;
+}
+
+// Stretches the reduced resolution capture over the output render target
+void AOWLLivestreamingCamera::UpscaleToOutput()
+{
+	if (ScaledCaptureTarget == nullptr || OutputRenderTarget == nullptr) return;
+
+	UCanvas* Canvas = nullptr;
+	FVector2D CanvasSize;
+	FDrawToRenderTargetContext Context;
+	UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(this, OutputRenderTarget, Canvas, CanvasSize, Context);
+	if (Canvas != nullptr)
+	{
+		Canvas->K2_DrawTexture(ScaledCaptureTarget, FVector2D::ZeroVector, CanvasSize, FVector2D::ZeroVector, FVector2D::UnitVector, FLinearColor::White, BLEND_Opaque);
+	}
+	UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(this, Context);
+}
+
+// Face size follows the output resolution (and the dynamic resolution scale) so the projection is close to 1:1
+void AOWLLivestreamingCamera::UpdateCubeCaptureTarget()
+{
+	if (!IsCapturing360() || OutputRenderTarget == nullptr)
+	{
+		CubeCaptureComponent->TextureTarget = nullptr;
+		if (CubeRenderTarget != nullptr) CubeRenderTarget->ReleaseResource();
+		CubeRenderTarget = nullptr;
+		return;
+	}
+
+	const int32 FaceSize = FMath::Max(FMath::RoundToInt(FMath::Max(OutputRenderTarget->SizeX / 4, OutputRenderTarget->SizeY / 2) * ResolutionScale), 16);
+	if (CubeRenderTarget == nullptr || CubeRenderTarget->SizeX != FaceSize)
+	{
+		if (CubeRenderTarget != nullptr) CubeRenderTarget->ReleaseResource();
+		CubeRenderTarget = NewObject<UTextureRenderTargetCube>(this);
+		CubeRenderTarget->Init(FaceSize, PF_FloatRGBA);
+		CubeRenderTarget->UpdateResourceImmediate(true);
+	}
+	CubeCaptureComponent->TextureTarget = CubeRenderTarget;
+}
+
+// Unwraps the cube faces onto the output render target on the GPU with the engine's long-lat cubemap shader
+void AOWLLivestreamingCamera::ProjectCubeToOutput()
+{
+	if (CubeRenderTarget == nullptr || CubeRenderTarget->Resource == nullptr || OutputRenderTarget == nullptr) return;
+
+	UCanvas* Canvas = nullptr;
+	FVector2D CanvasSize;
+	FDrawToRenderTargetContext Context;
+	UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(this, OutputRenderTarget, Canvas, CanvasSize, Context);
+	if (Canvas != nullptr)
+	{
+		FCanvasTileItem TileItem(FVector2D::ZeroVector, CubeRenderTarget->Resource, CanvasSize, FLinearColor::White);
+		TileItem.BlendMode = SE_BLEND_Opaque;
+		TileItem.BatchedElementParameters = new FMipLevelBatchedElementParameters(0.0f);
+		Canvas->DrawItem(TileItem);
+	}
+	UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(this, Context);
 }
 
 FIntPoint AOWLLivestreamingCamera::GetEffectiveOutputSize()
@@ -388,6 +604,7 @@ void AOWLLivestreamingCamera::SetTemporalAA(bool EnableTemporalAA)
 {
 	TemporalAAEnabled = EnableTemporalAA;
 	CaptureComponent->ShowFlags.SetTemporalAA(TemporalAAEnabled);
+	CubeCaptureComponent->ShowFlags.SetTemporalAA(TemporalAAEnabled);
 }
 
 bool AOWLLivestreamingCamera::GetTemportalAAEnabled()
@@ -399,6 +616,7 @@ void AOWLLivestreamingCamera::SetTAAMotionBlur(bool EnableTAAMotionBlur)
 {
 	TAAMotionBlurEnabled = EnableTAAMotionBlur;
 	CaptureComponent->ShowFlags.SetMotionBlur(TAAMotionBlurEnabled);
+	CubeCaptureComponent->ShowFlags.SetMotionBlur(TAAMotionBlurEnabled);
 }
 
 bool AOWLLivestreamingCamera::GetTAAMotionBlurEnabled()
@@ -545,6 +763,26 @@ void AOWLLivestreamingCamera::PostEditChangeProperty(FPropertyChangedEvent& Prop
 		SetCameraEnabled(CameraEnabled);
 		return;
 	}
+	if (PropertyName == GET_MEMBER_NAME_CHECKED(AOWLLivestreamingCamera, CaptureMode))
+	{
+		SetCaptureMode(CaptureMode);
+		return;
+	}
+	if (PropertyName == GET_MEMBER_NAME_CHECKED(AOWLLivestreamingCamera, DeltaTransportEnabled))
+	{
+		SetDeltaTransportEnabled(DeltaTransportEnabled);
+		return;
+	}
+	if (PropertyName == GET_MEMBER_NAME_CHECKED(AOWLLivestreamingCamera, BatchedCaptureEnabled))
+	{
+		SetBatchedCaptureEnabled(BatchedCaptureEnabled);
+		return;
+	}
+	if (PropertyName == GET_MEMBER_NAME_CHECKED(AOWLLivestreamingCamera, DynamicResolutionEnabled))
+	{
+		SetDynamicResolutionEnabled(DynamicResolutionEnabled);
+		return;
+	}
 }
 #endif
 
@@ -554,16 +792,22 @@ void AOWLLivestreamingCamera::BeginPlay()
 	Super::BeginPlay();
 	FIntPoint OutputSize = GetEffectiveOutputSize();
 
-	CaptureComponent->TextureTarget = UKismetRenderingLibrary::CreateRenderTarget2D(GetWorld(), OutputSize.X, OutputSize.Y, RenderTargetFormat);
-	CaptureComponent->TextureTarget->TargetGamma = 2.2f;
+	// render targets are leased from the world's pool and only held while the camera is enabled
+	if (CameraEnabled) LeaseRenderTarget(OutputSize);
 	ResizeToMatchStreamResolution(OutputSize);
 	SetAllCameraSettingsInternal();
+	SetDynamicResolutionEnabled(DynamicResolutionEnabled);
+	SetBatchedCaptureEnabled(BatchedCaptureEnabled);
 }
 
 void AOWLLivestreamingCamera::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 	USpoutInterface::CloseSender(CameraName);
+	LogDeltaStats();
+	if (UOWLDynamicResolutionController* Controller = GetWorld()->GetSubsystem<UOWLDynamicResolutionController>()) Controller->UnregisterCamera(this);
+	if (UOWLBatchedCaptureSubsystem* Subsystem = GetWorld()->GetSubsystem<UOWLBatchedCaptureSubsystem>()) Subsystem->UnregisterCamera(this);
+	ReturnRenderTarget();
 }
 
 // Called every frame
@@ -575,7 +819,20 @@ void AOWLLivestreamingCamera::Tick(float DeltaTime)
 
 void AOWLLivestreamingCamera::RenderFrame()
 {
-	if(CameraEnabled) USpoutInterface::Sender(CameraName, CaptureComponent->TextureTarget);
+	if (!CameraEnabled || OutputRenderTarget == nullptr) return;
+	if (IsCapturing360()) ProjectCubeToOutput();
+	else UpscaleToOutput();
+	USpoutInterface::Sender(CameraName, OutputRenderTarget, DeltaTransportEnabled);
+}
+
+void AOWLLivestreamingCamera::LogDeltaStats()
+{
+	FSpoutDeltaStats Stats;
+	if (!USpoutInterface::GetDeltaStats(CameraName, Stats) || Stats.FramesSent == 0) return;
+
+	UE_LOG(LivestreamingCameraLog, Display, TEXT("%s delta transport: %llu frames, %.1f MB sent and %.1f MB read back of %.1f MB, %.1f%% bandwidth saved"),
+		*CameraName, Stats.FramesSent, Stats.BytesSent / (1024.0 * 1024.0), Stats.ReadbackBytes / (1024.0 * 1024.0), Stats.FullFrameBytes / (1024.0 * 1024.0), Stats.GetSavedFraction() * 100.0f);
+	USpoutInterface::ResetDeltaStats(CameraName);
 }
 
 void AOWLLivestreamingCamera::SetAllCameraSettingsInternal()
@@ -602,4 +859,5 @@ void AOWLLivestreamingCamera::SetAllCameraSettingsInternal()
 	SetbUseRayTracingIfEnabled(bUseRayTracingIfEnabled);
 	SetTAAMotionBlur(TAAMotionBlurEnabled);
 	SetTemporalAA(TemporalAAEnabled);
+	SetCaptureMode(CaptureMode);
 }
@@ -0,0 +1,188 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#include "OWLRenderTargetPool.h"
+#include "LivestreamingCameraModule.h"
+#include "USpout/Public/SpoutInterface.h"
+#include "Kismet/KismetRenderingLibrary.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pooled RTs Leased"), STAT_OWLPooledRTsLeased, STATGROUP_OWLLivestreaming);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pooled RTs Free"), STAT_OWLPooledRTsFree, STATGROUP_OWLLivestreaming);
+DECLARE_MEMORY_STAT(TEXT("Pooled RT Memory Leased"), STAT_OWLPooledRTMemoryLeased, STATGROUP_OWLLivestreaming);
+DECLARE_MEMORY_STAT(TEXT("Pooled RT Memory Free"), STAT_OWLPooledRTMemoryFree, STATGROUP_OWLLivestreaming);
+
+static TAutoConsoleVariable<float> CVarRenderTargetPoolIdleSeconds(
+	TEXT("OWL.RenderTargetPool.IdleSeconds"),
+	10.0f,
+	TEXT("Seconds a returned livestreaming camera render target stays pooled before it is released."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorld DumpRenderTargetPoolCommand(
+	TEXT("OWL.RenderTargetPool.Dump"),
+	TEXT("Logs the render targets and Spout shared textures pooled for livestreaming cameras."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (World == nullptr) return;
+		if (UOWLRenderTargetPool* Pool = World->GetSubsystem<UOWLRenderTargetPool>()) Pool->DumpToLog();
+	}));
+
+uint64 UOWLRenderTargetPool::GetRenderTargetBytes(const UTextureRenderTarget2D* RenderTarget)
+{
+	const FPixelFormatInfo& FormatInfo = GPixelFormats[RenderTarget->GetFormat()];
+	return uint64(RenderTarget->SizeX) * RenderTarget->SizeY * FormatInfo.BlockBytes / (FormatInfo.BlockSizeX * FormatInfo.BlockSizeY);
+}
+
+UTextureRenderTarget2D* UOWLRenderTargetPool::Lease(UObject* Lessee, FIntPoint Size, ETextureRenderTargetFormat Format, float TargetGamma)
+{
+	for (FOWLPooledRenderTarget& Entry : Entries)
+	{
+		if (!Entry.Lessee.IsValid()
+			&& Entry.RenderTarget != nullptr
+			&& Entry.RenderTarget->SizeX == Size.X
+			&& Entry.RenderTarget->SizeY == Size.Y
+			&& Entry.RenderTarget->RenderTargetFormat == Format)
+		{
+			Entry.Lessee = Lessee;
+			Entry.ReturnedTime = 0.0;
+			Entry.RenderTarget->TargetGamma = TargetGamma;
+			UE_LOG(LivestreamingCameraLog, Verbose, TEXT("Reusing pooled %d x %d render target for %s"), Size.X, Size.Y, *GetNameSafe(Lessee))
+			return Entry.RenderTarget;
+		}
+	}
+
+	UTextureRenderTarget2D* RenderTarget = UKismetRenderingLibrary::CreateRenderTarget2D(GetWorld(), Size.X, Size.Y, Format);
+	if (RenderTarget == nullptr) return nullptr;
+	RenderTarget->TargetGamma = TargetGamma;
+
+	FOWLPooledRenderTarget& Entry = Entries.AddDefaulted_GetRef();
+	Entry.RenderTarget = RenderTarget;
+	Entry.Lessee = Lessee;
+	return RenderTarget;
+}
+
+void UOWLRenderTargetPool::Return(UTextureRenderTarget2D* RenderTarget)
+{
+	if (RenderTarget == nullptr) return;
+
+	for (FOWLPooledRenderTarget& Entry : Entries)
+	{
+		if (Entry.RenderTarget == RenderTarget)
+		{
+			Entry.Lessee = nullptr;
+			Entry.ReturnedTime = FPlatformTime::Seconds();
+			return;
+		}
+	}
+}
+
+void UOWLRenderTargetPool::Trim(float MaxIdleSeconds)
+{
+	const double Now = FPlatformTime::Seconds();
+	for (int32 Index = Entries.Num() - 1; Index >= 0; --Index)
+	{
+		FOWLPooledRenderTarget& Entry = Entries[Index];
+		if (Entry.RenderTarget == nullptr)
+		{
+			Entries.RemoveAtSwap(Index);
+			continue;
+		}
+		// a lessee that was destroyed without returning its lease counts as returned now
+		if (!Entry.Lessee.IsValid() && Entry.ReturnedTime == 0.0)
+		{
+			Entry.ReturnedTime = Now;
+		}
+		if (!Entry.Lessee.IsValid() && Now - Entry.ReturnedTime > MaxIdleSeconds)
+		{
+			UE_LOG(LivestreamingCameraLog, Verbose, TEXT("Releasing idle %d x %d pooled render target"), Entry.RenderTarget->SizeX, Entry.RenderTarget->SizeY)
+			Entry.RenderTarget->ReleaseResource();
+			Entry.RenderTarget->MarkPendingKill();
+			Entries.RemoveAtSwap(Index);
+		}
+	}
+}
+
+void UOWLRenderTargetPool::CountEntries(uint32& OutLeased, uint32& OutFree, uint64& OutLeasedBytes, uint64& OutFreeBytes) const
+{
+	OutLeased = OutFree = 0;
+	OutLeasedBytes = OutFreeBytes = 0;
+	for (const FOWLPooledRenderTarget& Entry : Entries)
+	{
+		if (Entry.RenderTarget == nullptr) continue;
+		if (Entry.Lessee.IsValid())
+		{
+			OutLeased++;
+			OutLeasedBytes += GetRenderTargetBytes(Entry.RenderTarget);
+		}
+		else
+		{
+			OutFree++;
+			OutFreeBytes += GetRenderTargetBytes(Entry.RenderTarget);
+		}
+	}
+}
+
+FOWLRenderTargetPoolStats UOWLRenderTargetPool::GetPoolStats() const
+{
+	FOWLRenderTargetPoolStats Stats;
+	uint32 Leased, Free;
+	uint64 LeasedBytes, FreeBytes;
+	CountEntries(Leased, Free, LeasedBytes, FreeBytes);
+	Stats.LeasedRenderTargets = Leased;
+	Stats.FreeRenderTargets = Free;
+	Stats.LeasedMB = LeasedBytes / (1024.0f * 1024.0f);
+	Stats.FreeMB = FreeBytes / (1024.0f * 1024.0f);
+
+	uint64 FreeSharedBytes = 0;
+	USpoutInterface::GetSharedTexturePoolStats(Stats.SharedTexturesInUse, Stats.FreeSharedTextures, FreeSharedBytes);
+	Stats.FreeSharedTextureMB = FreeSharedBytes / (1024.0f * 1024.0f);
+	return Stats;
+}
+
+void UOWLRenderTargetPool::DumpToLog() const
+{
+	UE_LOG(LivestreamingCameraLog, Display, TEXT("Livestreaming camera render target pool (%s):"), *GetWorld()->GetName())
+	for (const FOWLPooledRenderTarget& Entry : Entries)
+	{
+		if (Entry.RenderTarget == nullptr) continue;
+		UE_LOG(LivestreamingCameraLog, Display, TEXT("  %4d x %4d %-12s %7.1f MB  %s"),
+			Entry.RenderTarget->SizeX, Entry.RenderTarget->SizeY,
+			GPixelFormats[Entry.RenderTarget->GetFormat()].Name,
+			GetRenderTargetBytes(Entry.RenderTarget) / (1024.0f * 1024.0f),
+			Entry.Lessee.IsValid() ? *Entry.Lessee->GetName() : TEXT("<free>"))
+	}
+
+	const FOWLRenderTargetPoolStats Stats = GetPoolStats();
+	UE_LOG(LivestreamingCameraLog, Display, TEXT("  Leased: %d (%.1f MB)  Free: %d (%.1f MB)"), Stats.LeasedRenderTargets, Stats.LeasedMB, Stats.FreeRenderTargets, Stats.FreeMB)
+	UE_LOG(LivestreamingCameraLog, Display, TEXT("  Spout shared textures in use: %d  pooled: %d (%.1f MB)"), Stats.SharedTexturesInUse, Stats.FreeSharedTextures, Stats.FreeSharedTextureMB)
+}
+
+void UOWLRenderTargetPool::Deinitialize()
+{
+	for (FOWLPooledRenderTarget& Entry : Entries)
+	{
+		if (Entry.RenderTarget != nullptr) Entry.RenderTarget->ReleaseResource();
+	}
+	Entries.Empty();
+	Super::Deinitialize();
+}
+
+void UOWLRenderTargetPool::Tick(float DeltaTime)
+{
+	Trim(CVarRenderTargetPoolIdleSeconds.GetValueOnGameThread());
+
+#if STATS
+	uint32 Leased, Free;
+	uint64 LeasedBytes, FreeBytes;
+	CountEntries(Leased, Free, LeasedBytes, FreeBytes);
+	INC_DWORD_STAT_BY(STAT_OWLPooledRTsLeased, Leased);
+	INC_DWORD_STAT_BY(STAT_OWLPooledRTsFree, Free);
+	SET_MEMORY_STAT(STAT_OWLPooledRTMemoryLeased, LeasedBytes);
+	SET_MEMORY_STAT(STAT_OWLPooledRTMemoryFree, FreeBytes);
+#endif
+}
+
+TStatId UOWLRenderTargetPool::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOWLRenderTargetPool, STATGROUP_Tickables);
+}
@@ -3,6 +3,10 @@
 #include "OWLSpoutReceiver.h"
 #include "LivestreamingCameraModule.h"
 #include "USpout/Public/SpoutInterface.h"
+#include "USpout/Public/SpoutFrameSignal.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Async/Async.h"
 #include "UObject/ConstructorHelpers.h"
 #include "Components/PostProcessComponent.h"
 #include "Kismet/KismetRenderingLibrary.h"
@@ -23,12 +27,94 @@ TStatId FReceiverTickHelper::GetStatId() const
 	RETURN_QUICK_DECLARE_CYCLE_STAT(FReceiverTickHelper, STATGROUP_Tickables);
 }
 
+struct FReceiverFrameStats
+{
+	TAtomic<uint64> FramesReceived{ 0 };
+	TAtomic<uint64> DuplicateFrames{ 0 };
+	TAtomic<uint64> MissedFrames{ 0 };
+
+	/* Counts the sender frames between two arrivals that were overwritten before they could be copied */
+	void RecordMissed(uint64 LastCount, uint64 Count)
+	{
+		// the count restarts from 0 when the sender is recreated
+		if (LastCount != 0 && Count > LastCount + 1) MissedFrames += Count - LastCount - 1;
+	}
+};
+
+// Waits for the sender's frame signal and hands each published frame to the game thread, so copies follow the sender
+// rather than the tick rate. The copy is issued on the game thread, after any resize of the render target and only while
+// the receiver still exists, this thread never touches the render target.
+class FReceiverFrameWaiter : public FRunnable
+{
+public:
+	FReceiverFrameWaiter(const FString& InSenderName, AOWLSpoutReceiver* InOwner)
+		: SenderName(InSenderName)
+		, Owner(InOwner)
+		, bDispatchPending(MakeShared<TAtomic<bool>, ESPMode::ThreadSafe>(false))
+	{
+		Signal.Watch(SenderName);
+		Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("SpoutReceiverWaiter_%s"), *SenderName), 0, TPri_AboveNormal);
+	}
+
+	virtual ~FReceiverFrameWaiter()
+	{
+		if (Thread != nullptr)
+		{
+			Thread->Kill(true);
+			delete Thread;
+		}
+	}
+
+	/* False while the sender doesn't publish a frame count, the tick keeps copying in that case */
+	bool IsConnected() const { return bConnected; }
+
+	/* Latest frame count the sender published */
+	uint64 GetLatestCount() const { return LatestCount; }
+
+	virtual uint32 Run() override
+	{
+		while (!bStopping)
+		{
+			const uint64 Count = Signal.Wait(LatestCount, WaitTimeoutMs);
+			bConnected = Count != 0;
+			if (Count == 0 || Count == LatestCount) continue;
+			LatestCount = Count;
+
+			// one game thread task at a time, it copies the latest frame when it runs
+			if (bDispatchPending->Exchange(true)) continue;
+			AsyncTask(ENamedThreads::GameThread, [WeakOwner = Owner, Pending = bDispatchPending]()
+			{
+				*Pending = false;
+				if (WeakOwner.IsValid()) WeakOwner->ReceiveArrivedFrame();
+			});
+		}
+		return 0;
+	}
+
+	virtual void Stop() override { bStopping = true; }
+
+private:
+	// bounds the time a wake up shared with other receivers of the same sender can be missed for
+	static constexpr uint32 WaitTimeoutMs = 4;
+
+	FString SenderName;
+	TWeakObjectPtr<AOWLSpoutReceiver> Owner;
+	TSharedRef<TAtomic<bool>, ESPMode::ThreadSafe> bDispatchPending;
+	FSpoutFrameSignal Signal;
+	FRunnableThread* Thread = nullptr;
+	TAtomic<uint64> LatestCount{ 0 };
+	TAtomic<bool> bStopping{ false };
+	TAtomic<bool> bConnected{ false };
+};
+
 // Sets default values
 AOWLSpoutReceiver::AOWLSpoutReceiver(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
 	DummyRoot = CreateDefaultSubobject<USceneComponent>(TEXT("RootComponent"));
 	RootComponent = DummyRoot;
+	FrameStats = MakeShared<FReceiverFrameStats>();
+	PendingCopies = MakeShared<TAtomic<int32>, ESPMode::ThreadSafe>(0);
 }
 
 void AOWLSpoutReceiver::OnLevelActorDeleted(AActor* DestroyedActor)
@@ -66,6 +152,7 @@ void AOWLSpoutReceiver::PostInitProperties()
 
 void AOWLSpoutReceiver::BeginDestroy()
 {
+	ResetFrameScheduling();
 #if WITH_EDITOR
 	if (GEngine)
 	{
@@ -91,6 +178,7 @@ void AOWLSpoutReceiver::SetReceiverActive(bool ActivateReceiver)
 	else
 	{
 		USpoutInterface::CloseReceiver(ReceiverName);
+		ResetFrameScheduling();
 		TickHelper.Owner = NULL;
 		UE_LOG(LivestreamingCameraLog, Warning, TEXT("Receiver %s deactivated"), *ReceiverName)
 	}
@@ -110,6 +198,7 @@ UTextureRenderTarget2D* AOWLSpoutReceiver::GetRenderTarget()
 void AOWLSpoutReceiver::SetReceiverName(FString NewReceiverName)
 {
 	if (ReceiverActive) USpoutInterface::CloseReceiver(ReceiverName);
+	ResetFrameScheduling();
 	ReceiverName = NewReceiverName;
 	OldReceiverName = NewReceiverName;
 }
@@ -119,6 +208,40 @@ FString AOWLSpoutReceiver::GetReceiverName()
 	return ReceiverName;
 }
 
+void AOWLSpoutReceiver::SetReceivePolicy(ESpoutReceivePolicy NewReceivePolicy)
+{
+	ReceivePolicy = NewReceivePolicy;
+	if (ReceivePolicy != ESpoutReceivePolicy::RP_EveryFrame) FrameWaiter.Reset();
+	// the tick didn't see the frames the waiter copied
+	LastFrameCount = 0;
+}
+
+ESpoutReceivePolicy AOWLSpoutReceiver::GetReceivePolicy()
+{
+	return ReceivePolicy;
+}
+
+void AOWLSpoutReceiver::GetFrameStats(int64& FramesReceived, int64& DuplicateFrames, int64& MissedFrames)
+{
+	FramesReceived = FrameStats->FramesReceived;
+	DuplicateFrames = FrameStats->DuplicateFrames;
+	MissedFrames = FrameStats->MissedFrames;
+}
+
+void AOWLSpoutReceiver::ResetFrameStats()
+{
+	FrameStats->FramesReceived = 0;
+	FrameStats->DuplicateFrames = 0;
+	FrameStats->MissedFrames = 0;
+}
+
+void AOWLSpoutReceiver::ResetFrameScheduling()
+{
+	FrameWaiter.Reset();
+	FrameSignal.Reset();
+	LastFrameCount = 0;
+}
+
 #if WITH_EDITOR
 void AOWLSpoutReceiver::PostEditChangeProperty(FPropertyChangedEvent& Prop)
 {
@@ -138,6 +261,10 @@ void AOWLSpoutReceiver::PostEditChangeProperty(FPropertyChangedEvent& Prop)
 	{
 		SetRenderTarget(RenderTarget);
 	}
+	if (PropertyName == GET_MEMBER_NAME_CHECKED(AOWLSpoutReceiver, ReceivePolicy))
+	{
+		SetReceivePolicy(ReceivePolicy);
+	}
 }
 #endif
 
@@ -150,8 +277,63 @@ void AOWLSpoutReceiver::BeginPlay()
 
 void AOWLSpoutReceiver::RenderFrame()
 {
-	if (RenderTarget != nullptr && ReceiverName != FString::FString(""))
+	if (RenderTarget == nullptr || ReceiverName == FString::FString("")) return;
+	if (!USpoutInterface::UpdateReceiverTarget(ReceiverName, RenderTarget, Force_RGBA8_SRGB)) return;
+
+	if (ReceivePolicy == ESpoutReceivePolicy::RP_EveryFrame)
+	{
+		if (!FrameWaiter.IsValid()) FrameWaiter = MakeShared<FReceiverFrameWaiter>(ReceiverName, this);
+		if (FrameWaiter->IsConnected())
+		{
+			// picks up a frame whose copy was held back while the previous one was in flight
+			CopyArrivedFrame();
+			return;
+		}
+	}
+
+	if (!FrameSignal.IsValid())
 	{
-		USpoutInterface::Receiver(ReceiverName, RenderTarget, Force_RGBA8_SRGB);
+		FrameSignal = MakeShared<FSpoutFrameSignal>();
+		FrameSignal->Watch(ReceiverName);
 	}
+
+	// senders without a frame count are copied every tick
+	const uint64 Count = FrameSignal->Poll();
+	if (Count != 0)
+	{
+		if (Count == LastFrameCount)
+		{
+			FrameStats->DuplicateFrames++;
+			return;
+		}
+		FrameStats->RecordMissed(LastFrameCount, Count);
+		LastFrameCount = Count;
+	}
+	FrameStats->FramesReceived++;
+	USpoutInterface::ReceiveFrame(ReceiverName, RenderTarget);
+}
+
+void AOWLSpoutReceiver::ReceiveArrivedFrame()
+{
+	check(IsInGameThread());
+	if (!ReceiverActive || RenderTarget == nullptr || ReceiverName == FString::FString("")) return;
+	if (ReceivePolicy != ESpoutReceivePolicy::RP_EveryFrame || !FrameWaiter.IsValid()) return;
+	// the render target may have been resized for the sender since the last tick
+	if (!USpoutInterface::UpdateReceiverTarget(ReceiverName, RenderTarget, Force_RGBA8_SRGB)) return;
+	CopyArrivedFrame();
+}
+
+void AOWLSpoutReceiver::CopyArrivedFrame()
+{
+	const uint64 Count = FrameWaiter->GetLatestCount();
+	if (Count == 0 || Count == LastFrameCount) return;
+
+	// a copy that hasn't run yet will pick up this frame instead of the one it was issued for, copy it afterwards
+	if (*PendingCopies > 0) return;
+
+	FrameStats->RecordMissed(LastFrameCount, Count);
+	LastFrameCount = Count;
+	FrameStats->FramesReceived++;
+	(*PendingCopies)++;
+	USpoutInterface::ReceiveFrame(ReceiverName, RenderTarget, [Pending = PendingCopies]() { (*Pending)--; });
 }
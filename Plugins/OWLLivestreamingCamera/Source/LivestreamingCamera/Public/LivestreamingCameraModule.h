@@ -4,8 +4,10 @@
 
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
+#include "Stats/Stats.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LivestreamingCameraLog, Log, All);
+DECLARE_STATS_GROUP(TEXT("OWL Livestreaming"), STATGROUP_OWLLivestreaming, STATCAT_Advanced);
 
 class FLivestreamingCameraModule : public IModuleInterface
 {
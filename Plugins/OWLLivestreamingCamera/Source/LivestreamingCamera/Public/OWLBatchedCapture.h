@@ -0,0 +1,68 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "OWLBatchedCapture.generated.h"
+
+class AOWLLivestreamingCamera;
+
+/*
+ * Renders all batched livestreaming cameras of a world as views of a single scene view family.
+ * Scene captures normally each run their own scene renderer, one view family per camera. Rendering the cameras
+ * as split screen style views into a shared atlas lets the renderer do family level work once per frame
+ * (scene and GPU scene updates, shadow setup and the whole scene shadow depths of local lights, light grid)
+ * instead of once per camera. Each view's rect is then copied into the camera's capture render target.
+ * Cameras only batch with cameras that agree on the family wide settings (capture source, show flags),
+ * anything else keeps its own scene capture.
+ */
+UCLASS()
+class LIVESTREAMINGCAMERA_API UOWLBatchedCaptureSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	void RegisterCamera(AOWLLivestreamingCamera* Camera);
+	void UnregisterCamera(AOWLLivestreamingCamera* Camera);
+
+	/* Spawns 2, 4 and 8 cameras at the current view and logs frame timings with and without batching */
+	void StartBenchmark(int32 FramesPerRun);
+
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Cameras.Num() > 0 || Benchmark.IsValid(); }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+private:
+	struct FBatch
+	{
+		TArray<AOWLLivestreamingCamera*> Cameras;
+		TArray<FIntPoint> Offsets;
+		FIntPoint AtlasSize = FIntPoint::ZeroValue;
+	};
+
+	struct FBenchmarkState;
+
+	/* Cameras that can share one view family have the same key */
+	static uint32 GetBatchKey(AOWLLivestreamingCamera* Camera);
+	static bool CanBatch(AOWLLivestreamingCamera* Camera);
+	static void PackAtlas(FBatch& Batch);
+	void RenderBatch(const FBatch& Batch, UTextureRenderTarget2D* Atlas);
+	void SetBatched(AOWLLivestreamingCamera* Camera, bool bBatched);
+	void ReleaseAtlases(int32 FirstAtlas);
+	void TickBenchmark();
+
+	TArray<TWeakObjectPtr<AOWLLivestreamingCamera>> Cameras;
+	TSet<TWeakObjectPtr<AOWLLivestreamingCamera>> BatchedCameras;
+
+	UPROPERTY(Transient)
+	TArray<UTextureRenderTarget2D*> Atlases;
+
+	TSharedPtr<FBenchmarkState> Benchmark;
+};
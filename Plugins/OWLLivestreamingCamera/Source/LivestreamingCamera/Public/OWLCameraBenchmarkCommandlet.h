@@ -0,0 +1,31 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "OWLCameraBenchmarkCommandlet.generated.h"
+
+/*
+ * Measures the cost of livestreaming cameras for every combination of camera count and stream resolution.
+ * Each run spawns the cameras into the benchmark level, ticks the world for a fixed number of frames and records
+ * game, render thread and GPU time per camera, bytes sent through Spout and memory. Results are written as JSON
+ * and CSV and can be compared against an earlier JSON result, the commandlet then fails if anything regressed.
+ *
+ * UE4Editor-Cmd.exe Project.uproject -run=OWLCameraBenchmark [-Map=/Game/Maps/Bench] [-Cameras=1,2,4]
+ *     [-Resolutions=1280x720,1920x1080] [-Frames=300] [-Warmup=30] [-Delta] [-Output=Path/Result]
+ *     [-Baseline=Path/Result.json] [-Tolerance=0.1]
+ *
+ * Commandlets run without an RHI, which is enough to check the game thread side. Pass -AllowCommandletRendering
+ * to render with the real RHI. Without -Map a generated grid of cubes is used.
+ */
+UCLASS()
+class LIVESTREAMINGCAMERA_API UOWLCameraBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UOWLCameraBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
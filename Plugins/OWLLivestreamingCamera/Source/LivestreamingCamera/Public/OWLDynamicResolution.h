@@ -0,0 +1,49 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "OWLDynamicResolution.generated.h"
+
+class AOWLLivestreamingCamera;
+
+/*
+ * Per world controller that trades capture resolution of livestreaming cameras for GPU time.
+ * When the GPU frame time goes over budget the lowest priority camera is stepped down first, when there is
+ * headroom again the highest priority camera is stepped back up. Cameras with their own budget are stepped down
+ * whenever their estimated share of the frame goes over it. Output stays at the advertised stream resolution,
+ * the camera upscales the reduced capture.
+ */
+UCLASS()
+class LIVESTREAMINGCAMERA_API UOWLDynamicResolutionController : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	void RegisterCamera(AOWLLivestreamingCamera* Camera);
+	void UnregisterCamera(AOWLLivestreamingCamera* Camera);
+
+	/* Smoothed GPU frame time the controller is working with */
+	UFUNCTION(BlueprintCallable, Category = "Off World Live Dynamic Resolution")
+	float GetSmoothedGPUFrameMs() const { return SmoothedGPUFrameMs; }
+
+	UFUNCTION(BlueprintCallable, Category = "Off World Live Dynamic Resolution")
+	float GetGPUBudgetMs() const;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Cameras.Num() > 0; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+private:
+	/* Rough per camera GPU cost, the frame time split by rendered pixels between the viewport and all captures */
+	float EstimateCameraGPUMs(AOWLLivestreamingCamera* Camera, float TotalPixels) const;
+	bool StepCamera(AOWLLivestreamingCamera* Camera, float Direction, const TCHAR* Reason);
+
+	TArray<TWeakObjectPtr<AOWLLivestreamingCamera>> Cameras;
+	float SmoothedGPUFrameMs = 0.0f;
+	int32 FramesSinceLastChange = 0;
+};
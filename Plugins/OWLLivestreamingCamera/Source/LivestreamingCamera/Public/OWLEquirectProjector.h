@@ -0,0 +1,53 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+ * CPU reference for the 360 capture mode, projects six BGRA8 cube faces to an equirectangular image.
+ * The cube face, texel and bilinear weights of every output pixel are resolved once into a lookup table,
+ * projecting a frame only gathers four texels per pixel and blends them (SSE2 where available).
+ * Faces are stored back to back in D3D order (+X, -X, +Y, -Y, +Z, -Z) and addressed like a TextureCube
+ * sampled with a world space direction. The centre column of the output looks down +X.
+ */
+class LIVESTREAMINGCAMERA_API FOWLEquirectProjector
+{
+public:
+	FOWLEquirectProjector(int32 InFaceSize, int32 InOutputWidth, int32 InOutputHeight);
+
+	/* Faces holds 6 * FaceSize * FaceSize texels, Output OutputWidth * OutputHeight texels */
+	void Project(const uint32* Faces, uint32* Output, bool bParallel = true) const;
+
+	/* Projects output rows [FirstRow, FirstRow + NumRows) */
+	void ProjectRows(const uint32* Faces, uint32* Output, int32 FirstRow, int32 NumRows) const;
+
+	/* World space view direction of a point of the equirectangular image, U and V in [0, 1] */
+	static FVector GetDirection(float U, float V);
+
+	/* Cube face and face coordinates in [0, 1] a direction samples */
+	static void GetFaceCoordinates(const FVector& Direction, int32& OutFace, float& OutU, float& OutV);
+
+	int32 GetFaceSize() const { return FaceSize; }
+	int32 GetOutputWidth() const { return OutputWidth; }
+	int32 GetOutputHeight() const { return OutputHeight; }
+	SIZE_T GetLookupTableBytes() const { return LookupTable.GetAllocatedSize(); }
+
+private:
+	struct FLookupEntry
+	{
+		/* Top left texel of the bilinear footprint */
+		uint32 TexelIndex;
+		/* Weight of the right and bottom texels, 0-255 */
+		uint8 WeightX;
+		uint8 WeightY;
+		/* 0 where the footprint is clamped to the face edge */
+		uint8 StepX;
+		uint8 StepY;
+	};
+
+	int32 FaceSize;
+	int32 OutputWidth;
+	int32 OutputHeight;
+	TArray<FLookupEntry> LookupTable;
+};
@@ -6,6 +6,8 @@
 #include "GameFramework/Actor.h"
 #include "Engine/TextureRenderTarget2D.h"
 #include "SceneCaptureComponent2DNoMesh.h"
+#include "Components/SceneCaptureComponentCube.h"
+#include "Engine/TextureRenderTargetCube.h"
 #include "Engine/Scene.h"
 #include "OWLLivestreamingCamera.generated.h"
 
@@ -30,6 +32,15 @@ enum class EStreamResolution : uint8 {
 	RS_4K UMETA(DisplayName = "4K"),
 };
 
+/* Projection of the camera output */
+UENUM(BlueprintType)
+enum class ELivestreamCaptureMode : uint8 {
+	/* Regular perspective view */
+	CM_Standard UMETA(DisplayName = "Standard"),
+	/* Full 360 degree view in equirectangular projection, use a 2:1 stream resolution */
+	CM_Equirectangular360 UMETA(DisplayName = "360 Equirectangular"),
+};
+
 UCLASS()
 class LIVESTREAMINGCAMERA_API AOWLLivestreamingCamera : public AActor
 {
@@ -45,7 +56,7 @@ public:
 	FString Support = FString("Please visit our website.");
 
 	UPROPERTY(VisibleAnywhere, Category = "Version and Support", meta = (MultiLine = "true"))
-	FString NotIncluded = FString("360 Camera, Audience Interactivity Tools.");
+	FString NotIncluded = FString("Audience Interactivity Tools.");
 
 	UPROPERTY(VisibleAnywhere, Category = "Version and Support", meta = (MultiLine = "true"))
 	FString PluginVersion = FString("");
@@ -79,6 +90,9 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Off World Live Livestreaming Camera Settings")
 	FIntPoint GetEffectiveOutputSize();
 
+	/* Render target sent to Spout, null while the camera is disabled */
+	UTextureRenderTarget2D* GetOutputRenderTarget() const { return OutputRenderTarget; }
+
 	/* Texture resolution for camera render output */
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Off World Live Livestreaming Camera Settings", meta = (DisplayPriority = "2"))
 	bool UseCustomStreamResolution = false;
@@ -109,6 +123,68 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Off World Live Livestreaming Camera Settings")
 	FIntPoint GetCustomStreamResolution();
 
+	/* Standard perspective output or a 360 equirectangular feed for VR viewers */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Off World Live Livestreaming Camera Settings", meta = (DisplayPriority = "2"))
+	ELivestreamCaptureMode CaptureMode = ELivestreamCaptureMode::CM_Standard;
+
+	UFUNCTION(BlueprintCallable, Category = "Off World Live Livestreaming Camera Settings")
+	void SetCaptureMode(ELivestreamCaptureMode NewCaptureMode);
+
+	UFUNCTION(BlueprintCallable, Category = "Off World Live Livestreaming Camera Settings")
+	ELivestreamCaptureMode GetCaptureMode();
+
+	/* Only send the 64x64 tiles that changed since the previous frame. Saves bandwidth for mostly static shots. */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Off World Live Livestreaming Camera Settings", meta = (DisplayPriority = "3"))
+	bool DeltaTransportEnabled = false;
+
+	UFUNCTION(BlueprintCallable, Category = "Off World Live Livestreaming Camera Settings")
+	void SetDeltaTransportEnabled(bool NewDeltaTransportEnabled);
+
+	UFUNCTION(BlueprintCallable, Category = "Off World Live Livestreaming Camera Settings")
+	bool GetDeltaTransportEnabled();
+
+	/* Fraction (0-1) of the full frame bandwidth the delta transport saved since it was enabled */
+	UFUNCTION(BlueprintCallable, Category = "Off World Live Livestreaming Camera Settings")
+	float GetDeltaBandwidthSaved();
+
+	/* Render this camera together with the other batched cameras as views of one scene render, sharing per frame scene setup and shadow work */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Off World Live Livestreaming Camera Settings", meta = (DisplayPriority = "3"))
+	bool BatchedCaptureEnabled = false;
+
+	UFUNCTION(BlueprintCallable, Category = "Off World Live Livestreaming Camera Settings")
+	void SetBatchedCaptureEnabled(bool NewBatchedCaptureEnabled);
+
+	UFUNCTION(BlueprintCallable, Category = "Off World Live Livestreaming Camera Settings")
+	bool GetBatchedCaptureEnabled();
+
+	/* Called by the batched capture subsystem, the camera's own scene capture is paused while the batch renders it */
+	void SetCapturedByBatch(bool bNewCapturedByBatch);
+
+	/* Lower the capture resolution when the GPU is over budget. Output stays at the stream resolution via upscaling. */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Off World Live Dynamic Resolution")
+	bool DynamicResolutionEnabled = false;
+
+	UFUNCTION(BlueprintCallable, Category = "Off World Live Dynamic Resolution")
+	void SetDynamicResolutionEnabled(bool NewDynamicResolutionEnabled);
+
+	/* Higher priority cameras keep their resolution longer, give the program feed the highest priority */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Off World Live Dynamic Resolution", meta = (editcondition = "DynamicResolutionEnabled"))
+	int32 DynamicResolutionPriority = 0;
+
+	/* Lowest fraction of the stream resolution the capture may drop to */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Off World Live Dynamic Resolution", meta = (editcondition = "DynamicResolutionEnabled", ClampMin = "0.1", ClampMax = "1.0"))
+	float MinResolutionScale = 0.5f;
+
+	/* Optional GPU budget for this camera in ms, 0 only uses the global OWL.DynamicResolution.GPUBudgetMs */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Off World Live Dynamic Resolution", meta = (editcondition = "DynamicResolutionEnabled", ClampMin = "0.0"))
+	float DynamicResolutionGPUBudgetMs = 0.0f;
+
+	/* Fraction of the stream resolution the capture currently renders at */
+	UFUNCTION(BlueprintCallable, Category = "Off World Live Dynamic Resolution")
+	float GetResolutionScale() const;
+
+	void SetResolutionScale(float NewResolutionScale);
+
 	///////////////// Scene Capture 2D Interface ////////////////////
 	/** Camera field of view (in degrees). */
 	UPROPERTY(interp, EditAnywhere, Category = SceneCapture, meta = (DisplayName = "Field of View", UIMin = "5.0", UIMax = "170", ClampMin = "0.001", ClampMax = "360.0"))
@@ -334,6 +410,10 @@ public:
 	UPROPERTY()
 	USceneCaptureComponent2DNoMesh* CaptureComponent = nullptr;
 
+	/* Renders the six faces for the 360 capture mode */
+	UPROPERTY()
+	USceneCaptureComponentCube* CubeCaptureComponent = nullptr;
+
 	/* A camera to show the preview in the viewport */
 	UPROPERTY()
 	class UCameraComponent* Camera = nullptr;
@@ -360,8 +440,28 @@ private:
 	USceneComponent* DummyRoot = nullptr;
 	USceneCaptureComponent2DNoMesh* CreateCaptureComponent(const FObjectInitializer& ObjectInitializer);
 	void ResizeToMatchStreamResolution(FIntPoint OutputSize);
+	void LeaseRenderTarget(FIntPoint OutputSize);
+	void ReturnRenderTarget();
+	void UpdateScaledCaptureTarget();
+	void UpscaleToOutput();
+	void UpdateCubeCaptureTarget();
+	void ProjectCubeToOutput();
+	void ActivateCaptureComponents();
+	bool IsCapturing360() const { return CaptureMode == ELivestreamCaptureMode::CM_Equirectangular360; }
+	/* Render target sent to Spout, always at the stream resolution */
+	UPROPERTY(Transient)
+	UTextureRenderTarget2D* OutputRenderTarget = nullptr;
+	/* Reduced resolution capture target while dynamic resolution has scaled this camera down */
+	UPROPERTY(Transient)
+	UTextureRenderTarget2D* ScaledCaptureTarget = nullptr;
+	/* Cube faces of the 360 capture mode, projected onto the output render target every frame */
+	UPROPERTY(Transient)
+	UTextureRenderTargetCube* CubeRenderTarget = nullptr;
+	float ResolutionScale = 1.0f;
+	bool bCapturedByBatch = false;
 	FIntPoint GetResolutionFromEnum(EStreamResolution Res);
 	void RenderFrame();
+	void LogDeltaStats();
 	void SetAllCameraSettingsInternal();
 	FString OldCameraName;
 };
@@ -0,0 +1,91 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "OWLRenderTargetPool.generated.h"
+
+USTRUCT()
+struct FOWLPooledRenderTarget
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UTextureRenderTarget2D* RenderTarget = nullptr;
+
+	/* Object currently holding the lease, null while the render target is free */
+	UPROPERTY()
+	TWeakObjectPtr<UObject> Lessee;
+
+	double ReturnedTime = 0.0;
+};
+
+/* VRAM accounting of the render target pool and the pooled Spout shared textures */
+USTRUCT(BlueprintType)
+struct FOWLRenderTargetPoolStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Off World Live Render Target Pool")
+	int32 LeasedRenderTargets = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Off World Live Render Target Pool")
+	int32 FreeRenderTargets = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Off World Live Render Target Pool")
+	float LeasedMB = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Off World Live Render Target Pool")
+	float FreeMB = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Off World Live Render Target Pool")
+	int32 SharedTexturesInUse = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Off World Live Render Target Pool")
+	int32 FreeSharedTextures = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Off World Live Render Target Pool")
+	float FreeSharedTextureMB = 0.0f;
+};
+
+/*
+ * Per world pool of capture render targets keyed by size and format.
+ * Livestreaming cameras lease a render target while enabled and hand it back when disabled, so disabled
+ * cameras don't hold on to VRAM. Free render targets are released after OWL.RenderTargetPool.IdleSeconds.
+ */
+UCLASS()
+class LIVESTREAMINGCAMERA_API UOWLRenderTargetPool : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UTextureRenderTarget2D* Lease(UObject* Lessee, FIntPoint Size, ETextureRenderTargetFormat Format, float TargetGamma);
+	void Return(UTextureRenderTarget2D* RenderTarget);
+
+	/* Releases free render targets that have not been leased for MaxIdleSeconds */
+	void Trim(float MaxIdleSeconds);
+
+	UFUNCTION(BlueprintCallable, Category = "Off World Live Render Target Pool")
+	FOWLRenderTargetPoolStats GetPoolStats() const;
+
+	void DumpToLog() const;
+
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Entries.Num() > 0; }
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+private:
+	static uint64 GetRenderTargetBytes(const UTextureRenderTarget2D* RenderTarget);
+	void CountEntries(uint32& OutLeased, uint32& OutFree, uint64& OutLeasedBytes, uint64& OutFreeBytes) const;
+
+	UPROPERTY()
+	TArray<FOWLPooledRenderTarget> Entries;
+};
@@ -9,6 +9,19 @@
 #include "OWLSpoutReceiver.generated.h"
 
 
+/* When the receiver copies the sender's shared texture */
+UENUM(BlueprintType)
+enum class ESpoutReceivePolicy : uint8 {
+	/* Copy once per tick if the sender published a frame since the last copy, frames in between are skipped */
+	RP_LatestOnly UMETA(DisplayName = "Latest Only"),
+	/* Copy every frame as soon as the sender publishes it, independent of the tick rate */
+	RP_EveryFrame UMETA(DisplayName = "Every Frame")
+};
+
+struct FReceiverFrameStats;
+class FReceiverFrameWaiter;
+class FSpoutFrameSignal;
+
 struct FReceiverTickHelper : FTickableGameObject
 {
 	TWeakObjectPtr<class AOWLSpoutReceiver> Owner;
@@ -37,6 +50,9 @@ public:
 
 	virtual void TickMe(float DeltaTime);
 
+	/* Game thread, copies the frame the waiter thread saw arriving for the every frame policy */
+	void ReceiveArrivedFrame();
+
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Off World Live Spout Receiver Settings")
 	bool ReceiverActive = false;
 
@@ -62,6 +78,24 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Off World Live Spout Receiver Settings")
 	FString GetReceiverName();
 
+	/* Senders of this plugin announce new frames, other senders are copied every tick */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Off World Live Spout Receiver Settings")
+	ESpoutReceivePolicy ReceivePolicy = ESpoutReceivePolicy::RP_LatestOnly;
+
+	UFUNCTION(BlueprintCallable, Category = "Off World Live Spout Receiver Settings")
+	void SetReceivePolicy(ESpoutReceivePolicy NewReceivePolicy);
+
+	UFUNCTION(BlueprintCallable, Category = "Off World Live Spout Receiver Settings")
+	ESpoutReceivePolicy GetReceivePolicy();
+
+	/* Frames copied, ticks skipped because no new frame had arrived, and sender frames that were never copied */
+	UFUNCTION(BlueprintCallable, Category = "Off World Live Spout Receiver Settings")
+	void GetFrameStats(int64& FramesReceived, int64& DuplicateFrames, int64& MissedFrames);
+
+	UFUNCTION(BlueprintCallable, Category = "Off World Live Spout Receiver Settings")
+	void ResetFrameStats();
+
+	/* Forces the render target to RGBA8 sRGB. Senders of any supported format are converted into the render target's format, so this is optional */
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Off World Live Spout Receiver Settings")
 	bool Force_RGBA8_SRGB = true;
 
@@ -80,5 +114,16 @@ private:
 	USceneComponent* DummyRoot = nullptr;
 	FReceiverTickHelper TickHelper;
 	void RenderFrame();
+	/* Drops the frame watchers, e.g. when the receiver is renamed or deactivated */
+	void ResetFrameScheduling();
+	void CopyArrivedFrame();
 	FString OldReceiverName;
+
+	// frame arrival tracking, the waiter thread only runs for the every frame policy
+	TSharedPtr<FSpoutFrameSignal> FrameSignal;
+	TSharedPtr<FReceiverFrameWaiter> FrameWaiter;
+	TSharedPtr<FReceiverFrameStats> FrameStats;
+	// copies issued for the every frame policy the render thread hasn't run yet
+	TSharedPtr<TAtomic<int32>, ESPMode::ThreadSafe> PendingCopies;
+	uint64 LastFrameCount = 0;
 };
@@ -0,0 +1,589 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#include "SpoutDelta.h"
+#include "SpoutModule.h"
+#include "SpoutTileDiff.h"
+#include "Spout.h"
+#include "HAL/IConsoleManager.h"
+
+#include "Windows/AllowWindowsPlatformTypes.h"
+THIRD_PARTY_INCLUDES_START
+#include <d3dcompiler.h>
+THIRD_PARTY_INCLUDES_END
+#include "Windows/HideWindowsPlatformTypes.h"
+
+static constexpr uint32 SpoutDeltaMagic = 0x41544C44; // 'DLTA'
+static constexpr uint32 SpoutDeltaVersion = 1;
+// Above this share of dirty tiles a single CopyResource is cheaper than the region copies
+static constexpr float FullCopyDirtyRatio = 0.75f;
+// longest a sender waits for its tile copies before giving up on publishing the frame
+static constexpr double MaxPublishWaitSeconds = 0.005;
+
+static TAutoConsoleVariable<int32> CVarSpoutDeltaCPUFallback(
+	TEXT("Spout.DeltaCPUFallback"),
+	0,
+	TEXT("0: delta senders without the tile compare shader send whole frames. 1: they compare tiles on a CPU readback of every frame, which only pays off when the receiver is bandwidth bound."),
+	ECVF_Default);
+
+// One 16x16 group per 64x64 tile, every thread compares a 4x4 block
+static const char* TileDiffShaderSource = R"(
+Texture2D<float4> CurrentFrame : register(t0);
+Texture2D<float4> PreviousFrame : register(t1);
+RWStructuredBuffer<uint> TileFlags : register(u0);
+
+cbuffer Params : register(b0)
+{
+	uint2 FrameSize;
+	uint TilesX;
+	uint Padding;
+};
+
+[numthreads(16, 16, 1)]
+void MainCS(uint3 GroupId : SV_GroupID, uint3 ThreadId : SV_GroupThreadID)
+{
+	uint2 BlockOrigin = GroupId.xy * 64 + ThreadId.xy * 4;
+	bool bDiffers = false;
+
+	[unroll]
+	for (uint Y = 0; Y < 4; ++Y)
+	{
+		[unroll]
+		for (uint X = 0; X < 4; ++X)
+		{
+			uint2 Pixel = BlockOrigin + uint2(X, Y);
+			if (all(Pixel < FrameSize))
+			{
+				bDiffers = bDiffers || any(CurrentFrame.Load(int3(Pixel, 0)) != PreviousFrame.Load(int3(Pixel, 0)));
+			}
+		}
+	}
+
+	if (bDiffers)
+	{
+		TileFlags[GroupId.y * TilesX + GroupId.x] = 1;
+	}
+}
+)";
+
+struct FTileDiffParams
+{
+	uint32 FrameSize[2];
+	uint32 TilesX;
+	uint32 Padding;
+};
+
+template<typename T>
+static void SafeRelease(T*& Object)
+{
+	if (Object != nullptr)
+	{
+		Object->Release();
+		Object = nullptr;
+	}
+}
+
+static FString GetDeltaChannelName(const FString& SenderName)
+{
+	return SenderName + TEXT("_OWLDelta");
+}
+
+static int32 GetDeltaChannelSize()
+{
+	// enough bitmap for a 16k x 16k frame
+	const int32 MaxTiles = SpoutTileDiff::NumTilesX(16384);
+	return sizeof(FSpoutDeltaHeader) + SpoutTileDiff::BitmapBytes(MaxTiles, MaxTiles);
+}
+
+// SRVs can't be created on typeless formats, pick the matching typed one
+DXGI_FORMAT GetSpoutTypedFormat(DXGI_FORMAT Format)
+{
+	switch (Format)
+	{
+	case DXGI_FORMAT_B8G8R8A8_TYPELESS: return DXGI_FORMAT_B8G8R8A8_UNORM;
+	case DXGI_FORMAT_R8G8B8A8_TYPELESS: return DXGI_FORMAT_R8G8B8A8_UNORM;
+	case DXGI_FORMAT_R10G10B10A2_TYPELESS: return DXGI_FORMAT_R10G10B10A2_UNORM;
+	case DXGI_FORMAT_R16G16B16A16_TYPELESS: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+	case DXGI_FORMAT_R32G32B32A32_TYPELESS: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+	default: return Format;
+	}
+}
+
+uint32 GetSpoutBytesPerPixel(DXGI_FORMAT Format)
+{
+	switch (GetSpoutTypedFormat(Format))
+	{
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+		return 8;
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		return 16;
+	default:
+		return 4;
+	}
+}
+
+static ID3DBlob* GetTileDiffShaderBytecode()
+{
+	static ID3DBlob* Bytecode = nullptr;
+	static bool bCompileAttempted = false;
+	if (bCompileAttempted) return Bytecode;
+	bCompileAttempted = true;
+
+	ID3DBlob* Errors = nullptr;
+	HRESULT hr = D3DCompile(TileDiffShaderSource, FCStringAnsi::Strlen(TileDiffShaderSource), "SpoutTileDiff", nullptr, nullptr,
+		"MainCS", "cs_5_0", D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, &Bytecode, &Errors);
+	if (FAILED(hr))
+	{
+		UE_LOG(SpoutLog, Warning, TEXT("Delta transport: tile compare shader failed to compile, falling back to CPU comparison"));
+		if (Errors != nullptr) UE_LOG(SpoutLog, Warning, TEXT("%s"), ANSI_TO_TCHAR((const char*)Errors->GetBufferPointer()));
+		Bytecode = nullptr;
+	}
+	SafeRelease(Errors);
+	return Bytecode;
+}
+
+//////////////////////////// FSpoutDeltaChannel ////////////////////////////
+
+FSpoutDeltaChannel::~FSpoutDeltaChannel()
+{
+	Close();
+}
+
+bool FSpoutDeltaChannel::Create(const FString& SenderName)
+{
+	Close();
+	Memory = new SpoutSharedMemory;
+	if (Memory->Create(TCHAR_TO_ANSI(*GetDeltaChannelName(SenderName)), GetDeltaChannelSize()) == SPOUT_CREATE_FAILED)
+	{
+		UE_LOG(SpoutLog, Warning, TEXT("Delta transport: couldn't create tile channel for %s"), *SenderName);
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool FSpoutDeltaChannel::Open(const FString& SenderName)
+{
+	Close();
+	Memory = new SpoutSharedMemory;
+	if (!Memory->Open(TCHAR_TO_ANSI(*GetDeltaChannelName(SenderName))))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void FSpoutDeltaChannel::Close()
+{
+	if (Memory != nullptr)
+	{
+		Memory->Close();
+		delete Memory;
+		Memory = nullptr;
+	}
+}
+
+void FSpoutDeltaChannel::Publish(uint64 FrameIndex, uint32 Width, uint32 Height, const uint8* Bitmap, uint32 DirtyTileCount)
+{
+	if (Memory == nullptr) return;
+	char* Buffer = Memory->Lock();
+	if (Buffer == nullptr) return;
+
+	FSpoutDeltaHeader* Header = (FSpoutDeltaHeader*)Buffer;
+	Header->Magic = SpoutDeltaMagic;
+	Header->Version = SpoutDeltaVersion;
+	Header->FrameIndex = FrameIndex;
+	Header->Width = Width;
+	Header->Height = Height;
+	Header->TileSize = SpoutTileDiff::TileSize;
+	Header->TilesX = SpoutTileDiff::NumTilesX(Width);
+	Header->TilesY = SpoutTileDiff::NumTilesY(Height);
+	Header->DirtyTileCount = DirtyTileCount;
+	FMemory::Memcpy(Buffer + sizeof(FSpoutDeltaHeader), Bitmap, SpoutTileDiff::BitmapBytes(Header->TilesX, Header->TilesY));
+
+	Memory->Unlock();
+}
+
+bool FSpoutDeltaChannel::Read(FSpoutDeltaHeader& OutHeader, TArray<uint8>& OutBitmap)
+{
+	if (Memory == nullptr) return false;
+	char* Buffer = Memory->Lock();
+	if (Buffer == nullptr) return false;
+
+	FMemory::Memcpy(&OutHeader, Buffer, sizeof(FSpoutDeltaHeader));
+	const bool bValid = OutHeader.Magic == SpoutDeltaMagic
+		&& OutHeader.Version == SpoutDeltaVersion
+		&& OutHeader.TileSize == SpoutTileDiff::TileSize;
+	if (bValid)
+	{
+		OutBitmap.SetNumUninitialized(SpoutTileDiff::BitmapBytes(OutHeader.TilesX, OutHeader.TilesY), false);
+		FMemory::Memcpy(OutBitmap.GetData(), Buffer + sizeof(FSpoutDeltaHeader), OutBitmap.Num());
+	}
+
+	Memory->Unlock();
+	return bValid;
+}
+
+//////////////////////////// FSpoutDeltaSender ////////////////////////////
+
+FSpoutDeltaSender::FSpoutDeltaSender(const FString& InSenderName, uint32 InWidth, uint32 InHeight, DXGI_FORMAT InFormat)
+	: SenderName(InSenderName)
+	, Width(InWidth)
+	, Height(InHeight)
+	, Format(InFormat)
+	, TilesX(SpoutTileDiff::NumTilesX(InWidth))
+	, TilesY(SpoutTileDiff::NumTilesY(InHeight))
+	, BytesPerPixel(GetSpoutBytesPerPixel(InFormat))
+{
+	Bitmap.SetNumZeroed(SpoutTileDiff::BitmapBytes(TilesX, TilesY));
+	Channel.Create(SenderName);
+}
+
+FSpoutDeltaSender::~FSpoutDeltaSender()
+{
+	ReleaseDeviceObjects();
+}
+
+void FSpoutDeltaSender::ReleaseDeviceObjects()
+{
+	SafeRelease(TileDiffShader);
+	SafeRelease(ParamsBuffer);
+	SafeRelease(TileFlagsBuffer);
+	SafeRelease(TileFlagsUAV);
+	SafeRelease(TileFlagsReadback);
+	SafeRelease(PreviousFrameSRV);
+	SafeRelease(StagingTexture);
+	SafeRelease(CopyDoneQuery);
+}
+
+bool FSpoutDeltaSender::InitGPU(ID3D11Device* Device, ID3D11Texture2D* Target)
+{
+	ID3DBlob* Bytecode = GetTileDiffShaderBytecode();
+	if (Bytecode == nullptr) return false;
+
+	if (FAILED(Device->CreateComputeShader(Bytecode->GetBufferPointer(), Bytecode->GetBufferSize(), nullptr, &TileDiffShader))) return false;
+
+	D3D11_BUFFER_DESC ParamsDesc = {};
+	ParamsDesc.ByteWidth = sizeof(FTileDiffParams);
+	ParamsDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	ParamsDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	FTileDiffParams Params = { { Width, Height }, TilesX, 0 };
+	D3D11_SUBRESOURCE_DATA ParamsData = { &Params, 0, 0 };
+	if (FAILED(Device->CreateBuffer(&ParamsDesc, &ParamsData, &ParamsBuffer))) return false;
+
+	D3D11_BUFFER_DESC FlagsDesc = {};
+	FlagsDesc.ByteWidth = GetNumTiles() * sizeof(uint32);
+	FlagsDesc.Usage = D3D11_USAGE_DEFAULT;
+	FlagsDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+	FlagsDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	FlagsDesc.StructureByteStride = sizeof(uint32);
+	if (FAILED(Device->CreateBuffer(&FlagsDesc, nullptr, &TileFlagsBuffer))) return false;
+
+	D3D11_UNORDERED_ACCESS_VIEW_DESC UAVDesc = {};
+	UAVDesc.Format = DXGI_FORMAT_UNKNOWN;
+	UAVDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+	UAVDesc.Buffer.NumElements = GetNumTiles();
+	if (FAILED(Device->CreateUnorderedAccessView(TileFlagsBuffer, &UAVDesc, &TileFlagsUAV))) return false;
+
+	D3D11_BUFFER_DESC ReadbackDesc = FlagsDesc;
+	ReadbackDesc.Usage = D3D11_USAGE_STAGING;
+	ReadbackDesc.BindFlags = 0;
+	ReadbackDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	if (FAILED(Device->CreateBuffer(&ReadbackDesc, nullptr, &TileFlagsReadback))) return false;
+
+	// the shared texture always holds the last published frame, so it doubles as the comparison reference
+	D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
+	SRVDesc.Format = GetSpoutTypedFormat(Format);
+	SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	SRVDesc.Texture2D.MipLevels = 1;
+	if (FAILED(Device->CreateShaderResourceView(Target, &SRVDesc, &PreviousFrameSRV))) return false;
+
+	return true;
+}
+
+bool FSpoutDeltaSender::InitCPU(ID3D11Device* Device)
+{
+	D3D11_TEXTURE2D_DESC Desc = {};
+	Desc.Width = Width;
+	Desc.Height = Height;
+	Desc.MipLevels = 1;
+	Desc.ArraySize = 1;
+	Desc.Format = Format;
+	Desc.SampleDesc.Count = 1;
+	Desc.Usage = D3D11_USAGE_STAGING;
+	Desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	if (FAILED(Device->CreateTexture2D(&Desc, nullptr, &StagingTexture))) return false;
+
+	RetainedFrame.SetNumZeroed(Width * Height * BytesPerPixel);
+	return true;
+}
+
+uint32 FSpoutDeltaSender::FindDirtyTilesGPU(ID3D11Device* Device, ID3D11DeviceContext* Context, ID3D11Resource* Source)
+{
+	D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
+	SRVDesc.Format = GetSpoutTypedFormat(Format);
+	SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	SRVDesc.Texture2D.MipLevels = 1;
+	ID3D11ShaderResourceView* SourceSRV = nullptr;
+	if (FAILED(Device->CreateShaderResourceView(Source, &SRVDesc, &SourceSRV)))
+	{
+		// treat everything as changed, the next frame will try again
+		FMemory::Memset(Bitmap.GetData(), 0xFF, Bitmap.Num());
+		return GetNumTiles();
+	}
+
+	const UINT ClearValue[4] = { 0, 0, 0, 0 };
+	Context->ClearUnorderedAccessViewUint(TileFlagsUAV, ClearValue);
+
+	ID3D11ShaderResourceView* SRVs[2] = { SourceSRV, PreviousFrameSRV };
+	Context->CSSetShader(TileDiffShader, nullptr, 0);
+	Context->CSSetShaderResources(0, 2, SRVs);
+	Context->CSSetUnorderedAccessViews(0, 1, &TileFlagsUAV, nullptr);
+	Context->CSSetConstantBuffers(0, 1, &ParamsBuffer);
+	Context->Dispatch(TilesX, TilesY, 1);
+
+	// unbind so the textures can be used as copy sources/destinations again
+	ID3D11ShaderResourceView* NullSRVs[2] = { nullptr, nullptr };
+	ID3D11UnorderedAccessView* NullUAV = nullptr;
+	Context->CSSetShaderResources(0, 2, NullSRVs);
+	Context->CSSetUnorderedAccessViews(0, 1, &NullUAV, nullptr);
+	Context->CSSetShader(nullptr, nullptr, 0);
+	SourceSRV->Release();
+
+	Context->CopyResource(TileFlagsReadback, TileFlagsBuffer);
+
+	// the readback is only NumTiles * 4 bytes (8KB for 4K), waiting for it is far cheaper than a full frame copy
+	uint32 DirtyTiles = 0;
+	FMemory::Memzero(Bitmap.GetData(), Bitmap.Num());
+	D3D11_MAPPED_SUBRESOURCE Mapped;
+	if (FAILED(Context->Map(TileFlagsReadback, 0, D3D11_MAP_READ, 0, &Mapped)))
+	{
+		FMemory::Memset(Bitmap.GetData(), 0xFF, Bitmap.Num());
+		return GetNumTiles();
+	}
+	const uint32* Flags = (const uint32*)Mapped.pData;
+	for (uint32 TileIndex = 0; TileIndex < GetNumTiles(); ++TileIndex)
+	{
+		if (Flags[TileIndex] != 0)
+		{
+			SpoutTileDiff::MarkTileDirty(Bitmap.GetData(), TileIndex);
+			++DirtyTiles;
+		}
+	}
+	Context->Unmap(TileFlagsReadback, 0);
+	return DirtyTiles;
+}
+
+uint32 FSpoutDeltaSender::FindDirtyTilesCPU(ID3D11DeviceContext* Context, ID3D11Resource* Source)
+{
+	Context->CopyResource(StagingTexture, Source);
+
+	D3D11_MAPPED_SUBRESOURCE Mapped;
+	if (FAILED(Context->Map(StagingTexture, 0, D3D11_MAP_READ, 0, &Mapped)))
+	{
+		FMemory::Memset(Bitmap.GetData(), 0xFF, Bitmap.Num());
+		return GetNumTiles();
+	}
+
+	const uint8* Current = (const uint8*)Mapped.pData;
+	const int32 RetainedPitch = Width * BytesPerPixel;
+	uint32 DirtyTiles = 0;
+	if (bHasPreviousFrame)
+	{
+		DirtyTiles = SpoutTileDiff::CompareTiles(Current, Mapped.RowPitch, RetainedFrame.GetData(), RetainedPitch,
+			Width, Height, BytesPerPixel, Bitmap.GetData());
+	}
+	else
+	{
+		FMemory::Memset(Bitmap.GetData(), 0xFF, Bitmap.Num());
+		DirtyTiles = GetNumTiles();
+	}
+
+	// keep the retained copy in sync for the next comparison, only the changed tiles need refreshing
+	SpoutTileDiff::ForEachDirtyRun(Bitmap.GetData(), TilesX, TilesY, [&](int32 TileX, int32 TileY, int32 RunLength)
+	{
+		const uint32 Left = TileX * SpoutTileDiff::TileSize;
+		const uint32 Right = FMath::Min<uint32>((TileX + RunLength) * SpoutTileDiff::TileSize, Width);
+		const uint32 Top = TileY * SpoutTileDiff::TileSize;
+		const uint32 Bottom = FMath::Min<uint32>(Top + SpoutTileDiff::TileSize, Height);
+		for (uint32 Row = Top; Row < Bottom; ++Row)
+		{
+			FMemory::Memcpy(RetainedFrame.GetData() + Row * RetainedPitch + Left * BytesPerPixel,
+				Current + Row * Mapped.RowPitch + Left * BytesPerPixel, (Right - Left) * BytesPerPixel);
+		}
+	});
+
+	Context->Unmap(StagingTexture, 0);
+	return DirtyTiles;
+}
+
+uint64 FSpoutDeltaSender::Send(ID3D11Device* Device, ID3D11DeviceContext* Context, ID3D11Resource* Source, ID3D11Texture2D* Target)
+{
+	if (!bInitialised)
+	{
+		bInitialised = true;
+		bUseGPU = InitGPU(Device, Target);
+		if (!bUseGPU)
+		{
+			ReleaseDeviceObjects();
+			if (CVarSpoutDeltaCPUFallback.GetValueOnRenderThread() == 0)
+			{
+				UE_LOG(SpoutLog, Warning, TEXT("Delta transport: no tile compare shader for %s, sending whole frames (Spout.DeltaCPUFallback 1 compares on the CPU)"), *SenderName);
+			}
+			else if (!InitCPU(Device))
+			{
+				UE_LOG(SpoutLog, Error, TEXT("Delta transport: couldn't create staging texture for %s"), *SenderName);
+			}
+		}
+		if (bUseGPU || StagingTexture != nullptr)
+		{
+			UE_LOG(SpoutLog, Display, TEXT("Delta transport enabled for %s using %s tile comparison"), *SenderName, bUseGPU ? TEXT("GPU") : TEXT("CPU"));
+		}
+	}
+	if (CopyDoneQuery == nullptr && !bCopyDoneQueryFailed)
+	{
+		D3D11_QUERY_DESC QueryDesc = { D3D11_QUERY_EVENT, 0 };
+		bCopyDoneQueryFailed = FAILED(Device->CreateQuery(&QueryDesc, &CopyDoneQuery));
+		if (bCopyDoneQueryFailed)
+		{
+			UE_LOG(SpoutLog, Warning, TEXT("Delta transport: couldn't create a copy query for %s, receivers will copy whole frames"), *SenderName);
+		}
+	}
+
+	const uint64 FullFrameBytes = uint64(Width) * Height * BytesPerPixel;
+	uint32 DirtyTiles = GetNumTiles();
+	// the CPU comparison reads back the whole frame even for the first one, the GPU one only reads the tile flags
+	LastReadbackBytes = bUseGPU ? (bHasPreviousFrame ? GetNumTiles() * sizeof(uint32) : 0) : (StagingTexture != nullptr ? FullFrameBytes : 0);
+
+	if (!bHasPreviousFrame || (!bUseGPU && StagingTexture == nullptr))
+	{
+		FMemory::Memset(Bitmap.GetData(), 0xFF, Bitmap.Num());
+		if (!bUseGPU && StagingTexture != nullptr) FindDirtyTilesCPU(Context, Source);
+	}
+	else
+	{
+		DirtyTiles = bUseGPU ? FindDirtyTilesGPU(Device, Context, Source) : FindDirtyTilesCPU(Context, Source);
+	}
+
+	uint64 BytesCopied = 0;
+	if (DirtyTiles >= GetNumTiles() * FullCopyDirtyRatio)
+	{
+		Context->CopyResource(Target, Source);
+		BytesCopied = FullFrameBytes;
+	}
+	else
+	{
+		SpoutTileDiff::ForEachDirtyRun(Bitmap.GetData(), TilesX, TilesY, [&](int32 TileX, int32 TileY, int32 RunLength)
+		{
+			D3D11_BOX Box;
+			Box.left = TileX * SpoutTileDiff::TileSize;
+			Box.right = FMath::Min<uint32>((TileX + RunLength) * SpoutTileDiff::TileSize, Width);
+			Box.top = TileY * SpoutTileDiff::TileSize;
+			Box.bottom = FMath::Min<uint32>(Box.top + SpoutTileDiff::TileSize, Height);
+			Box.front = 0;
+			Box.back = 1;
+			Context->CopySubresourceRegion(Target, 0, Box.left, Box.top, 0, Source, 0, &Box);
+			BytesCopied += uint64(Box.right - Box.left) * (Box.bottom - Box.top) * BytesPerPixel;
+		});
+	}
+
+	bHasPreviousFrame = true;
+	LastDirtyTiles = DirtyTiles;
+	if (CopyDoneQuery != nullptr)
+	{
+		Context->End(CopyDoneQuery);
+	}
+	bPublishPending = true;
+	return BytesCopied;
+}
+
+void FSpoutDeltaSender::Publish(ID3D11DeviceContext* Context)
+{
+	if (!bPublishPending) return;
+	bPublishPending = false;
+
+	// Receivers only copy the dirty tiles of a frame that directly follows the one they have, so the header may only
+	// go out once the copies are in the shared texture. Without that, the frame index is skipped instead, which makes
+	// every receiver copy the next frame whole.
+	bool bCopied = false;
+	if (CopyDoneQuery != nullptr)
+	{
+		const double Deadline = FPlatformTime::Seconds() + MaxPublishWaitSeconds;
+		HRESULT Result;
+		while ((Result = Context->GetData(CopyDoneQuery, nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH)) == S_FALSE && FPlatformTime::Seconds() < Deadline)
+		{
+			FPlatformProcess::YieldThread();
+		}
+		bCopied = Result == S_OK;
+	}
+
+	if (bCopied)
+	{
+		Channel.Publish(++FrameIndex, Width, Height, Bitmap.GetData(), LastDirtyTiles);
+	}
+	else
+	{
+		++FrameIndex;
+	}
+}
+
+//////////////////////////// FSpoutDeltaReceiver ////////////////////////////
+
+FSpoutDeltaReceiver::FSpoutDeltaReceiver(const FString& InSenderName)
+	: SenderName(InSenderName)
+{
+}
+
+bool FSpoutDeltaReceiver::Receive(ID3D11DeviceContext* Context, ID3D11Resource* Source, ID3D11Resource* Target, uint32 Width, uint32 Height, DXGI_FORMAT Format, uint64& OutBytesCopied)
+{
+	OutBytesCopied = 0;
+	const uint64 FullFrameBytes = uint64(Width) * Height * GetSpoutBytesPerPixel(Format);
+
+	// senders can switch delta mode on at any time, look for the channel every now and then
+	if (!Channel.IsOpen() && --FramesUntilReopen <= 0)
+	{
+		Channel.Open(SenderName);
+		FramesUntilReopen = 60;
+	}
+
+	FSpoutDeltaHeader Header;
+	const bool bHasDelta = Channel.IsOpen() && Channel.Read(Header, Bitmap);
+	const bool bSameSize = bHasDelta && Header.Width == Width && Header.Height == Height;
+	if (bSameSize && bHasFullFrame && Header.FrameIndex == LastFrameIndex)
+	{
+		// nothing was published since the last receive
+		return false;
+	}
+	const bool bContiguous = bHasDelta
+		&& bHasFullFrame
+		&& Header.FrameIndex == LastFrameIndex + 1
+		&& bSameSize;
+
+	uint64& BytesCopied = OutBytesCopied;
+	if (bContiguous)
+	{
+		SpoutTileDiff::ForEachDirtyRun(Bitmap.GetData(), Header.TilesX, Header.TilesY, [&](int32 TileX, int32 TileY, int32 RunLength)
+		{
+			D3D11_BOX Box;
+			Box.left = TileX * SpoutTileDiff::TileSize;
+			Box.right = FMath::Min<uint32>((TileX + RunLength) * SpoutTileDiff::TileSize, Width);
+			Box.top = TileY * SpoutTileDiff::TileSize;
+			Box.bottom = FMath::Min<uint32>(Box.top + SpoutTileDiff::TileSize, Height);
+			Box.front = 0;
+			Box.back = 1;
+			Context->CopySubresourceRegion(Target, 0, Box.left, Box.top, 0, Source, 0, &Box);
+			BytesCopied += uint64(Box.right - Box.left) * (Box.bottom - Box.top) * GetSpoutBytesPerPixel(Format);
+		});
+	}
+	else
+	{
+		Context->CopyResource(Target, Source);
+		BytesCopied = FullFrameBytes;
+	}
+
+	bHasFullFrame = true;
+	LastFrameIndex = bHasDelta ? Header.FrameIndex : 0;
+	if (!bHasDelta) Channel.Close();
+	return true;
+}
@@ -0,0 +1,142 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpoutInterface.h"
+
+class SpoutSharedMemory;
+
+/* Layout of the shared memory block published next to the shared texture of a delta sender */
+struct FSpoutDeltaHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	uint64 FrameIndex;
+	uint32 Width;
+	uint32 Height;
+	uint32 TileSize;
+	uint32 TilesX;
+	uint32 TilesY;
+	uint32 DirtyTileCount;
+	// followed by the dirty tile bitmap, one bit per tile in row major order
+};
+
+/* Shared memory channel carrying the dirty tile bitmap of the last published frame */
+class FSpoutDeltaChannel
+{
+public:
+	~FSpoutDeltaChannel();
+
+	bool Create(const FString& SenderName);
+	bool Open(const FString& SenderName);
+	void Close();
+	bool IsOpen() const { return Memory != nullptr; }
+
+	void Publish(uint64 FrameIndex, uint32 Width, uint32 Height, const uint8* Bitmap, uint32 DirtyTileCount);
+	bool Read(FSpoutDeltaHeader& OutHeader, TArray<uint8>& OutBitmap);
+
+private:
+	SpoutSharedMemory* Memory = nullptr;
+};
+
+/*
+ * Sender half of the delta transport.
+ * Compares the outgoing frame with the previously published one in 64x64 tiles and only copies changed tiles
+ * into the shared texture. Comparison runs in a compute shader on the spout device. Without the shader, frames are
+ * compared on mapped staging copies with SSE2 only if Spout.DeltaCPUFallback is set, as reading back every frame
+ * costs more than the copies it saves; otherwise whole frames are sent.
+ */
+class FSpoutDeltaSender
+{
+public:
+	FSpoutDeltaSender(const FString& InSenderName, uint32 InWidth, uint32 InHeight, DXGI_FORMAT InFormat);
+	~FSpoutDeltaSender();
+
+	/* Updates Target from Source. Returns the number of bytes copied into Target. */
+	uint64 Send(ID3D11Device* Device, ID3D11DeviceContext* Context, ID3D11Resource* Source, ID3D11Texture2D* Target);
+	/* Publishes the tile bitmap of the last Send once its copies have completed. Call after the context was flushed. */
+	void Publish(ID3D11DeviceContext* Context);
+
+	uint32 GetNumTiles() const { return TilesX * TilesY; }
+	uint32 GetLastDirtyTiles() const { return LastDirtyTiles; }
+	/* Bytes the last Send read back to compare tiles */
+	uint64 GetLastReadbackBytes() const { return LastReadbackBytes; }
+
+private:
+	bool InitGPU(ID3D11Device* Device, ID3D11Texture2D* Target);
+	bool InitCPU(ID3D11Device* Device);
+	uint32 FindDirtyTilesGPU(ID3D11Device* Device, ID3D11DeviceContext* Context, ID3D11Resource* Source);
+	uint32 FindDirtyTilesCPU(ID3D11DeviceContext* Context, ID3D11Resource* Source);
+	void ReleaseDeviceObjects();
+
+	FString SenderName;
+	uint32 Width;
+	uint32 Height;
+	DXGI_FORMAT Format;
+	uint32 TilesX;
+	uint32 TilesY;
+	uint32 BytesPerPixel;
+
+	uint64 FrameIndex = 0;
+	uint32 LastDirtyTiles = 0;
+	uint64 LastReadbackBytes = 0;
+	bool bHasPreviousFrame = false;
+	bool bInitialised = false;
+	bool bUseGPU = false;
+	bool bPublishPending = false;
+	bool bCopyDoneQueryFailed = false;
+	TArray<uint8> Bitmap;
+	FSpoutDeltaChannel Channel;
+
+	// GPU comparison
+	ID3D11ComputeShader* TileDiffShader = nullptr;
+	ID3D11Buffer* ParamsBuffer = nullptr;
+	ID3D11Buffer* TileFlagsBuffer = nullptr;
+	ID3D11UnorderedAccessView* TileFlagsUAV = nullptr;
+	ID3D11Buffer* TileFlagsReadback = nullptr;
+	ID3D11ShaderResourceView* PreviousFrameSRV = nullptr;
+
+	// signalled once the copies of the last Send are done
+	ID3D11Query* CopyDoneQuery = nullptr;
+
+	// CPU comparison
+	ID3D11Texture2D* StagingTexture = nullptr;
+	TArray<uint8> RetainedFrame;
+};
+
+/* Receiver half of the delta transport, restricts copies to the dirty tiles while no frame was missed */
+class FSpoutDeltaReceiver
+{
+public:
+	explicit FSpoutDeltaReceiver(const FString& InSenderName);
+
+	/* Copies Source into Target. Returns false without copying when the sender publishes frame indices and hasn't
+	 * published a new frame since the last receive, Target then still holds the latest frame. */
+	bool Receive(ID3D11DeviceContext* Context, ID3D11Resource* Source, ID3D11Resource* Target, uint32 Width, uint32 Height, DXGI_FORMAT Format, uint64& OutBytesCopied);
+
+	/* Forces the next receive to copy the whole frame */
+	void Invalidate() { bHasFullFrame = false; }
+
+	/* Tracks the native target texture, a reallocated target needs a full copy */
+	void SetTarget(void* NativeTarget)
+	{
+		if (NativeTarget != LastTarget) Invalidate();
+		LastTarget = NativeTarget;
+	}
+
+private:
+	FString SenderName;
+	FSpoutDeltaChannel Channel;
+	TArray<uint8> Bitmap;
+	uint64 LastFrameIndex = 0;
+	bool bHasFullFrame = false;
+	int32 FramesUntilReopen = 0;
+	void* LastTarget = nullptr;
+};
+
+/* Size in bytes of a single pixel of the formats the plugin sends */
+uint32 GetSpoutBytesPerPixel(DXGI_FORMAT Format);
+
+/* Typed format views of a (possibly typeless) texture format are created with */
+DXGI_FORMAT GetSpoutTypedFormat(DXGI_FORMAT Format);
@@ -0,0 +1,157 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#include "SpoutFrameSignal.h"
+#include "SpoutModule.h"
+#include "Spout.h"
+
+static constexpr uint32 SpoutFrameMagic = 0x4D52464F; // 'OFRM'
+static constexpr uint32 SpoutFrameVersion = 1;
+// receivers retry opening the block of senders that don't publish one at most this often
+static constexpr double SpoutFrameReopenInterval = 1.0;
+
+struct FSpoutFrameHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	uint64 FrameCount;
+};
+
+static FString GetFrameChannelName(const FString& SenderName)
+{
+	return SenderName + TEXT("_OWLFrame");
+}
+
+static FString GetFrameEventName(const FString& SenderName)
+{
+	return SenderName + TEXT("_OWLFrameEvent");
+}
+
+FSpoutFrameSignal::~FSpoutFrameSignal()
+{
+	Close();
+}
+
+void FSpoutFrameSignal::Close()
+{
+	if (Memory != nullptr)
+	{
+		Memory->Close();
+		delete Memory;
+		Memory = nullptr;
+	}
+	if (Event != nullptr)
+	{
+		CloseHandle(Event);
+		Event = nullptr;
+	}
+}
+
+bool FSpoutFrameSignal::Create(const FString& InSenderName)
+{
+	Close();
+	SenderName = InSenderName;
+	Memory = new SpoutSharedMemory;
+	const SpoutCreateResult Result = Memory->Create(TCHAR_TO_ANSI(*GetFrameChannelName(SenderName)), sizeof(FSpoutFrameHeader));
+	if (Result == SPOUT_CREATE_FAILED)
+	{
+		UE_LOG(SpoutLog, Warning, TEXT("Frame signal: couldn't create frame channel for %s"), *SenderName);
+		Close();
+		return false;
+	}
+
+	char* Buffer = Memory->Lock();
+	if (Buffer != nullptr)
+	{
+		FSpoutFrameHeader* Header = (FSpoutFrameHeader*)Buffer;
+		if (Result == SPOUT_CREATE_SUCCESS || Header->Magic != SpoutFrameMagic || Header->Version != SpoutFrameVersion)
+		{
+			Header->Magic = SpoutFrameMagic;
+			Header->Version = SpoutFrameVersion;
+			Header->FrameCount = 0;
+		}
+		FrameCount = Header->FrameCount;
+		Memory->Unlock();
+	}
+
+	Event = CreateEventW(nullptr, 1, 0, *GetFrameEventName(SenderName));
+	return true;
+}
+
+void FSpoutFrameSignal::Publish()
+{
+	if (Memory == nullptr) return;
+	char* Buffer = Memory->Lock();
+	if (Buffer == nullptr) return;
+	((FSpoutFrameHeader*)Buffer)->FrameCount = ++FrameCount;
+	Memory->Unlock();
+
+	if (Event != nullptr) SetEvent(Event);
+}
+
+void FSpoutFrameSignal::Watch(const FString& InSenderName)
+{
+	Close();
+	SenderName = InSenderName;
+	FrameCount = 0;
+	NextOpenTime = 0.0;
+}
+
+bool FSpoutFrameSignal::Open()
+{
+	if (Memory != nullptr) return true;
+	if (SenderName.IsEmpty() || FPlatformTime::Seconds() < NextOpenTime) return false;
+	NextOpenTime = FPlatformTime::Seconds() + SpoutFrameReopenInterval;
+
+	Memory = new SpoutSharedMemory;
+	if (!Memory->Open(TCHAR_TO_ANSI(*GetFrameChannelName(SenderName))))
+	{
+		Close();
+		return false;
+	}
+	Event = OpenEventW(SYNCHRONIZE | EVENT_MODIFY_STATE, 0, *GetFrameEventName(SenderName));
+	return true;
+}
+
+uint64 FSpoutFrameSignal::ReadCount()
+{
+	char* Buffer = Memory->Lock();
+	if (Buffer == nullptr) return FrameCount;
+	const FSpoutFrameHeader* Header = (const FSpoutFrameHeader*)Buffer;
+	const bool bValid = Header->Magic == SpoutFrameMagic && Header->Version == SpoutFrameVersion;
+	const uint64 Count = Header->FrameCount;
+	Memory->Unlock();
+
+	if (!bValid)
+	{
+		Close();
+		return 0;
+	}
+	FrameCount = Count;
+	return Count;
+}
+
+uint64 FSpoutFrameSignal::Poll()
+{
+	if (!Open()) return 0;
+	return ReadCount();
+}
+
+uint64 FSpoutFrameSignal::Wait(uint64 LastSeen, uint32 TimeoutMs)
+{
+	if (!Open())
+	{
+		FPlatformProcess::Sleep(TimeoutMs / 1000.0f);
+		return 0;
+	}
+
+	uint64 Count = ReadCount();
+	if (Count != LastSeen || Event == nullptr || Memory == nullptr) return Count;
+
+	// reset, then re-read so a frame published in between isn't slept through
+	ResetEvent(Event);
+	Count = ReadCount();
+	if (Count != LastSeen || Memory == nullptr) return Count;
+
+	WaitForSingleObject(Event, TimeoutMs);
+	return Memory != nullptr ? ReadCount() : 0;
+}
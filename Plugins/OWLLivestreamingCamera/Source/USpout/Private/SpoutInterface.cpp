@@ -2,7 +2,17 @@
 
 #include "SpoutInterface.h"
 #include "SpoutModule.h"
+#include "SpoutDelta.h"
+#include "SpoutReceiveBuffer.h"
+#include "SpoutFrameSignal.h"
 #include "Spout.h"
+#include "Misc/ScopeExit.h"
+#include "Templates/Atomic.h"
+
+DECLARE_STATS_GROUP(TEXT("Spout"), STATGROUP_Spout, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Delta Dirty Tiles"), STAT_SpoutDeltaDirtyTiles, STATGROUP_Spout);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Delta KB Sent"), STAT_SpoutDeltaKBSent, STATGROUP_Spout);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Delta KB Saved"), STAT_SpoutDeltaKBSaved, STATGROUP_Spout);
 
 // DirectX Interface
 ID3D11Device* Device11 = nullptr;
@@ -14,9 +24,40 @@ spoutDirectX* sdx = nullptr;
 // Our Active Senders
 UPROPERTY()
 TArray<FSpoutResource> ActiveSpoutResources;
-bool Initialised = false;
+// Set and cleared on the render thread, IsSpoutOpen reads it from the game thread
+TAtomic<bool> Initialised(false);
 bool RecieverFormatWarningIssued = false;
 bool RecieverNoNameWarningIssued = false;
+// Delta transport accounting, written on the render thread and read from the game thread
+FCriticalSection DeltaStatsLock;
+TMap<FString, FSpoutDeltaStats> DeltaStatsBySender;
+
+// Sender sizes and formats as the render thread last saw them. senderNames belongs to the render thread, the game
+// thread sizes receiver render targets from this instead.
+struct FSpoutSenderSnapshot
+{
+	uint32 Width;
+	uint32 Height;
+	DXGI_FORMAT Format;
+};
+FCriticalSection SenderSnapshotLock;
+TMap<FString, FSpoutSenderSnapshot> SenderSnapshots;
+
+// Shared textures of closed senders, kept around so re-enabled or resized senders don't have to recreate them.
+// Receivers may still hold the handle a texture was published under, so it only goes back to a sender with that name.
+struct FPooledSharedTexture
+{
+	FString SenderName;
+	uint32 Width;
+	uint32 Height;
+	DXGI_FORMAT Format;
+	ID3D11Texture2D* Texture;
+	HANDLE Handle;
+};
+static constexpr int32 MaxPooledSharedTextures = 8;
+FCriticalSection SharedTexturePoolLock;
+TArray<FPooledSharedTexture> FreeSharedTextures;
+int32 SharedTexturesInUse = 0;
 
 // Local helper functions invisible to the BP user 
 
@@ -98,12 +139,64 @@ bool GetDevice()
 	return false;
 }
 
+bool TakePooledSharedTexture(const FString& SenderName, uint32 Width, uint32 Height, DXGI_FORMAT Format, ID3D11Texture2D*& OutTexture, HANDLE& OutHandle)
+{
+	FScopeLock Lock(&SharedTexturePoolLock);
+	for (int32 Index = 0; Index < FreeSharedTextures.Num(); ++Index)
+	{
+		const FPooledSharedTexture& Pooled = FreeSharedTextures[Index];
+		if (Pooled.SenderName == SenderName && Pooled.Width == Width && Pooled.Height == Height && Pooled.Format == Format)
+		{
+			OutTexture = Pooled.Texture;
+			OutHandle = Pooled.Handle;
+			FreeSharedTextures.RemoveAtSwap(Index);
+			SharedTexturesInUse++;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Hands a sender's shared texture back to the pool, evicting the oldest entry when the pool is full
+void ReturnSharedTexture(const FSpoutResource& Resource)
+{
+	if (Resource.SharedSenderTexture == nullptr) return;
+
+	FScopeLock Lock(&SharedTexturePoolLock);
+	SharedTexturesInUse = FMath::Max(SharedTexturesInUse - 1, 0);
+	if (FreeSharedTextures.Num() >= MaxPooledSharedTextures)
+	{
+		FreeSharedTextures[0].Texture->Release();
+		FreeSharedTextures.RemoveAt(0);
+	}
+	FreeSharedTextures.Add({ Resource.Name, uint32(Resource.Width), uint32(Resource.Height), Resource.Format, Resource.SharedSenderTexture, Resource.Handle });
+}
+
+void ReleaseSharedTexturePool()
+{
+	FScopeLock Lock(&SharedTexturePoolLock);
+	for (FPooledSharedTexture& Pooled : FreeSharedTextures)
+	{
+		Pooled.Texture->Release();
+	}
+	FreeSharedTextures.Empty();
+}
+
 FSpoutResource CreateSenderResource(FString spoutName, uint32 Width, uint32 Height, DXGI_FORMAT Format)
 {
 	HANDLE sharedSendingHandle = NULL;
 	ID3D11Texture2D* sendingTexture = nullptr;
 
-	if (!sdx->CreateSharedDX11Texture(Device11, Width, Height, Format, &sendingTexture, sharedSendingHandle))
+	if (TakePooledSharedTexture(spoutName, Width, Height, Format, sendingTexture, sharedSendingHandle))
+	{
+		UE_LOG(SpoutLog, Verbose, TEXT("Reusing pooled shared texture for sender %s"), *spoutName);
+	}
+	else if (sdx->CreateSharedDX11Texture(Device11, Width, Height, Format, &sendingTexture, sharedSendingHandle))
+	{
+		FScopeLock Lock(&SharedTexturePoolLock);
+		SharedTexturesInUse++;
+	}
+	else
 	{
 		UE_LOG(SpoutLog, Error, TEXT("SharedDX11Texture creation failed"));
 		return FSpoutResource();
@@ -159,6 +252,7 @@ FSpoutResource CreateReceiverResource(FString spoutName, UTextureRenderTarget2D*
 	NewResource.Handle = sharedHandle;
 	NewResource.SpoutType = ESpoutType::ST_Receiver;
 	NewResource.ReceiverRT = ReceiverRT;
+	NewResource.ReceiveBuffer = MakeShared<FSpoutReceiveBuffer>(spoutName);
 	HRESULT hr = S_OK;
 	hr = Device11->OpenSharedResource(NewResource.Handle, __uuidof(ID3D11Resource), (void**)(&NewResource.SharedSenderTexture));
 
@@ -195,7 +289,9 @@ bool UpdateRegisteredSender(FString spoutName, uint32 Width, uint32 Height, DXGI
 	for (int32 Index = 0; Index != ActiveSpoutResources.Num(); ++Index)
 	{
 		if (ActiveSpoutResources[Index].Name == spoutName) {
-			ActiveSpoutResources[Index].SharedSenderTexture->Release();
+			ReturnSharedTexture(ActiveSpoutResources[Index]);
+			// receivers keep watching the same frame count across the resize
+			SenderStruct.FrameSignal = ActiveSpoutResources[Index].FrameSignal;
 			ActiveSpoutResources.RemoveAt(Index, 1, false);
 			ActiveSpoutResources.EmplaceAt(Index, SenderStruct);
 			Updated = true;
@@ -247,6 +343,26 @@ FSpoutResource* GetRegistredSpout(FString spoutName)
 
 void UnregisterSpout(FString spoutName) {
 	auto Predicate = [&](const FSpoutResource InItem) { return InItem.Name == spoutName; };
+	FSpoutResource* Resource = ActiveSpoutResources.FindByPredicate(Predicate);
+	if (Resource != nullptr)
+	{
+		// the textures and delta state may still be in use by a queued copy, let the render thread retire them
+		ENQUEUE_RENDER_COMMAND(ReleaseSpoutResource)(
+			[ReleasedResource = *Resource](FRHICommandListImmediate& RHICmdList) mutable {
+				ReleasedResource.DeltaSender.Reset();
+				ReleasedResource.FrameSignal.Reset();
+				ReleasedResource.ReceiveBuffer.Reset();
+				if (ReleasedResource.SpoutType == ESpoutType::ST_Sender)
+				{
+					ReturnSharedTexture(ReleasedResource);
+				}
+				else if (ReleasedResource.SharedSenderTexture != nullptr)
+				{
+					// receivers only hold an opened handle to somebody else's texture
+					ReleasedResource.SharedSenderTexture->Release();
+				}
+			});
+	}
 	ActiveSpoutResources.RemoveAll(Predicate);
 }
 
@@ -268,6 +384,36 @@ void ReleaseResources(FString spoutName)
 	if (senderNames!= nullptr) senderNames->ReleaseSenderName(TCHAR_TO_ANSI(*spoutName));
 }
 
+void RecordDeltaFrame(const FSpoutResource& SenderResource, uint64 BytesSent)
+{
+	const uint64 FullFrameBytes = uint64(SenderResource.Width) * SenderResource.Height * GetSpoutBytesPerPixel(SenderResource.Format);
+	INC_DWORD_STAT_BY(STAT_SpoutDeltaDirtyTiles, SenderResource.DeltaSender->GetLastDirtyTiles());
+	INC_DWORD_STAT_BY(STAT_SpoutDeltaKBSent, uint32(BytesSent / 1024));
+	INC_DWORD_STAT_BY(STAT_SpoutDeltaKBSaved, uint32(FMath::Max<int64>(int64(FullFrameBytes) - int64(BytesSent) - int64(SenderResource.DeltaSender->GetLastReadbackBytes()), 0) / 1024));
+
+	FScopeLock Lock(&DeltaStatsLock);
+	FSpoutDeltaStats& Stats = DeltaStatsBySender.FindOrAdd(SenderResource.Name);
+	Stats.FramesSent++;
+	Stats.FullFrameBytes += FullFrameBytes;
+	Stats.BytesSent += BytesSent;
+	Stats.ReadbackBytes += SenderResource.DeltaSender->GetLastReadbackBytes();
+	Stats.LastDirtyTiles = SenderResource.DeltaSender->GetLastDirtyTiles();
+	Stats.TotalTiles = SenderResource.DeltaSender->GetNumTiles();
+}
+
+// Copies the outgoing frame into the shared texture, through the delta transport when it is enabled
+void CopyToSharedTexture(FSpoutResource* SenderResource, ID3D11Resource* Source)
+{
+	if (!SenderResource->DeltaSender.IsValid())
+	{
+		DeviceContext11->CopyResource(SenderResource->SharedSenderTexture, Source);
+		return;
+	}
+
+	uint64 BytesSent = SenderResource->DeltaSender->Send(Device11, DeviceContext11, Source, SenderResource->SharedSenderTexture);
+	RecordDeltaFrame(*SenderResource, BytesSent);
+}
+
 FSpoutResource* PrepareSenderStructForSending(const FTexture2DRHIRef SrcTexture, FString spoutName)
 {
 	FIntPoint SourceSize = SrcTexture->GetSizeXY();
@@ -337,6 +483,11 @@ void USpoutInterface::OpenSpout()
 		});
 }
 
+bool USpoutInterface::IsSpoutOpen()
+{
+	return Initialised;
+}
+
 void USpoutInterface::CloseSender(FString spoutName)
 {
 	if (IsSpoutResourceRegistered(spoutName)) UnregisterSpout(spoutName);
@@ -376,6 +527,8 @@ void USpoutInterface::CloseSpout()
 		[](FRHICommandListImmediate& RHICmdList) {
 			UE_LOG(SpoutLog, Display, TEXT("Closing Spout"));
 
+			ReleaseSharedTexturePool();
+
 			FString RHIName = GDynamicRHI->GetName();
 			if (RHIName == TEXT("D3D12"))
 			{
@@ -400,6 +553,10 @@ void USpoutInterface::CloseSpout()
 				delete senderNames;
 				senderNames = nullptr;
 			}
+			{
+				FScopeLock Lock(&SenderSnapshotLock);
+				SenderSnapshots.Empty();
+			}
 			if (sdx != nullptr)
 			{
 				delete sdx;
@@ -409,7 +566,7 @@ void USpoutInterface::CloseSpout()
 		});
 }
 
-void USpoutInterface::Sender(FString spoutName, UTextureRenderTarget2D* textureRenderTarget2D)
+void USpoutInterface::Sender(FString spoutName, UTextureRenderTarget2D* textureRenderTarget2D, bool DeltaMode)
 {
 
 	if (textureRenderTarget2D == nullptr)
@@ -419,7 +576,7 @@ void USpoutInterface::Sender(FString spoutName, UTextureRenderTarget2D* textureR
 	}
 
 	ENQUEUE_RENDER_COMMAND(void)(
-		[spoutName, textureRenderTarget2D](FRHICommandListImmediate& RHICmdList) {
+		[spoutName, textureRenderTarget2D, DeltaMode](FRHICommandListImmediate& RHICmdList) {
 			if (!Initialised)
 			{
 				UE_LOG(SpoutLog, Error, TEXT("You need to open spout first"));
@@ -433,9 +590,17 @@ void USpoutInterface::Sender(FString spoutName, UTextureRenderTarget2D* textureR
 				UE_LOG(SpoutLog, Error, TEXT("Couldn't prepare sender struct"));
 				return;
 			}
-			// Copy sending texture into shared texture
-			ID3D11Texture2D* targetTex = SenderResource->SharedSenderTexture;
+			// Delta state is tied to the shared texture, which is recreated on resize
+			if (DeltaMode && !SenderResource->DeltaSender.IsValid())
+			{
+				SenderResource->DeltaSender = MakeShared<FSpoutDeltaSender>(spoutName, SenderResource->Width, SenderResource->Height, SenderResource->Format);
+			}
+			else if (!DeltaMode && SenderResource->DeltaSender.IsValid())
+			{
+				SenderResource->DeltaSender.Reset();
+			}
 
+			// Copy sending texture into shared texture
 			FString RHIName = GDynamicRHI->GetName();
 			if (RHIName == TEXT("D3D12"))
 			{
@@ -448,7 +613,7 @@ void USpoutInterface::Sender(FString spoutName, UTextureRenderTarget2D* textureR
 				// Get our Source Resource from d3d12 to be available for use with d3d11
 				Device11on12->AcquireWrappedResources(&WrappedDX11SrcResource, 1);
 				// copy it using the d3d11 context into a d3d11 shared texture
-				DeviceContext11->CopyResource(targetTex, WrappedDX11SrcResource);
+				CopyToSharedTexture(SenderResource, WrappedDX11SrcResource);
 				// Release the source Resource so it can be used again with d3d12
 				Device11on12->ReleaseWrappedResources(&WrappedDX11SrcResource, 1);
 				// submit d3d11 commands to the GPU
@@ -457,32 +622,68 @@ void USpoutInterface::Sender(FString spoutName, UTextureRenderTarget2D* textureR
 			else // (RHIName == TEXT("D3D11"))
 			{
 				ID3D11Texture2D* Source = (ID3D11Texture2D*)Src->GetNativeResource();
-				DeviceContext11->CopyResource(targetTex, Source);
+				CopyToSharedTexture(SenderResource, Source);
 				DeviceContext11->Flush();
 			}
+			if (SenderResource->DeltaSender.IsValid())
+			{
+				SenderResource->DeltaSender->Publish(DeviceContext11);
+			}
 			senderNames->UpdateSender(TCHAR_TO_ANSI(*spoutName), SenderResource->Width, SenderResource->Height, SenderResource->Handle);
+
+			if (!SenderResource->FrameSignal.IsValid())
+			{
+				SenderResource->FrameSignal = MakeShared<FSpoutFrameSignal>();
+				SenderResource->FrameSignal->Create(spoutName);
+			}
+			SenderResource->FrameSignal->Publish();
 		});
 
 	return;
 }
 
-void USpoutInterface::Receiver(FString spoutName, UTextureRenderTarget2D* textureRenderTarget2D, bool Force_RGBA8_SRGB)
+bool USpoutInterface::UpdateReceiverTarget(FString spoutName, UTextureRenderTarget2D* textureRenderTarget2D, bool Force_RGBA8_SRGB)
 {
 	if (textureRenderTarget2D == nullptr)
 	{
 		UE_LOG(SpoutLog, Warning, TEXT("No Texture2D Selected!"));
-		return;
+		return false;
 	}
 
-	if (textureRenderTarget2D->RenderTargetFormat != RTF_RGBA8_SRGB && Force_RGBA8_SRGB)
+	// Reallocate the render target only when the sender changes, the receive path converts any supported format
+	// into whatever format the render target has, so the format is only forced when asked to
+	// The sender is only known once ReceiveFrame has seen it, until then the render target keeps its size and
+	// the receive path skips frames that don't fit.
+	uint32 SenderWidth = 0;
+	uint32 SenderHeight = 0;
+	bool bSenderFound = false;
+	{
+		FScopeLock Lock(&SenderSnapshotLock);
+		if (const FSpoutSenderSnapshot* Snapshot = SenderSnapshots.Find(spoutName))
+		{
+			SenderWidth = Snapshot->Width;
+			SenderHeight = Snapshot->Height;
+			bSenderFound = true;
+		}
+	}
+	const ETextureRenderTargetFormat WantedFormat = Force_RGBA8_SRGB ? RTF_RGBA8_SRGB : textureRenderTarget2D->RenderTargetFormat;
+	if (bSenderFound && SenderWidth > 0 && SenderHeight > 0
+		&& (textureRenderTarget2D->SizeX != int32(SenderWidth) || textureRenderTarget2D->SizeY != int32(SenderHeight) || textureRenderTarget2D->RenderTargetFormat != WantedFormat))
 	{
-		textureRenderTarget2D->RenderTargetFormat = RTF_RGBA8_SRGB;
+		textureRenderTarget2D->SizeX = SenderWidth;
+		textureRenderTarget2D->SizeY = SenderHeight;
+		textureRenderTarget2D->RenderTargetFormat = WantedFormat;
 		textureRenderTarget2D->UpdateResource();
-		UE_LOG(SpoutLog, Warning, TEXT("Setting format to RTF_RGBA8_SRGB on Render Target %s  "), *textureRenderTarget2D->GetFName().GetPlainNameString());
+		UE_LOG(SpoutLog, Display, TEXT("Receiver %s: render target %s set to %i x %i"), *spoutName, *textureRenderTarget2D->GetFName().GetPlainNameString(), SenderWidth, SenderHeight);
 	}
+	return true;
+}
 
+void USpoutInterface::ReceiveFrame(FString spoutName, UTextureRenderTarget2D* textureRenderTarget2D, TFunction<void()> OnDone)
+{
 	ENQUEUE_RENDER_COMMAND(void)(
-		[spoutName, textureRenderTarget2D](FRHICommandListImmediate& RHICmdList) {
+		[spoutName, textureRenderTarget2D, OnDone](FRHICommandListImmediate& RHICmdList) {
+			ON_SCOPE_EXIT{ if (OnDone) OnDone(); };
 			if (!Initialised)
 			{
 				UE_LOG(SpoutLog, Error, TEXT("You need to open spout first"));
@@ -492,6 +693,17 @@ void USpoutInterface::Receiver(FString spoutName, UTextureRenderTarget2D* textur
 			bool ResourceExists = DoesSpoutResourceExist(spoutName);
 			bool ResourceRegistered = IsSpoutResourceRegistered(spoutName);
 
+			unsigned int SenderWidth = 0;
+			unsigned int SenderHeight = 0;
+			HANDLE SenderHandle = nullptr;
+			unsigned long SenderFormat = 0;
+			const bool bSenderFound = ResourceExists && senderNames->GetSenderInfo(TCHAR_TO_ANSI(*spoutName), SenderWidth, SenderHeight, SenderHandle, SenderFormat);
+			{
+				FScopeLock Lock(&SenderSnapshotLock);
+				if (bSenderFound) SenderSnapshots.Add(spoutName, { SenderWidth, SenderHeight, DXGI_FORMAT(SenderFormat) });
+				else SenderSnapshots.Remove(spoutName);
+			}
+
 			if (!ResourceExists)
 			{
 				if (!RecieverNoNameWarningIssued)
@@ -503,6 +715,16 @@ void USpoutInterface::Receiver(FString spoutName, UTextureRenderTarget2D* textur
 				if(ResourceRegistered) CloseSender(spoutName);
 				return;
 			}
+			if (ResourceRegistered)
+			{
+				// a resized sender publishes a new shared texture, reopen it
+				FSpoutResource* Registered = GetRegistredSpout(spoutName);
+				if (bSenderFound && SenderHandle != Registered->Handle)
+				{
+					UnregisterSpout(spoutName);
+					ResourceRegistered = false;
+				}
+			}
 			if (!ResourceRegistered)
 			{
 				if (!CreateRegisterReceiver(spoutName, textureRenderTarget2D)) return;
@@ -510,51 +732,32 @@ void USpoutInterface::Receiver(FString spoutName, UTextureRenderTarget2D* textur
 
 			FSpoutResource* ReciverResource = GetRegistredSpout(spoutName);
 
-			// Update Receiving Render Target
-			ID3D11Texture2D* Source = ReciverResource->SharedSenderTexture;
-			textureRenderTarget2D->ResizeTarget(ReciverResource->Width, ReciverResource->Height);
-			if (ReciverResource->Format != DXGI_FORMAT_B8G8R8A8_UNORM
-				&& !RecieverFormatWarningIssued)
+			if (!FSpoutReceiveBuffer::IsSupportedSourceFormat(ReciverResource->Format))
 			{
-				UE_LOG(SpoutLog, Warning, TEXT("Reciever %s is trying to read unsuppoted texture format."), *spoutName);
-				UE_LOG(SpoutLog, Warning, TEXT("Try deselecting  Force_RGBA8_SRGB and changing pixel formarts in Render Target Editor"));
-				UE_LOG(SpoutLog, Warning, TEXT("Or change format of your sending texture to DXGI_FORMAT_B8G8R8A8_UNORM"));
-				RecieverFormatWarningIssued = true;
-			}
-
-			FTexture2DRHIRef Target = textureRenderTarget2D->Resource->TextureRHI->GetTexture2D();
-
-			FString RHIName = GDynamicRHI->GetName();
-			if (RHIName == TEXT("D3D12"))
-			{
-				ID3D11Resource* WrappedDX11SrcResource = nullptr;
-				if (!WrapDX12Resource(Target, &WrappedDX11SrcResource))
+				if (!RecieverFormatWarningIssued)
 				{
-					UE_LOG(SpoutLog, Error, TEXT("Couldn't wrap dx12 resource"));
-					return;
+					UE_LOG(SpoutLog, Warning, TEXT("Reciever %s is trying to read unsuppoted texture format %i."), *spoutName, int(ReciverResource->Format));
+					UE_LOG(SpoutLog, Warning, TEXT("Supported sender formats are RGBA16F, R10G10B10A2, RGBA8 and BGRA8"));
+					RecieverFormatWarningIssued = true;
 				}
-				// Get our Source Resource from d3d12 to be available for use with d3d11
-				Device11on12->AcquireWrappedResources(&WrappedDX11SrcResource, 1);
-				// copy it using the d3d11 context into a d3d11 shared texture
-				DeviceContext11->CopyResource(WrappedDX11SrcResource, Source);
-				// Release the source Resource so it can be used again with d3d12
-				Device11on12->ReleaseWrappedResources(&WrappedDX11SrcResource, 1);
-				// submit d3d11 commands to the GPU
-				DeviceContext11->Flush();
-			}
-			else // (RHIName == TEXT("D3D11"))
-			{
-				
-				ID3D11Texture2D* targetTex = (ID3D11Texture2D*)Target->GetNativeResource();
-				DeviceContext11->CopyResource(targetTex, Source);
-				DeviceContext11->Flush();
+				return;
 			}
 
+			ReciverResource->ReceiveBuffer->Receive(RHICmdList, Device11, DeviceContext11, Device11on12, ReciverResource->SharedSenderTexture,
+				ReciverResource->Width, ReciverResource->Height, ReciverResource->Format, textureRenderTarget2D->GetRenderTargetResource());
 		});
 
 	return;
 }
 
+void USpoutInterface::Receiver(FString spoutName, UTextureRenderTarget2D* textureRenderTarget2D, bool Force_RGBA8_SRGB)
+{
+	if (UpdateReceiverTarget(spoutName, textureRenderTarget2D, Force_RGBA8_SRGB))
+	{
+		ReceiveFrame(spoutName, textureRenderTarget2D);
+	}
+}
+
 void USpoutInterface::CloseReceiver(FString spoutName)
 {
 	if (IsSpoutResourceRegistered(spoutName)) 
@@ -562,8 +765,39 @@ void USpoutInterface::CloseReceiver(FString spoutName)
 		if (GetRegistredSpout(spoutName)->ReceiverRT != nullptr) GetRegistredSpout(spoutName)->ReceiverRT->UpdateResource();
 		UnregisterSpout(spoutName);
 	}
+	{
+		FScopeLock Lock(&SenderSnapshotLock);
+		SenderSnapshots.Remove(spoutName);
+	}
 	UE_LOG(SpoutLog, Display, TEXT("Closed Receiver %s."), *spoutName);
 	RecieverFormatWarningIssued = false;
 	RecieverNoNameWarningIssued = false;
 }
 
+
+bool USpoutInterface::GetDeltaStats(FString spoutName, FSpoutDeltaStats& OutStats)
+{
+	FScopeLock Lock(&DeltaStatsLock);
+	const FSpoutDeltaStats* Stats = DeltaStatsBySender.Find(spoutName);
+	if (Stats == nullptr) return false;
+	OutStats = *Stats;
+	return true;
+}
+
+void USpoutInterface::ResetDeltaStats(FString spoutName)
+{
+	FScopeLock Lock(&DeltaStatsLock);
+	DeltaStatsBySender.Remove(spoutName);
+}
+
+void USpoutInterface::GetSharedTexturePoolStats(int32& OutInUse, int32& OutFree, uint64& OutFreeBytes)
+{
+	FScopeLock Lock(&SharedTexturePoolLock);
+	OutInUse = SharedTexturesInUse;
+	OutFree = FreeSharedTextures.Num();
+	OutFreeBytes = 0;
+	for (const FPooledSharedTexture& Pooled : FreeSharedTextures)
+	{
+		OutFreeBytes += uint64(Pooled.Width) * Pooled.Height * GetSpoutBytesPerPixel(Pooled.Format);
+	}
+}
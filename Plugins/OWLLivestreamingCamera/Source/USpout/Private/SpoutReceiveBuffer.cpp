@@ -0,0 +1,310 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#include "SpoutReceiveBuffer.h"
+#include "SpoutModule.h"
+#include "TextureResource.h"
+
+#include "Windows/AllowWindowsPlatformTypes.h"
+THIRD_PARTY_INCLUDES_START
+#include <d3d11_1.h>
+#include <d3dcompiler.h>
+THIRD_PARTY_INCLUDES_END
+#include "Windows/HideWindowsPlatformTypes.h"
+
+// Full screen triangle, every target pixel loads the matching source pixel. Format conversion happens in the
+// views: 8 bit formats are read and written through sRGB views, float and 10 bit formats are treated as linear.
+static const char* ConversionShaderSource = R"(
+Texture2D<float4> Source : register(t0);
+
+float4 MainVS(uint VertexId : SV_VertexID) : SV_Position
+{
+	float2 UV = float2((VertexId << 1) & 2, VertexId & 2);
+	return float4(UV * float2(2, -2) + float2(-1, 1), 0, 1);
+}
+
+float4 MainPS(float4 Position : SV_Position) : SV_Target
+{
+	return Source.Load(int3(Position.xy, 0));
+}
+)";
+
+template<typename T>
+static void SafeRelease(T*& Object)
+{
+	if (Object != nullptr)
+	{
+		Object->Release();
+		Object = nullptr;
+	}
+}
+
+static DXGI_FORMAT GetTypelessFormat(DXGI_FORMAT Format)
+{
+	switch (Format)
+	{
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		return DXGI_FORMAT_B8G8R8A8_TYPELESS;
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		return DXGI_FORMAT_R8G8B8A8_TYPELESS;
+	case DXGI_FORMAT_R10G10B10A2_UNORM:
+		return DXGI_FORMAT_R10G10B10A2_TYPELESS;
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		return DXGI_FORMAT_R16G16B16A16_TYPELESS;
+	default:
+		return Format;
+	}
+}
+
+static bool IsEightBitFormat(DXGI_FORMAT Format)
+{
+	const DXGI_FORMAT Typeless = GetTypelessFormat(Format);
+	return Typeless == DXGI_FORMAT_B8G8R8A8_TYPELESS || Typeless == DXGI_FORMAT_R8G8B8A8_TYPELESS;
+}
+
+// 8 bit content is sRGB encoded, views on 8 bit textures decode and encode it
+static DXGI_FORMAT GetViewFormat(DXGI_FORMAT Format)
+{
+	switch (GetSpoutTypedFormat(GetTypelessFormat(Format)))
+	{
+	case DXGI_FORMAT_B8G8R8A8_UNORM: return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+	case DXGI_FORMAT_R8G8B8A8_UNORM: return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+	default: return GetSpoutTypedFormat(GetTypelessFormat(Format));
+	}
+}
+
+static ID3DBlob* CompileConversionShader(const char* EntryPoint, const char* Target)
+{
+	ID3DBlob* Bytecode = nullptr;
+	ID3DBlob* Errors = nullptr;
+	HRESULT hr = D3DCompile(ConversionShaderSource, FCStringAnsi::Strlen(ConversionShaderSource), "SpoutReceiveConversion", nullptr, nullptr,
+		EntryPoint, Target, D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, &Bytecode, &Errors);
+	if (FAILED(hr))
+	{
+		UE_LOG(SpoutLog, Warning, TEXT("Receiver: format conversion shader failed to compile"));
+		if (Errors != nullptr) UE_LOG(SpoutLog, Warning, TEXT("%s"), ANSI_TO_TCHAR((const char*)Errors->GetBufferPointer()));
+		Bytecode = nullptr;
+	}
+	SafeRelease(Errors);
+	return Bytecode;
+}
+
+FSpoutReceiveBuffer::FSpoutReceiveBuffer(const FString& InSenderName)
+	: SenderName(InSenderName)
+	, DeltaReceiver(InSenderName)
+{
+}
+
+FSpoutReceiveBuffer::~FSpoutReceiveBuffer()
+{
+	ReleaseResources();
+	SafeRelease(ConversionVS);
+	SafeRelease(ConversionPS);
+	SafeRelease(ConversionState);
+}
+
+bool FSpoutReceiveBuffer::IsSupportedSourceFormat(DXGI_FORMAT Format)
+{
+	switch (GetTypelessFormat(Format))
+	{
+	case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+	case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+	case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+	case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void FSpoutReceiveBuffer::ReleaseResources()
+{
+	SafeRelease(ReceiveSRV);
+	SafeRelease(ReceiveTexture);
+	for (int32 Index = 0; Index < 2; ++Index)
+	{
+		SafeRelease(IntermediateRTVs[Index]);
+		SafeRelease(NativeIntermediates[Index]);
+		Intermediates[Index].SafeRelease();
+	}
+	bFrontBufferValid = false;
+	bFrontBufferCopied = false;
+	DeltaReceiver.Invalidate();
+}
+
+bool FSpoutReceiveBuffer::CreateConversionPipeline(ID3D11Device* Device)
+{
+	if (ConversionState != nullptr) return true;
+
+	static ID3DBlob* VSBytecode = CompileConversionShader("MainVS", "vs_5_0");
+	static ID3DBlob* PSBytecode = CompileConversionShader("MainPS", "ps_5_0");
+	if (VSBytecode == nullptr || PSBytecode == nullptr) return false;
+
+	if (FAILED(Device->CreateVertexShader(VSBytecode->GetBufferPointer(), VSBytecode->GetBufferSize(), nullptr, &ConversionVS))) return false;
+	if (FAILED(Device->CreatePixelShader(PSBytecode->GetBufferPointer(), PSBytecode->GetBufferSize(), nullptr, &ConversionPS))) return false;
+
+	ID3D11Device1* Device1 = nullptr;
+	if (FAILED(Device->QueryInterface(__uuidof(ID3D11Device1), (void**)&Device1))) return false;
+	const D3D_FEATURE_LEVEL FeatureLevel = Device->GetFeatureLevel();
+	HRESULT hr = Device1->CreateDeviceContextState(0, &FeatureLevel, 1, D3D11_SDK_VERSION, __uuidof(ID3D11Device1), nullptr, &ConversionState);
+	Device1->Release();
+	return SUCCEEDED(hr);
+}
+
+bool FSpoutReceiveBuffer::CreateResources(FRHICommandListImmediate& RHICmdList, ID3D11Device* Device, ID3D11On12Device* Device11on12, FRHITexture2D* TargetTexture)
+{
+	ReleaseResources();
+
+	D3D11_TEXTURE2D_DESC ReceiveDesc = {};
+	ReceiveDesc.Width = Width;
+	ReceiveDesc.Height = Height;
+	ReceiveDesc.MipLevels = 1;
+	ReceiveDesc.ArraySize = 1;
+	// typeless so the conversion can read 8 bit sources through an sRGB view
+	ReceiveDesc.Format = GetTypelessFormat(SourceFormat);
+	ReceiveDesc.SampleDesc.Count = 1;
+	ReceiveDesc.Usage = D3D11_USAGE_DEFAULT;
+	ReceiveDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	if (FAILED(Device->CreateTexture2D(&ReceiveDesc, nullptr, &ReceiveTexture))) return false;
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
+	SRVDesc.Format = IsEightBitFormat(SourceFormat) ? GetViewFormat(SourceFormat) : GetSpoutTypedFormat(ReceiveDesc.Format);
+	SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	SRVDesc.Texture2D.MipLevels = 1;
+	if (FAILED(Device->CreateShaderResourceView(ReceiveTexture, &SRVDesc, &ReceiveSRV))) return false;
+
+	const ETextureCreateFlags SRGBFlag = bTargetSRGB ? TexCreate_SRGB : TexCreate_None;
+	for (int32 Index = 0; Index < 2; ++Index)
+	{
+		FRHIResourceCreateInfo CreateInfo;
+		Intermediates[Index] = RHICreateTexture2D(Width, Height, TargetFormat, 1, 1, TexCreate_RenderTargetable | TexCreate_ShaderResource | SRGBFlag, CreateInfo);
+		if (!Intermediates[Index].IsValid()) return false;
+		// the intermediates are only ever a copy source on the engine side, that is also the state the spout device leaves them in
+		RHICmdList.Transition(FRHITransitionInfo(Intermediates[Index], ERHIAccess::Unknown, ERHIAccess::CopySrc));
+
+		if (bIsD3D12)
+		{
+			D3D11_RESOURCE_FLAGS Flags = {};
+			Flags.BindFlags = D3D11_BIND_RENDER_TARGET;
+			HRESULT hr = Device11on12->CreateWrappedResource((ID3D12Resource*)Intermediates[Index]->GetNativeResource(), &Flags,
+				D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE, __uuidof(ID3D11Resource), (void**)&NativeIntermediates[Index]);
+			if (FAILED(hr)) return false;
+			// wrapped resources are created acquired
+			Device11on12->ReleaseWrappedResources(&NativeIntermediates[Index], 1);
+		}
+		else
+		{
+			NativeIntermediates[Index] = (ID3D11Resource*)Intermediates[Index]->GetNativeResource();
+			NativeIntermediates[Index]->AddRef();
+		}
+
+		ID3D11Texture2D* NativeTexture = nullptr;
+		if (FAILED(NativeIntermediates[Index]->QueryInterface(__uuidof(ID3D11Texture2D), (void**)&NativeTexture))) return false;
+		D3D11_TEXTURE2D_DESC IntermediateDesc;
+		NativeTexture->GetDesc(&IntermediateDesc);
+		NativeTexture->Release();
+
+		bCopyWithoutConversion = GetTypelessFormat(IntermediateDesc.Format) == GetTypelessFormat(SourceFormat);
+		if (bCopyWithoutConversion) continue;
+
+		D3D11_RENDER_TARGET_VIEW_DESC RTVDesc = {};
+		RTVDesc.Format = IsEightBitFormat(IntermediateDesc.Format) ? GetViewFormat(IntermediateDesc.Format) : GetSpoutTypedFormat(IntermediateDesc.Format);
+		RTVDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+		if (FAILED(Device->CreateRenderTargetView(NativeIntermediates[Index], &RTVDesc, &IntermediateRTVs[Index]))) return false;
+	}
+
+	// make sure the engine side transitions have happened before the spout device touches the intermediates
+	RHICmdList.SubmitCommandsAndFlushGPU();
+
+	UE_LOG(SpoutLog, Display, TEXT("Receiver %s: receiving %u x %u, source format %i into pixel format %s (%s)"), *SenderName, Width, Height, int(SourceFormat),
+		GPixelFormats[TargetFormat].Name, bCopyWithoutConversion ? TEXT("copy") : TEXT("converted"));
+	return true;
+}
+
+void FSpoutReceiveBuffer::Convert(ID3D11DeviceContext* Context, ID3D11RenderTargetView* TargetView)
+{
+	ID3D11DeviceContext1* Context1 = nullptr;
+	if (FAILED(Context->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&Context1))) return;
+
+	ID3DDeviceContextState* PreviousState = nullptr;
+	Context1->SwapDeviceContextState(ConversionState, &PreviousState);
+
+	D3D11_VIEWPORT Viewport = { 0.0f, 0.0f, float(Width), float(Height), 0.0f, 1.0f };
+	Context->RSSetViewports(1, &Viewport);
+	Context->OMSetRenderTargets(1, &TargetView, nullptr);
+	Context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	Context->VSSetShader(ConversionVS, nullptr, 0);
+	Context->PSSetShader(ConversionPS, nullptr, 0);
+	Context->PSSetShaderResources(0, 1, &ReceiveSRV);
+	Context->Draw(3, 0);
+
+	ID3D11ShaderResourceView* NullSRV = nullptr;
+	Context->PSSetShaderResources(0, 1, &NullSRV);
+	Context->OMSetRenderTargets(0, nullptr, nullptr);
+
+	Context1->SwapDeviceContextState(PreviousState, nullptr);
+	SafeRelease(PreviousState);
+	Context1->Release();
+}
+
+bool FSpoutReceiveBuffer::Receive(FRHICommandListImmediate& RHICmdList, ID3D11Device* Device, ID3D11DeviceContext* Context, ID3D11On12Device* Device11on12,
+	ID3D11Resource* Shared, uint32 InWidth, uint32 InHeight, DXGI_FORMAT InSourceFormat, FTextureRenderTargetResource* Target)
+{
+	if (Target == nullptr || Target->TextureRHI == nullptr) return false;
+	FRHITexture2D* TargetTexture = Target->TextureRHI->GetTexture2D();
+	// the game thread resizes the render target when the sender changes, skip frames until that has landed
+	if (TargetTexture == nullptr || TargetTexture->GetSizeX() != InWidth || TargetTexture->GetSizeY() != InHeight) return false;
+
+	const EPixelFormat InTargetFormat = TargetTexture->GetFormat();
+	const bool bInTargetSRGB = EnumHasAnyFlags(TargetTexture->GetFlags(), TexCreate_SRGB);
+	if (InWidth != Width || InHeight != Height || InSourceFormat != SourceFormat || InTargetFormat != TargetFormat || bInTargetSRGB != bTargetSRGB || !Intermediates[0].IsValid())
+	{
+		Width = InWidth;
+		Height = InHeight;
+		SourceFormat = InSourceFormat;
+		TargetFormat = InTargetFormat;
+		bTargetSRGB = bInTargetSRGB;
+		bIsD3D12 = Device11on12 != nullptr;
+		if (!CreateResources(RHICmdList, Device, Device11on12, TargetTexture) || (!bCopyWithoutConversion && !CreateConversionPipeline(Device)))
+		{
+			UE_LOG(SpoutLog, Error, TEXT("Receiver %s: couldn't create receive buffers"), *SenderName);
+			ReleaseResources();
+			return false;
+		}
+	}
+
+	// shared texture into our own copy, only the dirty tiles if the sender publishes them, nothing if it published no new frame
+	DeltaReceiver.SetTarget(ReceiveTexture);
+	uint64 BytesCopied = 0;
+	const bool bNewFrame = DeltaReceiver.Receive(Context, Shared, ReceiveTexture, Width, Height, SourceFormat, BytesCopied);
+
+	// our copy into the back buffer in the render target's format
+	if (bNewFrame)
+	{
+		ID3D11Resource* BackResource = NativeIntermediates[BackBuffer];
+		if (bIsD3D12) Device11on12->AcquireWrappedResources(&BackResource, 1);
+		if (bCopyWithoutConversion) Context->CopyResource(BackResource, ReceiveTexture);
+		else Convert(Context, IntermediateRTVs[BackBuffer]);
+		if (bIsD3D12) Device11on12->ReleaseWrappedResources(&BackResource, 1);
+		Context->Flush();
+	}
+
+	// the front buffer was finished a frame ago, copy it into the render target on the engine's queue once
+	if (TargetTexture != LastTargetTexture) bFrontBufferCopied = false;
+	LastTargetTexture = TargetTexture;
+	if (bFrontBufferValid && !bFrontBufferCopied)
+	{
+		RHICmdList.Transition(FRHITransitionInfo(TargetTexture, ERHIAccess::Unknown, ERHIAccess::CopyDest));
+		RHICmdList.CopyTexture(Intermediates[1 - BackBuffer], TargetTexture, FRHICopyTextureInfo());
+		RHICmdList.Transition(FRHITransitionInfo(TargetTexture, ERHIAccess::CopyDest, ERHIAccess::SRVMask));
+		bFrontBufferCopied = true;
+	}
+	if (bNewFrame)
+	{
+		bFrontBufferValid = true;
+		bFrontBufferCopied = false;
+		BackBuffer = 1 - BackBuffer;
+	}
+	return true;
+}
@@ -0,0 +1,70 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpoutInterface.h"
+#include "SpoutDelta.h"
+#include "RHI.h"
+
+struct ID3D11DeviceContext1;
+struct ID3DDeviceContextState;
+
+/*
+ * Receive path of a spout receiver.
+ * The shared texture is copied (dirty tiles only for delta senders) into a texture owned by the receiver, then
+ * converted into the render target's format in one of two intermediates. The intermediate completed on the
+ * previous frame is copied into the render target with the engine's RHI, so the render target is only written
+ * on the engine's own queue and always from a finished frame, never while the spout device is writing it.
+ * Sources can be RGBA16F, R10G10B10A2, RGBA8 or BGRA8 regardless of the render target format.
+ */
+class FSpoutReceiveBuffer
+{
+public:
+	explicit FSpoutReceiveBuffer(const FString& InSenderName);
+	~FSpoutReceiveBuffer();
+
+	/* Render thread. Returns false if the frame was skipped, e.g. while a resize of the render target is pending. */
+	bool Receive(FRHICommandListImmediate& RHICmdList, ID3D11Device* Device, ID3D11DeviceContext* Context, ID3D11On12Device* Device11on12,
+		ID3D11Resource* Shared, uint32 Width, uint32 Height, DXGI_FORMAT SourceFormat, FTextureRenderTargetResource* Target);
+
+	/* False for source formats the conversion pass can't read */
+	static bool IsSupportedSourceFormat(DXGI_FORMAT Format);
+
+private:
+	bool CreateResources(FRHICommandListImmediate& RHICmdList, ID3D11Device* Device, ID3D11On12Device* Device11on12, FRHITexture2D* TargetTexture);
+	bool CreateConversionPipeline(ID3D11Device* Device);
+	void Convert(ID3D11DeviceContext* Context, ID3D11RenderTargetView* TargetView);
+	void ReleaseResources();
+
+	FString SenderName;
+	FSpoutDeltaReceiver DeltaReceiver;
+
+	// what the resources were created for, anything changing recreates them
+	uint32 Width = 0;
+	uint32 Height = 0;
+	DXGI_FORMAT SourceFormat = DXGI_FORMAT_UNKNOWN;
+	EPixelFormat TargetFormat = PF_Unknown;
+	bool bTargetSRGB = false;
+	bool bIsD3D12 = false;
+	bool bCopyWithoutConversion = false;
+
+	// copy of the shared texture, persistent so delta frames can be applied on top of it
+	ID3D11Texture2D* ReceiveTexture = nullptr;
+	ID3D11ShaderResourceView* ReceiveSRV = nullptr;
+
+	// double buffered intermediates in the render target's format, engine textures the spout device writes into
+	FTexture2DRHIRef Intermediates[2];
+	ID3D11Resource* NativeIntermediates[2] = { nullptr, nullptr };
+	ID3D11RenderTargetView* IntermediateRTVs[2] = { nullptr, nullptr };
+	int32 BackBuffer = 0;
+	bool bFrontBufferValid = false;
+	// the front buffer only needs copying into the render target once, unless the render target was recreated
+	bool bFrontBufferCopied = false;
+	FRHITexture2D* LastTargetTexture = nullptr;
+
+	// conversion pass, run in its own device context state so the engine's cached D3D11 state stays intact
+	ID3D11VertexShader* ConversionVS = nullptr;
+	ID3D11PixelShader* ConversionPS = nullptr;
+	ID3DDeviceContextState* ConversionState = nullptr;
+};
@@ -0,0 +1,67 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#include "SpoutTileDiff.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Returns true if the two rows differ anywhere in the first NumBytes bytes
+	FORCEINLINE bool RowDiffers(const uint8* A, const uint8* B, int32 NumBytes)
+	{
+		int32 Offset = 0;
+#if PLATFORM_CPU_X86_FAMILY
+		// 64 bytes per iteration, folding the four compares into one movemask
+		for (; Offset + 64 <= NumBytes; Offset += 64)
+		{
+			const __m128i Eq0 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(A + Offset)), _mm_loadu_si128((const __m128i*)(B + Offset)));
+			const __m128i Eq1 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(A + Offset + 16)), _mm_loadu_si128((const __m128i*)(B + Offset + 16)));
+			const __m128i Eq2 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(A + Offset + 32)), _mm_loadu_si128((const __m128i*)(B + Offset + 32)));
+			const __m128i Eq3 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(A + Offset + 48)), _mm_loadu_si128((const __m128i*)(B + Offset + 48)));
+			const __m128i AllEq = _mm_and_si128(_mm_and_si128(Eq0, Eq1), _mm_and_si128(Eq2, Eq3));
+			if (_mm_movemask_epi8(AllEq) != 0xFFFF) return true;
+		}
+		for (; Offset + 16 <= NumBytes; Offset += 16)
+		{
+			const __m128i Eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(A + Offset)), _mm_loadu_si128((const __m128i*)(B + Offset)));
+			if (_mm_movemask_epi8(Eq) != 0xFFFF) return true;
+		}
+#endif
+		return Offset < NumBytes && FMemory::Memcmp(A + Offset, B + Offset, NumBytes - Offset) != 0;
+	}
+}
+
+int32 SpoutTileDiff::CompareTiles(const uint8* Current, int32 CurrentPitch, const uint8* Previous, int32 PreviousPitch,
+	int32 Width, int32 Height, int32 BytesPerPixel, uint8* OutBitmap)
+{
+	const int32 TilesX = NumTilesX(Width);
+	const int32 TilesY = NumTilesY(Height);
+	FMemory::Memzero(OutBitmap, BitmapBytes(TilesX, TilesY));
+
+	int32 DirtyTiles = 0;
+	for (int32 TileY = 0; TileY < TilesY; ++TileY)
+	{
+		const int32 RowStart = TileY * TileSize;
+		const int32 RowEnd = FMath::Min(RowStart + TileSize, Height);
+
+		for (int32 TileX = 0; TileX < TilesX; ++TileX)
+		{
+			const int32 ColumnStart = TileX * TileSize;
+			const int32 SpanBytes = (FMath::Min(ColumnStart + TileSize, Width) - ColumnStart) * BytesPerPixel;
+			const int32 ByteOffset = ColumnStart * BytesPerPixel;
+
+			for (int32 Row = RowStart; Row < RowEnd; ++Row)
+			{
+				if (RowDiffers(Current + Row * CurrentPitch + ByteOffset, Previous + Row * PreviousPitch + ByteOffset, SpanBytes))
+				{
+					MarkTileDirty(OutBitmap, TileY * TilesX + TileX);
+					++DirtyTiles;
+					break;
+				}
+			}
+		}
+	}
+	return DirtyTiles;
+}
@@ -0,0 +1,55 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Tile helpers shared by the delta sender and the delta receiver
+namespace SpoutTileDiff
+{
+	/* Edge length in pixels of the square tiles frames are compared in */
+	static constexpr int32 TileSize = 64;
+
+	FORCEINLINE int32 NumTilesX(int32 Width) { return FMath::DivideAndRoundUp(Width, TileSize); }
+	FORCEINLINE int32 NumTilesY(int32 Height) { return FMath::DivideAndRoundUp(Height, TileSize); }
+	FORCEINLINE int32 BitmapBytes(int32 TilesX, int32 TilesY) { return FMath::DivideAndRoundUp(TilesX * TilesY, 8); }
+
+	FORCEINLINE bool IsTileDirty(const uint8* Bitmap, int32 TileIndex)
+	{
+		return (Bitmap[TileIndex >> 3] & (1 << (TileIndex & 7))) != 0;
+	}
+
+	FORCEINLINE void MarkTileDirty(uint8* Bitmap, int32 TileIndex)
+	{
+		Bitmap[TileIndex >> 3] |= (1 << (TileIndex & 7));
+	}
+
+	/**
+	 * Compares two CPU copies of a frame in TileSize x TileSize tiles using SSE2 where available.
+	 * Sets one bit per changed tile in OutBitmap (which must hold BitmapBytes(TilesX, TilesY) bytes)
+	 * and returns the number of changed tiles.
+	 */
+	int32 CompareTiles(const uint8* Current, int32 CurrentPitch, const uint8* Previous, int32 PreviousPitch,
+		int32 Width, int32 Height, int32 BytesPerPixel, uint8* OutBitmap);
+
+	/* Calls Visitor(TileX, TileY, RunLength) once per horizontal run of dirty tiles, so neighbouring tiles are copied in one go */
+	template<typename VisitorType>
+	void ForEachDirtyRun(const uint8* Bitmap, int32 TilesX, int32 TilesY, VisitorType&& Visitor)
+	{
+		for (int32 TileY = 0; TileY < TilesY; ++TileY)
+		{
+			int32 TileX = 0;
+			while (TileX < TilesX)
+			{
+				if (!IsTileDirty(Bitmap, TileY * TilesX + TileX))
+				{
+					++TileX;
+					continue;
+				}
+				const int32 RunStart = TileX;
+				while (TileX < TilesX && IsTileDirty(Bitmap, TileY * TilesX + TileX)) ++TileX;
+				Visitor(RunStart, TileY, TileX - RunStart);
+			}
+		}
+	}
+}
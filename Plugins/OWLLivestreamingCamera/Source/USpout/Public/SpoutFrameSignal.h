@@ -0,0 +1,46 @@
+// Copyright Off World Live Limited, 2020-2021. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class SpoutSharedMemory;
+
+/*
+ * Frame arrival notification next to a sender's shared texture.
+ * Senders count published frames in a small shared memory block and set a named event after each frame, so
+ * receivers can tell whether the shared texture holds a new frame and wait for one without polling it.
+ * The count is authoritative, the event is only a wake up hint: it is manual reset and shared by every receiver
+ * of a sender, so waits are bounded by a timeout and always re-read the count.
+ */
+class USPOUT_API FSpoutFrameSignal
+{
+public:
+	~FSpoutFrameSignal();
+
+	/* Sender side, attaches to an existing block so the count carries on across sender restarts */
+	bool Create(const FString& SenderName);
+	/* Sender side, call once the frame has been copied into the shared texture */
+	void Publish();
+
+	/* Receiver side, the block is opened lazily as the sender may not exist yet */
+	void Watch(const FString& InSenderName);
+	/* Receiver side. Returns the number of frames the sender has published, 0 if it doesn't publish a count. */
+	uint64 Poll();
+	/* Receiver side. Blocks until the count differs from LastSeen or the timeout elapses, returns the latest count. */
+	uint64 Wait(uint64 LastSeen, uint32 TimeoutMs);
+	/* Receiver side. False while the sender hasn't been found, e.g. senders from other applications */
+	bool IsConnected() const { return Memory != nullptr; }
+
+	void Close();
+
+private:
+	bool Open();
+	uint64 ReadCount();
+
+	FString SenderName;
+	SpoutSharedMemory* Memory = nullptr;
+	void* Event = nullptr;
+	uint64 FrameCount = 0;
+	double NextOpenTime = 0.0;
+};
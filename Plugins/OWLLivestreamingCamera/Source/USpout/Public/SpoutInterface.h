@@ -30,6 +30,24 @@ enum class ESpoutType : uint8 {
 	ST_Invalid 
 };
 
+/* Bandwidth accounting of a sender running in delta mode */
+struct FSpoutDeltaStats
+{
+	uint64 FramesSent = 0;
+	/* Bytes a full copy of every frame would have moved */
+	uint64 FullFrameBytes = 0;
+	/* Bytes actually copied into the shared texture */
+	uint64 BytesSent = 0;
+	/* Bytes read back from the GPU to find the changed tiles, a whole frame per frame when comparing on the CPU */
+	uint64 ReadbackBytes = 0;
+	uint32 LastDirtyTiles = 0;
+	uint32 TotalTiles = 0;
+
+	/* Negative when finding the changed tiles costs more than copying whole frames would */
+	int64 GetBytesSaved() const { return int64(FullFrameBytes) - int64(BytesSent) - int64(ReadbackBytes); }
+	float GetSavedFraction() const { return FullFrameBytes > 0 ? float(double(GetBytesSaved()) / double(FullFrameBytes)) : 0.0f; }
+};
+
 struct FSpoutResource
 {
 	FString Name;
@@ -41,6 +59,12 @@ struct FSpoutResource
 	DXGI_FORMAT Format;
 	ESpoutType SpoutType;
 	UTextureRenderTarget2D* ReceiverRT;
+	// Delta transport state, only valid while delta mode is in use
+	TSharedPtr<class FSpoutDeltaSender> DeltaSender;
+	// Frame count receivers watch to only copy new frames
+	TSharedPtr<class FSpoutFrameSignal> FrameSignal;
+	// Receiver Only Stuff
+	TSharedPtr<class FSpoutReceiveBuffer> ReceiveBuffer;
 
 	FSpoutResource()
 	{
@@ -64,10 +88,26 @@ class USPOUT_API USpoutInterface : public UObject
 public:
 	static void OpenSpout();
 	static void CloseSpout();
+	/* False until the render thread has opened the spout device, and always without a D3D RHI */
+	static bool IsSpoutOpen();
 
-	static void Sender(FString spoutName, UTextureRenderTarget2D* textureRenderTarget2D);
+	/* Publishes the render target. In delta mode only the 64x64 tiles that changed since the last frame are copied. */
+	static void Sender(FString spoutName, UTextureRenderTarget2D* textureRenderTarget2D, bool DeltaMode = false);
 	static void CloseSender(FString spoutName);
 
+	/* Returns false if the sender has never run in delta mode */
+	static bool GetDeltaStats(FString spoutName, FSpoutDeltaStats& OutStats);
+	static void ResetDeltaStats(FString spoutName);
+
+	/* Shared textures of closed senders are pooled and handed to the next sender with the same name, size and format */
+	static void GetSharedTexturePoolStats(int32& OutInUse, int32& OutFree, uint64& OutFreeBytes);
+
+	/* Copies the sender into the render target. The render target is resized on the game thread only when the sender changes,
+	 * and the frame shows up one frame later as the receive path is double buffered */
 	static void Receiver(FString spoutName, UTextureRenderTarget2D* textureRenderTarget2D, bool Force_RGBA8_SRGB);
+	/* Game thread half of Receiver, matches the render target to the sender. Returns false if there is nothing to receive into. */
+	static bool UpdateReceiverTarget(FString spoutName, UTextureRenderTarget2D* textureRenderTarget2D, bool Force_RGBA8_SRGB);
+	/* Render thread half of Receiver, enqueue it from the game thread after UpdateReceiverTarget. OnDone runs on the render thread once the copy has been issued. */
+	static void ReceiveFrame(FString spoutName, UTextureRenderTarget2D* textureRenderTarget2D, TFunction<void()> OnDone = nullptr);
 	static void CloseReceiver(FString spoutName);
 };
\ No newline at end of file
@@ -72,6 +72,7 @@ public class USpout : ModuleRules
 
                 });
 
+            AddEngineThirdPartyPrivateStaticDependencies(Target, "DX11");
             AddEngineThirdPartyPrivateStaticDependencies(Target, "DX12");
             AddEngineThirdPartyPrivateStaticDependencies(Target, "NVAftermath");
 
@@ -9,6 +9,6 @@ public class Broadcast_TestMapTarget : TargetRules
 	{
 		Type = TargetType.Game;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
-		ExtraModuleNames.Add("Broadcast_TestMap");
+		ExtraModuleNames.AddRange(new string[] { "Broadcast_TestMap", "PoseStream" });
 	}
 }
@@ -9,6 +9,6 @@ public class Broadcast_TestMapEditorTarget : TargetRules
 	{
 		Type = TargetType.Editor;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
-		ExtraModuleNames.Add("Broadcast_TestMap");
+		ExtraModuleNames.AddRange(new string[] { "Broadcast_TestMap", "PoseStream", "PoseStreamEditor" });
 	}
 }
@@ -0,0 +1,15 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class PoseStream : ModuleRules
+{
+	public PoseStream(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "LiveLinkInterface", "AnimGraphRuntime" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Sockets", "Networking", "AnimationCore" });
+	}
+}
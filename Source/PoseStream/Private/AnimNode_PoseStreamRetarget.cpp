@@ -0,0 +1,174 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "AnimNode_PoseStreamRetarget.h"
+#include "PoseStreamModule.h"
+#include "PoseStreamSubsystem.h"
+#include "PoseStreamRecording.h"
+#include "AnimationRuntime.h"
+#include "Algo/Sort.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Engine/Engine.h"
+#include "Misc/Paths.h"
+
+DECLARE_CYCLE_STAT(TEXT("Retarget Solve"), STAT_PoseStreamRetarget, STATGROUP_PoseStream);
+
+struct FPoseStreamRetargetPlayback
+{
+	FString Path;
+	TSharedPtr<FPoseStreamRecording> Recording;
+	FPoseStreamRecordCursor Cursor;
+	FPoseStreamFrame Frame;
+	double Time = 0.0;
+};
+
+FBoneReference& FPoseStreamRetargetBoneMap::Get(int32 Bone)
+{
+	using namespace PoseStreamRetarget;
+	static FBoneReference FPoseStreamRetargetBoneMap::* const Members[NumBones] =
+	{
+		&FPoseStreamRetargetBoneMap::Pelvis,
+		&FPoseStreamRetargetBoneMap::Spine1, &FPoseStreamRetargetBoneMap::Spine2, &FPoseStreamRetargetBoneMap::Spine3,
+		&FPoseStreamRetargetBoneMap::Neck, &FPoseStreamRetargetBoneMap::Head,
+		&FPoseStreamRetargetBoneMap::ClavicleL, &FPoseStreamRetargetBoneMap::UpperArmL, &FPoseStreamRetargetBoneMap::LowerArmL, &FPoseStreamRetargetBoneMap::HandL,
+		&FPoseStreamRetargetBoneMap::ClavicleR, &FPoseStreamRetargetBoneMap::UpperArmR, &FPoseStreamRetargetBoneMap::LowerArmR, &FPoseStreamRetargetBoneMap::HandR,
+		&FPoseStreamRetargetBoneMap::ThighL, &FPoseStreamRetargetBoneMap::CalfL, &FPoseStreamRetargetBoneMap::FootL,
+		&FPoseStreamRetargetBoneMap::ThighR, &FPoseStreamRetargetBoneMap::CalfR, &FPoseStreamRetargetBoneMap::FootR,
+	};
+	check(Bone >= 0 && Bone < NumBones);
+	return this->*Members[Bone];
+}
+
+void FAnimNode_PoseStreamRetarget::PreUpdate(const UAnimInstance* InAnimInstance)
+{
+	bHasKeypoints = false;
+
+	if (!Recording.FilePath.IsEmpty())
+	{
+		// a recording that fails to open isn't retried until the path changes
+		if (!Playback.IsValid() || Playback->Path != Recording.FilePath)
+		{
+			Playback = MakeShared<FPoseStreamRetargetPlayback>();
+			Playback->Path = Recording.FilePath;
+			Playback->Recording = FPoseStreamRecording::Open(FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), Recording.FilePath));
+		}
+		return;
+	}
+	Playback.Reset();
+
+	const UPoseStreamSubsystem* Subsystem = GEngine != nullptr ? GEngine->GetEngineSubsystem<UPoseStreamSubsystem>() : nullptr;
+	if (Subsystem != nullptr)
+	{
+		CopyKeypoints(Subsystem->GetLatestFrame());
+	}
+}
+
+void FAnimNode_PoseStreamRetarget::UpdateInternal(const FAnimationUpdateContext& Context)
+{
+	Super::UpdateInternal(Context);
+	if (!Playback.IsValid() || !Playback->Recording.IsValid()) return;
+
+	const FPoseStreamRecording& PlaybackRecording = *Playback->Recording;
+	const double Duration = PlaybackRecording.GetDuration();
+	Playback->Time = Duration > 0.0 ? FMath::Fmod(Playback->Time + Context.GetDeltaTime() * PlayRate, Duration) : 0.0;
+	if (Playback->Time < 0.0) Playback->Time += Duration;
+
+	double FrameTime;
+	if (Playback->Cursor.ReadAtTime(PlaybackRecording, Playback->Time, Playback->Frame, FrameTime))
+	{
+		CopyKeypoints(Playback->Frame);
+	}
+}
+
+void FAnimNode_PoseStreamRetarget::CopyKeypoints(const FPoseStreamFrame& Frame)
+{
+	bHasKeypoints = false;
+	for (int32 PersonIndex = 0; PersonIndex < Frame.NumPeople; ++PersonIndex)
+	{
+		const FPoseStreamPerson& Person = Frame.People[PersonIndex];
+		if (Person.PersonId != PersonId) continue;
+
+		const int32 NumKeypoints = FMath::Clamp(Person.NumKeypoints, 0, (int32)PoseStream::MaxKeypoints);
+		FMemory::Memcpy(Keypoints, Person.Positions, NumKeypoints * sizeof(FVector));
+		FMemory::Memcpy(Confidences, Person.Confidences, NumKeypoints * sizeof(float));
+		for (int32 Keypoint = NumKeypoints; Keypoint < PoseStream::MaxKeypoints; ++Keypoint)
+		{
+			Keypoints[Keypoint] = FVector::ZeroVector;
+			Confidences[Keypoint] = 0.0f;
+		}
+		bHasKeypoints = true;
+		return;
+	}
+}
+
+bool FAnimNode_PoseStreamRetarget::Solve(const FVector* InKeypoints, const float* InConfidences, FTransform (&OutComponentSpace)[PoseStreamRetarget::NumBones]) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_PoseStreamRetarget);
+	return Solver.Solve(InKeypoints, InConfidences, KeypointRotation.Quaternion(), MinConfidence, OutComponentSpace);
+}
+
+void FAnimNode_PoseStreamRetarget::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms)
+{
+	check(OutBoneTransforms.Num() == 0);
+	if (!bHasKeypoints) return;
+
+	FTransform Solved[PoseStreamRetarget::NumBones];
+	if (!Solve(Keypoints, Confidences, Solved)) return;
+
+	for (int32 Index = 0; Index < NumOutputBones; ++Index)
+	{
+		const int32 Bone = OutputBones[Index];
+		OutBoneTransforms.Add(FBoneTransform(FCompactPoseBoneIndex(CompactIndices[Bone]), Solved[Bone]));
+	}
+}
+
+bool FAnimNode_PoseStreamRetarget::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones)
+{
+	return bBonesValid && Solver.IsInitialized();
+}
+
+void FAnimNode_PoseStreamRetarget::InitializeBoneReferences(const FBoneContainer& RequiredBones)
+{
+	using namespace PoseStreamRetarget;
+
+	bBonesValid = true;
+	FTransform RefComponentSpace[NumBones];
+	for (int32 Bone = 0; Bone < NumBones; ++Bone)
+	{
+		FBoneReference& Reference = Bones.Get(Bone);
+		Reference.Initialize(RequiredBones);
+		if (!Reference.IsValidToEvaluate(RequiredBones))
+		{
+			bBonesValid = false;
+			continue;
+		}
+		CompactIndices[Bone] = Reference.GetCompactPoseIndex(RequiredBones).GetInt();
+		RefComponentSpace[Bone] = FAnimationRuntime::GetComponentSpaceTransformRefPose(RequiredBones.GetReferenceSkeleton(), Reference.GetMeshPoseIndex(RequiredBones).GetInt());
+	}
+	if (!bBonesValid) return;
+
+	Solver.Initialize(RefComponentSpace);
+
+	// bone transforms have to reach the pose parents first, hands and feet are left to the incoming pose
+	NumOutputBones = 0;
+	for (int32 Bone = 0; Bone < NumBones; ++Bone)
+	{
+		if (Bone == HandL || Bone == HandR || Bone == FootL || Bone == FootR) continue;
+		OutputBones[NumOutputBones++] = (uint8)Bone;
+	}
+	Algo::SortBy(MakeArrayView(OutputBones, NumOutputBones), [this](uint8 Bone) { return CompactIndices[Bone]; });
+}
+
+void FAnimNode_PoseStreamRetarget::GatherDebugData(FNodeDebugData& DebugData)
+{
+	FString DebugLine = DebugData.GetNodeName(this);
+	DebugLine += FString::Printf(TEXT("(Person: %d%s"), PersonId, bHasKeypoints ? TEXT("") : TEXT(", not tracked"));
+	if (Playback.IsValid())
+	{
+		DebugLine += Playback->Recording.IsValid()
+			? FString::Printf(TEXT(", playing %s at %.2f s"), *FPaths::GetCleanFilename(Playback->Path), Playback->Time)
+			: FString::Printf(TEXT(", can't open %s"), *FPaths::GetCleanFilename(Playback->Path));
+	}
+	DebugLine += TEXT(")");
+	DebugData.AddDebugItem(DebugLine);
+	ComponentPose.GatherDebugData(DebugData);
+}
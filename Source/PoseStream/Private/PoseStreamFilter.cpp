@@ -0,0 +1,312 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamFilter.h"
+#include "Math/VectorRegister.h"
+
+// samples further apart than this restart the filter instead of smoothing across the gap
+static constexpr double MaxDeltaTime = 0.5;
+// keeps low confidence keypoints from making the Kalman gain vanish entirely
+static constexpr float MinConfidence = 0.05f;
+
+struct alignas(16) FPoseStreamFilter::FSlot
+{
+	/** One Euro: filtered position and speed. Kalman: position, speed and covariance. Loaded as aligned vectors. */
+	alignas(16) float X[NumPaddedLanes];
+	alignas(16) float DX[NumPaddedLanes];
+	alignas(16) float P00[NumPaddedLanes];
+	alignas(16) float P01[NumPaddedLanes];
+	alignas(16) float P11[NumPaddedLanes];
+
+	int32 PersonId = INDEX_NONE;
+	double LastTime = 0.0;
+	bool bInitialized = false;
+};
+
+namespace
+{
+	template<typename Type>
+	Type* NewAligned()
+	{
+		return new (FMemory::Malloc(sizeof(Type), alignof(Type))) Type();
+	}
+
+	template<typename Type>
+	void DeleteAligned(Type* Ptr)
+	{
+		Ptr->~Type();
+		FMemory::Free(Ptr);
+	}
+
+	/*
+	 * The scalar and vector kernels do the same operations in the same order, so they only differ by what
+	 * the compiler is allowed to contract or reorder.
+	 */
+
+	FORCEINLINE void OneEuroScalar(float In, float DeltaTime, float TwoPiDeltaTime, float MinCutoff, float Beta, float DerivativeCutoff, float& X, float& DX)
+	{
+		const float TD = TwoPiDeltaTime * DerivativeCutoff;
+		const float AlphaD = TD / (TD + 1.0f);
+		const float RawDX = (In - X) / DeltaTime;
+		DX = DX + AlphaD * (RawDX - DX);
+		const float Cutoff = MinCutoff + Beta * FMath::Abs(DX);
+		const float T = TwoPiDeltaTime * Cutoff;
+		const float Alpha = T / (T + 1.0f);
+		X = X + Alpha * (In - X);
+	}
+
+	FORCEINLINE void KalmanScalar(float In, float Confidence, float DeltaTime, float ProcessNoise, float MeasurementNoise, float& X, float& V, float& P00, float& P01, float& P11)
+	{
+		// predict with white noise acceleration
+		const float DT2 = DeltaTime * DeltaTime;
+		X = X + V * DeltaTime;
+		P00 = P00 + DeltaTime * (2.0f * P01 + DeltaTime * P11) + ProcessNoise * (DT2 * DT2 * 0.25f);
+		P01 = P01 + DeltaTime * P11 + ProcessNoise * (DT2 * DeltaTime * 0.5f);
+		P11 = P11 + ProcessNoise * DT2;
+
+		// update with the position measurement
+		const float S = P00 + MeasurementNoise / Confidence;
+		const float K0 = P00 / S;
+		const float K1 = P01 / S;
+		const float Residual = In - X;
+		X = X + K0 * Residual;
+		V = V + K1 * Residual;
+		P11 = P11 - K1 * P01;
+		P01 = P01 - K0 * P01;
+		P00 = P00 - K0 * P00;
+	}
+
+	FORCEINLINE VectorRegister VectorMulAdd(VectorRegister A, VectorRegister B, VectorRegister C)
+	{
+		return VectorAdd(VectorMultiply(A, B), C);
+	}
+}
+
+FPoseStreamFilter::FPoseStreamFilter(int32 NumSlots)
+{
+	static_assert(STRUCT_OFFSET(FSlot, X) % 16 == 0 && STRUCT_OFFSET(FSlot, P11) % 16 == 0, "Slot lanes are loaded as aligned vectors");
+	LaneParams = NewAligned<FLaneParams>();
+	for (int32 Index = 0; Index < NumSlots; ++Index)
+	{
+		Slots.Add(NewAligned<FSlot>());
+	}
+	SetAllJointParams(FPoseStreamFilterParams());
+}
+
+FPoseStreamFilter::~FPoseStreamFilter()
+{
+	for (FSlot* Slot : Slots) DeleteAligned(Slot);
+	DeleteAligned(LaneParams);
+}
+
+void FPoseStreamFilter::SetFilterType(EPoseStreamFilterType InType)
+{
+	if (InType == Type) return;
+	Type = InType;
+	Reset();
+}
+
+void FPoseStreamFilter::SetJointParams(int32 Keypoint, const FPoseStreamFilterParams& Params)
+{
+	if (Keypoint < 0 || Keypoint >= PoseStream::MaxKeypoints) return;
+	JointParams[Keypoint] = Params;
+	UpdateLaneParams(Keypoint);
+}
+
+void FPoseStreamFilter::SetAllJointParams(const FPoseStreamFilterParams& Params)
+{
+	for (int32 Keypoint = 0; Keypoint < PoseStream::MaxKeypoints; ++Keypoint)
+	{
+		SetJointParams(Keypoint, Params);
+	}
+	// padding lanes filter zeros, they only need parameters that don't divide by zero
+	for (int32 Lane = NumLanes; Lane < NumPaddedLanes; ++Lane)
+	{
+		LaneParams->MinCutoff[Lane] = LaneParams->DerivativeCutoff[Lane] = 1.0f;
+		LaneParams->Beta[Lane] = LaneParams->ProcessNoise[Lane] = 0.0f;
+		LaneParams->MeasurementNoise[Lane] = 1.0f;
+	}
+}
+
+void FPoseStreamFilter::UpdateLaneParams(int32 Keypoint)
+{
+	const FPoseStreamFilterParams& Params = JointParams[Keypoint];
+	for (int32 Lane = Keypoint * 3; Lane < Keypoint * 3 + 3; ++Lane)
+	{
+		LaneParams->MinCutoff[Lane] = FMath::Max(Params.MinCutoff, 0.01f);
+		LaneParams->Beta[Lane] = FMath::Max(Params.Beta, 0.0f);
+		LaneParams->DerivativeCutoff[Lane] = FMath::Max(Params.DerivativeCutoff, 0.01f);
+		LaneParams->ProcessNoise[Lane] = FMath::Max(Params.ProcessNoise, 0.0f);
+		LaneParams->MeasurementNoise[Lane] = FMath::Max(Params.MeasurementNoise, 0.0001f);
+	}
+}
+
+void FPoseStreamFilter::Reset()
+{
+	for (FSlot* Slot : Slots)
+	{
+		Slot->PersonId = INDEX_NONE;
+		Slot->bInitialized = false;
+	}
+}
+
+int32 FPoseStreamFilter::FindSlot(int32 PersonId)
+{
+	int32 Oldest = INDEX_NONE;
+	for (int32 Index = 0; Index < Slots.Num(); ++Index)
+	{
+		if (Slots[Index]->PersonId == PersonId) return Index;
+		if (Oldest == INDEX_NONE || !Slots[Index]->bInitialized || (Slots[Oldest]->bInitialized && Slots[Index]->LastTime < Slots[Oldest]->LastTime))
+		{
+			Oldest = Index;
+		}
+	}
+	// a new person takes the slot that was updated longest ago
+	if (Oldest != INDEX_NONE)
+	{
+		Slots[Oldest]->PersonId = PersonId;
+		Slots[Oldest]->bInitialized = false;
+	}
+	return Oldest;
+}
+
+void FPoseStreamFilter::Apply(FPoseStreamFrame& Frame)
+{
+	if (Type == EPoseStreamFilterType::None) return;
+
+	const double Time = Frame.SourceTime != 0.0 ? Frame.SourceTime : Frame.ReceiveTime;
+	for (int32 PersonIndex = 0; PersonIndex < Frame.NumPeople; ++PersonIndex)
+	{
+		FPoseStreamPerson& Person = Frame.People[PersonIndex];
+		const int32 Slot = FindSlot(Person.PersonId);
+		if (Slot != INDEX_NONE) FilterPerson(Slot, Time, Person);
+	}
+}
+
+void FPoseStreamFilter::FilterPerson(int32 SlotIndex, double Time, FPoseStreamPerson& Person)
+{
+	if (Type == EPoseStreamFilterType::None || !Slots.IsValidIndex(SlotIndex)) return;
+	FSlot& Slot = *Slots[SlotIndex];
+
+	// FVector is three packed floats, so the positions already are the lanes
+	static_assert(sizeof(FVector) == 3 * sizeof(float), "Keypoint lanes assume packed vectors");
+	alignas(16) float In[NumPaddedLanes];
+	alignas(16) float Confidence[NumPaddedLanes];
+	const int32 NumKeypoints = FMath::Clamp(Person.NumKeypoints, 0, (int32)PoseStream::MaxKeypoints);
+	FMemory::Memcpy(In, Person.Positions, NumKeypoints * sizeof(FVector));
+	for (int32 Keypoint = 0; Keypoint < NumKeypoints; ++Keypoint)
+	{
+		Confidence[Keypoint * 3] = Confidence[Keypoint * 3 + 1] = Confidence[Keypoint * 3 + 2] = FMath::Max(Person.Confidences[Keypoint], MinConfidence);
+	}
+	// missing keypoints hold their last position rather than pulling the filter towards garbage
+	for (int32 Lane = NumKeypoints * 3; Lane < NumPaddedLanes; ++Lane)
+	{
+		In[Lane] = Slot.bInitialized ? Slot.X[Lane] : 0.0f;
+		Confidence[Lane] = 1.0f;
+	}
+
+	const float DeltaTime = float(Time - Slot.LastTime);
+	if (Slot.bInitialized && DeltaTime <= 0.0f)
+	{
+		// repeated or late sample, keep the current estimate
+		FMemory::Memcpy(Person.Positions, Slot.X, NumKeypoints * sizeof(FVector));
+		return;
+	}
+	if (!Slot.bInitialized || DeltaTime > MaxDeltaTime)
+	{
+		FMemory::Memcpy(Slot.X, In, sizeof(In));
+		FMemory::Memzero(Slot.DX);
+		FMemory::Memzero(Slot.P01);
+		FMemory::Memzero(Slot.P11);
+		for (int32 Lane = 0; Lane < NumPaddedLanes; ++Lane)
+		{
+			Slot.P00[Lane] = LaneParams->MeasurementNoise[Lane] / Confidence[Lane];
+		}
+		Slot.LastTime = Time;
+		Slot.bInitialized = true;
+		return;
+	}
+	Slot.LastTime = Time;
+
+	const FLaneParams& Params = *LaneParams;
+	const float TwoPiDeltaTime = (2.0f * PI) * DeltaTime;
+	if (!bSimd)
+	{
+		for (int32 Lane = 0; Lane < NumPaddedLanes; ++Lane)
+		{
+			if (Type == EPoseStreamFilterType::OneEuro)
+			{
+				OneEuroScalar(In[Lane], DeltaTime, TwoPiDeltaTime, Params.MinCutoff[Lane], Params.Beta[Lane], Params.DerivativeCutoff[Lane], Slot.X[Lane], Slot.DX[Lane]);
+			}
+			else
+			{
+				KalmanScalar(In[Lane], Confidence[Lane], DeltaTime, Params.ProcessNoise[Lane], Params.MeasurementNoise[Lane], Slot.X[Lane], Slot.DX[Lane], Slot.P00[Lane], Slot.P01[Lane], Slot.P11[Lane]);
+			}
+		}
+	}
+	else if (Type == EPoseStreamFilterType::OneEuro)
+	{
+		const VectorRegister VDeltaTime = VectorSetFloat1(DeltaTime);
+		const VectorRegister VTwoPiDeltaTime = VectorSetFloat1(TwoPiDeltaTime);
+		const VectorRegister VOne = VectorOne();
+		for (int32 Lane = 0; Lane < NumPaddedLanes; Lane += 4)
+		{
+			const VectorRegister VIn = VectorLoadAligned(&In[Lane]);
+			VectorRegister X = VectorLoadAligned(&Slot.X[Lane]);
+			VectorRegister DX = VectorLoadAligned(&Slot.DX[Lane]);
+
+			const VectorRegister TD = VectorMultiply(VTwoPiDeltaTime, VectorLoadAligned(&Params.DerivativeCutoff[Lane]));
+			const VectorRegister AlphaD = VectorDivide(TD, VectorAdd(TD, VOne));
+			const VectorRegister RawDX = VectorDivide(VectorSubtract(VIn, X), VDeltaTime);
+			DX = VectorMulAdd(AlphaD, VectorSubtract(RawDX, DX), DX);
+			const VectorRegister Cutoff = VectorMulAdd(VectorLoadAligned(&Params.Beta[Lane]), VectorAbs(DX), VectorLoadAligned(&Params.MinCutoff[Lane]));
+			const VectorRegister T = VectorMultiply(VTwoPiDeltaTime, Cutoff);
+			const VectorRegister Alpha = VectorDivide(T, VectorAdd(T, VOne));
+			X = VectorMulAdd(Alpha, VectorSubtract(VIn, X), X);
+
+			VectorStoreAligned(X, &Slot.X[Lane]);
+			VectorStoreAligned(DX, &Slot.DX[Lane]);
+		}
+	}
+	else
+	{
+		const float DT2 = DeltaTime * DeltaTime;
+		const VectorRegister VDeltaTime = VectorSetFloat1(DeltaTime);
+		const VectorRegister VTwo = VectorSetFloat1(2.0f);
+		const VectorRegister VQ00 = VectorSetFloat1(DT2 * DT2 * 0.25f);
+		const VectorRegister VQ01 = VectorSetFloat1(DT2 * DeltaTime * 0.5f);
+		const VectorRegister VQ11 = VectorSetFloat1(DT2);
+		for (int32 Lane = 0; Lane < NumPaddedLanes; Lane += 4)
+		{
+			const VectorRegister VIn = VectorLoadAligned(&In[Lane]);
+			const VectorRegister Q = VectorLoadAligned(&Params.ProcessNoise[Lane]);
+			VectorRegister X = VectorLoadAligned(&Slot.X[Lane]);
+			VectorRegister V = VectorLoadAligned(&Slot.DX[Lane]);
+			VectorRegister P00 = VectorLoadAligned(&Slot.P00[Lane]);
+			VectorRegister P01 = VectorLoadAligned(&Slot.P01[Lane]);
+			VectorRegister P11 = VectorLoadAligned(&Slot.P11[Lane]);
+
+			X = VectorMulAdd(V, VDeltaTime, X);
+			P00 = VectorAdd(VectorMulAdd(VDeltaTime, VectorMulAdd(VDeltaTime, P11, VectorMultiply(VTwo, P01)), P00), VectorMultiply(Q, VQ00));
+			P01 = VectorAdd(VectorMulAdd(VDeltaTime, P11, P01), VectorMultiply(Q, VQ01));
+			P11 = VectorMulAdd(Q, VQ11, P11);
+
+			const VectorRegister S = VectorAdd(P00, VectorDivide(VectorLoadAligned(&Params.MeasurementNoise[Lane]), VectorLoadAligned(&Confidence[Lane])));
+			const VectorRegister K0 = VectorDivide(P00, S);
+			const VectorRegister K1 = VectorDivide(P01, S);
+			const VectorRegister Residual = VectorSubtract(VIn, X);
+			X = VectorMulAdd(K0, Residual, X);
+			V = VectorMulAdd(K1, Residual, V);
+			P11 = VectorSubtract(P11, VectorMultiply(K1, P01));
+			P01 = VectorSubtract(P01, VectorMultiply(K0, P01));
+			P00 = VectorSubtract(P00, VectorMultiply(K0, P00));
+
+			VectorStoreAligned(X, &Slot.X[Lane]);
+			VectorStoreAligned(V, &Slot.DX[Lane]);
+			VectorStoreAligned(P00, &Slot.P00[Lane]);
+			VectorStoreAligned(P01, &Slot.P01[Lane]);
+			VectorStoreAligned(P11, &Slot.P11[Lane]);
+		}
+	}
+
+	FMemory::Memcpy(Person.Positions, Slot.X, NumKeypoints * sizeof(FVector));
+}
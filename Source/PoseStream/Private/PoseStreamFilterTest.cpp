@@ -0,0 +1,176 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamModule.h"
+#include "PoseStreamFilter.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+
+namespace
+{
+	/** People walking in circles with per keypoint noise, the occasional low confidence keypoint and frame time jitter */
+	struct FNoisyPoseSource
+	{
+		FRandomStream Random;
+		double Time = 0.0;
+
+		explicit FNoisyPoseSource(int32 Seed) : Random(Seed) {}
+
+		void Next(int32 NumPeople, TArray<FPoseStreamPerson>& OutPeople)
+		{
+			Time += 1.0 / 120.0 + Random.FRandRange(-0.001f, 0.001f);
+			OutPeople.SetNum(NumPeople);
+			for (int32 PersonId = 0; PersonId < NumPeople; ++PersonId)
+			{
+				FPoseStreamPerson& Person = OutPeople[PersonId];
+				Person.PersonId = PersonId;
+				Person.NumKeypoints = PoseStream::MaxKeypoints;
+				const FVector Center(FMath::Cos(Time + PersonId) * 200.0f, FMath::Sin(Time + PersonId) * 200.0f, 0.0f);
+				for (int32 Keypoint = 0; Keypoint < PoseStream::MaxKeypoints; ++Keypoint)
+				{
+					const FVector Offset(0.0f, Keypoint * 2.0f, 180.0f - Keypoint * 5.0f);
+					Person.Positions[Keypoint] = Center + Offset + Random.GetUnitVector() * Random.FRandRange(0.0f, 2.0f);
+					Person.Confidences[Keypoint] = Random.FRand() < 0.05f ? 0.1f : Random.FRandRange(0.7f, 1.0f);
+				}
+			}
+		}
+	};
+
+	/** Microseconds per frame of NumPeople skeletons */
+	double BenchmarkFilter(EPoseStreamFilterType Type, bool bSimd, int32 NumPeople, int32 NumFrames)
+	{
+		FPoseStreamFilter Filter(NumPeople);
+		Filter.SetFilterType(Type);
+		Filter.SetSimdEnabled(bSimd);
+
+		// inputs generated up front so only the filter is timed
+		FNoisyPoseSource Source(42);
+		TArray<TArray<FPoseStreamPerson>> Frames;
+		TArray<double> Times;
+		Frames.SetNum(NumFrames);
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			Source.Next(NumPeople, Frames[Frame]);
+			Times.Add(Source.Time);
+		}
+
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			for (int32 Slot = 0; Slot < NumPeople; ++Slot)
+			{
+				Filter.FilterPerson(Slot, Times[Frame], Frames[Frame][Slot]);
+			}
+		}
+		return (FPlatformTime::Seconds() - StartTime) * 1e6 / NumFrames;
+	}
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Runs the vector path against the scalar reference on the same input, returns the largest relative difference */
+	float CompareWithScalar(EPoseStreamFilterType Type, int32 NumPeople, int32 NumFrames)
+	{
+		FPoseStreamFilter Simd(NumPeople);
+		FPoseStreamFilter Scalar(NumPeople);
+		Simd.SetFilterType(Type);
+		Scalar.SetFilterType(Type);
+		Scalar.SetSimdEnabled(false);
+
+		// a few joints with their own parameters so the per lane parameters are covered
+		FPoseStreamFilterParams Wrists;
+		Wrists.MinCutoff = 3.0f;
+		Wrists.Beta = 0.05f;
+		Wrists.ProcessNoise = 50000.0f;
+		for (FPoseStreamFilter* Filter : { &Simd, &Scalar })
+		{
+			Filter->SetJointParams(PoseStream::LeftWrist, Wrists);
+			Filter->SetJointParams(PoseStream::RightWrist, Wrists);
+		}
+
+		FNoisyPoseSource Source(1234);
+		TArray<FPoseStreamPerson> People;
+		float MaxError = 0.0f;
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			Source.Next(NumPeople, People);
+			for (int32 Slot = 0; Slot < NumPeople; ++Slot)
+			{
+				FPoseStreamPerson SimdPerson = People[Slot];
+				FPoseStreamPerson ScalarPerson = People[Slot];
+				Simd.FilterPerson(Slot, Source.Time, SimdPerson);
+				Scalar.FilterPerson(Slot, Source.Time, ScalarPerson);
+				for (int32 Keypoint = 0; Keypoint < PoseStream::MaxKeypoints; ++Keypoint)
+				{
+					const FVector& A = SimdPerson.Positions[Keypoint];
+					const FVector& B = ScalarPerson.Positions[Keypoint];
+					MaxError = FMath::Max(MaxError, (A - B).GetAbsMax() / FMath::Max(1.0f, B.GetAbsMax()));
+				}
+			}
+		}
+		return MaxError;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPoseStreamFilterVectorTest, "PoseStream.Filter.VectorMatchesScalar", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPoseStreamFilterVectorTest::RunTest(const FString& Parameters)
+{
+	// the kernels may differ by contraction and reordering under fast math, never by more than rounding
+	const float Tolerance = 1e-4f;
+	for (EPoseStreamFilterType Type : { EPoseStreamFilterType::OneEuro, EPoseStreamFilterType::Kalman })
+	{
+		const TCHAR* Name = Type == EPoseStreamFilterType::OneEuro ? TEXT("One Euro") : TEXT("Kalman");
+		const float Error = CompareWithScalar(Type, 4, 500);
+		TestTrue(FString::Printf(TEXT("%s vector path within %g of the scalar reference, largest difference %g"), Name, Tolerance, Error), Error <= Tolerance);
+	}
+
+	// Apply with the defaults is what the subsystem runs on every received frame
+	FPoseStreamFilter Filter;
+	FNoisyPoseSource Source(7);
+	TArray<FPoseStreamPerson> People;
+	FPoseStreamFrame Frame;
+	for (int32 FrameIndex = 0; FrameIndex < 10; ++FrameIndex)
+	{
+		Source.Next(2, People);
+		Frame.SourceTime = Source.Time;
+		Frame.NumPeople = People.Num();
+		for (int32 PersonIndex = 0; PersonIndex < People.Num(); ++PersonIndex)
+		{
+			Frame.People[PersonIndex] = People[PersonIndex];
+		}
+		Filter.Apply(Frame);
+	}
+	for (int32 PersonIndex = 0; PersonIndex < Frame.NumPeople; ++PersonIndex)
+	{
+		const FVector& Filtered = Frame.People[PersonIndex].Positions[PoseStream::Nose];
+		const FVector& Raw = People[PersonIndex].Positions[PoseStream::Nose];
+		TestTrue(TEXT("Filtered keypoints stay finite"), !Filtered.ContainsNaN());
+		TestTrue(TEXT("Filtered keypoints stay near the input"), FVector::Dist(Filtered, Raw) < 20.0f);
+	}
+	return true;
+}
+
+#endif
+
+static FAutoConsoleCommand PoseStreamFilterBenchmarkCommand(
+	TEXT("PoseStream.FilterBenchmark"),
+	TEXT("Times the vector keypoint filters against the scalar reference. Arguments: [People=10] [Frames=2000]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		const int32 NumPeople = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10;
+		const int32 NumFrames = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 2) : 2000;
+		const int32 NumJoints = NumPeople * PoseStream::MaxKeypoints;
+
+		for (EPoseStreamFilterType Type : { EPoseStreamFilterType::OneEuro, EPoseStreamFilterType::Kalman })
+		{
+			const TCHAR* Name = Type == EPoseStreamFilterType::OneEuro ? TEXT("One Euro") : TEXT("Kalman");
+			const double SimdMicroseconds = BenchmarkFilter(Type, true, NumPeople, NumFrames);
+			const double ScalarMicroseconds = BenchmarkFilter(Type, false, NumPeople, NumFrames);
+			UE_LOG(LogPoseStream, Display, TEXT("%s: %d people x %d keypoints, vector %.3f us per frame (%.0f joints/us), scalar %.3f us per frame (%.0f joints/us), %.2fx"),
+				Name, NumPeople, PoseStream::MaxKeypoints,
+				SimdMicroseconds, NumJoints / SimdMicroseconds, ScalarMicroseconds, NumJoints / ScalarMicroseconds, ScalarMicroseconds / SimdMicroseconds);
+		}
+	}));
@@ -0,0 +1,164 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamJitterBuffer.h"
+
+// share of the gap closed per sample when transit times get longer, lets the clock mapping follow sender drift
+static constexpr double ClockDriftRate = 0.002;
+// smoothing of the added latency average
+static constexpr double LatencyAverageRate = 0.05;
+
+FPoseStreamJitterBuffer::FPoseStreamJitterBuffer(int32 InCapacity)
+	: Capacity(FMath::Max(InCapacity, 4))
+{
+	Samples.Reserve(Capacity);
+}
+
+void FPoseStreamJitterBuffer::Reset()
+{
+	Samples.Reset();
+	bHasClockOffset = false;
+	PlayTime = -DBL_MAX;
+	LastMeasuredSourceTime = -DBL_MAX;
+	bUnderrun = false;
+	Stats = FPoseStreamJitterStats();
+}
+
+void FPoseStreamJitterBuffer::Push(double SourceTime, double LocalTime, const FPoseStreamPerson& Person)
+{
+	Stats.Received++;
+	LastArrival = FMath::Max(LastArrival, LocalTime);
+
+	// the fastest sample is the best estimate of the clock offset, slower ones only nudge it
+	const double Transit = LocalTime - SourceTime;
+	if (!bHasClockOffset || Transit < ClockOffset)
+	{
+		ClockOffset = Transit;
+		bHasClockOffset = true;
+	}
+	else
+	{
+		ClockOffset += (Transit - ClockOffset) * ClockDriftRate;
+	}
+
+	if (SourceTime <= PlayTime)
+	{
+		Stats.Late++;
+		return;
+	}
+
+	// samples mostly arrive in order, so the insert point is found from the back
+	int32 Index = Samples.Num();
+	while (Index > 0 && Samples[Index - 1].SourceTime > SourceTime) --Index;
+	if (Index > 0 && Samples[Index - 1].SourceTime == SourceTime)
+	{
+		Stats.Duplicates++;
+		return;
+	}
+
+	if (Samples.Num() == Capacity)
+	{
+		if (Index == 0)
+		{
+			Stats.Late++;
+			return;
+		}
+		Samples.RemoveAt(0, 1, false);
+		--Index;
+	}
+	Samples.Insert(FSample{ SourceTime, LocalTime, Person }, Index);
+}
+
+void FPoseStreamJitterBuffer::Trim()
+{
+	// wait of every sample the playout point reached since the last evaluation
+	for (const FSample& Sample : Samples)
+	{
+		if (Sample.SourceTime > PlayTime) break;
+		if (Sample.SourceTime <= LastMeasuredSourceTime) continue;
+		const double Wait = FMath::Max(Sample.SourceTime + ClockOffset + PlayoutDelay - Sample.LocalTime, 0.0);
+		Stats.AddedLatency = LastMeasuredSourceTime == -DBL_MAX ? Wait : Stats.AddedLatency + (Wait - Stats.AddedLatency) * LatencyAverageRate;
+		LastMeasuredSourceTime = Sample.SourceTime;
+	}
+
+	int32 NumPlayed = 0;
+	while (NumPlayed + 2 < Samples.Num() && Samples[NumPlayed + 2].SourceTime <= PlayTime) ++NumPlayed;
+	if (NumPlayed > 0) Samples.RemoveAt(0, NumPlayed, false);
+}
+
+bool FPoseStreamJitterBuffer::Evaluate(double LocalTime, FPoseStreamPerson& OutPerson)
+{
+	if (Samples.Num() == 0) return false;
+
+	// playout never goes backwards, even if the clock mapping does
+	PlayTime = FMath::Max(PlayTime, LocalTime - ClockOffset - PlayoutDelay);
+	Trim();
+
+	int32 Index = Samples.Num() - 1;
+	while (Index >= 0 && Samples[Index].SourceTime > PlayTime) --Index;
+
+	const int32 Num = Samples.Num();
+	Stats.Depth = Num - 1 - Index;
+	Stats.BufferedTime = FMath::Max(Samples.Last().SourceTime - PlayTime, 0.0);
+
+	if (Index < 0)
+	{
+		// still filling up
+		OutPerson = Samples[0].Person;
+		return true;
+	}
+
+	const FSample& From = Samples[Index];
+	OutPerson.PersonId = From.Person.PersonId;
+	if (Index == Num - 1)
+	{
+		if (!bUnderrun) Stats.Underruns++;
+		bUnderrun = true;
+		Stats.Extrapolated++;
+
+		// carry on along the last velocity for a while, then hold
+		const FSample* Previous = Index > 0 ? &Samples[Index - 1] : nullptr;
+		const float Extrapolation = (float)FMath::Min(PlayTime - From.SourceTime, MaxExtrapolation);
+		const float InvDelta = Previous != nullptr ? float(1.0 / (From.SourceTime - Previous->SourceTime)) : 0.0f;
+		const int32 NumKeypoints = Previous != nullptr ? FMath::Min(From.Person.NumKeypoints, Previous->Person.NumKeypoints) : From.Person.NumKeypoints;
+		OutPerson.NumKeypoints = From.Person.NumKeypoints;
+		for (int32 Keypoint = 0; Keypoint < From.Person.NumKeypoints; ++Keypoint)
+		{
+			const FVector Velocity = Keypoint < NumKeypoints && Previous != nullptr ? (From.Person.Positions[Keypoint] - Previous->Person.Positions[Keypoint]) * InvDelta : FVector::ZeroVector;
+			OutPerson.Positions[Keypoint] = From.Person.Positions[Keypoint] + Velocity * Extrapolation;
+			OutPerson.Confidences[Keypoint] = From.Person.Confidences[Keypoint];
+		}
+		return true;
+	}
+	bUnderrun = false;
+
+	// cubic Hermite between From and To with Catmull-Rom tangents for uneven spacing
+	const FSample& To = Samples[Index + 1];
+	const FSample* Before = Index > 0 ? &Samples[Index - 1] : nullptr;
+	const FSample* After = Index + 2 < Num ? &Samples[Index + 2] : nullptr;
+	const double Span = To.SourceTime - From.SourceTime;
+	const float S = float((PlayTime - From.SourceTime) / Span);
+	const float S2 = S * S;
+	const float S3 = S2 * S;
+	const float H00 = 2.0f * S3 - 3.0f * S2 + 1.0f;
+	const float H10 = (S3 - 2.0f * S2 + S) * (float)Span;
+	const float H01 = -2.0f * S3 + 3.0f * S2;
+	const float H11 = (S3 - S2) * (float)Span;
+	const float InvSpan = float(1.0 / Span);
+	const float InvBeforeSpan = Before != nullptr ? float(1.0 / (To.SourceTime - Before->SourceTime)) : 0.0f;
+	const float InvAfterSpan = After != nullptr ? float(1.0 / (After->SourceTime - From.SourceTime)) : 0.0f;
+
+	const int32 NumKeypoints = FMath::Min(From.Person.NumKeypoints, To.Person.NumKeypoints);
+	const bool bBefore = Before != nullptr && Before->Person.NumKeypoints >= NumKeypoints;
+	const bool bAfter = After != nullptr && After->Person.NumKeypoints >= NumKeypoints;
+	OutPerson.NumKeypoints = NumKeypoints;
+	for (int32 Keypoint = 0; Keypoint < NumKeypoints; ++Keypoint)
+	{
+		const FVector& P1 = From.Person.Positions[Keypoint];
+		const FVector& P2 = To.Person.Positions[Keypoint];
+		const FVector M1 = bBefore ? (P2 - Before->Person.Positions[Keypoint]) * InvBeforeSpan : (P2 - P1) * InvSpan;
+		const FVector M2 = bAfter ? (After->Person.Positions[Keypoint] - P1) * InvAfterSpan : (P2 - P1) * InvSpan;
+		OutPerson.Positions[Keypoint] = P1 * H00 + M1 * H10 + P2 * H01 + M2 * H11;
+		OutPerson.Confidences[Keypoint] = FMath::Lerp(From.Person.Confidences[Keypoint], To.Person.Confidences[Keypoint], S);
+	}
+	return true;
+}
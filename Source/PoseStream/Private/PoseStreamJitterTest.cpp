@@ -0,0 +1,176 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamModule.h"
+#include "PoseStreamJitterBuffer.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+namespace
+{
+	/** Known motion, so the played out keypoints can be compared with the truth at their play time */
+	void MakeJitterTestPerson(double Time, FPoseStreamPerson& OutPerson)
+	{
+		OutPerson.PersonId = 0;
+		OutPerson.NumKeypoints = PoseStream::MaxKeypoints;
+		for (int32 Keypoint = 0; Keypoint < PoseStream::MaxKeypoints; ++Keypoint)
+		{
+			const float Phase = float(Time * 2.0 + Keypoint * 0.2);
+			OutPerson.Positions[Keypoint] = FVector(FMath::Sin(Phase) * 50.0f, FMath::Cos(Phase * 0.7f) * 30.0f, Keypoint * 5.0f);
+			OutPerson.Confidences[Keypoint] = 1.0f;
+		}
+	}
+
+	struct FJitterTestPacket
+	{
+		double SourceTime;
+		double ArrivalTime;
+	};
+
+	struct FJitterTestResult
+	{
+		int32 NumPackets = 0;
+		int32 NumEvaluations = 0;
+		double RmsError = 0.0;
+		float MaxError = 0.0f;
+		FPoseStreamJitterStats Stats;
+	};
+
+	/** Plays the known motion through a jitter buffer over a simulated lossy network, deterministic for a seed */
+	FJitterTestResult RunJitterSimulation(double Seconds, float Loss, double Jitter, double Delay, int32 Seed)
+	{
+		// 120 Hz sender on its own clock, 10 ms base transit plus uniform jitter which also reorders,
+		// random loss and the odd duplicate
+		FRandomStream Random(Seed);
+		const double SenderClockOffset = 1000.0;
+		const double BaseTransit = 0.01;
+		TArray<FJitterTestPacket> Packets;
+		for (double SourceTime = 0.0; SourceTime < Seconds; SourceTime += 1.0 / 120.0)
+		{
+			if (Random.FRand() < Loss) continue;
+			const double Arrival = SourceTime - SenderClockOffset + BaseTransit + Random.FRand() * Jitter;
+			Packets.Add({ SourceTime, Arrival });
+			if (Random.FRand() < 0.01f) Packets.Add({ SourceTime, Arrival + Random.FRand() * Jitter });
+		}
+		Packets.Sort([](const FJitterTestPacket& A, const FJitterTestPacket& B) { return A.ArrivalTime < B.ArrivalTime; });
+
+		FPoseStreamJitterBuffer Buffer;
+		Buffer.SetPlayoutDelay(Delay);
+
+		// 60 Hz game ticks on the local clock
+		FJitterTestResult Result;
+		FPoseStreamPerson Person, Played, Truth;
+		int32 NextPacket = 0;
+		double SumSquaredError = 0.0;
+		for (double LocalTime = -SenderClockOffset; LocalTime < Seconds - SenderClockOffset; LocalTime += 1.0 / 60.0)
+		{
+			for (; NextPacket < Packets.Num() && Packets[NextPacket].ArrivalTime <= LocalTime; ++NextPacket)
+			{
+				MakeJitterTestPerson(Packets[NextPacket].SourceTime, Person);
+				Buffer.Push(Packets[NextPacket].SourceTime, Packets[NextPacket].ArrivalTime, Person);
+			}
+			if (!Buffer.Evaluate(LocalTime, Played)) continue;
+
+			// the first second settles the clock mapping
+			if (Buffer.GetPlayTime() < 1.0) continue;
+			MakeJitterTestPerson(Buffer.GetPlayTime(), Truth);
+			for (int32 Keypoint = 0; Keypoint < PoseStream::MaxKeypoints; ++Keypoint)
+			{
+				const float Error = FVector::Dist(Played.Positions[Keypoint], Truth.Positions[Keypoint]);
+				SumSquaredError += Error * Error;
+				Result.MaxError = FMath::Max(Result.MaxError, Error);
+			}
+			++Result.NumEvaluations;
+		}
+
+		Result.NumPackets = Packets.Num();
+		Result.RmsError = Result.NumEvaluations > 0 ? FMath::Sqrt(SumSquaredError / (Result.NumEvaluations * PoseStream::MaxKeypoints)) : 0.0;
+		Result.Stats = Buffer.GetStats();
+		return Result;
+	}
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPoseStreamJitterBufferTest, "PoseStream.JitterBuffer.Playout", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPoseStreamJitterBufferTest::RunTest(const FString& Parameters)
+{
+	// straight line motion at 100 Hz without transit time, Catmull-Rom tangents reproduce it exactly
+	FPoseStreamJitterBuffer Buffer;
+	Buffer.SetPlayoutDelay(0.05);
+	Buffer.SetMaxExtrapolation(0.1);
+	FPoseStreamPerson Person;
+	Person.PersonId = 3;
+	Person.NumKeypoints = 1;
+	for (int32 Index = 0; Index <= 20; ++Index)
+	{
+		const double Time = Index / 100.0;
+		Person.Positions[0] = FVector(100.0f * Time, -50.0f * Time, 7.0f);
+		Person.Confidences[0] = Index % 2 == 0 ? 0.5f : 1.0f;
+		Buffer.Push(Time, Time, Person);
+	}
+
+	FPoseStreamPerson Played;
+	TestTrue(TEXT("Evaluates once samples arrived"), Buffer.Evaluate(0.155, Played));
+	TestEqual(TEXT("Play time is the local time minus the playout delay"), Buffer.GetPlayTime(), 0.105, 1e-9);
+	TestEqual(TEXT("Person id of the played sample"), Played.PersonId, 3);
+	TestEqual(TEXT("Keypoints of the played sample"), Played.NumKeypoints, 1);
+	TestTrue(FString::Printf(TEXT("Interpolated position %s on the line"), *Played.Positions[0].ToString()), Played.Positions[0].Equals(FVector(10.5f, -5.25f, 7.0f), 1e-3f));
+	TestEqual(TEXT("Confidence interpolated halfway"), Played.Confidences[0], 0.75f, 1e-3f);
+	TestEqual(TEXT("No underrun while samples are ahead"), (int32)Buffer.GetStats().Underruns, 0);
+
+	// past the newest sample the motion carries on for MaxExtrapolation, then holds
+	TestTrue(TEXT("Evaluates past the newest sample"), Buffer.Evaluate(0.30, Played));
+	TestTrue(FString::Printf(TEXT("Extrapolated position %s"), *Played.Positions[0].ToString()), Played.Positions[0].Equals(FVector(25.0f, -12.5f, 7.0f), 1e-2f));
+	Buffer.Evaluate(0.50, Played);
+	TestTrue(FString::Printf(TEXT("Held position %s"), *Played.Positions[0].ToString()), Played.Positions[0].Equals(FVector(30.0f, -15.0f, 7.0f), 1e-2f));
+	TestEqual(TEXT("One underrun for one run past the end"), (int32)Buffer.GetStats().Underruns, 1);
+	TestEqual(TEXT("Extrapolated evaluations"), (int32)Buffer.GetStats().Extrapolated, 2);
+
+	// samples behind the playout point are late, repeats of a buffered sample are duplicates
+	Buffer.Push(0.2, 0.5, Person);
+	Buffer.Push(0.6, 0.6, Person);
+	Buffer.Push(0.6, 0.6, Person);
+	TestEqual(TEXT("Late samples"), (int32)Buffer.GetStats().Late, 1);
+	TestEqual(TEXT("Duplicate samples"), (int32)Buffer.GetStats().Duplicates, 1);
+
+	// the lossy network of the console command with its defaults, delay well above the jitter
+	FJitterTestResult Result = RunJitterSimulation(10.0, 0.05f, 0.02, 0.05, 1);
+	TestTrue(TEXT("Simulation evaluated after settling"), Result.NumEvaluations > 500);
+	TestTrue(FString::Printf(TEXT("Rms error %.4f against the truth"), Result.RmsError), Result.RmsError < 0.05);
+	TestTrue(FString::Printf(TEXT("Max error %.4f against the truth"), Result.MaxError), Result.MaxError < 0.5f);
+	TestEqual(TEXT("No late samples with the delay above the jitter"), (int32)Result.Stats.Late, 0);
+	TestEqual(TEXT("No underruns with the delay above the jitter"), (int32)Result.Stats.Underruns, 0);
+	TestTrue(TEXT("Duplicates on the network are dropped"), Result.Stats.Duplicates > 0);
+
+	// delay below the jitter, samples are late and playout runs dry but stays close to the motion
+	Result = RunJitterSimulation(10.0, 0.05f, 0.02, 0.005, 1);
+	TestTrue(TEXT("Late samples with the delay below the jitter"), Result.Stats.Late > 0);
+	TestTrue(TEXT("Underruns with the delay below the jitter"), Result.Stats.Underruns > 0);
+	TestTrue(FString::Printf(TEXT("Max error %.4f while extrapolating"), Result.MaxError), Result.MaxError < 2.0f);
+	return true;
+}
+
+#endif
+
+static FAutoConsoleCommand PoseStreamJitterTestCommand(
+	TEXT("PoseStream.JitterTest"),
+	TEXT("Plays a known motion through the jitter buffer over a simulated lossy network and reports the error against the truth. ")
+	TEXT("Deterministic for a seed. Arguments: [Seconds=10] [Loss=0.05] [Jitter ms=20] [Delay ms=50] [Seed=1]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		const double Seconds = Args.Num() > 0 ? FMath::Max(FCString::Atod(*Args[0]), 1.0) : 10.0;
+		const float Loss = Args.Num() > 1 ? FMath::Clamp(FCString::Atof(*Args[1]), 0.0f, 0.9f) : 0.05f;
+		const double Jitter = (Args.Num() > 2 ? FMath::Max(FCString::Atod(*Args[2]), 0.0) : 20.0) / 1000.0;
+		const double Delay = (Args.Num() > 3 ? FMath::Max(FCString::Atod(*Args[3]), 0.0) : 50.0) / 1000.0;
+		const int32 Seed = Args.Num() > 4 ? FCString::Atoi(*Args[4]) : 1;
+
+		const FJitterTestResult Result = RunJitterSimulation(Seconds, Loss, Jitter, Delay, Seed);
+		const FPoseStreamJitterStats& Stats = Result.Stats;
+		UE_LOG(LogPoseStream, Display, TEXT("Jitter buffer: %d packets, %.0f%% loss, %.0f ms jitter, %.0f ms delay, seed %d"),
+			Result.NumPackets, Loss * 100.0f, Jitter * 1000.0, Delay * 1000.0, Seed);
+		UE_LOG(LogPoseStream, Display, TEXT("Jitter buffer: received %llu, late %llu, duplicates %llu, underruns %llu, extrapolated %llu of %d ticks, added latency %.1f ms, depth %d"),
+			Stats.Received, Stats.Late, Stats.Duplicates, Stats.Underruns, Stats.Extrapolated, Result.NumEvaluations, Stats.AddedLatency * 1000.0, Stats.Depth);
+		UE_LOG(LogPoseStream, Display, TEXT("Jitter buffer: keypoint error against the truth at play time, rms %.3f, max %.3f"), Result.RmsError, Result.MaxError);
+	}));
@@ -0,0 +1,102 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamLiveLinkSource.h"
+#include "ILiveLinkClient.h"
+#include "Roles/LiveLinkAnimationRole.h"
+#include "Roles/LiveLinkAnimationTypes.h"
+
+#define LOCTEXT_NAMESPACE "PoseStreamLiveLinkSource"
+
+// people missing for longer than this are removed from LiveLink
+static constexpr double SubjectTimeout = 1.0;
+
+FPoseStreamLiveLinkSource::FPoseStreamLiveLinkSource(int32 InPort)
+	: Port(InPort)
+{
+}
+
+void FPoseStreamLiveLinkSource::ReceiveClient(ILiveLinkClient* InClient, FGuid InSourceGuid)
+{
+	Client = InClient;
+	SourceGuid = InSourceGuid;
+}
+
+bool FPoseStreamLiveLinkSource::RequestSourceShutdown()
+{
+	Client = nullptr;
+	return true;
+}
+
+FText FPoseStreamLiveLinkSource::GetSourceType() const
+{
+	return LOCTEXT("SourceType", "Pose Stream");
+}
+
+FText FPoseStreamLiveLinkSource::GetSourceMachineName() const
+{
+	return FText::Format(LOCTEXT("MachineName", "UDP {0}"), FText::AsNumber(Port, &FNumberFormattingOptions::DefaultNoGrouping()));
+}
+
+FText FPoseStreamLiveLinkSource::GetSourceStatus() const
+{
+	return FText::Format(LOCTEXT("Status", "{0} people"), FText::AsNumber(LastSeen.Num()));
+}
+
+FName FPoseStreamLiveLinkSource::GetSubjectName(int32 PersonId)
+{
+	return FName(TEXT("PoseStream"), PersonId + 1);
+}
+
+void FPoseStreamLiveLinkSource::Publish(const FPoseStreamFrame& Frame, double Time)
+{
+	if (Client == nullptr) return;
+
+	for (int32 PersonIndex = 0; PersonIndex < Frame.NumPeople; ++PersonIndex)
+	{
+		const FPoseStreamPerson& Person = Frame.People[PersonIndex];
+		const FLiveLinkSubjectKey Key(SourceGuid, GetSubjectName(Person.PersonId));
+
+		if (!LastSeen.Contains(Person.PersonId))
+		{
+			FLiveLinkStaticDataStruct StaticDataStruct(FLiveLinkSkeletonStaticData::StaticStruct());
+			FLiveLinkSkeletonStaticData& StaticData = *StaticDataStruct.Cast<FLiveLinkSkeletonStaticData>();
+			StaticData.BoneNames.Reserve(PoseStream::MaxKeypoints);
+			for (int32 Keypoint = 0; Keypoint < PoseStream::MaxKeypoints; ++Keypoint)
+			{
+				StaticData.BoneNames.Add(PoseStream::GetKeypointName(Keypoint));
+			}
+			StaticData.BoneParents.Init(INDEX_NONE, PoseStream::MaxKeypoints);
+			Client->PushSubjectStaticData_AnyThread(Key, ULiveLinkAnimationRole::StaticClass(), MoveTemp(StaticDataStruct));
+		}
+		LastSeen.Add(Person.PersonId, Time);
+
+		// LiveLink owns its frame data, this is the one allocation per person and frame on the path
+		FLiveLinkFrameDataStruct FrameDataStruct(FLiveLinkAnimationFrameData::StaticStruct());
+		FLiveLinkAnimationFrameData& FrameData = *FrameDataStruct.Cast<FLiveLinkAnimationFrameData>();
+		FrameData.WorldTime = FLiveLinkWorldTime(Frame.ReceiveTime);
+		FrameData.Transforms.SetNumUninitialized(PoseStream::MaxKeypoints);
+		for (int32 Keypoint = 0; Keypoint < PoseStream::MaxKeypoints; ++Keypoint)
+		{
+			// missing keypoints collapse onto the first one rather than the origin
+			const FVector& Position = Person.Positions[Keypoint < Person.NumKeypoints ? Keypoint : 0];
+			FrameData.Transforms[Keypoint] = FTransform(Position);
+		}
+		Client->PushSubjectFrameData_AnyThread(Key, MoveTemp(FrameDataStruct));
+	}
+}
+
+void FPoseStreamLiveLinkSource::RemoveStaleSubjects(double Time)
+{
+	if (Client == nullptr) return;
+
+	for (auto It = LastSeen.CreateIterator(); It; ++It)
+	{
+		if (Time - It.Value() > SubjectTimeout)
+		{
+			Client->RemoveSubject_AnyThread(FLiveLinkSubjectKey(SourceGuid, GetSubjectName(It.Key())));
+			It.RemoveCurrent();
+		}
+	}
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,43 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ILiveLinkSource.h"
+#include "PoseStreamTypes.h"
+
+class ILiveLinkClient;
+
+/**
+ * LiveLink source publishing every tracked person as an animation subject named PoseStream_<Id>.
+ * Keypoints become root level bones named after the landmarks, with the keypoint position as translation.
+ */
+class FPoseStreamLiveLinkSource : public ILiveLinkSource
+{
+public:
+	explicit FPoseStreamLiveLinkSource(int32 InPort);
+
+	/** Game thread. Pushes the people of Frame, subjects get their static data when they first appear. */
+	void Publish(const FPoseStreamFrame& Frame, double Time);
+
+	/** Game thread. Removes the subjects of people that haven't been seen for a while. */
+	void RemoveStaleSubjects(double Time);
+
+	// ILiveLinkSource
+	virtual void ReceiveClient(ILiveLinkClient* InClient, FGuid InSourceGuid) override;
+	virtual bool IsSourceStillValid() const override { return Client != nullptr; }
+	virtual bool RequestSourceShutdown() override;
+	virtual FText GetSourceType() const override;
+	virtual FText GetSourceMachineName() const override;
+	virtual FText GetSourceStatus() const override;
+
+private:
+	static FName GetSubjectName(int32 PersonId);
+
+	ILiveLinkClient* Client = nullptr;
+	FGuid SourceGuid;
+	int32 Port;
+
+	/** Last time each person was published */
+	TMap<int32, double> LastSeen;
+};
@@ -0,0 +1,356 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamModule.h"
+#include "PoseStreamOSC.h"
+#include "PoseStreamReceiver.h"
+#include "PoseStreamSubsystem.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/AutomationTest.h"
+#include "Common/UdpSocketBuilder.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+
+namespace
+{
+	/** Deterministic people that move a little every frame */
+	void MakePerson(int32 PersonId, int32 FrameIndex, FPoseStreamPerson& OutPerson)
+	{
+		OutPerson.PersonId = PersonId;
+		OutPerson.NumKeypoints = PoseStream::MaxKeypoints;
+		for (int32 Keypoint = 0; Keypoint < PoseStream::MaxKeypoints; ++Keypoint)
+		{
+			const float Phase = FrameIndex * 0.05f + Keypoint * 0.3f;
+			OutPerson.Positions[Keypoint] = FVector(PersonId + FMath::Sin(Phase) * 0.2f, Keypoint * 0.05f, FMath::Cos(Phase) * 0.2f);
+			OutPerson.Confidences[Keypoint] = 0.9f;
+		}
+	}
+
+	/** Parses a prebuilt bundle in a loop, the parser cost without sockets or threads */
+	void MeasureParseThroughput(int32 NumPeople)
+	{
+		PoseStreamOSC::FWriter Writer;
+		Writer.BeginBundle(FPlatformTime::Seconds());
+		FPoseStreamPerson Person;
+		for (int32 PersonId = 0; PersonId < NumPeople; ++PersonId)
+		{
+			MakePerson(PersonId, 0, Person);
+			Writer.AddPerson(Person, true);
+		}
+		const TArray<uint8>& Packet = Writer.GetData();
+
+		TUniquePtr<FPoseStreamFrame> Frame = MakeUnique<FPoseStreamFrame>();
+		const int32 Iterations = 100000;
+		int32 Failures = 0;
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			Frame->NumPeople = 0;
+			Frame->SourceTime = 0.0;
+			Failures += PoseStreamOSC::ParsePacket(Packet.GetData(), Packet.Num(), *Frame) != PoseStreamOSC::EParseResult::Ok;
+		}
+		const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+		UE_LOG(LogPoseStream, Display, TEXT("Parse: %d byte bundle, %d people, %.3f us per bundle, %.0f bundles/s, %.1f MB/s, %d failures"),
+			Packet.Num(), Frame->NumPeople, Elapsed * 1e6 / Iterations, Iterations / Elapsed,
+			Packet.Num() * (double)Iterations / Elapsed / (1024.0 * 1024.0), Failures);
+	}
+
+	/** Sends bundles to the local port at a fixed rate, stamped with FPlatformTime::Seconds so latency can be read off the receiving side */
+	class FLoopbackSender : public FRunnable
+	{
+	public:
+		FLoopbackSender(int32 InPort, double InRate, int32 InNumPeople, double InDuration)
+			: Port(InPort), Rate(InRate), NumPeople(InNumPeople), Duration(InDuration)
+		{
+			Thread = FRunnableThread::Create(this, TEXT("PoseStreamLoopbackSender"), 0, TPri_AboveNormal);
+		}
+
+		virtual ~FLoopbackSender()
+		{
+			if (Thread != nullptr)
+			{
+				Thread->Kill(true);
+				delete Thread;
+			}
+		}
+
+		virtual uint32 Run() override
+		{
+			ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+			FSocket* Socket = FUdpSocketBuilder(TEXT("PoseStreamLoopbackSender")).Build();
+			if (Socket == nullptr) return 1;
+
+			TSharedRef<FInternetAddr> Destination = SocketSubsystem->CreateInternetAddr();
+			Destination->SetIp(FIPv4Address(127, 0, 0, 1).Value);
+			Destination->SetPort(Port);
+
+			PoseStreamOSC::FWriter Writer;
+			FPoseStreamPerson Person;
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 FrameIndex = 0; !bStopping; ++FrameIndex)
+			{
+				// paced against the start time so sleep overshoot doesn't accumulate
+				const double SendTime = StartTime + FrameIndex / Rate;
+				if (SendTime - StartTime >= Duration) break;
+				for (double Now = FPlatformTime::Seconds(); Now < SendTime; Now = FPlatformTime::Seconds())
+				{
+					if (SendTime - Now > 0.002) FPlatformProcess::Sleep(0.001f);
+					else FPlatformProcess::YieldThread();
+				}
+
+				Writer.BeginBundle(FPlatformTime::Seconds());
+				for (int32 PersonId = 0; PersonId < NumPeople; ++PersonId)
+				{
+					MakePerson(PersonId, FrameIndex, Person);
+					Writer.AddPerson(Person, true);
+				}
+				int32 BytesSent = 0;
+				if (Socket->SendTo(Writer.GetData().GetData(), Writer.GetData().Num(), BytesSent, *Destination)) Sent++;
+			}
+
+			Socket->Close();
+			SocketSubsystem->DestroySocket(Socket);
+			bFinished = true;
+			return 0;
+		}
+
+		virtual void Stop() override { bStopping = true; }
+
+		std::atomic<int32> Sent{ 0 };
+		std::atomic<bool> bFinished{ false };
+
+	private:
+		int32 Port;
+		double Rate;
+		int32 NumPeople;
+		double Duration;
+		std::atomic<bool> bStopping{ false };
+		FRunnableThread* Thread = nullptr;
+	};
+
+	/** State of the running loopback test, lives until the ticker reports */
+	struct FLoopbackTest
+	{
+		TUniquePtr<FLoopbackSender> Sender;
+		FDelegateHandle FrameHandle;
+		uint64 StartParseCycles = 0;
+		uint64 StartFrames = 0;
+		uint64 StartDropped = 0;
+		int32 ExpectedPeople = 0;
+		int32 WrongPeople = 0;
+		bool bSenderFinished = false;
+		/** Receive thread time minus send time, and game thread delivery minus send time, in ms */
+		TArray<double> ReceiveLatencies;
+		TArray<double> DeliveryLatencies;
+	};
+	TUniquePtr<FLoopbackTest> RunningTest;
+
+	void LogLatencies(const TCHAR* Name, TArray<double>& Latencies)
+	{
+		if (Latencies.Num() == 0)
+		{
+			UE_LOG(LogPoseStream, Display, TEXT("%s latency: no frames"), Name);
+			return;
+		}
+		Latencies.Sort();
+		double Sum = 0.0;
+		for (double Latency : Latencies) Sum += Latency;
+		UE_LOG(LogPoseStream, Display, TEXT("%s latency: avg %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms"),
+			Name, Sum / Latencies.Num(), Latencies[Latencies.Num() / 2], Latencies[FMath::Min(Latencies.Num() * 99 / 100, Latencies.Num() - 1)], Latencies.Last());
+	}
+
+	bool TickLoopbackTest(float DeltaTime)
+	{
+		UPoseStreamSubsystem* Subsystem = GEngine != nullptr ? GEngine->GetEngineSubsystem<UPoseStreamSubsystem>() : nullptr;
+		if (!RunningTest.IsValid() || Subsystem == nullptr) return false;
+		// one more ticker interval after the sender is done so the last datagrams come through
+		if (!RunningTest->bSenderFinished)
+		{
+			RunningTest->bSenderFinished = RunningTest->Sender->bFinished;
+			return true;
+		}
+
+		const FPoseStreamReceiverStats* Stats = Subsystem->GetReceiverStats();
+		Subsystem->OnFrame.Remove(RunningTest->FrameHandle);
+		const int32 Sent = RunningTest->Sender->Sent;
+		const uint64 Frames = Stats != nullptr ? Stats->Frames - RunningTest->StartFrames : 0;
+		const uint64 Dropped = Stats != nullptr ? Stats->Dropped - RunningTest->StartDropped : 0;
+		const double ParseSeconds = Stats != nullptr ? (Stats->ParseCycles - RunningTest->StartParseCycles) * FPlatformTime::GetSecondsPerCycle64() : 0.0;
+
+		UE_LOG(LogPoseStream, Display, TEXT("Loopback: sent %d, received %llu, delivered %d, dropped %llu, %d frames with the wrong number of people, %.3f us parse per frame"),
+			Sent, Frames, RunningTest->DeliveryLatencies.Num(), Dropped, RunningTest->WrongPeople, Frames > 0 ? ParseSeconds * 1e6 / Frames : 0.0);
+		LogLatencies(TEXT("Receive"), RunningTest->ReceiveLatencies);
+		LogLatencies(TEXT("Delivery"), RunningTest->DeliveryLatencies);
+
+		RunningTest.Reset();
+		return false;
+	}
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Frames the loopback test sends, with and without confidences and with varying numbers of people */
+	constexpr int32 LoopbackTestFrames = 8;
+	constexpr int32 LoopbackTestPort = 47017;
+
+	int32 GetLoopbackTestPeople(int32 FrameIndex) { return 1 + FrameIndex % 4; }
+	double GetLoopbackTestTime(int32 FrameIndex) { return 1000.0 + FrameIndex / 120.0; }
+
+	void WriteLoopbackTestFrame(int32 FrameIndex, PoseStreamOSC::FWriter& Writer)
+	{
+		Writer.BeginBundle(GetLoopbackTestTime(FrameIndex));
+		FPoseStreamPerson Person;
+		for (int32 PersonId = 0; PersonId < GetLoopbackTestPeople(FrameIndex); ++PersonId)
+		{
+			MakePerson(PersonId, FrameIndex, Person);
+			Writer.AddPerson(Person, FrameIndex % 2 == 0);
+		}
+	}
+
+	/** Number of people in Frame that differ from what WriteLoopbackTestFrame wrote */
+	int32 CountMismatchedPeople(int32 FrameIndex, const FPoseStreamFrame& Frame)
+	{
+		int32 Mismatches = FMath::Abs(Frame.NumPeople - GetLoopbackTestPeople(FrameIndex));
+		FPoseStreamPerson Expected;
+		for (int32 PersonIndex = 0; PersonIndex < FMath::Min(Frame.NumPeople, GetLoopbackTestPeople(FrameIndex)); ++PersonIndex)
+		{
+			const FPoseStreamPerson& Person = Frame.People[PersonIndex];
+			MakePerson(PersonIndex, FrameIndex, Expected);
+			bool bEqual = Person.PersonId == Expected.PersonId && Person.NumKeypoints == Expected.NumKeypoints;
+			for (int32 Keypoint = 0; bEqual && Keypoint < Expected.NumKeypoints; ++Keypoint)
+			{
+				// floats go over the wire bit for bit, frames without confidences read back as fully confident
+				const float ExpectedConfidence = FrameIndex % 2 == 0 ? Expected.Confidences[Keypoint] : 1.0f;
+				bEqual = Person.Positions[Keypoint] == Expected.Positions[Keypoint] && Person.Confidences[Keypoint] == ExpectedConfidence;
+			}
+			Mismatches += !bEqual;
+		}
+		return Mismatches;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPoseStreamLoopbackTest, "PoseStream.Receiver.Loopback", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPoseStreamLoopbackTest::RunTest(const FString& Parameters)
+{
+	PoseStreamOSC::FWriter Writer;
+	TUniquePtr<FPoseStreamFrame> Frame = MakeUnique<FPoseStreamFrame>();
+
+	// parser on its own, including packets it has to reject
+	for (int32 FrameIndex = 0; FrameIndex < LoopbackTestFrames; ++FrameIndex)
+	{
+		WriteLoopbackTestFrame(FrameIndex, Writer);
+		Frame->NumPeople = 0;
+		Frame->SourceTime = 0.0;
+		TestEqual(TEXT("Bundle parses"), (int32)PoseStreamOSC::ParsePacket(Writer.GetData().GetData(), Writer.GetData().Num(), *Frame), (int32)PoseStreamOSC::EParseResult::Ok);
+		TestEqual(TEXT("Parsed people differing from the written ones"), CountMismatchedPeople(FrameIndex, *Frame), 0);
+		TestTrue(TEXT("Time tag survives the round trip"), FMath::IsNearlyEqual(Frame->SourceTime, GetLoopbackTestTime(FrameIndex), 1e-6));
+	}
+	const TArray<uint8>& Packet = Writer.GetData();
+	Frame->NumPeople = 0;
+	TestEqual(TEXT("Truncated bundle is malformed"), (int32)PoseStreamOSC::ParsePacket(Packet.GetData(), Packet.Num() - 4, *Frame), (int32)PoseStreamOSC::EParseResult::Malformed);
+	const uint8 Garbage[8] = { 'n', 'o', 't', ' ', 'o', 's', 'c', 0 };
+	TestEqual(TEXT("Garbage isn't OSC"), (int32)PoseStreamOSC::ParsePacket(Garbage, sizeof(Garbage), *Frame), (int32)PoseStreamOSC::EParseResult::NotOSC);
+
+	// the same bundles through a UDP socket and the receive thread
+	TUniquePtr<FPoseStreamFrameRing> Ring = MakeUnique<FPoseStreamFrameRing>();
+	FPoseStreamReceiverStats Stats;
+	TUniquePtr<FPoseStreamReceiver> Receiver = MakeUnique<FPoseStreamReceiver>(*Ring, Stats);
+	if (!Receiver->Start(LoopbackTestPort))
+	{
+		AddError(FString::Printf(TEXT("Couldn't bind UDP port %d"), LoopbackTestPort));
+		return false;
+	}
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	FSocket* Socket = FUdpSocketBuilder(TEXT("PoseStreamLoopbackTest")).Build();
+	if (Socket == nullptr)
+	{
+		AddError(TEXT("Couldn't create the sending socket"));
+		return false;
+	}
+	TSharedRef<FInternetAddr> Destination = SocketSubsystem->CreateInternetAddr();
+	Destination->SetIp(FIPv4Address(127, 0, 0, 1).Value);
+	Destination->SetPort(LoopbackTestPort);
+
+	int32 BytesSent = 0;
+	Socket->SendTo(Garbage, sizeof(Garbage), BytesSent, *Destination);
+	for (int32 FrameIndex = 0; FrameIndex < LoopbackTestFrames; ++FrameIndex)
+	{
+		WriteLoopbackTestFrame(FrameIndex, Writer);
+		TestTrue(TEXT("Bundle sent"), Socket->SendTo(Writer.GetData().GetData(), Writer.GetData().Num(), BytesSent, *Destination) && BytesSent == Writer.GetData().Num());
+	}
+	Socket->Close();
+	SocketSubsystem->DestroySocket(Socket);
+
+	for (const double Deadline = FPlatformTime::Seconds() + 2.0; Stats.Frames < LoopbackTestFrames && FPlatformTime::Seconds() < Deadline;)
+	{
+		FPlatformProcess::Sleep(0.001f);
+	}
+	Receiver.Reset();
+
+	TestEqual(TEXT("Frames received"), (int32)Stats.Frames, LoopbackTestFrames);
+	TestEqual(TEXT("Packets rejected by the parser"), (int32)Stats.ParseErrors, 1);
+	TestEqual(TEXT("Frames dropped"), (int32)Stats.Dropped, 0);
+	uint64 LastSequence = 0;
+	for (int32 FrameIndex = 0; FrameIndex < LoopbackTestFrames; ++FrameIndex)
+	{
+		const FPoseStreamFrame* Received = Ring->Peek();
+		if (Received == nullptr) break;
+		TestEqual(TEXT("Received people differing from the sent ones"), CountMismatchedPeople(FrameIndex, *Received), 0);
+		TestTrue(TEXT("Time tag survives the loopback"), FMath::IsNearlyEqual(Received->SourceTime, GetLoopbackTestTime(FrameIndex), 1e-6));
+		TestTrue(TEXT("Sequence numbers increase"), Received->Sequence > LastSequence);
+		LastSequence = Received->Sequence;
+		Ring->Pop();
+	}
+	return true;
+}
+
+#endif
+
+static FAutoConsoleCommand PoseStreamLoopbackTestCommand(
+	TEXT("PoseStream.LoopbackTest"),
+	TEXT("Measures parse throughput, then sends pose bundles to the local receiver and reports delivery latency. Arguments: [Seconds=5] [Rate=120] [People=4] [Port=7000]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		const double Seconds = Args.Num() > 0 ? FMath::Max(FCString::Atod(*Args[0]), 0.1) : 5.0;
+		const double Rate = Args.Num() > 1 ? FMath::Max(FCString::Atod(*Args[1]), 1.0) : 120.0;
+		const int32 NumPeople = Args.Num() > 2 ? FMath::Clamp(FCString::Atoi(*Args[2]), 1, PoseStream::MaxPeople) : 4;
+		const int32 Port = Args.Num() > 3 ? FCString::Atoi(*Args[3]) : 7000;
+
+		UPoseStreamSubsystem* Subsystem = GEngine != nullptr ? GEngine->GetEngineSubsystem<UPoseStreamSubsystem>() : nullptr;
+		if (Subsystem == nullptr || RunningTest.IsValid())
+		{
+			UE_LOG(LogPoseStream, Warning, TEXT("Pose stream loopback test is already running or the subsystem isn't available"));
+			return;
+		}
+
+		MeasureParseThroughput(NumPeople);
+
+		if (!Subsystem->StartListening(Port)) return;
+		const FPoseStreamReceiverStats* Stats = Subsystem->GetReceiverStats();
+
+		RunningTest = MakeUnique<FLoopbackTest>();
+		RunningTest->StartFrames = Stats->Frames;
+		RunningTest->StartDropped = Stats->Dropped;
+		RunningTest->StartParseCycles = Stats->ParseCycles;
+		RunningTest->ExpectedPeople = NumPeople;
+		RunningTest->ReceiveLatencies.Reserve(FMath::CeilToInt(Seconds * Rate));
+		RunningTest->DeliveryLatencies.Reserve(FMath::CeilToInt(Seconds * Rate));
+		RunningTest->FrameHandle = Subsystem->OnFrame.AddLambda([](const FPoseStreamFrame& Frame)
+		{
+			RunningTest->WrongPeople += Frame.NumPeople != RunningTest->ExpectedPeople;
+			RunningTest->ReceiveLatencies.Add((Frame.ReceiveTime - Frame.SourceTime) * 1000.0);
+			RunningTest->DeliveryLatencies.Add((FPlatformTime::Seconds() - Frame.SourceTime) * 1000.0);
+		});
+		RunningTest->Sender = MakeUnique<FLoopbackSender>(Port, Rate, NumPeople, Seconds);
+
+		UE_LOG(LogPoseStream, Display, TEXT("Sending %d people at %.0f Hz for %.1f s to port %d"), NumPeople, Rate, Seconds, Port);
+		FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&TickLoopbackTest), 0.25f);
+	}));
@@ -0,0 +1,7 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamModule.h"
+
+DEFINE_LOG_CATEGORY(LogPoseStream);
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, PoseStream);
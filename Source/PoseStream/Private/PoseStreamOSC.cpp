@@ -0,0 +1,206 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamOSC.h"
+#include "Misc/ByteSwap.h"
+
+namespace PoseStreamOSC
+{
+	namespace
+	{
+		// nested bundles deeper than this are rejected rather than recursed into
+		constexpr int32 MaxBundleDepth = 4;
+		constexpr uint64 ImmediateTimeTag = 1;
+
+		FORCEINLINE uint32 FromBigEndian(uint32 Value)
+		{
+#if PLATFORM_LITTLE_ENDIAN
+			return BYTESWAP_ORDER32(Value);
+#else
+			return Value;
+#endif
+		}
+
+		FORCEINLINE int32 PadTo4(int32 Size)
+		{
+			return (Size + 3) & ~3;
+		}
+
+		struct FReader
+		{
+			const uint8* Cursor;
+			const uint8* End;
+
+			bool ReadUInt32(uint32& Out)
+			{
+				if (End - Cursor < 4) return false;
+				uint32 Raw;
+				FMemory::Memcpy(&Raw, Cursor, 4);
+				Out = FromBigEndian(Raw);
+				Cursor += 4;
+				return true;
+			}
+
+			bool ReadInt32(int32& Out)
+			{
+				uint32 Raw;
+				if (!ReadUInt32(Raw)) return false;
+				Out = (int32)Raw;
+				return true;
+			}
+
+			bool ReadFloat(float& Out)
+			{
+				uint32 Raw;
+				if (!ReadUInt32(Raw)) return false;
+				FMemory::Memcpy(&Out, &Raw, 4);
+				return true;
+			}
+
+			/** Null terminated, padded to 4 bytes. OutLength excludes the terminator. */
+			bool ReadString(const char*& OutString, int32& OutLength)
+			{
+				const uint8* Terminator = (const uint8*)memchr(Cursor, 0, End - Cursor);
+				if (Terminator == nullptr) return false;
+				OutString = (const char*)Cursor;
+				OutLength = int32(Terminator - Cursor);
+				const int32 Padded = PadTo4(OutLength + 1);
+				if (End - Cursor < Padded) return false;
+				Cursor += Padded;
+				return true;
+			}
+		};
+
+		bool IsBundle(const uint8* Data, int32 Size)
+		{
+			return Size >= 16 && FMemory::Memcmp(Data, "#bundle", 8) == 0;
+		}
+
+		EParseResult ParseMessage(const uint8* Data, int32 Size, FPoseStreamFrame& OutFrame)
+		{
+			FReader Reader{ Data, Data + Size };
+			const char* Address;
+			int32 AddressLength;
+			if (Size < 4 || Data[0] != '/' || !Reader.ReadString(Address, AddressLength)) return EParseResult::NotOSC;
+			if (FCStringAnsi::Strcmp(Address, PersonAddress) != 0) return EParseResult::Ok;
+
+			const char* Tags;
+			int32 TagsLength;
+			if (!Reader.ReadString(Tags, TagsLength) || TagsLength < 3 || Tags[0] != ',' || Tags[1] != 'i' || Tags[2] != 'i') return EParseResult::Malformed;
+			const int32 NumFloats = TagsLength - 3;
+			for (int32 Index = 3; Index < TagsLength; ++Index)
+			{
+				if (Tags[Index] != 'f') return EParseResult::Malformed;
+			}
+
+			int32 PersonId, NumKeypoints;
+			if (!Reader.ReadInt32(PersonId) || !Reader.ReadInt32(NumKeypoints)) return EParseResult::Malformed;
+			if (NumKeypoints < 0 || NumKeypoints > PoseStream::MaxKeypoints) return EParseResult::Malformed;
+			const bool bWithConfidences = NumFloats == NumKeypoints * 4;
+			if (!bWithConfidences && NumFloats != NumKeypoints * 3) return EParseResult::Malformed;
+			if (Reader.End - Reader.Cursor < NumFloats * 4) return EParseResult::Malformed;
+
+			if (OutFrame.NumPeople == PoseStream::MaxPeople) return EParseResult::Ok;
+			FPoseStreamPerson& Person = OutFrame.People[OutFrame.NumPeople++];
+			Person.PersonId = PersonId;
+			Person.NumKeypoints = NumKeypoints;
+			for (int32 Keypoint = 0; Keypoint < NumKeypoints; ++Keypoint)
+			{
+				FVector& Position = Person.Positions[Keypoint];
+				Reader.ReadFloat(Position.X);
+				Reader.ReadFloat(Position.Y);
+				Reader.ReadFloat(Position.Z);
+				if (bWithConfidences) Reader.ReadFloat(Person.Confidences[Keypoint]);
+				else Person.Confidences[Keypoint] = 1.0f;
+			}
+			return EParseResult::Ok;
+		}
+
+		EParseResult ParseElement(const uint8* Data, int32 Size, FPoseStreamFrame& OutFrame, int32 Depth)
+		{
+			if (!IsBundle(Data, Size)) return ParseMessage(Data, Size, OutFrame);
+			if (Depth >= MaxBundleDepth) return EParseResult::Malformed;
+
+			FReader Reader{ Data + 8, Data + Size };
+			uint32 Seconds, Fraction;
+			Reader.ReadUInt32(Seconds);
+			Reader.ReadUInt32(Fraction);
+			// the outermost time tag wins, immediate bundles carry no capture time
+			const uint64 TimeTag = (uint64(Seconds) << 32) | Fraction;
+			if (OutFrame.SourceTime == 0.0 && TimeTag != ImmediateTimeTag)
+			{
+				OutFrame.SourceTime = double(Seconds) + double(Fraction) / 4294967296.0;
+			}
+
+			while (Reader.Cursor < Reader.End)
+			{
+				int32 ElementSize;
+				if (!Reader.ReadInt32(ElementSize) || ElementSize <= 0 || (ElementSize & 3) != 0 || ElementSize > Reader.End - Reader.Cursor) return EParseResult::Malformed;
+				const EParseResult Result = ParseElement(Reader.Cursor, ElementSize, OutFrame, Depth + 1);
+				if (Result != EParseResult::Ok) return EParseResult::Malformed;
+				Reader.Cursor += ElementSize;
+			}
+			return EParseResult::Ok;
+		}
+	}
+
+	EParseResult ParsePacket(const uint8* Data, int32 Size, FPoseStreamFrame& OutFrame)
+	{
+		if (Data == nullptr || Size < 4 || (Size & 3) != 0) return EParseResult::NotOSC;
+		return ParseElement(Data, Size, OutFrame, 0);
+	}
+
+	void FWriter::BeginBundle(double SourceTime)
+	{
+		Data.Reset();
+		WriteString("#bundle");
+		const double Seconds = FMath::FloorToDouble(SourceTime);
+		WriteInt32((int32)(uint32)Seconds);
+		WriteInt32((int32)(uint32)((SourceTime - Seconds) * 4294967296.0));
+	}
+
+	void FWriter::AddPerson(const FPoseStreamPerson& Person, bool bWithConfidences)
+	{
+		const int32 SizeOffset = Data.Num();
+		WriteInt32(0);
+
+		WriteString(PersonAddress);
+		ANSICHAR Tags[3 + PoseStream::MaxKeypoints * 4 + 1] = ",ii";
+		const int32 NumFloats = Person.NumKeypoints * (bWithConfidences ? 4 : 3);
+		FMemory::Memset(Tags + 3, 'f', NumFloats);
+		Tags[3 + NumFloats] = 0;
+		WriteString(Tags);
+
+		WriteInt32(Person.PersonId);
+		WriteInt32(Person.NumKeypoints);
+		for (int32 Keypoint = 0; Keypoint < Person.NumKeypoints; ++Keypoint)
+		{
+			WriteFloat(Person.Positions[Keypoint].X);
+			WriteFloat(Person.Positions[Keypoint].Y);
+			WriteFloat(Person.Positions[Keypoint].Z);
+			if (bWithConfidences) WriteFloat(Person.Confidences[Keypoint]);
+		}
+
+		const uint32 ElementSize = FromBigEndian(uint32(Data.Num() - SizeOffset - 4));
+		FMemory::Memcpy(Data.GetData() + SizeOffset, &ElementSize, 4);
+	}
+
+	void FWriter::WriteInt32(int32 Value)
+	{
+		const uint32 BigEndian = FromBigEndian((uint32)Value);
+		Data.Append((const uint8*)&BigEndian, 4);
+	}
+
+	void FWriter::WriteFloat(float Value)
+	{
+		uint32 Raw;
+		FMemory::Memcpy(&Raw, &Value, 4);
+		WriteInt32((int32)Raw);
+	}
+
+	void FWriter::WriteString(const char* String)
+	{
+		const int32 Length = FCStringAnsi::Strlen(String);
+		const int32 Offset = Data.AddZeroed(PadTo4(Length + 1));
+		FMemory::Memcpy(Data.GetData() + Offset, String, Length);
+	}
+}
@@ -0,0 +1,92 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamReceiver.h"
+#include "PoseStreamModule.h"
+#include "PoseStreamOSC.h"
+#include "HAL/RunnableThread.h"
+#include "Common/UdpSocketBuilder.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+
+// bounds how long Stop waits for the thread to notice
+static const FTimespan ReceiveWaitTime = FTimespan::FromMilliseconds(100);
+
+FPoseStreamReceiver::FPoseStreamReceiver(FPoseStreamFrameRing& InRing, FPoseStreamReceiverStats& InStats)
+	: Ring(InRing)
+	, Stats(InStats)
+{
+}
+
+FPoseStreamReceiver::~FPoseStreamReceiver()
+{
+	if (Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+	}
+	if (Socket != nullptr)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+	}
+}
+
+bool FPoseStreamReceiver::Start(int32 Port)
+{
+	Socket = FUdpSocketBuilder(TEXT("PoseStreamReceiver"))
+		.AsNonBlocking()
+		.AsReusable()
+		.BoundToAddress(FIPv4Address::Any)
+		.BoundToPort(Port)
+		// a few hundred frames of slack for when the thread is descheduled
+		.WithReceiveBufferSize(2 * 1024 * 1024);
+	if (Socket == nullptr)
+	{
+		UE_LOG(LogPoseStream, Error, TEXT("Couldn't bind UDP port %d for the pose stream"), Port);
+		return false;
+	}
+
+	Thread = FRunnableThread::Create(this, TEXT("PoseStreamReceiver"), 0, TPri_AboveNormal);
+	return Thread != nullptr;
+}
+
+uint32 FPoseStreamReceiver::Run()
+{
+	TSharedRef<FInternetAddr> Sender = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+	while (!bStopping)
+	{
+		if (!Socket->Wait(ESocketWaitConditions::WaitForRead, ReceiveWaitTime)) continue;
+
+		int32 BytesRead = 0;
+		while (!bStopping && Socket->RecvFrom(Buffer, BufferSize, BytesRead, *Sender))
+		{
+			const double ReceiveTime = FPlatformTime::Seconds();
+			Stats.Packets++;
+			Stats.Bytes += BytesRead;
+
+			FPoseStreamFrame* Frame = Ring.BeginWrite();
+			if (Frame == nullptr)
+			{
+				Stats.Dropped++;
+				continue;
+			}
+
+			Frame->NumPeople = 0;
+			Frame->SourceTime = 0.0;
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			const PoseStreamOSC::EParseResult Result = PoseStreamOSC::ParsePacket(Buffer, BytesRead, *Frame);
+			Stats.ParseCycles += FPlatformTime::Cycles64() - StartCycles;
+			if (Result != PoseStreamOSC::EParseResult::Ok)
+			{
+				Stats.ParseErrors++;
+				continue;
+			}
+
+			Frame->Sequence = ++Sequence;
+			Frame->ReceiveTime = ReceiveTime;
+			Ring.CommitWrite();
+			Stats.Frames++;
+		}
+	}
+	return 0;
+}
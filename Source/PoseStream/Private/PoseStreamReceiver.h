@@ -0,0 +1,57 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "PoseStreamTypes.h"
+#include "PoseStreamRing.h"
+#include <atomic>
+
+class FSocket;
+class FRunnableThread;
+
+/** Frames in flight between the receive thread and the game thread, about half a second at 120 Hz */
+using FPoseStreamFrameRing = TPoseStreamRing<FPoseStreamFrame, 64>;
+
+/** Counters of the receive thread, readable from any thread */
+struct FPoseStreamReceiverStats
+{
+	std::atomic<uint64> Packets{ 0 };
+	std::atomic<uint64> Frames{ 0 };
+	/** Packets that weren't OSC or had broken /pose messages */
+	std::atomic<uint64> ParseErrors{ 0 };
+	/** Frames dropped because the game thread hadn't drained the ring */
+	std::atomic<uint64> Dropped{ 0 };
+	std::atomic<uint64> ParseCycles{ 0 };
+	std::atomic<uint64> Bytes{ 0 };
+};
+
+/**
+ * Receives pose packets on a dedicated thread and parses them straight into the ring.
+ * The thread blocks on the socket, so a frame is parsed as soon as it arrives rather than on the next tick.
+ */
+class FPoseStreamReceiver : public FRunnable
+{
+public:
+	FPoseStreamReceiver(FPoseStreamFrameRing& InRing, FPoseStreamReceiverStats& InStats);
+	virtual ~FPoseStreamReceiver();
+
+	/** Binds the UDP port and starts the thread */
+	bool Start(int32 Port);
+
+	virtual uint32 Run() override;
+	virtual void Stop() override { bStopping = true; }
+
+private:
+	FPoseStreamFrameRing& Ring;
+	FPoseStreamReceiverStats& Stats;
+	FSocket* Socket = nullptr;
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopping{ false };
+	uint64 Sequence = 0;
+
+	// largest UDP payload
+	static constexpr int32 BufferSize = 65536;
+	uint8 Buffer[BufferSize];
+};
@@ -0,0 +1,496 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamRecording.h"
+#include "PoseStreamModule.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DECLARE_CYCLE_STAT(TEXT("Recording Decode"), STAT_PoseStreamRecordingDecode, STATGROUP_PoseStream);
+
+namespace PoseStreamRecording
+{
+	// the most one person can take, so whole people can be decoded without bounds checks
+	static constexpr int32 MaxVarintBytes = 5;
+	static constexpr int32 MaxPersonBytes = MaxVarintBytes + 1 + MaxVarintBytes * (3 + PoseStream::MaxKeypoints * 4);
+	static constexpr int32 MaxFrameHeaderBytes = MaxVarintBytes * 2;
+
+	static FORCEINLINE uint32 ZigZag(int32 Value)
+	{
+		return ((uint32)Value << 1) ^ (uint32)(Value >> 31);
+	}
+
+	static FORCEINLINE int32 UnZigZag(uint32 Value)
+	{
+		return (int32)(Value >> 1) ^ -(int32)(Value & 1);
+	}
+
+	static FORCEINLINE uint8* WriteVarint(uint8* Ptr, uint32 Value)
+	{
+		while (Value >= 0x80)
+		{
+			*Ptr++ = uint8(Value | 0x80);
+			Value >>= 7;
+		}
+		*Ptr++ = uint8(Value);
+		return Ptr;
+	}
+
+	/** Reads a varint, unchecked readers need MaxVarintBytes available */
+	template<bool bChecked>
+	static FORCEINLINE bool ReadVarint(const uint8*& Ptr, const uint8* End, uint32& OutValue)
+	{
+		uint32 Value = 0;
+		for (int32 Shift = 0; Shift < MaxVarintBytes * 7; Shift += 7)
+		{
+			if (bChecked && Ptr == End) return false;
+			const uint8 Byte = *Ptr++;
+			Value |= uint32(Byte & 0x7f) << Shift;
+			if ((Byte & 0x80) == 0)
+			{
+				OutValue = Value;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static FORCEINLINE int32 Quantize(float Value, double InvPrecision)
+	{
+		return (int32)FMath::Clamp<double>(FMath::RoundToDouble(Value * InvPrecision), MIN_int32, MAX_int32);
+	}
+
+	static void QuantizePerson(const FPoseStreamPerson& Person, double InvPrecision, FQuantizedPerson& OutPerson)
+	{
+		const int32 NumKeypoints = FMath::Clamp(Person.NumKeypoints, 0, (int32)PoseStream::MaxKeypoints);
+		OutPerson.PersonId = Person.PersonId;
+		OutPerson.NumKeypoints = NumKeypoints;
+
+		// the hips are closest to the middle of the body, which keeps the offsets well inside 16 bit
+		FVector Root = FVector::ZeroVector;
+		if (NumKeypoints > PoseStream::RightHip)
+		{
+			Root = (Person.Positions[PoseStream::LeftHip] + Person.Positions[PoseStream::RightHip]) * 0.5f;
+		}
+		else if (NumKeypoints > 0)
+		{
+			Root = Person.Positions[0];
+		}
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			OutPerson.Root[Axis] = Quantize(Root[Axis], InvPrecision);
+		}
+
+		for (int32 Keypoint = 0; Keypoint < NumKeypoints; ++Keypoint)
+		{
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				const int64 Offset = (int64)Quantize(Person.Positions[Keypoint][Axis], InvPrecision) - OutPerson.Root[Axis];
+				OutPerson.Values[Keypoint][Axis] = (int32)FMath::Clamp<int64>(Offset, MIN_int16, MAX_int16);
+			}
+			OutPerson.Values[Keypoint][3] = FMath::RoundToInt(FMath::Clamp(Person.Confidences[Keypoint], 0.0f, 1.0f) * 255.0f);
+		}
+	}
+
+	static uint8* EncodePerson(uint8* Ptr, const FQuantizedPerson& Person, const FQuantizedPerson* Reference)
+	{
+		static const FQuantizedPerson Zero = {};
+		const FQuantizedPerson& Base = Reference != nullptr ? *Reference : Zero;
+
+		Ptr = WriteVarint(Ptr, ZigZag(Person.PersonId));
+		*Ptr++ = (uint8)Person.NumKeypoints;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			Ptr = WriteVarint(Ptr, ZigZag(Person.Root[Axis] - Base.Root[Axis]));
+		}
+		for (int32 Keypoint = 0; Keypoint < Person.NumKeypoints; ++Keypoint)
+		{
+			for (int32 Channel = 0; Channel < 4; ++Channel)
+			{
+				Ptr = WriteVarint(Ptr, ZigZag(Person.Values[Keypoint][Channel] - Base.Values[Keypoint][Channel]));
+			}
+		}
+		return Ptr;
+	}
+
+	template<bool bChecked>
+	static bool DecodePerson(const uint8*& Ptr, const uint8* End, const FQuantizedFrame& Previous, FQuantizedPerson& OutPerson)
+	{
+		uint32 Value;
+		if (!ReadVarint<bChecked>(Ptr, End, Value)) return false;
+		OutPerson.PersonId = UnZigZag(Value);
+		if (bChecked && Ptr == End) return false;
+		OutPerson.NumKeypoints = *Ptr++;
+		if (OutPerson.NumKeypoints > PoseStream::MaxKeypoints) return false;
+
+		static const FQuantizedPerson Zero = {};
+		const FQuantizedPerson* Reference = Previous.FindPerson(OutPerson.PersonId, OutPerson.NumKeypoints);
+		const FQuantizedPerson& Base = Reference != nullptr ? *Reference : Zero;
+
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			if (!ReadVarint<bChecked>(Ptr, End, Value)) return false;
+			OutPerson.Root[Axis] = Base.Root[Axis] + UnZigZag(Value);
+		}
+		for (int32 Keypoint = 0; Keypoint < OutPerson.NumKeypoints; ++Keypoint)
+		{
+			for (int32 Channel = 0; Channel < 4; ++Channel)
+			{
+				if (!ReadVarint<bChecked>(Ptr, End, Value)) return false;
+				OutPerson.Values[Keypoint][Channel] = Base.Values[Keypoint][Channel] + UnZigZag(Value);
+			}
+		}
+		return true;
+	}
+
+	const FQuantizedPerson* FQuantizedFrame::FindPerson(int32 PersonId, int32 NumKeypoints) const
+	{
+		for (int32 Index = 0; Index < NumPeople; ++Index)
+		{
+			if (People[Index].PersonId == PersonId && People[Index].NumKeypoints == NumKeypoints) return &People[Index];
+		}
+		return nullptr;
+	}
+}
+
+FPoseStreamRecordWriter::FPoseStreamRecordWriter()
+{
+	FMemory::Memzero(Header);
+}
+
+FPoseStreamRecordWriter::~FPoseStreamRecordWriter()
+{
+	Close();
+}
+
+bool FPoseStreamRecordWriter::Open(const FString& InFilename, float InPrecision, int32 InFramesPerChunk)
+{
+	Close();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(InFilename));
+	File.Reset(PlatformFile.OpenWrite(*InFilename));
+	if (!File.IsValid())
+	{
+		UE_LOG(LogPoseStream, Error, TEXT("Couldn't create recording %s"), *InFilename);
+		return false;
+	}
+
+	Filename = InFilename;
+	FMemory::Memzero(Header);
+	Header.Version = PoseStreamRecording::Version;
+	Header.Precision = FMath::Max(InPrecision, KINDA_SMALL_NUMBER);
+	Header.FramesPerChunk = FMath::Max(InFramesPerChunk, 1);
+	Index.Reset();
+	Chunk.Reset();
+	bWriteError = false;
+	PreviousTime = 0;
+
+	// the magic is only written once the index is, unfinished recordings don't open
+	bWriteError |= !File->Write((const uint8*)&Header, sizeof(Header));
+	Written = sizeof(Header);
+	return true;
+}
+
+void FPoseStreamRecordWriter::Write(double Time, const FPoseStreamFrame& Frame)
+{
+	if (!File.IsValid()) return;
+
+	if (Header.NumFrames == 0) StartTime = Time;
+	const uint64 FrameTime = FMath::Max((uint64)(FMath::Max(Time - StartTime, 0.0) * 1e6 + 0.5), PreviousTime);
+
+	PoseStreamRecording::FQuantizedFrame& Previous = Frames[CurrentFrame];
+	if (Header.NumFrames % Header.FramesPerChunk == 0)
+	{
+		FlushChunk();
+		Index.Add({ (uint64)Written, FrameTime });
+		Previous.NumPeople = 0;
+		PreviousTime = FrameTime;
+	}
+
+	CurrentFrame ^= 1;
+	PoseStreamRecording::FQuantizedFrame& Current = Frames[CurrentFrame];
+	const double InvPrecision = 1.0 / Header.Precision;
+	Current.NumPeople = FMath::Clamp(Frame.NumPeople, 0, (int32)PoseStream::MaxPeople);
+	for (int32 PersonIndex = 0; PersonIndex < Current.NumPeople; ++PersonIndex)
+	{
+		PoseStreamRecording::QuantizePerson(Frame.People[PersonIndex], InvPrecision, Current.People[PersonIndex]);
+	}
+
+	const int32 Start = Chunk.Num();
+	Chunk.AddUninitialized(PoseStreamRecording::MaxFrameHeaderBytes + Current.NumPeople * PoseStreamRecording::MaxPersonBytes);
+	uint8* Ptr = Chunk.GetData() + Start;
+	Ptr = PoseStreamRecording::WriteVarint(Ptr, (uint32)FMath::Min<uint64>(FrameTime - PreviousTime, MAX_uint32));
+	Ptr = PoseStreamRecording::WriteVarint(Ptr, (uint32)Current.NumPeople);
+	for (int32 PersonIndex = 0; PersonIndex < Current.NumPeople; ++PersonIndex)
+	{
+		const PoseStreamRecording::FQuantizedPerson& Person = Current.People[PersonIndex];
+		Ptr = PoseStreamRecording::EncodePerson(Ptr, Person, Previous.FindPerson(Person.PersonId, Person.NumKeypoints));
+	}
+	Chunk.SetNum(int32(Ptr - Chunk.GetData()), false);
+
+	PreviousTime = FrameTime;
+	Header.NumFrames++;
+}
+
+void FPoseStreamRecordWriter::FlushChunk()
+{
+	if (Chunk.Num() == 0) return;
+	bWriteError |= !File->Write(Chunk.GetData(), Chunk.Num());
+	Written += Chunk.Num();
+	Chunk.Reset();
+}
+
+bool FPoseStreamRecordWriter::Close()
+{
+	if (!File.IsValid()) return false;
+
+	FlushChunk();
+
+	// the index is read in place, so it starts 8 byte aligned
+	const uint8 Padding[8] = {};
+	const int64 PaddingSize = Align(Written, 8) - Written;
+	if (PaddingSize > 0)
+	{
+		bWriteError |= !File->Write(Padding, PaddingSize);
+		Written += PaddingSize;
+	}
+
+	Header.Magic = PoseStreamRecording::Magic;
+	Header.NumChunks = Index.Num();
+	Header.IndexOffset = Written;
+	Header.Duration = PreviousTime;
+	bWriteError |= !File->Write((const uint8*)Index.GetData(), Index.Num() * sizeof(PoseStreamRecording::FChunk));
+	Written += Index.Num() * sizeof(PoseStreamRecording::FChunk);
+	bWriteError |= !File->Seek(0);
+	bWriteError |= !File->Write((const uint8*)&Header, sizeof(Header));
+	File.Reset();
+
+	if (bWriteError)
+	{
+		UE_LOG(LogPoseStream, Error, TEXT("Couldn't write recording %s"), *Filename);
+		return false;
+	}
+	UE_LOG(LogPoseStream, Log, TEXT("Recorded %u frames, %.1f s, %.2f MB to %s"), Header.NumFrames, Header.Duration * 1e-6, Written / (1024.0 * 1024.0), *Filename);
+	return true;
+}
+
+TSharedPtr<FPoseStreamRecording> FPoseStreamRecording::Open(const FString& Filename)
+{
+	TSharedPtr<FPoseStreamRecording> Recording = MakeShareable(new FPoseStreamRecording());
+	Recording->Filename = Filename;
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	Recording->MappedFile = PlatformFile.OpenMapped(*Filename);
+	if (Recording->MappedFile != nullptr)
+	{
+		Recording->MappedRegion = Recording->MappedFile->MapRegion(0, Recording->MappedFile->GetFileSize());
+	}
+	if (Recording->MappedRegion != nullptr)
+	{
+		Recording->Data = Recording->MappedRegion->GetMappedPtr();
+		Recording->Size = Recording->MappedRegion->GetMappedSize();
+	}
+	else
+	{
+		delete Recording->MappedFile;
+		Recording->MappedFile = nullptr;
+		if (!FFileHelper::LoadFileToArray(Recording->Loaded, *Filename, FILEREAD_Silent))
+		{
+			UE_LOG(LogPoseStream, Error, TEXT("Couldn't open recording %s"), *Filename);
+			return nullptr;
+		}
+		Recording->Data = Recording->Loaded.GetData();
+		Recording->Size = Recording->Loaded.Num();
+	}
+
+	if (!Recording->Initialize())
+	{
+		UE_LOG(LogPoseStream, Error, TEXT("%s isn't a complete pose stream recording"), *Filename);
+		return nullptr;
+	}
+	return Recording;
+}
+
+FPoseStreamRecording::~FPoseStreamRecording()
+{
+	delete MappedRegion;
+	delete MappedFile;
+}
+
+bool FPoseStreamRecording::Initialize()
+{
+	if (Size < (int64)sizeof(PoseStreamRecording::FHeader)) return false;
+	FMemory::Memcpy(&Header, Data, sizeof(PoseStreamRecording::FHeader));
+	if (Header.Magic != PoseStreamRecording::Magic || Header.Version != PoseStreamRecording::Version) return false;
+	if (!(Header.Precision > 0.0f) || Header.FramesPerChunk == 0 || Header.NumFrames == 0) return false;
+	if (Header.NumChunks != FMath::DivideAndRoundUp(Header.NumFrames, Header.FramesPerChunk)) return false;
+	if (Header.IndexOffset % alignof(PoseStreamRecording::FChunk) != 0 || Header.IndexOffset > (uint64)Size || ((uint64)Size - Header.IndexOffset) / sizeof(PoseStreamRecording::FChunk) < Header.NumChunks) return false;
+
+	Index = reinterpret_cast<const PoseStreamRecording::FChunk*>(Data + Header.IndexOffset);
+	uint64 PreviousOffset = sizeof(PoseStreamRecording::FHeader);
+	for (uint32 ChunkIndex = 0; ChunkIndex < Header.NumChunks; ++ChunkIndex)
+	{
+		if (Index[ChunkIndex].Offset < PreviousOffset || Index[ChunkIndex].Offset > Header.IndexOffset) return false;
+		PreviousOffset = Index[ChunkIndex].Offset;
+	}
+	return true;
+}
+
+int32 FPoseStreamRecording::FindChunk(uint64 Time) const
+{
+	// last chunk starting at or before Time
+	int32 First = 0;
+	int32 Count = (int32)Header.NumChunks;
+	while (Count > 0)
+	{
+		const int32 Step = Count / 2;
+		if (Index[First + Step].Time <= Time)
+		{
+			First += Step + 1;
+			Count -= Step + 1;
+		}
+		else
+		{
+			Count = Step;
+		}
+	}
+	return FMath::Max(First - 1, 0);
+}
+
+const uint8* FPoseStreamRecording::GetChunkEnd(int32 ChunkIndex) const
+{
+	return Data + (ChunkIndex + 1 < (int32)Header.NumChunks ? Index[ChunkIndex + 1].Offset : Header.IndexOffset);
+}
+
+void FPoseStreamRecordCursor::BeginChunk(const FPoseStreamRecording& Recording, int32 InChunkIndex)
+{
+	ChunkIndex = InChunkIndex;
+	FrameIndex = InChunkIndex * Recording.GetFramesPerChunk() - 1;
+	Offset = 0;
+	Time = Recording.GetChunk(InChunkIndex).Time;
+	Frames[CurrentFrame].NumPeople = 0;
+}
+
+bool FPoseStreamRecordCursor::PeekTime(const FPoseStreamRecording& Recording, uint64& OutTime) const
+{
+	const int32 Next = FrameIndex + 1;
+	if (Next >= Recording.GetNumFrames() || Next >= (ChunkIndex + 1) * Recording.GetFramesPerChunk()) return false;
+
+	const uint8* Ptr = Recording.GetChunkData(ChunkIndex) + Offset;
+	uint32 Delta;
+	if (!PoseStreamRecording::ReadVarint<true>(Ptr, Recording.GetChunkEnd(ChunkIndex), Delta)) return false;
+	OutTime = Time + Delta;
+	return true;
+}
+
+bool FPoseStreamRecordCursor::DecodeNext(const FPoseStreamRecording& Recording)
+{
+	const uint8* const Start = Recording.GetChunkData(ChunkIndex);
+	const uint8* const End = Recording.GetChunkEnd(ChunkIndex);
+	const uint8* Ptr = Start + Offset;
+
+	const PoseStreamRecording::FQuantizedFrame& Previous = Frames[CurrentFrame];
+	PoseStreamRecording::FQuantizedFrame& Current = Frames[CurrentFrame ^ 1];
+
+	uint32 Delta, NumPeople;
+	if (!PoseStreamRecording::ReadVarint<true>(Ptr, End, Delta) || !PoseStreamRecording::ReadVarint<true>(Ptr, End, NumPeople) || NumPeople > PoseStream::MaxPeople)
+	{
+		return false;
+	}
+	for (uint32 PersonIndex = 0; PersonIndex < NumPeople; ++PersonIndex)
+	{
+		// the bounds are only checked per value near the end of the chunk
+		const bool bDecoded = End - Ptr >= PoseStreamRecording::MaxPersonBytes
+			? PoseStreamRecording::DecodePerson<false>(Ptr, End, Previous, Current.People[PersonIndex])
+			: PoseStreamRecording::DecodePerson<true>(Ptr, End, Previous, Current.People[PersonIndex]);
+		if (!bDecoded) return false;
+	}
+	Current.NumPeople = (int32)NumPeople;
+
+	CurrentFrame ^= 1;
+	Offset = Ptr - Start;
+	Time += Delta;
+	FrameIndex++;
+	return true;
+}
+
+void FPoseStreamRecordCursor::Dequantize(const FPoseStreamRecording& Recording, FPoseStreamFrame& OutFrame, double& OutTime) const
+{
+	const PoseStreamRecording::FQuantizedFrame& Current = Frames[CurrentFrame];
+	const float Precision = Recording.GetPrecision();
+
+	OutTime = Time * 1e-6;
+	OutFrame.Sequence = FrameIndex + 1;
+	OutFrame.SourceTime = OutTime;
+	OutFrame.ReceiveTime = OutTime;
+	OutFrame.NumPeople = Current.NumPeople;
+	for (int32 PersonIndex = 0; PersonIndex < Current.NumPeople; ++PersonIndex)
+	{
+		const PoseStreamRecording::FQuantizedPerson& Quantized = Current.People[PersonIndex];
+		FPoseStreamPerson& Person = OutFrame.People[PersonIndex];
+		Person.PersonId = Quantized.PersonId;
+		Person.NumKeypoints = Quantized.NumKeypoints;
+		for (int32 Keypoint = 0; Keypoint < Quantized.NumKeypoints; ++Keypoint)
+		{
+			const int32* Values = Quantized.Values[Keypoint];
+			Person.Positions[Keypoint] = FVector(
+				float(Quantized.Root[0] + Values[0]) * Precision,
+				float(Quantized.Root[1] + Values[1]) * Precision,
+				float(Quantized.Root[2] + Values[2]) * Precision);
+			Person.Confidences[Keypoint] = Values[3] * (1.0f / 255.0f);
+		}
+	}
+}
+
+bool FPoseStreamRecordCursor::ReadFrame(const FPoseStreamRecording& Recording, int32 InFrameIndex, FPoseStreamFrame& OutFrame, double& OutTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PoseStreamRecordingDecode);
+	if (InFrameIndex < 0 || InFrameIndex >= Recording.GetNumFrames()) return false;
+
+	const int32 TargetChunk = InFrameIndex / Recording.GetFramesPerChunk();
+	if (TargetChunk != ChunkIndex || InFrameIndex < FrameIndex)
+	{
+		BeginChunk(Recording, TargetChunk);
+	}
+	while (FrameIndex < InFrameIndex)
+	{
+		if (!DecodeNext(Recording))
+		{
+			Reset();
+			return false;
+		}
+	}
+	Dequantize(Recording, OutFrame, OutTime);
+	return true;
+}
+
+bool FPoseStreamRecordCursor::ReadAtTime(const FPoseStreamRecording& Recording, double InTime, FPoseStreamFrame& OutFrame, double& OutTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PoseStreamRecordingDecode);
+	const uint64 TargetTime = InTime > 0.0 ? (uint64)(InTime * 1e6 + 0.5) : 0;
+
+	const int32 TargetChunk = Recording.FindChunk(TargetTime);
+	if (TargetChunk != ChunkIndex || FrameIndex < TargetChunk * Recording.GetFramesPerChunk() || TargetTime < Time)
+	{
+		BeginChunk(Recording, TargetChunk);
+		if (!DecodeNext(Recording))
+		{
+			Reset();
+			return false;
+		}
+	}
+
+	uint64 NextTime;
+	while (PeekTime(Recording, NextTime) && NextTime <= TargetTime)
+	{
+		if (!DecodeNext(Recording))
+		{
+			Reset();
+			return false;
+		}
+	}
+	Dequantize(Recording, OutFrame, OutTime);
+	return true;
+}
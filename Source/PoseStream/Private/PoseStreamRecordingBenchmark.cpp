@@ -0,0 +1,263 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamModule.h"
+#include "PoseStreamRecording.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	/**
+	 * Performers walking around the stage with swinging limbs, half a centimetre of estimator noise and confidences
+	 * that wander. Every frame comes from its own seed so any frame can be rebuilt to check the decoded one.
+	 */
+	void MakeRecordingBenchmarkFrame(int32 FrameIndex, int32 NumPeople, FPoseStreamFrame& OutFrame)
+	{
+		FRandomStream Random(FrameIndex * 7919 + 17);
+		const float Time = FrameIndex / 120.0f;
+		OutFrame.NumPeople = NumPeople;
+		for (int32 PersonIndex = 0; PersonIndex < NumPeople; ++PersonIndex)
+		{
+			FPoseStreamPerson& Person = OutFrame.People[PersonIndex];
+			Person.PersonId = PersonIndex;
+			Person.NumKeypoints = PoseStream::MaxKeypoints;
+
+			const float Walk = Time * 0.3f + PersonIndex * 1.7f;
+			const FVector Root(FMath::Cos(Walk) * 300.0f, FMath::Sin(Walk) * 300.0f, 95.0f);
+			const float Swing = FMath::Sin(Time * 5.0f + PersonIndex);
+			for (int32 Keypoint = 0; Keypoint < PoseStream::MaxKeypoints; ++Keypoint)
+			{
+				// a rough body, limbs further from the hips swing further
+				const float Height = 80.0f - Keypoint * 5.0f;
+				const float Side = (Keypoint % 2 == 0 ? 1.0f : -1.0f) * (10.0f + (Keypoint % 5) * 4.0f);
+				const FVector Limb(Swing * FMath::Abs(Height) * 0.3f * (Keypoint % 2 == 0 ? 1.0f : -1.0f), Side, Height);
+				Person.Positions[Keypoint] = Root + Limb + Random.GetUnitVector() * Random.FRandRange(0.0f, 0.5f);
+				Person.Confidences[Keypoint] = FMath::Clamp(0.85f + FMath::Sin(Time + Keypoint) * 0.1f + Random.FRandRange(-0.02f, 0.02f), 0.0f, 1.0f);
+			}
+		}
+	}
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** People that leave and come back, so frames are coded against people missing from the previous frame */
+	int32 GetRecordingTestPeople(int32 FrameIndex) { return (FrameIndex / 200) % 2 == 0 ? 3 : 2; }
+
+	/** Largest position and confidence difference between a decoded frame and the frame it was recorded from */
+	bool CompareRecordedFrame(const FPoseStreamFrame& Decoded, const FPoseStreamFrame& Truth, float& OutPositionError, float& OutConfidenceError)
+	{
+		if (Decoded.NumPeople != Truth.NumPeople) return false;
+		for (int32 PersonIndex = 0; PersonIndex < Truth.NumPeople; ++PersonIndex)
+		{
+			const FPoseStreamPerson& Person = Decoded.People[PersonIndex];
+			const FPoseStreamPerson& Expected = Truth.People[PersonIndex];
+			if (Person.PersonId != Expected.PersonId || Person.NumKeypoints != Expected.NumKeypoints) return false;
+			for (int32 Keypoint = 0; Keypoint < Expected.NumKeypoints; ++Keypoint)
+			{
+				OutPositionError = FMath::Max(OutPositionError, (Person.Positions[Keypoint] - Expected.Positions[Keypoint]).GetAbsMax());
+				OutConfidenceError = FMath::Max(OutConfidenceError, FMath::Abs(Person.Confidences[Keypoint] - Expected.Confidences[Keypoint]));
+			}
+		}
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPoseStreamRecordingTest, "PoseStream.Recording.RoundTrip", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPoseStreamRecordingTest::RunTest(const FString& Parameters)
+{
+	const int32 NumFrames = 1000;
+	const int32 FramesPerChunk = 128;
+	const float Precision = 0.1f;
+	const FString Filename = FPaths::ProjectSavedDir() / TEXT("PoseStream") / TEXT("RecordingTest.posestream");
+	const FString TruncatedFilename = FPaths::ProjectSavedDir() / TEXT("PoseStream") / TEXT("RecordingTestTruncated.posestream");
+
+	TUniquePtr<FPoseStreamFrame> Frame = MakeUnique<FPoseStreamFrame>();
+	TUniquePtr<FPoseStreamFrame> Truth = MakeUnique<FPoseStreamFrame>();
+	{
+		FPoseStreamRecordWriter Writer;
+		if (!TestTrue(TEXT("Recording opened for writing"), Writer.Open(Filename, Precision, FramesPerChunk))) return false;
+		for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+		{
+			MakeRecordingBenchmarkFrame(FrameIndex, GetRecordingTestPeople(FrameIndex), *Frame);
+			// on a clock that doesn't start at zero, the recording starts at the first frame
+			Writer.Write(500.0 + FrameIndex / 120.0, *Frame);
+		}
+		TestEqual(TEXT("Frames written"), Writer.GetNumFrames(), NumFrames);
+		if (!TestTrue(TEXT("Recording closed"), Writer.Close())) return false;
+	}
+
+	TSharedPtr<FPoseStreamRecording> Recording = FPoseStreamRecording::Open(Filename);
+	if (!TestTrue(TEXT("Recording opens"), Recording.IsValid())) return false;
+
+	// header and chunk index
+	TestEqual(TEXT("Frames in the header"), Recording->GetNumFrames(), NumFrames);
+	TestEqual(TEXT("Frames per chunk"), Recording->GetFramesPerChunk(), FramesPerChunk);
+	TestEqual(TEXT("Chunks in the index"), Recording->GetNumChunks(), FMath::DivideAndRoundUp(NumFrames, FramesPerChunk));
+	TestEqual(TEXT("Precision"), Recording->GetPrecision(), Precision);
+	TestEqual(TEXT("Duration"), Recording->GetDuration(), (NumFrames - 1) / 120.0, 1e-5);
+	for (int32 ChunkIndex = 0; ChunkIndex < Recording->GetNumChunks(); ++ChunkIndex)
+	{
+		const uint64 ChunkTime = Recording->GetChunk(ChunkIndex).Time;
+		TestEqual(TEXT("Chunk starts at its first frame's time"), (double)ChunkTime, FMath::RoundToDouble(ChunkIndex * FramesPerChunk / 120.0 * 1e6), 1.0);
+		TestEqual(TEXT("Chunk found from its start time"), Recording->FindChunk(ChunkTime), ChunkIndex);
+		TestEqual(TEXT("Chunk found from a time within it"), Recording->FindChunk(ChunkTime + 1000), ChunkIndex);
+		TestTrue(TEXT("Chunk data lies before its end"), Recording->GetChunkData(ChunkIndex) < Recording->GetChunkEnd(ChunkIndex));
+	}
+	TestEqual(TEXT("Times before the start fall in the first chunk"), Recording->FindChunk(0), 0);
+
+	// sequential decode against the input
+	FPoseStreamRecordCursor Cursor;
+	double FrameTime;
+	float PositionError = 0.0f;
+	float ConfidenceError = 0.0f;
+	int32 Mismatched = 0;
+	for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+	{
+		if (!Cursor.ReadFrame(*Recording, FrameIndex, *Frame, FrameTime))
+		{
+			AddError(FString::Printf(TEXT("Couldn't decode frame %d"), FrameIndex));
+			return false;
+		}
+		MakeRecordingBenchmarkFrame(FrameIndex, GetRecordingTestPeople(FrameIndex), *Truth);
+		Mismatched += !CompareRecordedFrame(*Frame, *Truth, PositionError, ConfidenceError);
+		Mismatched += !FMath::IsNearlyEqual(FrameTime, FrameIndex / 120.0, 1e-5);
+	}
+	TestEqual(TEXT("Sequentially decoded frames with the wrong people or time"), Mismatched, 0);
+	TestTrue(FString::Printf(TEXT("Position error %.4f within half the %.2f step"), PositionError, Precision), PositionError <= Precision * 0.51f);
+	TestTrue(FString::Printf(TEXT("Confidence error %.4f within half an 8 bit step"), ConfidenceError), ConfidenceError <= 0.5f / 255.0f + KINDA_SMALL_NUMBER);
+	TestFalse(TEXT("Frames past the end don't decode"), Cursor.ReadFrame(*Recording, NumFrames, *Frame, FrameTime));
+
+	// random access by index and by time, every read restarting somewhere else
+	FRandomStream Random(38);
+	Mismatched = 0;
+	PositionError = 0.0f;
+	for (int32 Seek = 0; Seek < 200; ++Seek)
+	{
+		const int32 FrameIndex = Random.RandHelper(NumFrames);
+		const bool bByTime = Seek % 2 == 0;
+		const bool bDecoded = bByTime
+			? Cursor.ReadAtTime(*Recording, (FrameIndex + 0.5) / 120.0, *Frame, FrameTime)
+			: Cursor.ReadFrame(*Recording, FrameIndex, *Frame, FrameTime);
+		MakeRecordingBenchmarkFrame(FrameIndex, GetRecordingTestPeople(FrameIndex), *Truth);
+		Mismatched += !bDecoded || Cursor.GetFrameIndex() != FrameIndex || !CompareRecordedFrame(*Frame, *Truth, PositionError, ConfidenceError);
+	}
+	TestEqual(TEXT("Randomly accessed frames that differ from the input"), Mismatched, 0);
+	TestTrue(FString::Printf(TEXT("Position error %.4f after seeking"), PositionError), PositionError <= Precision * 0.51f);
+
+	// a recording cut short loses its index and must be refused rather than read past its end
+	TArray<uint8> Contents;
+	FFileHelper::LoadFileToArray(Contents, *Filename);
+	Contents.SetNum(Contents.Num() - 16);
+	FFileHelper::SaveArrayToFile(Contents, *TruncatedFilename);
+	TestFalse(TEXT("Truncated recording is refused"), FPoseStreamRecording::Open(TruncatedFilename).IsValid());
+
+	Recording.Reset();
+	IFileManager::Get().Delete(*Filename);
+	IFileManager::Get().Delete(*TruncatedFilename);
+	return true;
+}
+
+#endif
+
+static FAutoConsoleCommand PoseStreamRecordingBenchmarkCommand(
+	TEXT("PoseStream.RecordingBenchmark"),
+	TEXT("Records a synthetic 120 Hz session, then reports the compression against raw keypoints, sequential and random decode speed and the quantization error. ")
+	TEXT("Arguments: [Minutes=60] [People=4] [Precision=0.1]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		const float Minutes = Args.Num() > 0 ? FMath::Max(FCString::Atof(*Args[0]), 0.1f) : 60.0f;
+		const int32 NumPeople = Args.Num() > 1 ? FMath::Clamp(FCString::Atoi(*Args[1]), 1, (int32)PoseStream::MaxPeople) : 4;
+		const float Precision = Args.Num() > 2 ? FMath::Max(FCString::Atof(*Args[2]), 0.001f) : 0.1f;
+		const int32 NumFrames = FMath::RoundToInt(Minutes * 60.0f * 120.0f);
+		const FString Filename = FPaths::ProjectSavedDir() / TEXT("PoseStream") / TEXT("RecordingBenchmark.posestream");
+
+		FPoseStreamFrame Frame;
+		double GenerateSeconds = 0.0;
+		double EncodeSeconds = 0.0;
+		{
+			FPoseStreamRecordWriter Writer;
+			if (!Writer.Open(Filename, Precision)) return;
+			for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+			{
+				const double GenerateStart = FPlatformTime::Seconds();
+				MakeRecordingBenchmarkFrame(FrameIndex, NumPeople, Frame);
+				const double EncodeStart = FPlatformTime::Seconds();
+				Writer.Write(FrameIndex / 120.0, Frame);
+				EncodeSeconds += FPlatformTime::Seconds() - EncodeStart;
+				GenerateSeconds += EncodeStart - GenerateStart;
+			}
+			const double CloseStart = FPlatformTime::Seconds();
+			if (!Writer.Close()) return;
+			EncodeSeconds += FPlatformTime::Seconds() - CloseStart;
+		}
+
+		TSharedPtr<FPoseStreamRecording> Recording = FPoseStreamRecording::Open(Filename);
+		if (!Recording.IsValid()) return;
+
+		// raw is what the frames take in memory, keypoint positions and confidences as floats
+		const double RawBytes = double(NumFrames) * NumPeople * PoseStream::MaxKeypoints * (sizeof(FVector) + sizeof(float));
+		const double Megabytes = Recording->GetSize() / (1024.0 * 1024.0);
+		UE_LOG(LogPoseStream, Display, TEXT("Recording: %d frames, %d people, %.1f minutes, %.2f MB (%.1f bytes per person per frame), %.1fx smaller than raw floats, %s"),
+			NumFrames, NumPeople, Recording->GetDuration() / 60.0, Megabytes, Recording->GetSize() / (double(NumFrames) * NumPeople),
+			RawBytes / Recording->GetSize(), Recording->IsMapped() ? TEXT("memory mapped") : TEXT("loaded, the platform can't map files"));
+		UE_LOG(LogPoseStream, Display, TEXT("Recording: encode %.2f us per frame (%.0f MB/s of raw keypoints), generating the input took %.1f s"),
+			EncodeSeconds * 1e6 / NumFrames, RawBytes / (1024.0 * 1024.0) / EncodeSeconds, GenerateSeconds);
+
+		// sequential playback, checked against the input on a sample of frames
+		FPoseStreamRecordCursor Cursor;
+		FPoseStreamFrame Truth;
+		double FrameTime;
+		float MaxPositionError = 0.0f;
+		float MaxConfidenceError = 0.0f;
+		int32 NumChecked = 0;
+		double DecodeSeconds = 0.0;
+		for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+		{
+			const double DecodeStart = FPlatformTime::Seconds();
+			if (!Cursor.ReadFrame(*Recording, FrameIndex, Frame, FrameTime))
+			{
+				UE_LOG(LogPoseStream, Error, TEXT("Recording: couldn't decode frame %d"), FrameIndex);
+				return;
+			}
+			DecodeSeconds += FPlatformTime::Seconds() - DecodeStart;
+
+			if (FrameIndex % 97 != 0) continue;
+			MakeRecordingBenchmarkFrame(FrameIndex, NumPeople, Truth);
+			for (int32 PersonIndex = 0; PersonIndex < NumPeople; ++PersonIndex)
+			{
+				for (int32 Keypoint = 0; Keypoint < PoseStream::MaxKeypoints; ++Keypoint)
+				{
+					MaxPositionError = FMath::Max(MaxPositionError, (Frame.People[PersonIndex].Positions[Keypoint] - Truth.People[PersonIndex].Positions[Keypoint]).GetAbsMax());
+					MaxConfidenceError = FMath::Max(MaxConfidenceError, FMath::Abs(Frame.People[PersonIndex].Confidences[Keypoint] - Truth.People[PersonIndex].Confidences[Keypoint]));
+				}
+			}
+			++NumChecked;
+		}
+		UE_LOG(LogPoseStream, Display, TEXT("Recording: sequential decode %.2f us per frame, %.0f frames/s, %.0fx real time"),
+			DecodeSeconds * 1e6 / NumFrames, NumFrames / DecodeSeconds, Recording->GetDuration() / DecodeSeconds);
+
+		// scrubbing, every read lands in another chunk
+		FRandomStream Random(7);
+		const int32 NumSeeks = 10000;
+		const double SeekStart = FPlatformTime::Seconds();
+		for (int32 Seek = 0; Seek < NumSeeks; ++Seek)
+		{
+			Cursor.ReadAtTime(*Recording, Random.FRand() * Recording->GetDuration(), Frame, FrameTime);
+		}
+		const double SeekSeconds = FPlatformTime::Seconds() - SeekStart;
+		UE_LOG(LogPoseStream, Display, TEXT("Recording: random seek %.1f us, %d frames per chunk"), SeekSeconds * 1e6 / NumSeeks, Recording->GetFramesPerChunk());
+
+		UE_LOG(LogPoseStream, Display, TEXT("Recording: largest error over %d frames, position %.4f (step %.4f), confidence %.4f, %s"),
+			NumChecked, MaxPositionError, Precision, MaxConfidenceError,
+			MaxPositionError <= Precision * 0.51f && MaxConfidenceError <= 0.5f / 255.0f + KINDA_SMALL_NUMBER ? TEXT("passed") : TEXT("FAILED"));
+
+		Recording.Reset();
+		IFileManager::Get().Delete(*Filename);
+	}));
@@ -0,0 +1,229 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamModule.h"
+#include "AnimNode_PoseStreamRetarget.h"
+#include "AnimationRuntime.h"
+#include "Animation/Skeleton.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+
+namespace
+{
+	/** Keypoints of a performer with the skeleton's reference proportions, swaying and reaching over time */
+	void MakeKeypoints(const FTransform (&Ref)[PoseStreamRetarget::NumBones], float Time, FVector (&OutKeypoints)[PoseStream::MaxKeypoints], float (&OutConfidences)[PoseStream::MaxKeypoints])
+	{
+		using namespace PoseStream;
+		using namespace PoseStreamRetarget;
+
+		for (int32 Keypoint = 0; Keypoint < MaxKeypoints; ++Keypoint)
+		{
+			OutKeypoints[Keypoint] = Ref[Pelvis].GetLocation();
+			OutConfidences[Keypoint] = 1.0f;
+		}
+		const FQuat Sway(FVector::UpVector, FMath::Sin(Time) * 0.5f);
+		const FVector Reach(FMath::Sin(Time * 2.0f) * 20.0f, FMath::Cos(Time * 2.0f) * 20.0f, FMath::Sin(Time * 3.0f) * 30.0f);
+		auto Set = [&](int32 Keypoint, int32 Bone, const FVector& Offset = FVector::ZeroVector)
+		{
+			OutKeypoints[Keypoint] = Sway.RotateVector(Ref[Bone].GetLocation() + Offset);
+		};
+		Set(LeftHip, ThighL); Set(RightHip, ThighR);
+		Set(LeftKnee, CalfL); Set(RightKnee, CalfR);
+		Set(LeftAnkle, FootL); Set(RightAnkle, FootR);
+		Set(LeftShoulder, UpperArmL); Set(RightShoulder, UpperArmR);
+		Set(LeftElbow, LowerArmL, Reach * 0.5f); Set(RightElbow, LowerArmR, -Reach * 0.5f);
+		Set(LeftWrist, HandL, Reach); Set(RightWrist, HandR, -Reach);
+		Set(Nose, Head, FVector(0.0f, 15.0f, 10.0f));
+		Set(LeftEar, Head, FVector(8.0f, 0.0f, 10.0f)); Set(RightEar, Head, FVector(-8.0f, 0.0f, 10.0f));
+	}
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Keypoints on the joints of a bone pose, the head keypoints placed so the head faces the way the chest does */
+	void MakeTestKeypoints(const FVector (&BoneLocations)[PoseStreamRetarget::NumBones], FVector (&OutKeypoints)[PoseStream::MaxKeypoints], float (&OutConfidences)[PoseStream::MaxKeypoints])
+	{
+		using namespace PoseStream;
+		using namespace PoseStreamRetarget;
+
+		for (int32 Keypoint = 0; Keypoint < MaxKeypoints; ++Keypoint)
+		{
+			OutKeypoints[Keypoint] = BoneLocations[Pelvis];
+			OutConfidences[Keypoint] = 1.0f;
+		}
+		OutKeypoints[LeftHip] = BoneLocations[ThighL]; OutKeypoints[RightHip] = BoneLocations[ThighR];
+		OutKeypoints[LeftKnee] = BoneLocations[CalfL]; OutKeypoints[RightKnee] = BoneLocations[CalfR];
+		OutKeypoints[LeftAnkle] = BoneLocations[FootL]; OutKeypoints[RightAnkle] = BoneLocations[FootR];
+		OutKeypoints[LeftShoulder] = BoneLocations[UpperArmL]; OutKeypoints[RightShoulder] = BoneLocations[UpperArmR];
+		OutKeypoints[LeftElbow] = BoneLocations[LowerArmL]; OutKeypoints[RightElbow] = BoneLocations[LowerArmR];
+		OutKeypoints[LeftWrist] = BoneLocations[HandL]; OutKeypoints[RightWrist] = BoneLocations[HandR];
+
+		// ears across the shoulders' axis and the nose forward of them, as rotated with the chest
+		const FVector Right = (BoneLocations[UpperArmR] - BoneLocations[UpperArmL]).GetSafeNormal();
+		const FVector Up = ((BoneLocations[UpperArmL] + BoneLocations[UpperArmR]) * 0.5f - (BoneLocations[ThighL] + BoneLocations[ThighR]) * 0.5f).GetSafeNormal();
+		const FVector Forward = Right ^ Up;
+		OutKeypoints[LeftEar] = BoneLocations[Head] - Right * 8.0f;
+		OutKeypoints[RightEar] = BoneLocations[Head] + Right * 8.0f;
+		OutKeypoints[Nose] = BoneLocations[Head] + Forward * 10.0f;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPoseStreamRetargetRoundTripTest, "PoseStream.Retarget.RoundTrip", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPoseStreamRetargetRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace PoseStreamRetarget;
+
+	FTransform Ref[NumBones];
+	MakeTestReferencePose(Ref);
+	FPoseStreamRetargetSolver Solver;
+	Solver.Initialize(Ref);
+
+	// keypoints of the skeleton itself, turned and with the left arm raised, the solve has to land every joint on them
+	const FQuat Turn(FVector::UpVector, FMath::DegreesToRadians(40.0f));
+	const FQuat Raise(FVector::ForwardVector, FMath::DegreesToRadians(-60.0f));
+	for (const bool bPosed : { false, true })
+	{
+		FVector Expected[NumBones];
+		for (int32 Bone = 0; Bone < NumBones; ++Bone)
+		{
+			Expected[Bone] = Ref[Bone].GetLocation();
+		}
+		if (bPosed)
+		{
+			for (int32 Bone : { LowerArmL, HandL })
+			{
+				Expected[Bone] = Ref[UpperArmL].GetLocation() + Raise.RotateVector(Expected[Bone] - Ref[UpperArmL].GetLocation());
+			}
+			// the pelvis is on the turn's axis, so it stays where the reference pose has it
+			for (FVector& Location : Expected)
+			{
+				Location = Turn.RotateVector(Location);
+			}
+		}
+
+		FVector Keypoints[PoseStream::MaxKeypoints];
+		float Confidences[PoseStream::MaxKeypoints];
+		MakeTestKeypoints(Expected, Keypoints, Confidences);
+		FTransform Solved[NumBones];
+		if (!TestTrue(TEXT("Solve succeeds with confident keypoints"), Solver.Solve(Keypoints, Confidences, FQuat::Identity, 0.3f, Solved))) return false;
+
+		float LargestError = 0.0f;
+		for (int32 Bone = 0; Bone < NumBones; ++Bone)
+		{
+			LargestError = FMath::Max(LargestError, FVector::Dist(Solved[Bone].GetLocation(), Expected[Bone]));
+			TestFalse(TEXT("Solved transforms are finite"), Solved[Bone].ContainsNaN());
+		}
+		TestTrue(FString::Printf(TEXT("%s bones land on the keypoints, largest error %.4f cm"), bPosed ? TEXT("Posed") : TEXT("Reference"), LargestError), LargestError < 0.05f);
+
+		const FQuat ExpectedPelvis = bPosed ? Turn : FQuat::Identity;
+		TestTrue(TEXT("Pelvis takes the orientation of the hips"), Solved[Pelvis].GetRotation().Equals(ExpectedPelvis, 1e-3f));
+		TestTrue(TEXT("Head faces the way the chest does"), Solved[Head].GetRotation().Equals(ExpectedPelvis, 1e-3f));
+	}
+
+	// without a torso there is nothing to solve and the output stays as it was
+	FVector Keypoints[PoseStream::MaxKeypoints];
+	float Confidences[PoseStream::MaxKeypoints];
+	FVector RefLocations[NumBones];
+	for (int32 Bone = 0; Bone < NumBones; ++Bone)
+	{
+		RefLocations[Bone] = Ref[Bone].GetLocation();
+	}
+	MakeTestKeypoints(RefLocations, Keypoints, Confidences);
+	Confidences[PoseStream::LeftHip] = 0.1f;
+	FTransform Untouched[NumBones];
+	TestFalse(TEXT("Solve fails without a confident hip"), Solver.Solve(Keypoints, Confidences, FQuat::Identity, 0.3f, Untouched));
+	TestTrue(TEXT("Failed solve leaves the output untouched"), Untouched[Pelvis].Equals(FTransform::Identity));
+	return true;
+}
+
+#endif
+
+static FAutoConsoleCommand PoseStreamRetargetBenchmarkCommand(
+	TEXT("PoseStream.RetargetBenchmark"),
+	TEXT("Times the keypoint retarget solve for a crowd of characters, on one thread and across the task graph. Arguments: [Characters=50] [Frames=500] [Skeleton=/Game/Mannequin/Character/Mesh/UE4_Mannequin_Skeleton]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		const int32 NumCharacters = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 50;
+		const int32 NumFrames = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 500;
+		const FString SkeletonPath = Args.Num() > 2 ? Args[2] : TEXT("/Game/Mannequin/Character/Mesh/UE4_Mannequin_Skeleton");
+
+		const USkeleton* Skeleton = LoadObject<USkeleton>(nullptr, *SkeletonPath);
+		if (Skeleton == nullptr)
+		{
+			UE_LOG(LogPoseStream, Error, TEXT("Couldn't load skeleton %s"), *SkeletonPath);
+			return;
+		}
+
+		// the node's default bone map against the skeleton's reference pose
+		const FReferenceSkeleton& RefSkeleton = Skeleton->GetReferenceSkeleton();
+		FPoseStreamRetargetBoneMap BoneMap;
+		FTransform RefComponentSpace[PoseStreamRetarget::NumBones];
+		for (int32 Bone = 0; Bone < PoseStreamRetarget::NumBones; ++Bone)
+		{
+			const FName BoneName = BoneMap.Get(Bone).BoneName;
+			const int32 BoneIndex = RefSkeleton.FindBoneIndex(BoneName);
+			if (BoneIndex == INDEX_NONE)
+			{
+				UE_LOG(LogPoseStream, Error, TEXT("Skeleton %s has no bone %s"), *SkeletonPath, *BoneName.ToString());
+				return;
+			}
+			RefComponentSpace[Bone] = FAnimationRuntime::GetComponentSpaceTransformRefPose(RefSkeleton, BoneIndex);
+		}
+
+		FPoseStreamRetargetSolver Solver;
+		Solver.Initialize(RefComponentSpace);
+
+		// every character a little out of phase, inputs built before timing
+		struct FCharacter
+		{
+			FVector Keypoints[PoseStream::MaxKeypoints];
+			float Confidences[PoseStream::MaxKeypoints];
+			FTransform Solved[PoseStreamRetarget::NumBones];
+		};
+		TArray<FCharacter> Characters;
+		Characters.SetNum(NumCharacters);
+		for (int32 Index = 0; Index < NumCharacters; ++Index)
+		{
+			MakeKeypoints(RefComponentSpace, Index * 0.37f, Characters[Index].Keypoints, Characters[Index].Confidences);
+		}
+
+		int32 Failed = 0;
+		auto SolveCharacter = [&](int32 Index)
+		{
+			FCharacter& Character = Characters[Index];
+			if (!Solver.Solve(Character.Keypoints, Character.Confidences, FQuat::Identity, 0.3f, Character.Solved)) ++Failed;
+		};
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			for (int32 Index = 0; Index < NumCharacters; ++Index) SolveCharacter(Index);
+		}
+		const double SerialSeconds = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			// as the worker threads evaluate the graphs of separate characters
+			ParallelFor(NumCharacters, [&](int32 Index)
+			{
+				FCharacter& Character = Characters[Index];
+				Solver.Solve(Character.Keypoints, Character.Confidences, FQuat::Identity, 0.3f, Character.Solved);
+			});
+		}
+		const double ParallelSeconds = FPlatformTime::Seconds() - StartTime;
+
+		// degenerate bend planes or bases would show up as NaNs
+		bool bFinite = true;
+		for (const FCharacter& Character : Characters)
+		{
+			for (const FTransform& Transform : Character.Solved) bFinite &= !Transform.ContainsNaN();
+		}
+
+		UE_LOG(LogPoseStream, Display, TEXT("Retarget: %d characters, serial %.3f ms per frame (%.2f us per character), parallel %.3f ms per frame, %d failed solves, %s"),
+			NumCharacters, SerialSeconds * 1e3 / NumFrames, SerialSeconds * 1e6 / (NumFrames * NumCharacters), ParallelSeconds * 1e3 / NumFrames,
+			Failed, bFinite ? TEXT("all transforms finite") : TEXT("NaN in solved transforms"));
+	}));
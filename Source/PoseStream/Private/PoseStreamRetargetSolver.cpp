@@ -0,0 +1,214 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamRetargetSolver.h"
+#include "TwoBoneIK.h"
+
+using namespace PoseStreamRetarget;
+using namespace PoseStream;
+
+namespace
+{
+	struct FLimbDefinition
+	{
+		uint8 Upper, Lower, End;
+		uint8 RootKeypoint, JointKeypoint, EndKeypoint;
+		/** Elbows bend forwards and knees backwards, used when the limb is too straight to have a bend plane */
+		float BendSign;
+		/** Arms hang off the chest, legs off the pelvis */
+		bool bFromChest;
+	};
+
+	const FLimbDefinition Limbs[] =
+	{
+		{ UpperArmL, LowerArmL, HandL, LeftShoulder, LeftElbow, LeftWrist, 1.0f, true },
+		{ UpperArmR, LowerArmR, HandR, RightShoulder, RightElbow, RightWrist, 1.0f, true },
+		{ ThighL, CalfL, FootL, LeftHip, LeftKnee, LeftAnkle, -1.0f, false },
+		{ ThighR, CalfR, FootR, RightHip, RightKnee, RightAnkle, -1.0f, false },
+	};
+
+	// share of the chest's rotation relative to the pelvis each spine bone takes
+	const float SpineSwingWeights[] = { 0.25f, 0.6f, 1.0f };
+	const float SpineTwistWeights[] = { 1.0f / 3.0f, 2.0f / 3.0f, 1.0f };
+
+	/** X forward, Y along Right, Z as close to Up as Right allows */
+	FQuat MakeBasis(const FVector& Right, const FVector& Up)
+	{
+		return FRotationMatrix::MakeFromYZ(Right, Up).ToQuat();
+	}
+
+	FVector BendNormal(const FVector& UpperDir, const FVector& LowerDir, const FVector& Forward, float BendSign)
+	{
+		const FVector Normal = UpperDir ^ LowerDir;
+		// below about 3 degrees of bend the plane is mostly noise
+		if (Normal.SizeSquared() > 0.0025f * UpperDir.SizeSquared() * LowerDir.SizeSquared()) return Normal;
+		return UpperDir ^ (Forward * BendSign);
+	}
+}
+
+int32 PoseStreamRetarget::GetParent(int32 Bone)
+{
+	static const int32 Parents[NumBones] =
+	{
+		INDEX_NONE,
+		Pelvis, Spine1, Spine2,
+		Spine3, Neck,
+		Spine3, ClavicleL, UpperArmL, LowerArmL,
+		Spine3, ClavicleR, UpperArmR, LowerArmR,
+		Pelvis, ThighL, CalfL,
+		Pelvis, ThighR, CalfR,
+	};
+	return Bone >= 0 && Bone < NumBones ? Parents[Bone] : INDEX_NONE;
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+void PoseStreamRetarget::MakeTestReferencePose(FTransform (&OutRef)[NumBones])
+{
+	static const FVector Locations[NumBones] =
+	{
+		FVector(0.0f, 0.0f, 100.0f),
+		FVector(0.0f, 0.0f, 110.0f), FVector(0.0f, 0.0f, 122.0f), FVector(0.0f, 0.0f, 135.0f),
+		FVector(0.0f, 0.0f, 150.0f), FVector(0.0f, 0.0f, 160.0f),
+		FVector(0.0f, -3.0f, 145.0f), FVector(0.0f, -18.0f, 145.0f), FVector(3.0f, -45.0f, 145.0f), FVector(0.0f, -70.0f, 145.0f),
+		FVector(0.0f, 3.0f, 145.0f), FVector(0.0f, 18.0f, 145.0f), FVector(3.0f, 45.0f, 145.0f), FVector(0.0f, 70.0f, 145.0f),
+		FVector(0.0f, -10.0f, 95.0f), FVector(-2.0f, -10.0f, 52.0f), FVector(0.0f, -10.0f, 8.0f),
+		FVector(0.0f, 10.0f, 95.0f), FVector(-2.0f, 10.0f, 52.0f), FVector(0.0f, 10.0f, 8.0f),
+	};
+	for (int32 Bone = 0; Bone < NumBones; ++Bone)
+	{
+		OutRef[Bone] = FTransform(Locations[Bone]);
+	}
+}
+#endif
+
+void FPoseStreamRetargetSolver::Initialize(const FTransform (&RefComponentSpace)[NumBones])
+{
+	for (int32 Bone = 0; Bone < NumBones; ++Bone)
+	{
+		Ref[Bone] = RefComponentSpace[Bone];
+		const int32 Parent = GetParent(Bone);
+		RefLocal[Bone] = Parent == INDEX_NONE ? Ref[Bone] : Ref[Bone].GetRelativeTransform(RefComponentSpace[Parent]);
+	}
+
+	const FVector HipCenter = (Ref[ThighL].GetLocation() + Ref[ThighR].GetLocation()) * 0.5f;
+	const FVector ShoulderCenter = (Ref[UpperArmL].GetLocation() + Ref[UpperArmR].GetLocation()) * 0.5f;
+	const FVector Up = ShoulderCenter - HipCenter;
+	RefPelvisBasis = MakeBasis(Ref[ThighR].GetLocation() - Ref[ThighL].GetLocation(), Up);
+	RefChestBasis = MakeBasis(Ref[UpperArmR].GetLocation() - Ref[UpperArmL].GetLocation(), Up);
+
+	for (int32 Limb = 0; Limb < NumLimbs; ++Limb)
+	{
+		const FLimbDefinition& Definition = Limbs[Limb];
+		UpperLength[Limb] = FVector::Dist(Ref[Definition.Upper].GetLocation(), Ref[Definition.Lower].GetLocation());
+		LowerLength[Limb] = FVector::Dist(Ref[Definition.Lower].GetLocation(), Ref[Definition.End].GetLocation());
+	}
+	bInitialized = true;
+}
+
+void FPoseStreamRetargetSolver::Follow(int32 Bone, FTransform (&OutComponentSpace)[NumBones]) const
+{
+	const FTransform& Parent = OutComponentSpace[GetParent(Bone)];
+	OutComponentSpace[Bone].SetRotation(Parent.GetRotation() * RefLocal[Bone].GetRotation());
+	OutComponentSpace[Bone].SetTranslation(Parent.TransformPosition(RefLocal[Bone].GetTranslation()));
+	OutComponentSpace[Bone].SetScale3D(Ref[Bone].GetScale3D());
+}
+
+bool FPoseStreamRetargetSolver::Solve(const FVector* InKeypoints, const float* Confidences, const FQuat& KeypointToComponent, float MinConfidence, FTransform (&OutComponentSpace)[NumBones]) const
+{
+	if (!bInitialized) return false;
+	if (Confidences[LeftHip] < MinConfidence || Confidences[RightHip] < MinConfidence || Confidences[LeftShoulder] < MinConfidence || Confidences[RightShoulder] < MinConfidence) return false;
+
+	// only directions are used, so rotating is enough to bring the keypoints into component space
+	FVector Keypoints[MaxKeypoints];
+	for (int32 Keypoint = 0; Keypoint < MaxKeypoints; ++Keypoint)
+	{
+		Keypoints[Keypoint] = KeypointToComponent.RotateVector(InKeypoints[Keypoint]);
+	}
+
+	const FVector HipCenter = (Keypoints[LeftHip] + Keypoints[RightHip]) * 0.5f;
+	const FVector ShoulderCenter = (Keypoints[LeftShoulder] + Keypoints[RightShoulder]) * 0.5f;
+	const FVector Up = ShoulderCenter - HipCenter;
+	const FQuat PelvisBasis = MakeBasis(Keypoints[RightHip] - Keypoints[LeftHip], Up);
+	const FQuat ChestBasis = MakeBasis(Keypoints[RightShoulder] - Keypoints[LeftShoulder], Up);
+	const FQuat PelvisDelta = PelvisBasis * RefPelvisBasis.Inverse();
+	const FQuat ChestDelta = ChestBasis * RefChestBasis.Inverse();
+
+	// the pelvis stays where the reference pose has it, only the orientation comes from the performer
+	OutComponentSpace[Pelvis] = FTransform(PelvisDelta * Ref[Pelvis].GetRotation(), Ref[Pelvis].GetTranslation(), Ref[Pelvis].GetScale3D());
+
+	// twist about the spine and bend of the chest relative to the pelvis, spread up the spine
+	FQuat Swing, Twist;
+	(ChestDelta * PelvisDelta.Inverse()).ToSwingTwist(PelvisBasis.GetAxisZ(), Swing, Twist);
+	for (int32 Index = 0; Index < 3; ++Index)
+	{
+		const int32 Bone = Spine1 + Index;
+		const FQuat SpineDelta = FQuat::Slerp(FQuat::Identity, Swing, SpineSwingWeights[Index]) * FQuat::Slerp(FQuat::Identity, Twist, SpineTwistWeights[Index]) * PelvisDelta;
+		Follow(Bone, OutComponentSpace);
+		OutComponentSpace[Bone].SetRotation((SpineDelta * Ref[Bone].GetRotation()).GetNormalized());
+	}
+
+	// head relative to the chest from the ears and nose, half of it taken by the neck
+	FQuat HeadRelative = FQuat::Identity;
+	if (Confidences[LeftEar] >= MinConfidence && Confidences[RightEar] >= MinConfidence && Confidences[Nose] >= MinConfidence)
+	{
+		const FVector EarCenter = (Keypoints[LeftEar] + Keypoints[RightEar]) * 0.5f;
+		const FQuat HeadBasis = FRotationMatrix::MakeFromYX(Keypoints[RightEar] - Keypoints[LeftEar], Keypoints[Nose] - EarCenter).ToQuat();
+		HeadRelative = HeadBasis * ChestBasis.Inverse();
+	}
+	Follow(Neck, OutComponentSpace);
+	OutComponentSpace[Neck].SetRotation((FQuat::Slerp(FQuat::Identity, HeadRelative, 0.5f) * ChestDelta * Ref[Neck].GetRotation()).GetNormalized());
+	Follow(Head, OutComponentSpace);
+	OutComponentSpace[Head].SetRotation((HeadRelative * ChestDelta * Ref[Head].GetRotation()).GetNormalized());
+
+	Follow(ClavicleL, OutComponentSpace);
+	Follow(ClavicleR, OutComponentSpace);
+	const FVector ChestForward = ChestBasis.GetAxisX();
+	const FVector PelvisForward = PelvisBasis.GetAxisX();
+	SolveLimb(ArmL, Keypoints, Confidences, MinConfidence, ChestForward, OutComponentSpace);
+	SolveLimb(ArmR, Keypoints, Confidences, MinConfidence, ChestForward, OutComponentSpace);
+	SolveLimb(LegL, Keypoints, Confidences, MinConfidence, PelvisForward, OutComponentSpace);
+	SolveLimb(LegR, Keypoints, Confidences, MinConfidence, PelvisForward, OutComponentSpace);
+	return true;
+}
+
+void FPoseStreamRetargetSolver::SolveLimb(ELimb Limb, const FVector* Keypoints, const float* Confidences, float MinConfidence, const FVector& Forward, FTransform (&OutComponentSpace)[NumBones]) const
+{
+	const FLimbDefinition& Definition = Limbs[Limb];
+
+	// start from the limb carried rigidly by its parent
+	Follow(Definition.Upper, OutComponentSpace);
+	Follow(Definition.Lower, OutComponentSpace);
+	Follow(Definition.End, OutComponentSpace);
+
+	if (Confidences[Definition.RootKeypoint] < MinConfidence || Confidences[Definition.JointKeypoint] < MinConfidence || Confidences[Definition.EndKeypoint] < MinConfidence) return;
+	const FVector KeypointUpper = Keypoints[Definition.JointKeypoint] - Keypoints[Definition.RootKeypoint];
+	const FVector KeypointLower = Keypoints[Definition.EndKeypoint] - Keypoints[Definition.JointKeypoint];
+	const float KeypointLength = KeypointUpper.Size() + KeypointLower.Size();
+	if (KeypointLength < KINDA_SMALL_NUMBER) return;
+
+	// the performer's limb scaled to the skeleton's, keeping its direction and how far it is bent
+	const float Scale = (UpperLength[Limb] + LowerLength[Limb]) / KeypointLength;
+	const FVector Root = OutComponentSpace[Definition.Upper].GetLocation();
+	const FVector Joint = OutComponentSpace[Definition.Lower].GetLocation();
+	const FVector End = OutComponentSpace[Definition.End].GetLocation();
+	const FVector Effector = Root + (KeypointUpper + KeypointLower) * Scale;
+	const FVector JointTarget = Root + KeypointUpper * Scale;
+
+	FVector SolvedJoint, SolvedEnd;
+	AnimationCore::SolveTwoBoneIK(Root, Joint, End, JointTarget, Effector, SolvedJoint, SolvedEnd, UpperLength[Limb], LowerLength[Limb], false, 1.0f, 1.0f);
+
+	// upper bone maps its direction and bend plane onto the solved ones, which fixes its twist as well as its swing
+	const FVector FromUpper = Joint - Root;
+	const FVector FromLower = End - Joint;
+	const FVector ToUpper = SolvedJoint - Root;
+	const FVector ToLower = SolvedEnd - SolvedJoint;
+	const FQuat From = FRotationMatrix::MakeFromXY(FromUpper, BendNormal(FromUpper, FromLower, Forward, Definition.BendSign)).ToQuat();
+	const FQuat To = FRotationMatrix::MakeFromXY(ToUpper, BendNormal(ToUpper, ToLower, Forward, Definition.BendSign)).ToQuat();
+	const FQuat UpperDelta = To * From.Inverse();
+	OutComponentSpace[Definition.Upper].SetRotation((UpperDelta * OutComponentSpace[Definition.Upper].GetRotation()).GetNormalized());
+
+	// the lower bone only swings within the plane
+	const FQuat LowerDelta = FQuat::FindBetweenVectors(UpperDelta.RotateVector(FromLower), ToLower) * UpperDelta;
+	OutComponentSpace[Definition.Lower].SetRotation((LowerDelta * OutComponentSpace[Definition.Lower].GetRotation()).GetNormalized());
+	OutComponentSpace[Definition.Lower].SetTranslation(SolvedJoint);
+	Follow(Definition.End, OutComponentSpace);
+}
@@ -0,0 +1,377 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamSubsystem.h"
+#include "PoseStreamModule.h"
+#include "PoseStreamReceiver.h"
+#include "PoseStreamLiveLinkSource.h"
+#include "ILiveLinkClient.h"
+#include "Features/IModularFeatures.h"
+#include "Engine/Engine.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+
+DECLARE_CYCLE_STAT(TEXT("Drain Frames"), STAT_PoseStreamDrain, STATGROUP_PoseStream);
+DECLARE_CYCLE_STAT(TEXT("Track"), STAT_PoseStreamTrack, STATGROUP_PoseStream);
+DECLARE_CYCLE_STAT(TEXT("Filter"), STAT_PoseStreamFilter, STATGROUP_PoseStream);
+DECLARE_CYCLE_STAT(TEXT("Record"), STAT_PoseStreamRecord, STATGROUP_PoseStream);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Frames Per Tick"), STAT_PoseStreamFramesPerTick, STATGROUP_PoseStream);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Tracks"), STAT_PoseStreamTracks, STATGROUP_PoseStream);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Jitter Buffer Depth"), STAT_PoseStreamJitterDepth, STATGROUP_PoseStream);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Jitter Buffer Underruns"), STAT_PoseStreamJitterUnderruns, STATGROUP_PoseStream);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Jitter Buffer Added Latency (ms)"), STAT_PoseStreamJitterLatency, STATGROUP_PoseStream);
+
+// people whose samples stopped arriving this long ago are dropped from the jitter buffers
+static constexpr double JitterBufferTimeout = 1.0;
+
+static TAutoConsoleVariable<float> CVarPoseStreamScale(
+	TEXT("PoseStream.Scale"),
+	100.0f,
+	TEXT("Unreal units per unit of the pose stream, 100 for keypoints in metres."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarPoseStreamTracking(
+	TEXT("PoseStream.Tracking"),
+	1,
+	TEXT("Replace the pose estimator's person indices, which swap between frames, with stable track ids."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarPoseStreamJitterDelay(
+	TEXT("PoseStream.JitterDelay"),
+	0.0f,
+	TEXT("Milliseconds samples are held in per person jitter buffers to even out network delay, 0 delivers frames as they arrive."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarPoseStreamLiveLink(
+	TEXT("PoseStream.LiveLink"),
+	1,
+	TEXT("Publish received people as LiveLink subjects."),
+	ECVF_Default);
+
+UPoseStreamSubsystem::UPoseStreamSubsystem()
+{
+}
+
+UPoseStreamSubsystem::~UPoseStreamSubsystem()
+{
+}
+
+void UPoseStreamSubsystem::Deinitialize()
+{
+	StopListening();
+	StopRecording();
+	Super::Deinitialize();
+}
+
+bool UPoseStreamSubsystem::StartListening(int32 Port)
+{
+	StopListening();
+
+	Ring = MakeShareable(new FPoseStreamFrameRing());
+	ReceiverStats = MakeShared<FPoseStreamReceiverStats>();
+	Receiver = MakeShared<FPoseStreamReceiver>(*Ring, *ReceiverStats);
+	if (!Receiver->Start(Port))
+	{
+		StopListening();
+		return false;
+	}
+
+	IModularFeatures& ModularFeatures = IModularFeatures::Get();
+	if (ModularFeatures.IsModularFeatureAvailable(ILiveLinkClient::ModularFeatureName))
+	{
+		ILiveLinkClient& Client = ModularFeatures.GetModularFeature<ILiveLinkClient>(ILiveLinkClient::ModularFeatureName);
+		LiveLinkSource = MakeShared<FPoseStreamLiveLinkSource>(Port);
+		Client.AddSource(LiveLinkSource);
+	}
+
+	UE_LOG(LogPoseStream, Log, TEXT("Listening for pose bundles on UDP port %d"), Port);
+	return true;
+}
+
+void UPoseStreamSubsystem::StopListening()
+{
+	// the receiver joins its thread before the ring and stats it writes to go away
+	Receiver.Reset();
+	ReceiverStats.Reset();
+	Ring.Reset();
+
+	if (LiveLinkSource.IsValid() && LiveLinkSource->IsSourceStillValid())
+	{
+		IModularFeatures& ModularFeatures = IModularFeatures::Get();
+		if (ModularFeatures.IsModularFeatureAvailable(ILiveLinkClient::ModularFeatureName))
+		{
+			ModularFeatures.GetModularFeature<ILiveLinkClient>(ILiveLinkClient::ModularFeatureName).RemoveSource(LiveLinkSource);
+		}
+	}
+	LiveLinkSource.Reset();
+	LatestFrame.NumPeople = 0;
+	JitterBuffers.Reset();
+	Tracker.Reset();
+	Filter.Reset();
+}
+
+static void ConvertFrame(const FPoseStreamFrame& Source, FPoseStreamFrame& OutFrame, float Scale)
+{
+	// pose estimators are right handed, Y up, Z towards the camera
+	OutFrame.Sequence = Source.Sequence;
+	OutFrame.SourceTime = Source.SourceTime;
+	OutFrame.ReceiveTime = Source.ReceiveTime;
+	OutFrame.NumPeople = Source.NumPeople;
+	for (int32 PersonIndex = 0; PersonIndex < Source.NumPeople; ++PersonIndex)
+	{
+		const FPoseStreamPerson& SourcePerson = Source.People[PersonIndex];
+		FPoseStreamPerson& Person = OutFrame.People[PersonIndex];
+		Person.PersonId = SourcePerson.PersonId;
+		Person.NumKeypoints = SourcePerson.NumKeypoints;
+		for (int32 Keypoint = 0; Keypoint < SourcePerson.NumKeypoints; ++Keypoint)
+		{
+			const FVector& Position = SourcePerson.Positions[Keypoint];
+			Person.Positions[Keypoint] = FVector(-Position.Z, Position.X, Position.Y) * Scale;
+			Person.Confidences[Keypoint] = SourcePerson.Confidences[Keypoint];
+		}
+	}
+}
+
+void UPoseStreamSubsystem::Tick(float DeltaTime)
+{
+	if (!Ring.IsValid()) return;
+	SCOPE_CYCLE_COUNTER(STAT_PoseStreamDrain);
+
+	const float Scale = CVarPoseStreamScale.GetValueOnGameThread();
+	const double JitterDelay = CVarPoseStreamJitterDelay.GetValueOnGameThread() / 1000.0;
+	const bool bJitterBuffer = JitterDelay > 0.0;
+	const bool bTracking = CVarPoseStreamTracking.GetValueOnGameThread() != 0;
+	const double Now = FPlatformTime::Seconds();
+
+	int32 NumFrames = 0;
+	// OnFrame handlers may stop listening, which frees the ring, so a frame is popped before it is delivered
+	while (Ring.IsValid())
+	{
+		const FPoseStreamFrame* Frame = Ring->Peek();
+		if (Frame == nullptr) break;
+		const double ReceiveTime = Frame->ReceiveTime;
+		if (bJitterBuffer)
+		{
+			ConvertFrame(*Frame, ReceivedFrame, Scale);
+			if (bTracking) TrackFrame(ReceivedFrame);
+			// senders without time tags still get reordering by arrival and an even playout
+			const double SourceTime = Frame->SourceTime != 0.0 ? Frame->SourceTime : Frame->ReceiveTime;
+			for (int32 PersonIndex = 0; PersonIndex < ReceivedFrame.NumPeople; ++PersonIndex)
+			{
+				const FPoseStreamPerson& Person = ReceivedFrame.People[PersonIndex];
+				TUniquePtr<FPoseStreamJitterBuffer>& Buffer = JitterBuffers.FindOrAdd(Person.PersonId);
+				if (!Buffer.IsValid()) Buffer = MakeUnique<FPoseStreamJitterBuffer>();
+				Buffer->SetPlayoutDelay(JitterDelay);
+				Buffer->Push(SourceTime, ReceiveTime, Person);
+			}
+			Ring->Pop();
+		}
+		else
+		{
+			ConvertFrame(*Frame, LatestFrame, Scale);
+			if (bTracking) TrackFrame(LatestFrame);
+			Ring->Pop();
+			DeliverFrame(ReceiveTime);
+		}
+		++NumFrames;
+	}
+	SET_DWORD_STAT(STAT_PoseStreamFramesPerTick, NumFrames);
+
+	if (bJitterBuffer)
+	{
+		NumFrames = PlayJitterBuffers(Now) ? 1 : 0;
+	}
+	else if (JitterBuffers.Num() > 0)
+	{
+		JitterBuffers.Reset();
+	}
+
+	// LiveLink interpolates on its own, so only the newest frame of the tick is worth pushing
+	if (LiveLinkSource.IsValid() && CVarPoseStreamLiveLink.GetValueOnGameThread() != 0)
+	{
+		if (NumFrames > 0) LiveLinkSource->Publish(LatestFrame, Now);
+		LiveLinkSource->RemoveStaleSubjects(Now);
+	}
+}
+
+bool UPoseStreamSubsystem::PlayJitterBuffers(double Now)
+{
+	if (JitterBuffers.Num() == 0) return false;
+
+	LatestFrame.Sequence = ++PlayedSequence;
+	LatestFrame.SourceTime = 0.0;
+	LatestFrame.ReceiveTime = Now;
+	LatestFrame.NumPeople = 0;
+
+	int32 MaxDepth = 0;
+	uint64 Underruns = 0;
+	double MaxAddedLatency = 0.0;
+	for (auto It = JitterBuffers.CreateIterator(); It; ++It)
+	{
+		FPoseStreamJitterBuffer& Buffer = *It.Value();
+		if (Now - Buffer.GetLastArrival() > JitterBufferTimeout)
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+		if (LatestFrame.NumPeople < PoseStream::MaxPeople && Buffer.Evaluate(Now, LatestFrame.People[LatestFrame.NumPeople]))
+		{
+			LatestFrame.SourceTime = FMath::Max(LatestFrame.SourceTime, Buffer.GetPlayTime());
+			LatestFrame.NumPeople++;
+		}
+		const FPoseStreamJitterStats& Stats = Buffer.GetStats();
+		MaxDepth = FMath::Max(MaxDepth, Stats.Depth);
+		MaxAddedLatency = FMath::Max(MaxAddedLatency, Stats.AddedLatency);
+		Underruns += Stats.Underruns;
+	}
+	SET_DWORD_STAT(STAT_PoseStreamJitterDepth, MaxDepth);
+	SET_DWORD_STAT(STAT_PoseStreamJitterUnderruns, Underruns);
+	SET_FLOAT_STAT(STAT_PoseStreamJitterLatency, MaxAddedLatency * 1000.0);
+
+	DeliverFrame(Now);
+	return true;
+}
+
+void UPoseStreamSubsystem::TrackFrame(FPoseStreamFrame& Frame)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PoseStreamTrack);
+	Tracker.Update(Frame);
+	SET_DWORD_STAT(STAT_PoseStreamTracks, Tracker.GetStats().NumTracks);
+}
+
+void UPoseStreamSubsystem::DeliverFrame(double Time)
+{
+	if (Recorder.IsValid())
+	{
+		SCOPE_CYCLE_COUNTER(STAT_PoseStreamRecord);
+		Recorder->Write(Time, LatestFrame);
+	}
+	{
+		SCOPE_CYCLE_COUNTER(STAT_PoseStreamFilter);
+		Filter.Apply(LatestFrame);
+	}
+	OnFrame.Broadcast(LatestFrame);
+}
+
+bool UPoseStreamSubsystem::StartRecording(const FString& Filename)
+{
+	StopRecording();
+
+	FString Path = FPaths::IsRelative(Filename) ? FPaths::ProjectSavedDir() / TEXT("PoseStream") / Filename : Filename;
+	if (FPaths::GetExtension(Path) != TEXT("posestream")) Path += TEXT(".posestream");
+	TUniquePtr<FPoseStreamRecordWriter> Writer = MakeUnique<FPoseStreamRecordWriter>();
+	if (!Writer->Open(Path)) return false;
+
+	Recorder = MoveTemp(Writer);
+	UE_LOG(LogPoseStream, Log, TEXT("Recording pose stream to %s"), *Recorder->GetFilename());
+	return true;
+}
+
+void UPoseStreamSubsystem::StopRecording()
+{
+	if (Recorder.IsValid())
+	{
+		Recorder->Close();
+		Recorder.Reset();
+	}
+}
+
+const FPoseStreamJitterStats* UPoseStreamSubsystem::GetJitterStats(int32 PersonId) const
+{
+	const TUniquePtr<FPoseStreamJitterBuffer>* Buffer = JitterBuffers.Find(PersonId);
+	return Buffer != nullptr ? &(*Buffer)->GetStats() : nullptr;
+}
+
+TStatId UPoseStreamSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPoseStreamSubsystem, STATGROUP_Tickables);
+}
+
+static UPoseStreamSubsystem* GetPoseStreamSubsystem()
+{
+	return GEngine != nullptr ? GEngine->GetEngineSubsystem<UPoseStreamSubsystem>() : nullptr;
+}
+
+static FAutoConsoleCommand PoseStreamStartCommand(
+	TEXT("PoseStream.Start"),
+	TEXT("Starts receiving pose bundles. Arguments: [Port=7000]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		if (UPoseStreamSubsystem* Subsystem = GetPoseStreamSubsystem())
+		{
+			Subsystem->StartListening(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 7000);
+		}
+	}));
+
+static FAutoConsoleCommand PoseStreamStopCommand(
+	TEXT("PoseStream.Stop"),
+	TEXT("Stops receiving pose bundles."),
+	FConsoleCommandDelegate::CreateStatic([]()
+	{
+		if (UPoseStreamSubsystem* Subsystem = GetPoseStreamSubsystem())
+		{
+			Subsystem->StopListening();
+		}
+	}));
+
+static FAutoConsoleCommand PoseStreamRecordCommand(
+	TEXT("PoseStream.Record"),
+	TEXT("Records the pose stream to Saved/PoseStream. Arguments: [Filename=<date and time>]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		if (UPoseStreamSubsystem* Subsystem = GetPoseStreamSubsystem())
+		{
+			Subsystem->StartRecording(Args.Num() > 0 ? Args[0] : FDateTime::Now().ToString(TEXT("%Y%m%d-%H%M%S")));
+		}
+	}));
+
+static FAutoConsoleCommand PoseStreamStopRecordingCommand(
+	TEXT("PoseStream.StopRecording"),
+	TEXT("Finishes the pose stream recording."),
+	FConsoleCommandDelegate::CreateStatic([]()
+	{
+		if (UPoseStreamSubsystem* Subsystem = GetPoseStreamSubsystem())
+		{
+			Subsystem->StopRecording();
+		}
+	}));
+
+static FAutoConsoleCommand PoseStreamStatsCommand(
+	TEXT("PoseStream.Stats"),
+	TEXT("Logs the receive thread counters."),
+	FConsoleCommandDelegate::CreateStatic([]()
+	{
+		UPoseStreamSubsystem* Subsystem = GetPoseStreamSubsystem();
+		const FPoseStreamReceiverStats* Stats = Subsystem != nullptr ? Subsystem->GetReceiverStats() : nullptr;
+		if (Stats == nullptr)
+		{
+			UE_LOG(LogPoseStream, Display, TEXT("Pose stream isn't listening"));
+			return;
+		}
+
+		const uint64 Frames = Stats->Frames;
+		const double ParseSeconds = Stats->ParseCycles * FPlatformTime::GetSecondsPerCycle64();
+		UE_LOG(LogPoseStream, Display, TEXT("Packets %llu, frames %llu, parse errors %llu, dropped %llu, %.2f MB, %.2f us parse per frame"),
+			(uint64)Stats->Packets, Frames, (uint64)Stats->ParseErrors, (uint64)Stats->Dropped,
+			Stats->Bytes / (1024.0 * 1024.0), Frames > 0 ? ParseSeconds * 1e6 / Frames : 0.0);
+
+		const FPoseStreamTrackerStats& Tracking = Subsystem->GetTracker().GetStats();
+		UE_LOG(LogPoseStream, Display, TEXT("Tracks %d, started %llu, ended %llu, tentative detections %llu"),
+			Tracking.NumTracks, Tracking.Births, Tracking.Deaths, Tracking.Tentative);
+
+		if (const FPoseStreamRecordWriter* Recorder = Subsystem->GetRecorder())
+		{
+			UE_LOG(LogPoseStream, Display, TEXT("Recording %d frames, %.2f MB to %s"),
+				Recorder->GetNumFrames(), Recorder->GetSize() / (1024.0 * 1024.0), *Recorder->GetFilename());
+		}
+
+		const FPoseStreamFrame& Frame = Subsystem->GetLatestFrame();
+		for (int32 PersonIndex = 0; PersonIndex < Frame.NumPeople; ++PersonIndex)
+		{
+			if (const FPoseStreamJitterStats* Jitter = Subsystem->GetJitterStats(Frame.People[PersonIndex].PersonId))
+			{
+				UE_LOG(LogPoseStream, Display, TEXT("Person %d jitter buffer: depth %d (%.1f ms), added latency %.1f ms, received %llu, late %llu, duplicates %llu, underruns %llu, extrapolated %llu"),
+					Frame.People[PersonIndex].PersonId, Jitter->Depth, Jitter->BufferedTime * 1000.0, Jitter->AddedLatency * 1000.0,
+					Jitter->Received, Jitter->Late, Jitter->Duplicates, Jitter->Underruns, Jitter->Extrapolated);
+			}
+		}
+	}));
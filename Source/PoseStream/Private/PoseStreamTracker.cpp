@@ -0,0 +1,297 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamTracker.h"
+
+// cost of pairs outside the gate, above any real cost so the assignment only uses them when it has to
+static constexpr float GatedCost = 1e5f;
+// share of a new velocity sample taken into the root velocity
+static constexpr float RootVelocitySmoothing = 0.3f;
+// bone lengths become a running average over this many samples
+static constexpr int32 MaxBoneSamples = 50;
+
+// keypoint pairs of the bone length signature, bones that don't bend with the pose
+static const uint8 SignatureBones[][2] =
+{
+	{ PoseStream::LeftShoulder, PoseStream::RightShoulder },
+	{ PoseStream::LeftHip, PoseStream::RightHip },
+	{ PoseStream::LeftShoulder, PoseStream::LeftElbow },
+	{ PoseStream::RightShoulder, PoseStream::RightElbow },
+	{ PoseStream::LeftElbow, PoseStream::LeftWrist },
+	{ PoseStream::RightElbow, PoseStream::RightWrist },
+	{ PoseStream::LeftHip, PoseStream::LeftKnee },
+	{ PoseStream::RightHip, PoseStream::RightKnee },
+	{ PoseStream::LeftKnee, PoseStream::LeftAnkle },
+	{ PoseStream::RightKnee, PoseStream::RightAnkle },
+	{ PoseStream::LeftShoulder, PoseStream::LeftHip },
+	{ PoseStream::RightShoulder, PoseStream::RightHip },
+};
+
+static FVector GetTrackingRoot(const FPoseStreamPerson& Person)
+{
+	if (Person.NumKeypoints > PoseStream::RightHip)
+	{
+		return (Person.Positions[PoseStream::LeftHip] + Person.Positions[PoseStream::RightHip]) * 0.5f;
+	}
+	return Person.NumKeypoints > 0 ? Person.Positions[0] : FVector::ZeroVector;
+}
+
+FPoseStreamTracker::FPoseStreamTracker()
+{
+	static_assert(UE_ARRAY_COUNT(SignatureBones) == NumSignatureBones, "Signature bones don't match NumSignatureBones");
+}
+
+void FPoseStreamTracker::Reset()
+{
+	NumTracks = 0;
+	Stats = FPoseStreamTrackerStats();
+}
+
+void FPoseStreamTracker::GetBoneLengths(const FPoseStreamPerson& Person, float* OutLengths) const
+{
+	for (int32 Bone = 0; Bone < NumSignatureBones; ++Bone)
+	{
+		const int32 A = SignatureBones[Bone][0];
+		const int32 B = SignatureBones[Bone][1];
+		const bool bValid = A < Person.NumKeypoints && B < Person.NumKeypoints
+			&& Person.Confidences[A] >= Settings.MinConfidence && Person.Confidences[B] >= Settings.MinConfidence;
+		// 0 marks a bone that wasn't seen
+		OutLengths[Bone] = bValid ? FVector::Dist(Person.Positions[A], Person.Positions[B]) : 0.0f;
+	}
+}
+
+float FPoseStreamTracker::GetCost(const FTrack& Track, const FPoseStreamPerson& Person, const float* PersonBoneLengths, double Time) const
+{
+	const float DeltaTime = (float)FMath::Max(Time - Track.LastTime, 0.0);
+	const FVector Offset = Track.RootVelocity * DeltaTime;
+
+	float Distance = 0.0f;
+	float Weight = 0.0f;
+	const int32 NumKeypoints = FMath::Min(Track.NumKeypoints, Person.NumKeypoints);
+	for (int32 Keypoint = 0; Keypoint < NumKeypoints; ++Keypoint)
+	{
+		const float KeypointWeight = FMath::Min(Track.Confidences[Keypoint], Person.Confidences[Keypoint]);
+		if (KeypointWeight < Settings.MinConfidence) continue;
+		Distance += KeypointWeight * FVector::Dist(Track.Positions[Keypoint] + Offset, Person.Positions[Keypoint]);
+		Weight += KeypointWeight;
+	}
+	Distance = Weight > 0.0f ? Distance / Weight : FVector::Dist(Track.Root + Offset, GetTrackingRoot(Person));
+	if (Distance > Settings.MaxDistance + Settings.MaxDistanceGrowth * DeltaTime) return GatedCost;
+
+	float BoneDifference = 0.0f;
+	int32 NumBones = 0;
+	for (int32 Bone = 0; Bone < NumSignatureBones; ++Bone)
+	{
+		if (Track.BoneSamples[Bone] == 0 || PersonBoneLengths[Bone] <= 0.0f) continue;
+		BoneDifference += FMath::Abs(Track.BoneLengths[Bone] - PersonBoneLengths[Bone]);
+		++NumBones;
+	}
+	return Distance + (NumBones > 0 ? Settings.BoneLengthWeight * BoneDifference / NumBones : 0.0f);
+}
+
+void FPoseStreamTracker::UpdateTrack(FTrack& Track, const FPoseStreamPerson& Person, const float* PersonBoneLengths, double Time) const
+{
+	const FVector Root = GetTrackingRoot(Person);
+	const double DeltaTime = Time - Track.LastTime;
+	// frames that arrive out of order update the pose but not the velocity
+	if (Track.Hits > 0 && DeltaTime > KINDA_SMALL_NUMBER)
+	{
+		Track.RootVelocity = FMath::Lerp(Track.RootVelocity, (Root - Track.Root) / (float)DeltaTime, RootVelocitySmoothing);
+	}
+	Track.Root = Root;
+	Track.LastTime = FMath::Max(Track.LastTime, Time);
+	Track.NumKeypoints = FMath::Clamp(Person.NumKeypoints, 0, (int32)PoseStream::MaxKeypoints);
+	FMemory::Memcpy(Track.Positions, Person.Positions, Track.NumKeypoints * sizeof(FVector));
+	FMemory::Memcpy(Track.Confidences, Person.Confidences, Track.NumKeypoints * sizeof(float));
+
+	for (int32 Bone = 0; Bone < NumSignatureBones; ++Bone)
+	{
+		if (PersonBoneLengths[Bone] <= 0.0f) continue;
+		Track.BoneSamples[Bone] = FMath::Min(Track.BoneSamples[Bone] + 1, MaxBoneSamples);
+		Track.BoneLengths[Bone] += (PersonBoneLengths[Bone] - Track.BoneLengths[Bone]) / Track.BoneSamples[Bone];
+	}
+	Track.Hits++;
+}
+
+int32 FPoseStreamTracker::AllocateId() const
+{
+	for (int32 Id = 0; ; ++Id)
+	{
+		bool bUsed = false;
+		for (int32 TrackIndex = 0; TrackIndex < NumTracks && !bUsed; ++TrackIndex)
+		{
+			bUsed = Tracks[TrackIndex].Id == Id;
+		}
+		if (!bUsed) return Id;
+	}
+}
+
+void FPoseStreamTracker::Solve(int32 Size)
+{
+	// Hungarian method with row and column potentials, O(Size^3), rows and columns counted from 1 with 0 as the
+	// virtual start column
+	for (int32 Index = 0; Index <= Size; ++Index)
+	{
+		RowPotentials[Index] = 0.0;
+		ColumnPotentials[Index] = 0.0;
+		ColumnRow[Index] = 0;
+		Way[Index] = 0;
+	}
+
+	for (int32 Row = 1; Row <= Size; ++Row)
+	{
+		ColumnRow[0] = Row;
+		int32 Column0 = 0;
+		for (int32 Column = 0; Column <= Size; ++Column)
+		{
+			MinSlack[Column] = DBL_MAX;
+			Used[Column] = false;
+		}
+
+		// grow an alternating tree from Row until it reaches a free column
+		do
+		{
+			Used[Column0] = true;
+			const int32 Row0 = ColumnRow[Column0];
+			double Delta = DBL_MAX;
+			int32 Column1 = 0;
+			for (int32 Column = 1; Column <= Size; ++Column)
+			{
+				if (Used[Column]) continue;
+				const double Slack = Costs[Row0 - 1][Column - 1] - RowPotentials[Row0] - ColumnPotentials[Column];
+				if (Slack < MinSlack[Column])
+				{
+					MinSlack[Column] = Slack;
+					Way[Column] = Column0;
+				}
+				if (MinSlack[Column] < Delta)
+				{
+					Delta = MinSlack[Column];
+					Column1 = Column;
+				}
+			}
+			for (int32 Column = 0; Column <= Size; ++Column)
+			{
+				if (Used[Column])
+				{
+					RowPotentials[ColumnRow[Column]] += Delta;
+					ColumnPotentials[Column] -= Delta;
+				}
+				else
+				{
+					MinSlack[Column] -= Delta;
+				}
+			}
+			Column0 = Column1;
+		}
+		while (ColumnRow[Column0] != 0);
+
+		// flip the augmenting path
+		do
+		{
+			const int32 Column1 = Way[Column0];
+			ColumnRow[Column0] = ColumnRow[Column1];
+			Column0 = Column1;
+		}
+		while (Column0 != 0);
+	}
+
+	for (int32 Column = 1; Column <= Size; ++Column)
+	{
+		RowAssignment[ColumnRow[Column] - 1] = Column - 1;
+	}
+}
+
+void FPoseStreamTracker::Update(FPoseStreamFrame& Frame)
+{
+	const double Time = Frame.SourceTime != 0.0 ? Frame.SourceTime : Frame.ReceiveTime;
+	const int32 NumDetections = FMath::Clamp(Frame.NumPeople, 0, (int32)PoseStream::MaxPeople);
+
+	float BoneLengths[PoseStream::MaxPeople][NumSignatureBones];
+	for (int32 Detection = 0; Detection < NumDetections; ++Detection)
+	{
+		GetBoneLengths(Frame.People[Detection], BoneLengths[Detection]);
+	}
+
+	// square cost matrix, the padding rows and columns are free so either side can stay unmatched
+	const int32 Size = FMath::Max(NumTracks, NumDetections);
+	for (int32 Row = 0; Row < Size; ++Row)
+	{
+		for (int32 Column = 0; Column < Size; ++Column)
+		{
+			Costs[Row][Column] = Row < NumTracks && Column < NumDetections
+				? GetCost(Tracks[Row], Frame.People[Column], BoneLengths[Column], Time)
+				: 0.0f;
+		}
+	}
+	if (Size > 0) Solve(Size);
+
+	int32 DetectionIds[PoseStream::MaxPeople];
+	bool bDetectionMatched[PoseStream::MaxPeople] = {};
+	bool bTrackMatched[MaxTracks] = {};
+	for (int32 TrackIndex = 0; TrackIndex < NumTracks; ++TrackIndex)
+	{
+		const int32 Detection = RowAssignment[TrackIndex];
+		if (Detection >= NumDetections || Costs[TrackIndex][Detection] >= GatedCost) continue;
+
+		FTrack& Track = Tracks[TrackIndex];
+		UpdateTrack(Track, Frame.People[Detection], BoneLengths[Detection], Time);
+		if (!Track.bConfirmed && Track.Hits >= Settings.MinHits)
+		{
+			Track.bConfirmed = true;
+			Track.Id = AllocateId();
+			Stats.Births++;
+		}
+		bTrackMatched[TrackIndex] = true;
+		bDetectionMatched[Detection] = true;
+		DetectionIds[Detection] = Track.bConfirmed ? Track.Id : INDEX_NONE;
+	}
+
+	// tentative tracks end at their first miss, confirmed ones once they've been gone too long. From the back, so
+	// the track swapped into a removed slot has already been looked at.
+	for (int32 TrackIndex = NumTracks - 1; TrackIndex >= 0; --TrackIndex)
+	{
+		const FTrack& Track = Tracks[TrackIndex];
+		if (bTrackMatched[TrackIndex] || (Track.bConfirmed && Time - Track.LastTime <= Settings.MaxMissedTime)) continue;
+		if (Track.bConfirmed) Stats.Deaths++;
+		Tracks[TrackIndex] = Tracks[--NumTracks];
+	}
+
+	for (int32 Detection = 0; Detection < NumDetections; ++Detection)
+	{
+		if (bDetectionMatched[Detection]) continue;
+		DetectionIds[Detection] = INDEX_NONE;
+		if (NumTracks == MaxTracks) continue;
+
+		FTrack& Track = Tracks[NumTracks++];
+		Track.Id = INDEX_NONE;
+		Track.Hits = 0;
+		Track.bConfirmed = false;
+		Track.LastTime = Time;
+		Track.RootVelocity = FVector::ZeroVector;
+		FMemory::Memzero(Track.BoneLengths);
+		FMemory::Memzero(Track.BoneSamples);
+		UpdateTrack(Track, Frame.People[Detection], BoneLengths[Detection], Time);
+		if (Track.Hits >= Settings.MinHits)
+		{
+			Track.bConfirmed = true;
+			Track.Id = AllocateId();
+			Stats.Births++;
+			DetectionIds[Detection] = Track.Id;
+		}
+	}
+
+	// people of confirmed tracks keep their order
+	int32 NumPeople = 0;
+	for (int32 Detection = 0; Detection < NumDetections; ++Detection)
+	{
+		if (DetectionIds[Detection] == INDEX_NONE)
+		{
+			Stats.Tentative++;
+			continue;
+		}
+		if (NumPeople != Detection) Frame.People[NumPeople] = Frame.People[Detection];
+		Frame.People[NumPeople++].PersonId = DetectionIds[Detection];
+	}
+	Frame.NumPeople = NumPeople;
+	Stats.NumTracks = NumTracks;
+}
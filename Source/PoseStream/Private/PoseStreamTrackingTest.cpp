@@ -0,0 +1,338 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamModule.h"
+#include "PoseStreamTracker.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+namespace
+{
+	/** Standing pose relative to the hip midpoint, X forward, Y left, in centimetres for an adult */
+	const FVector TrackingTestBody[PoseStream::MaxKeypoints] =
+	{
+		{ 10, 0, 72 },
+		{ 8, 2, 76 }, { 8, 3.5f, 76 }, { 7, 5, 76 },
+		{ 8, -2, 76 }, { 8, -3.5f, 76 }, { 7, -5, 76 },
+		{ 0, 7, 74 }, { 0, -7, 74 },
+		{ 9, 2.5f, 67 }, { 9, -2.5f, 67 },
+		{ 0, 18, 55 }, { 0, -18, 55 },
+		{ 0, 22, 27 }, { 0, -22, 27 },
+		{ 5, 23, 2 }, { 5, -23, 2 },
+		{ 7, 24, -6 }, { 7, -24, -6 },
+		{ 8, 23, -7 }, { 8, -23, -7 },
+		{ 8, 21, -4 }, { 8, -21, -4 },
+		{ 0, 10, 0 }, { 0, -10, 0 },
+		{ 2, 10, -45 }, { 2, -10, -45 },
+		{ 0, 10, -88 }, { 0, -10, -88 },
+		{ -5, 10, -92 }, { -5, -10, -92 },
+		{ 15, 10, -95 }, { 15, -10, -95 },
+	};
+
+	/** Where a performer of a scenario is at a time, false while the estimator doesn't see them */
+	using FTrackingTestPath = TFunction<bool(int32 Performer, double Time, FVector& OutRoot)>;
+
+	struct FTrackingTestScenario
+	{
+		const TCHAR* Name;
+		int32 NumPerformers;
+		/** Performers are this much smaller or larger than average at most */
+		float SizeSpread;
+		double Seconds;
+		FTrackingTestPath Path;
+		/** Tracks a perfect tracker starts */
+		int32 ExpectedBirths;
+	};
+
+	/** A walking performer at Root facing along Velocity, with estimator noise */
+	void MakeTrackingTestPerson(const FVector& Root, const FVector& Velocity, float Size, double Time, FRandomStream& Random, FPoseStreamPerson& OutPerson)
+	{
+		const FQuat Facing(FVector::UpVector, FMath::Atan2(Velocity.Y, Velocity.X));
+		const float Stride = FMath::Sin(float(Time) * 6.0f) * FMath::Min(Velocity.Size() / 150.0f, 1.0f);
+		OutPerson.NumKeypoints = PoseStream::MaxKeypoints;
+		for (int32 Keypoint = 0; Keypoint < PoseStream::MaxKeypoints; ++Keypoint)
+		{
+			FVector Local = TrackingTestBody[Keypoint];
+			const float Side = Local.Y > 0.0f ? 1.0f : -1.0f;
+			if (Keypoint >= PoseStream::LeftElbow && Keypoint <= PoseStream::RightThumb)
+			{
+				Local.X += Stride * Side * (55.0f - Local.Z) * 0.4f;
+			}
+			else if (Keypoint >= PoseStream::LeftKnee)
+			{
+				Local.X -= Stride * Side * -Local.Z * 0.3f;
+			}
+			OutPerson.Positions[Keypoint] = Root + Facing.RotateVector(Local * Size) + Random.GetUnitVector() * Random.FRandRange(0.0f, 0.5f);
+			OutPerson.Confidences[Keypoint] = Random.FRand() < 0.03f ? 0.1f : Random.FRandRange(0.6f, 1.0f);
+		}
+	}
+
+	/** Straight line through Center at Speed along Direction, passing Center at CrossTime */
+	FVector CrossingRoot(const FVector& Center, float DirectionDegrees, float Speed, double Time, double CrossTime)
+	{
+		const float Radians = FMath::DegreesToRadians(DirectionDegrees);
+		return Center + FVector(FMath::Cos(Radians), FMath::Sin(Radians), 0.0f) * Speed * float(Time - CrossTime);
+	}
+
+	TArray<FTrackingTestScenario> MakeTrackingTestScenarios()
+	{
+		TArray<FTrackingTestScenario> Scenarios;
+
+		// same build walking through each other, only the prediction tells them apart
+		Scenarios.Add({ TEXT("Head-on crossing"), 2, 0.0f, 4.0, [](int32 Performer, double Time, FVector& OutRoot)
+		{
+			OutRoot = CrossingRoot(FVector(0.0f, Performer == 0 ? 10.0f : -10.0f, 95.0f), Performer == 0 ? 0.0f : 180.0f, 150.0f, Time, 2.0);
+			return true;
+		}, 2 });
+
+		// three paths meeting at one spot from different directions
+		Scenarios.Add({ TEXT("Three way crossing"), 3, 0.15f, 4.0, [](int32 Performer, double Time, FVector& OutRoot)
+		{
+			const float Direction = Performer * 120.0f;
+			const FVector Offset = FRotator(0.0f, Direction + 90.0f, 0.0f).Vector() * 15.0f;
+			OutRoot = CrossingRoot(FVector(0.0f, 0.0f, 95.0f) + Offset, Direction, 140.0f, Time, 2.0);
+			return true;
+		}, 3 });
+
+		// the middle one of three is hidden for a quarter second and has to come back with its id
+		Scenarios.Add({ TEXT("Occlusion"), 3, 0.15f, 4.0, [](int32 Performer, double Time, FVector& OutRoot)
+		{
+			OutRoot = FVector(-300.0f + float(Time) * 150.0f, (Performer - 1) * 80.0f, 95.0f);
+			return Performer != 1 || Time < 1.8 || Time > 2.05;
+		}, 3 });
+
+		// someone walks on, passes the other and leaves, a second visit is a new track
+		Scenarios.Add({ TEXT("Enter and leave"), 2, 0.15f, 6.0, [](int32 Performer, double Time, FVector& OutRoot)
+		{
+			if (Performer == 0)
+			{
+				OutRoot = FVector(0.0f, 0.0f, 95.0f);
+				return true;
+			}
+			OutRoot = FVector(-200.0f + float(FMath::Fmod(Time, 3.0)) * 200.0f, 40.0f, 95.0f);
+			return FMath::Fmod(Time, 3.0) > 0.5 && FMath::Fmod(Time, 3.0) < 2.0;
+		}, 3 });
+
+		// 20 performers on four rings walking in alternating directions, passing each other 60 cm apart
+		Scenarios.Add({ TEXT("Crowd of 20"), 20, 0.15f, 10.0, [](int32 Performer, double Time, FVector& OutRoot)
+		{
+			const int32 Ring = Performer / 5;
+			const float Radius = 150.0f + Ring * 60.0f;
+			const float Direction = Ring % 2 == 0 ? 1.0f : -1.0f;
+			const float Angle = Performer % 5 * (2.0f * PI / 5.0f) + Direction * float(Time) * 120.0f / Radius;
+			OutRoot = FVector(FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, 95.0f);
+			return true;
+		}, 20 });
+
+		return Scenarios;
+	}
+
+	struct FTrackingTestResult
+	{
+		int32 IdSwitches = 0;
+		/** Frames in which two performers had the same id */
+		int32 Collisions = 0;
+		uint64 Births = 0;
+		double AverageMicroseconds = 0.0;
+		double MaxMicroseconds = 0.0;
+	};
+
+	FTrackingTestResult RunTrackingTestScenario(const FTrackingTestScenario& Scenario, float DropRate, int32 Seed)
+	{
+		FPoseStreamTracker Tracker;
+		FRandomStream Random(Seed);
+		const double FrameTime = 1.0 / 120.0;
+
+		TArray<float> Sizes;
+		TArray<int32> LastIds;
+		/** Root of every performer this frame, seen or not */
+		TArray<FVector> LastRoots;
+		for (int32 Performer = 0; Performer < Scenario.NumPerformers; ++Performer)
+		{
+			Sizes.Add(1.0f + Random.FRandRange(-Scenario.SizeSpread, Scenario.SizeSpread));
+			LastIds.Add(INDEX_NONE);
+			LastRoots.Add(FVector::ZeroVector);
+		}
+
+		FTrackingTestResult Result;
+		FPoseStreamFrame Frame;
+		TArray<int32> Performers;
+		TArray<FVector> Firsts;
+		double TotalSeconds = 0.0;
+		int32 NumFrames = 0;
+		for (double Time = 0.0; Time < Scenario.Seconds; Time += FrameTime, ++NumFrames)
+		{
+			// the estimator lists people in any order and now and then misses someone
+			Performers.Reset();
+			for (int32 Performer = 0; Performer < Scenario.NumPerformers; ++Performer)
+			{
+				FVector Root;
+				const bool bVisible = Scenario.Path(Performer, Time, Root);
+				LastRoots[Performer] = Root;
+				if (bVisible && Random.FRand() >= DropRate) Performers.Add(Performer);
+			}
+			for (int32 Index = Performers.Num() - 1; Index > 0; --Index)
+			{
+				Performers.Swap(Index, Random.RandRange(0, Index));
+			}
+
+			Frame.SourceTime = Time + 1.0;
+			Frame.NumPeople = FMath::Min(Performers.Num(), (int32)PoseStream::MaxPeople);
+			Firsts.Reset();
+			for (int32 PersonIndex = 0; PersonIndex < Frame.NumPeople; ++PersonIndex)
+			{
+				const int32 Performer = Performers[PersonIndex];
+				FVector Previous;
+				Scenario.Path(Performer, Time - FrameTime, Previous);
+				FPoseStreamPerson& Person = Frame.People[PersonIndex];
+				Person.PersonId = PersonIndex;
+				MakeTrackingTestPerson(LastRoots[Performer], (LastRoots[Performer] - Previous) / FrameTime, Sizes[Performer], Time, Random, Person);
+				Firsts.Add(Person.Positions[0]);
+			}
+
+			const double StartTime = FPlatformTime::Seconds();
+			Tracker.Update(Frame);
+			const double Seconds = FPlatformTime::Seconds() - StartTime;
+			TotalSeconds += Seconds;
+			Result.MaxMicroseconds = FMath::Max(Result.MaxMicroseconds, Seconds * 1e6);
+
+			// the tracker copies people untouched, so the first keypoint tells which performer each one is
+			for (int32 PersonIndex = 0; PersonIndex < Frame.NumPeople; ++PersonIndex)
+			{
+				const int32 Detection = Firsts.IndexOfByKey(Frame.People[PersonIndex].Positions[0]);
+				check(Detection != INDEX_NONE);
+				const int32 Performer = Performers[Detection];
+				const int32 Id = Frame.People[PersonIndex].PersonId;
+				if (LastIds[Performer] != INDEX_NONE && LastIds[Performer] != Id) Result.IdSwitches++;
+				LastIds[Performer] = Id;
+				for (int32 Other = 0; Other < PersonIndex; ++Other)
+				{
+					if (Frame.People[Other].PersonId == Id) Result.Collisions++;
+				}
+			}
+		}
+
+		Result.Births = Tracker.GetStats().Births;
+		Result.AverageMicroseconds = TotalSeconds * 1e6 / FMath::Max(NumFrames, 1);
+		return Result;
+	}
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPoseStreamTrackerTest, "PoseStream.Tracker.IdStability", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPoseStreamTrackerTest::RunTest(const FString& Parameters)
+{
+	// two people standing apart, listed by the estimator in the opposite order every frame
+	FPoseStreamTracker Tracker;
+	FRandomStream Random(39);
+	FPoseStreamFrame Frame;
+	double Time = 1.0;
+	auto Detect = [&](std::initializer_list<FVector> Roots)
+	{
+		Frame.SourceTime = Time;
+		Frame.NumPeople = 0;
+		for (const FVector& Root : Roots)
+		{
+			FPoseStreamPerson& Person = Frame.People[Frame.NumPeople];
+			Person.PersonId = Frame.NumPeople++;
+			MakeTrackingTestPerson(Root, FVector::ZeroVector, 1.0f, Time, Random, Person);
+		}
+		Tracker.Update(Frame);
+		Time += 1.0 / 120.0;
+	};
+	// the person a track id was given to, told apart by which side of the stage they stand on
+	auto FindId = [&Frame](TFunctionRef<bool(const FVector&)> Where)
+	{
+		for (int32 PersonIndex = 0; PersonIndex < Frame.NumPeople; ++PersonIndex)
+		{
+			if (Where(Frame.People[PersonIndex].Positions[PoseStream::LeftHip])) return Frame.People[PersonIndex].PersonId;
+		}
+		return (int32)INDEX_NONE;
+	};
+	const FVector Left(-100.0f, 0.0f, 95.0f);
+	const FVector Right(100.0f, 0.0f, 95.0f);
+	auto IsLeft = [](const FVector& Position) { return Position.X < -50.0f; };
+	auto IsRight = [](const FVector& Position) { return Position.X > 50.0f; };
+
+	const int32 MinHits = Tracker.GetSettings().MinHits;
+	for (int32 Hit = 1; Hit < MinHits; ++Hit)
+	{
+		Detect({ Left, Right });
+		TestEqual(TEXT("Tentative people are held back"), Frame.NumPeople, 0);
+	}
+	Detect({ Left, Right });
+	TestEqual(TEXT("People reported once confirmed"), Frame.NumPeople, 2);
+	const int32 LeftId = FindId(IsLeft);
+	const int32 RightId = FindId(IsRight);
+	TestTrue(TEXT("First tracks take the smallest ids"), (LeftId == 0 && RightId == 1) || (LeftId == 1 && RightId == 0));
+
+	int32 Swaps = 0;
+	for (int32 FrameIndex = 0; FrameIndex < 120; ++FrameIndex)
+	{
+		if (FrameIndex % 2 == 0) Detect({ Right, Left });
+		else Detect({ Left, Right });
+		Swaps += FindId(IsLeft) != LeftId;
+		Swaps += FindId(IsRight) != RightId;
+	}
+	TestEqual(TEXT("Ids that followed the estimator's index instead of the person"), Swaps, 0);
+	TestEqual(TEXT("Tracks started"), (int32)Tracker.GetStats().Births, 2);
+
+	// the left person is gone for longer than MaxMissedTime, the other one keeps its id throughout
+	const int32 MissedFrames = FMath::CeilToInt((Tracker.GetSettings().MaxMissedTime + 0.25f) * 120.0f);
+	for (int32 FrameIndex = 0; FrameIndex < MissedFrames; ++FrameIndex)
+	{
+		Detect({ Right });
+		Swaps += FindId(IsRight) != RightId;
+	}
+	TestEqual(TEXT("Id changes of the remaining person"), Swaps, 0);
+	TestEqual(TEXT("Tracks ended"), (int32)Tracker.GetStats().Deaths, 1);
+
+	// someone new takes the freed id
+	const FVector Back(0.0f, 200.0f, 95.0f);
+	auto IsBack = [](const FVector& Position) { return Position.Y > 150.0f; };
+	for (int32 Hit = 0; Hit < MinHits; ++Hit)
+	{
+		Detect({ Back, Right });
+	}
+	TestEqual(TEXT("New person gets the smallest free id"), FindId(IsBack), LeftId);
+	TestEqual(TEXT("Remaining person keeps its id"), FindId(IsRight), RightId);
+	TestEqual(TEXT("Tracks started"), (int32)Tracker.GetStats().Births, 3);
+
+	// crossings, occlusion, entering and leaving and a crowd with shuffled estimator indices and dropped detections
+	for (const FTrackingTestScenario& Scenario : MakeTrackingTestScenarios())
+	{
+		const FTrackingTestResult Result = RunTrackingTestScenario(Scenario, 0.02f, 1);
+		TestEqual(FString::Printf(TEXT("%s: id switches"), Scenario.Name), Result.IdSwitches, 0);
+		TestEqual(FString::Printf(TEXT("%s: frames with two people on one id"), Scenario.Name), Result.Collisions, 0);
+		// a dropped frame may only delay a birth, never add one
+		TestEqual(FString::Printf(TEXT("%s: tracks started"), Scenario.Name), (int32)Result.Births, Scenario.ExpectedBirths);
+	}
+	return true;
+}
+
+#endif
+
+static FAutoConsoleCommand PoseStreamTrackingTestCommand(
+	TEXT("PoseStream.TrackingTest"),
+	TEXT("Runs synthetic crossing, occlusion, enter and leave and crowd scenarios through the person tracker with shuffled estimator indices, ")
+	TEXT("reports id switches and the time per frame. Arguments: [Drop rate=0.02] [Seed=1]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		const float DropRate = Args.Num() > 0 ? FMath::Clamp(FCString::Atof(*Args[0]), 0.0f, 0.5f) : 0.02f;
+		const int32 Seed = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 1;
+
+		int32 NumFailed = 0;
+		for (const FTrackingTestScenario& Scenario : MakeTrackingTestScenarios())
+		{
+			const FTrackingTestResult Result = RunTrackingTestScenario(Scenario, DropRate, Seed);
+			// a dropped frame may only delay a birth, never add one
+			const bool bPassed = Result.IdSwitches == 0 && Result.Collisions == 0 && Result.Births == Scenario.ExpectedBirths;
+			NumFailed += bPassed ? 0 : 1;
+			UE_LOG(LogPoseStream, Display, TEXT("%s: %d people, %d id switches, %d collisions, %llu tracks started (expected %d), %.2f us per frame, %.2f us at most, %s"),
+				Scenario.Name, Scenario.NumPerformers, Result.IdSwitches, Result.Collisions, Result.Births, Scenario.ExpectedBirths,
+				Result.AverageMicroseconds, Result.MaxMicroseconds, bPassed ? TEXT("passed") : TEXT("FAILED"));
+		}
+		UE_LOG(LogPoseStream, Display, TEXT("Tracking: %d scenarios failed"), NumFailed);
+	}));
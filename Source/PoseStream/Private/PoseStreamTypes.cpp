@@ -0,0 +1,30 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamTypes.h"
+
+namespace PoseStream
+{
+	FName GetKeypointName(int32 Index)
+	{
+		static const FName Names[MaxKeypoints] =
+		{
+			TEXT("nose"),
+			TEXT("left_eye_inner"), TEXT("left_eye"), TEXT("left_eye_outer"),
+			TEXT("right_eye_inner"), TEXT("right_eye"), TEXT("right_eye_outer"),
+			TEXT("left_ear"), TEXT("right_ear"),
+			TEXT("mouth_left"), TEXT("mouth_right"),
+			TEXT("left_shoulder"), TEXT("right_shoulder"),
+			TEXT("left_elbow"), TEXT("right_elbow"),
+			TEXT("left_wrist"), TEXT("right_wrist"),
+			TEXT("left_pinky"), TEXT("right_pinky"),
+			TEXT("left_index"), TEXT("right_index"),
+			TEXT("left_thumb"), TEXT("right_thumb"),
+			TEXT("left_hip"), TEXT("right_hip"),
+			TEXT("left_knee"), TEXT("right_knee"),
+			TEXT("left_ankle"), TEXT("right_ankle"),
+			TEXT("left_heel"), TEXT("right_heel"),
+			TEXT("left_foot_index"), TEXT("right_foot_index"),
+		};
+		return Index >= 0 && Index < MaxKeypoints ? Names[Index] : NAME_None;
+	}
+}
@@ -0,0 +1,114 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BoneContainer.h"
+#include "BoneControllers/AnimNode_SkeletalControlBase.h"
+#include "Engine/EngineTypes.h"
+#include "PoseStreamRetargetSolver.h"
+#include "AnimNode_PoseStreamRetarget.generated.h"
+
+struct FPoseStreamRetargetPlayback;
+
+/** Skeleton bones driven by the pose stream, defaults are the UE4 Mannequin's */
+USTRUCT(BlueprintType)
+struct POSESTREAM_API FPoseStreamRetargetBoneMap
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "Torso") FBoneReference Pelvis = FBoneReference(TEXT("pelvis"));
+	UPROPERTY(EditAnywhere, Category = "Torso") FBoneReference Spine1 = FBoneReference(TEXT("spine_01"));
+	UPROPERTY(EditAnywhere, Category = "Torso") FBoneReference Spine2 = FBoneReference(TEXT("spine_02"));
+	UPROPERTY(EditAnywhere, Category = "Torso") FBoneReference Spine3 = FBoneReference(TEXT("spine_03"));
+	UPROPERTY(EditAnywhere, Category = "Torso") FBoneReference Neck = FBoneReference(TEXT("neck_01"));
+	UPROPERTY(EditAnywhere, Category = "Torso") FBoneReference Head = FBoneReference(TEXT("head"));
+	UPROPERTY(EditAnywhere, Category = "Arms") FBoneReference ClavicleL = FBoneReference(TEXT("clavicle_l"));
+	UPROPERTY(EditAnywhere, Category = "Arms") FBoneReference UpperArmL = FBoneReference(TEXT("upperarm_l"));
+	UPROPERTY(EditAnywhere, Category = "Arms") FBoneReference LowerArmL = FBoneReference(TEXT("lowerarm_l"));
+	UPROPERTY(EditAnywhere, Category = "Arms") FBoneReference HandL = FBoneReference(TEXT("hand_l"));
+	UPROPERTY(EditAnywhere, Category = "Arms") FBoneReference ClavicleR = FBoneReference(TEXT("clavicle_r"));
+	UPROPERTY(EditAnywhere, Category = "Arms") FBoneReference UpperArmR = FBoneReference(TEXT("upperarm_r"));
+	UPROPERTY(EditAnywhere, Category = "Arms") FBoneReference LowerArmR = FBoneReference(TEXT("lowerarm_r"));
+	UPROPERTY(EditAnywhere, Category = "Arms") FBoneReference HandR = FBoneReference(TEXT("hand_r"));
+	UPROPERTY(EditAnywhere, Category = "Legs") FBoneReference ThighL = FBoneReference(TEXT("thigh_l"));
+	UPROPERTY(EditAnywhere, Category = "Legs") FBoneReference CalfL = FBoneReference(TEXT("calf_l"));
+	UPROPERTY(EditAnywhere, Category = "Legs") FBoneReference FootL = FBoneReference(TEXT("foot_l"));
+	UPROPERTY(EditAnywhere, Category = "Legs") FBoneReference ThighR = FBoneReference(TEXT("thigh_r"));
+	UPROPERTY(EditAnywhere, Category = "Legs") FBoneReference CalfR = FBoneReference(TEXT("calf_r"));
+	UPROPERTY(EditAnywhere, Category = "Legs") FBoneReference FootR = FBoneReference(TEXT("foot_r"));
+
+	/** Bone for a PoseStreamRetarget::EBone */
+	FBoneReference& Get(int32 Bone);
+};
+
+/**
+ * Poses a humanoid skeleton from one person of the pose stream.
+ * Keypoints are copied from UPoseStreamSubsystem in PreUpdate on the game thread, the solve runs wherever the
+ * graph is evaluated. Bone maps and reference pose data are rebuilt only when the required bones change, evaluation
+ * doesn't allocate. Hands, feet and bones below them keep the incoming animation's local transforms.
+ * With a Recording set the node plays it in a loop instead, decoding it on demand wherever the graph is updated.
+ */
+USTRUCT(BlueprintInternalUseOnly)
+struct POSESTREAM_API FAnimNode_PoseStreamRetarget : public FAnimNode_SkeletalControlBase
+{
+	GENERATED_BODY()
+
+	/** Person id of the pose stream to follow */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pose Stream", meta = (PinShownByDefault))
+	int32 PersonId = 0;
+
+	/** Rotation from the pose stream's Unreal space to component space, the default faces the Mannequin towards the camera */
+	UPROPERTY(EditAnywhere, Category = "Pose Stream")
+	FRotator KeypointRotation = FRotator(0.0f, -90.0f, 0.0f);
+
+	/** Limbs with a keypoint below this confidence follow their parent instead of being solved */
+	UPROPERTY(EditAnywhere, Category = "Pose Stream", meta = (ClampMin = "0", ClampMax = "1"))
+	float MinConfidence = 0.3f;
+
+	UPROPERTY(EditAnywhere, Category = "Pose Stream")
+	FPoseStreamRetargetBoneMap Bones;
+
+	/** Pose session to play instead of the live stream, see PoseStream.Record. Recordings aren't filtered. */
+	UPROPERTY(EditAnywhere, Category = "Pose Stream", meta = (FilePathFilter = "posestream", RelativeToGameDir))
+	FFilePath Recording;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pose Stream", meta = (PinHiddenByDefault))
+	float PlayRate = 1.0f;
+
+	// FAnimNode_Base interface
+	virtual bool HasPreUpdate() const override { return true; }
+	virtual void PreUpdate(const UAnimInstance* InAnimInstance) override;
+	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
+
+	// FAnimNode_SkeletalControlBase interface
+	virtual void EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms) override;
+	virtual bool IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones) override;
+
+	/** Solves the pose for InKeypoints, the path EvaluateSkeletalControl_AnyThread takes after PreUpdate */
+	bool Solve(const FVector* InKeypoints, const float* InConfidences, FTransform (&OutComponentSpace)[PoseStreamRetarget::NumBones]) const;
+
+private:
+	// FAnimNode_SkeletalControlBase interface
+	virtual void InitializeBoneReferences(const FBoneContainer& RequiredBones) override;
+	virtual void UpdateInternal(const FAnimationUpdateContext& Context) override;
+
+	/** Takes the keypoints of PersonId from Frame */
+	void CopyKeypoints(const FPoseStreamFrame& Frame);
+
+	FPoseStreamRetargetSolver Solver;
+	bool bBonesValid = false;
+
+	/** Compact pose index per solver bone, and the bones written to the pose in compact pose order */
+	int32 CompactIndices[PoseStreamRetarget::NumBones];
+	uint8 OutputBones[PoseStreamRetarget::NumBones];
+	int32 NumOutputBones = 0;
+
+	/** Opened on the game thread when Recording changes, per node instance */
+	TSharedPtr<FPoseStreamRetargetPlayback> Playback;
+
+	/** Copied from the subsystem on the game thread, or decoded from the recording */
+	FVector Keypoints[PoseStream::MaxKeypoints];
+	float Confidences[PoseStream::MaxKeypoints];
+	bool bHasKeypoints = false;
+};
@@ -0,0 +1,106 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PoseStreamTypes.h"
+#include "PoseStreamFilter.generated.h"
+
+UENUM(BlueprintType)
+enum class EPoseStreamFilterType : uint8
+{
+	None,
+	/** Adaptive low pass, smooth when still and responsive when moving */
+	OneEuro,
+	/** Constant velocity Kalman filter, weights keypoints by their confidence */
+	Kalman,
+};
+
+/** Smoothing of one keypoint. Distances are in Unreal units, times in seconds. */
+USTRUCT(BlueprintType)
+struct POSESTREAM_API FPoseStreamFilterParams
+{
+	GENERATED_BODY()
+
+	/** One Euro cutoff frequency in Hz while the keypoint is still, lower is smoother */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "One Euro", meta = (ClampMin = "0.01"))
+	float MinCutoff = 1.5f;
+
+	/** One Euro cutoff increase per unit/s of speed, higher reduces lag on fast moves */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "One Euro", meta = (ClampMin = "0"))
+	float Beta = 0.01f;
+
+	/** One Euro cutoff frequency in Hz of the speed estimate */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "One Euro", meta = (ClampMin = "0.01"))
+	float DerivativeCutoff = 1.0f;
+
+	/** Kalman acceleration variance in (units/s^2)^2, higher follows the measurements more closely */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Kalman", meta = (ClampMin = "0"))
+	float ProcessNoise = 10000.0f;
+
+	/** Kalman measurement variance in units^2 of a keypoint with confidence 1, divided by the confidence */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Kalman", meta = (ClampMin = "0.0001"))
+	float MeasurementNoise = 1.0f;
+};
+
+/**
+ * Smooths whole skeletons at once.
+ * State is kept as structure of arrays with one lane per keypoint axis, so a 33 keypoint skeleton is 99 lanes
+ * that are filtered four at a time with the engine's vector intrinsics (SSE or NEON). Parameters are per keypoint.
+ * People are filtered in slots, Apply keeps a slot per person id of the frame.
+ */
+class POSESTREAM_API FPoseStreamFilter
+{
+public:
+	explicit FPoseStreamFilter(int32 NumSlots = PoseStream::MaxPeople);
+	~FPoseStreamFilter();
+	FPoseStreamFilter(const FPoseStreamFilter&) = delete;
+	FPoseStreamFilter& operator=(const FPoseStreamFilter&) = delete;
+
+	void SetFilterType(EPoseStreamFilterType InType);
+	EPoseStreamFilterType GetFilterType() const { return Type; }
+
+	void SetJointParams(int32 Keypoint, const FPoseStreamFilterParams& Params);
+	void SetAllJointParams(const FPoseStreamFilterParams& Params);
+	const FPoseStreamFilterParams& GetJointParams(int32 Keypoint) const { return JointParams[Keypoint]; }
+
+	/** Scalar path, the reference the vector path is checked against */
+	void SetSimdEnabled(bool bEnabled) { bSimd = bEnabled; }
+
+	/** Forgets every person, the next samples pass through unfiltered */
+	void Reset();
+
+	/** Filters the people of Frame in place, at the frame's source time or its receive time if it has none */
+	void Apply(FPoseStreamFrame& Frame);
+
+	/** Filters Person in place as the occupant of Slot, Time is in seconds */
+	void FilterPerson(int32 Slot, double Time, FPoseStreamPerson& Person);
+
+	static constexpr int32 NumLanes = PoseStream::MaxKeypoints * 3;
+	/** Lanes rounded up to the vector width */
+	static constexpr int32 NumPaddedLanes = (NumLanes + 3) & ~3;
+
+private:
+	struct FSlot;
+
+	/** Refreshes the per lane parameters after a joint's parameters changed */
+	void UpdateLaneParams(int32 Keypoint);
+	int32 FindSlot(int32 PersonId);
+
+	EPoseStreamFilterType Type = EPoseStreamFilterType::OneEuro;
+	bool bSimd = true;
+	FPoseStreamFilterParams JointParams[PoseStream::MaxKeypoints];
+
+	/** Lane copies of JointParams */
+	struct alignas(16) FLaneParams
+	{
+		float MinCutoff[NumPaddedLanes];
+		float Beta[NumPaddedLanes];
+		float DerivativeCutoff[NumPaddedLanes];
+		float ProcessNoise[NumPaddedLanes];
+		float MeasurementNoise[NumPaddedLanes];
+	};
+	FLaneParams* LaneParams;
+
+	TArray<FSlot*> Slots;
+};
@@ -0,0 +1,92 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PoseStreamTypes.h"
+
+/** Counters of one jitter buffer */
+struct FPoseStreamJitterStats
+{
+	/** Samples waiting to be played */
+	int32 Depth = 0;
+	/** Source time buffered ahead of the playout point, in seconds */
+	double BufferedTime = 0.0;
+	/** Average time samples waited between arriving and being played, in seconds */
+	double AddedLatency = 0.0;
+	uint64 Received = 0;
+	/** Samples that arrived after their time had been played */
+	uint64 Late = 0;
+	uint64 Duplicates = 0;
+	/** Times playout ran past the newest sample */
+	uint64 Underruns = 0;
+	/** Evaluations that extrapolated or held the last sample */
+	uint64 Extrapolated = 0;
+};
+
+/**
+ * Smooths out network delay variation for one person of the pose stream.
+ * Samples are ordered by their source time and played a fixed delay behind the newest arrivals, with the sender's
+ * clock mapped onto the local one from the smallest transit time seen. Positions are interpolated with cubic Hermite
+ * curves through the neighbouring samples, and extrapolated along the last velocity for a short while when samples
+ * stop arriving. Storage is reserved up front, pushing and evaluating don't allocate.
+ */
+class POSESTREAM_API FPoseStreamJitterBuffer
+{
+public:
+	explicit FPoseStreamJitterBuffer(int32 InCapacity = 32);
+
+	/** Time between a sample's nominal arrival and when it is played */
+	void SetPlayoutDelay(double Seconds) { PlayoutDelay = FMath::Max(Seconds, 0.0); }
+	double GetPlayoutDelay() const { return PlayoutDelay; }
+
+	/** How far past the newest sample the motion is continued before it holds */
+	void SetMaxExtrapolation(double Seconds) { MaxExtrapolation = FMath::Max(Seconds, 0.0); }
+
+	/** Adds a sample stamped SourceTime on the sender's clock, that arrived at LocalTime */
+	void Push(double SourceTime, double LocalTime, const FPoseStreamPerson& Person);
+
+	/** Person at LocalTime minus the playout delay. False until the first sample arrived. */
+	bool Evaluate(double LocalTime, FPoseStreamPerson& OutPerson);
+
+	/** Source time of the last evaluation */
+	double GetPlayTime() const { return PlayTime; }
+
+	/** Local time of the newest arrival, to tell when a person left */
+	double GetLastArrival() const { return LastArrival; }
+
+	const FPoseStreamJitterStats& GetStats() const { return Stats; }
+
+	void Reset();
+
+private:
+	struct FSample
+	{
+		double SourceTime;
+		double LocalTime;
+		FPoseStreamPerson Person;
+	};
+
+	/** Drops samples the playout point has moved past, keeping one before it for tangents */
+	void Trim();
+
+	/** Samples in source time order */
+	TArray<FSample> Samples;
+	int32 Capacity;
+
+	double PlayoutDelay = 0.05;
+	double MaxExtrapolation = 0.1;
+
+	/** Local minus source time of the fastest sample, tracks sender clock drift slowly */
+	double ClockOffset = 0.0;
+	bool bHasClockOffset = false;
+
+	double PlayTime = -DBL_MAX;
+	double LastArrival = 0.0;
+	bool bUnderrun = false;
+
+	/** Source time of the newest sample whose wait was added to AddedLatency */
+	double LastMeasuredSourceTime = -DBL_MAX;
+
+	FPoseStreamJitterStats Stats;
+};
@@ -0,0 +1,9 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Modules/ModuleManager.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogPoseStream, Log, All);
+DECLARE_STATS_GROUP(TEXT("Pose Stream"), STATGROUP_PoseStream, STATCAT_Advanced);
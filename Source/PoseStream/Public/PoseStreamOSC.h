@@ -0,0 +1,50 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PoseStreamTypes.h"
+
+/**
+ * OSC encoding of pose frames.
+ * A frame is a bundle whose time tag is the capture time, with one message per person:
+ *   /pose ,ii[f...]  PersonId, NumKeypoints, then X Y Z per keypoint, or X Y Z Confidence per keypoint
+ * Nested bundles are flattened, messages with other addresses are ignored.
+ */
+namespace PoseStreamOSC
+{
+	/** OSC address of a person message */
+	constexpr const char* PersonAddress = "/pose";
+
+	enum class EParseResult : uint8
+	{
+		Ok,
+		/** Not an OSC message or bundle */
+		NotOSC,
+		/** Truncated packet, bad element size or a /pose message with the wrong arguments */
+		Malformed,
+	};
+
+	/**
+	 * Appends the people in Data to OutFrame and sets its source time. Never allocates, people beyond
+	 * PoseStream::MaxPeople are dropped.
+	 */
+	POSESTREAM_API EParseResult ParsePacket(const uint8* Data, int32 Size, FPoseStreamFrame& OutFrame);
+
+	/** Builds pose bundles, for tests and tools that replay poses */
+	class POSESTREAM_API FWriter
+	{
+	public:
+		void BeginBundle(double SourceTime);
+		void AddPerson(const FPoseStreamPerson& Person, bool bWithConfidences);
+		/** Packet written since BeginBundle */
+		const TArray<uint8>& GetData() const { return Data; }
+
+	private:
+		void WriteInt32(int32 Value);
+		void WriteFloat(float Value);
+		void WriteString(const char* String);
+
+		TArray<uint8> Data;
+	};
+}
@@ -0,0 +1,194 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PoseStreamTypes.h"
+
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Pose session recordings, .posestream files.
+ *
+ * Frames are grouped in chunks of a fixed number of frames, each starting with a frame that doesn't depend on
+ * earlier ones so playback can start at any chunk. Keypoints are quantized to a fixed step, the root (hip midpoint)
+ * as 32 bit and the keypoints as 16 bit offsets from it, confidences to 8 bit. Every value is stored as the zigzag
+ * varint of its difference to the same person in the previous frame. An index of chunk offsets and start times
+ * follows the last chunk, the header at the start points to it.
+ */
+namespace PoseStreamRecording
+{
+	constexpr uint32 Magic = 0x52535350; // PSSR
+	constexpr uint32 Version = 1;
+
+	struct FHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		/** Quantization step of positions, in Unreal units */
+		float Precision;
+		uint32 FramesPerChunk;
+		uint32 NumFrames;
+		uint32 NumChunks;
+		/** Offset of NumChunks FChunk entries */
+		uint64 IndexOffset;
+		/** Time of the last frame, in microseconds */
+		uint64 Duration;
+	};
+
+	struct FChunk
+	{
+		uint64 Offset;
+		/** Time of the chunk's first frame, in microseconds */
+		uint64 Time;
+	};
+
+	/** One person in quantized form, the reference the next frame's values are coded against */
+	struct FQuantizedPerson
+	{
+		int32 PersonId;
+		int32 NumKeypoints;
+		int32 Root[3];
+		/** Offset from the root per axis, then confidence */
+		int32 Values[PoseStream::MaxKeypoints][4];
+	};
+
+	struct FQuantizedFrame
+	{
+		int32 NumPeople = 0;
+		FQuantizedPerson People[PoseStream::MaxPeople];
+
+		const FQuantizedPerson* FindPerson(int32 PersonId, int32 NumKeypoints) const;
+	};
+}
+
+/** Records frames to a .posestream file. Chunks are written as they fill, the index when the recording is closed. */
+class POSESTREAM_API FPoseStreamRecordWriter
+{
+public:
+	FPoseStreamRecordWriter();
+	~FPoseStreamRecordWriter();
+
+	FPoseStreamRecordWriter(const FPoseStreamRecordWriter&) = delete;
+	FPoseStreamRecordWriter& operator=(const FPoseStreamRecordWriter&) = delete;
+
+	/** Creates Filename, Precision is the position quantization step in Unreal units, a millimetre by default */
+	bool Open(const FString& Filename, float InPrecision = 0.1f, int32 InFramesPerChunk = 128);
+
+	/** Appends Frame. Time is in seconds on any clock, the recording starts at the first frame's time. */
+	void Write(double Time, const FPoseStreamFrame& Frame);
+
+	/** Writes the last chunk and the index, false if the file couldn't be completed */
+	bool Close();
+
+	bool IsOpen() const { return File.IsValid(); }
+	const FString& GetFilename() const { return Filename; }
+	int32 GetNumFrames() const { return (int32)Header.NumFrames; }
+	/** Bytes in the file so far, including the chunk being filled */
+	int64 GetSize() const { return Written + Chunk.Num(); }
+
+private:
+	void FlushChunk();
+
+	TUniquePtr<IFileHandle> File;
+	FString Filename;
+	PoseStreamRecording::FHeader Header;
+	TArray<PoseStreamRecording::FChunk> Index;
+
+	/** Chunk being filled */
+	TArray<uint8> Chunk;
+	int64 Written = 0;
+	bool bWriteError = false;
+
+	double StartTime = 0.0;
+	uint64 PreviousTime = 0;
+	/** Quantized state of the current and the previous frame, swapped per frame */
+	PoseStreamRecording::FQuantizedFrame Frames[2];
+	int32 CurrentFrame = 0;
+};
+
+/**
+ * A .posestream file mapped into memory, or loaded where the platform can't map files.
+ * Immutable once opened, any number of FPoseStreamRecordCursor can decode from it on any thread.
+ */
+class POSESTREAM_API FPoseStreamRecording
+{
+public:
+	/** Null if the file can't be opened or isn't a complete recording */
+	static TSharedPtr<FPoseStreamRecording> Open(const FString& Filename);
+
+	~FPoseStreamRecording();
+
+	FPoseStreamRecording(const FPoseStreamRecording&) = delete;
+	FPoseStreamRecording& operator=(const FPoseStreamRecording&) = delete;
+
+	const FString& GetFilename() const { return Filename; }
+	int32 GetNumFrames() const { return (int32)Header.NumFrames; }
+	int32 GetNumChunks() const { return (int32)Header.NumChunks; }
+	int32 GetFramesPerChunk() const { return (int32)Header.FramesPerChunk; }
+	float GetPrecision() const { return Header.Precision; }
+	/** Seconds from the first to the last frame */
+	double GetDuration() const { return Header.Duration * 1e-6; }
+	int64 GetSize() const { return Size; }
+	bool IsMapped() const { return MappedRegion != nullptr; }
+
+	/** Chunk holding Time, the first one for times before the start */
+	int32 FindChunk(uint64 Time) const;
+	const PoseStreamRecording::FChunk& GetChunk(int32 ChunkIndex) const { return Index[ChunkIndex]; }
+	/** Byte range of a chunk */
+	const uint8* GetChunkData(int32 ChunkIndex) const { return Data + Index[ChunkIndex].Offset; }
+	const uint8* GetChunkEnd(int32 ChunkIndex) const;
+
+private:
+	FPoseStreamRecording() = default;
+	bool Initialize();
+
+	FString Filename;
+	IMappedFileHandle* MappedFile = nullptr;
+	IMappedFileRegion* MappedRegion = nullptr;
+	/** Contents when the file couldn't be mapped */
+	TArray<uint8> Loaded;
+
+	const uint8* Data = nullptr;
+	int64 Size = 0;
+	PoseStreamRecording::FHeader Header;
+	const PoseStreamRecording::FChunk* Index = nullptr;
+};
+
+/**
+ * Decoding position in a recording. Reading the frame after the last one decodes a single frame, anything else
+ * restarts at the start of the frame's chunk. Cheap to copy, holds no reference to the recording.
+ */
+struct POSESTREAM_API FPoseStreamRecordCursor
+{
+	/** Decodes frame FrameIndex, OutTime is its time in seconds from the start of the recording */
+	bool ReadFrame(const FPoseStreamRecording& Recording, int32 FrameIndex, FPoseStreamFrame& OutFrame, double& OutTime);
+
+	/** Decodes the last frame at or before Time seconds from the start of the recording */
+	bool ReadAtTime(const FPoseStreamRecording& Recording, double Time, FPoseStreamFrame& OutFrame, double& OutTime);
+
+	/** Index of the frame decoded last, INDEX_NONE before the first */
+	int32 GetFrameIndex() const { return FrameIndex; }
+
+	void Reset() { ChunkIndex = INDEX_NONE; FrameIndex = INDEX_NONE; }
+
+private:
+	/** Starts decoding at the first frame of ChunkIndex */
+	void BeginChunk(const FPoseStreamRecording& Recording, int32 InChunkIndex);
+	/** Time of the frame after the current one without decoding it, false at the end of the chunk */
+	bool PeekTime(const FPoseStreamRecording& Recording, uint64& OutTime) const;
+	/** Decodes the frame after the current one into the quantized state */
+	bool DecodeNext(const FPoseStreamRecording& Recording);
+	void Dequantize(const FPoseStreamRecording& Recording, FPoseStreamFrame& OutFrame, double& OutTime) const;
+
+	int32 ChunkIndex = INDEX_NONE;
+	int32 FrameIndex = INDEX_NONE;
+	/** Offset of the next frame from the start of the chunk */
+	int64 Offset = 0;
+	uint64 Time = 0;
+	/** Quantized state of the current and the previous frame, swapped per frame */
+	PoseStreamRecording::FQuantizedFrame Frames[2];
+	int32 CurrentFrame = 0;
+};
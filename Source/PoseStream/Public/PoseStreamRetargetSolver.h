@@ -0,0 +1,68 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PoseStreamTypes.h"
+
+namespace PoseStreamRetarget
+{
+	/** Bones the solver drives, parents before children */
+	enum EBone : uint8
+	{
+		Pelvis,
+		Spine1, Spine2, Spine3,
+		Neck, Head,
+		ClavicleL, UpperArmL, LowerArmL, HandL,
+		ClavicleR, UpperArmR, LowerArmR, HandR,
+		ThighL, CalfL, FootL,
+		ThighR, CalfR, FootR,
+		NumBones
+	};
+
+	/** Closest solver bone above Bone in the hierarchy, INDEX_NONE for the pelvis */
+	POSESTREAM_API int32 GetParent(int32 Bone);
+
+#if WITH_DEV_AUTOMATION_TESTS
+	/** Adult reference pose for tests in component space, X forward, Y right, Z up, no rotations, elbows and knees slightly bent */
+	POSESTREAM_API void MakeTestReferencePose(FTransform (&OutRef)[NumBones]);
+#endif
+}
+
+/**
+ * Turns one person's keypoints into component space transforms for a humanoid skeleton.
+ * The torso is oriented from the hips and shoulders, with the twist and swing between them spread over the spine by
+ * swing-twist decomposition. Arms and legs are solved with two bone IK towards keypoint targets that are rescaled to the
+ * skeleton's limb lengths, so proportions of the performer don't stretch the character.
+ * Everything the solve needs from the skeleton is computed in Initialize, Solve doesn't allocate and is thread safe.
+ */
+class POSESTREAM_API FPoseStreamRetargetSolver
+{
+public:
+	/** RefComponentSpace is the reference pose of the solver bones in component space */
+	void Initialize(const FTransform (&RefComponentSpace)[PoseStreamRetarget::NumBones]);
+	bool IsInitialized() const { return bInitialized; }
+
+	/**
+	 * Keypoints are in Unreal space as UPoseStreamSubsystem delivers them, KeypointToComponent turns them into component space.
+	 * Limbs whose keypoints are below MinConfidence follow their parent rigidly. Returns false, leaving the output
+	 * untouched, when the hips and shoulders aren't confident enough to place the torso.
+	 */
+	bool Solve(const FVector* Keypoints, const float* Confidences, const FQuat& KeypointToComponent, float MinConfidence, FTransform (&OutComponentSpace)[PoseStreamRetarget::NumBones]) const;
+
+private:
+	enum ELimb : uint8 { ArmL, ArmR, LegL, LegR, NumLimbs };
+
+	void SolveLimb(ELimb Limb, const FVector* Keypoints, const float* Confidences, float MinConfidence, const FVector& Forward, FTransform (&OutComponentSpace)[PoseStreamRetarget::NumBones]) const;
+	void Follow(int32 Bone, FTransform (&OutComponentSpace)[PoseStreamRetarget::NumBones]) const;
+
+	FTransform Ref[PoseStreamRetarget::NumBones];
+	/** Reference transforms relative to the solver parent */
+	FTransform RefLocal[PoseStreamRetarget::NumBones];
+	/** Orientation of the hips and shoulders in the reference pose, X forward, Y right, Z up */
+	FQuat RefPelvisBasis = FQuat::Identity;
+	FQuat RefChestBasis = FQuat::Identity;
+	float UpperLength[NumLimbs] = {};
+	float LowerLength[NumLimbs] = {};
+	bool bInitialized = false;
+};
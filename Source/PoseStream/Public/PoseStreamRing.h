@@ -0,0 +1,61 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/**
+ * Single producer, single consumer ring of fixed size elements.
+ * Elements are written and read in place, so neither side copies or allocates. The producer fills the slot
+ * returned by BeginWrite and publishes it with CommitWrite, the consumer reads Peek and releases it with Pop.
+ */
+template<typename ElementType, uint32 Capacity>
+class TPoseStreamRing
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	// rings are cache line aligned, which plain new doesn't guarantee before C++17
+	static void* operator new(size_t Size) { return FMemory::Malloc(Size, alignof(TPoseStreamRing)); }
+	static void operator delete(void* Ptr) { FMemory::Free(Ptr); }
+
+	/** Producer. Slot to fill, null while the ring is full. */
+	ElementType* BeginWrite()
+	{
+		const uint32 Write = WriteIndex.load(std::memory_order_relaxed);
+		if (Write - ReadIndex.load(std::memory_order_acquire) == Capacity) return nullptr;
+		return &Elements[Write & (Capacity - 1)];
+	}
+
+	/** Producer. Publishes the slot returned by BeginWrite. */
+	void CommitWrite()
+	{
+		WriteIndex.store(WriteIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/** Consumer. Oldest unread element, null while the ring is empty. */
+	const ElementType* Peek() const
+	{
+		const uint32 Read = ReadIndex.load(std::memory_order_relaxed);
+		if (Read == WriteIndex.load(std::memory_order_acquire)) return nullptr;
+		return &Elements[Read & (Capacity - 1)];
+	}
+
+	/** Consumer. Releases the element returned by Peek to the producer. */
+	void Pop()
+	{
+		ReadIndex.store(ReadIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	uint32 Num() const
+	{
+		return WriteIndex.load(std::memory_order_acquire) - ReadIndex.load(std::memory_order_acquire);
+	}
+
+private:
+	// indices on their own cache lines so the two threads don't share one
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> WriteIndex{ 0 };
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> ReadIndex{ 0 };
+	alignas(PLATFORM_CACHE_LINE_SIZE) ElementType Elements[Capacity];
+};
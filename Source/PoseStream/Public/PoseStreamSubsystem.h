@@ -0,0 +1,129 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "Tickable.h"
+#include "PoseStreamTypes.h"
+#include "PoseStreamFilter.h"
+#include "PoseStreamJitterBuffer.h"
+#include "PoseStreamRecording.h"
+#include "PoseStreamTracker.h"
+#include "PoseStreamSubsystem.generated.h"
+
+class FPoseStreamReceiver;
+class FPoseStreamLiveLinkSource;
+struct FPoseStreamReceiverStats;
+template<typename ElementType, uint32 Capacity> class TPoseStreamRing;
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnPoseStreamFrame, const FPoseStreamFrame&);
+
+/**
+ * Native path for the pose stream: a receive thread parses OSC pose bundles into a lock free ring, the game thread
+ * drains it every tick, converts the keypoints to Unreal space, replaces the estimator's person indices with stable
+ * track ids and publishes them to LiveLink.
+ */
+UCLASS()
+class POSESTREAM_API UPoseStreamSubsystem : public UEngineSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UPoseStreamSubsystem();
+	virtual ~UPoseStreamSubsystem();
+
+	virtual void Deinitialize() override;
+
+	/** Binds Port and starts receiving, restarts the receiver if it is already listening */
+	UFUNCTION(BlueprintCallable, Category = "Pose Stream")
+	bool StartListening(int32 Port = 7000);
+
+	UFUNCTION(BlueprintCallable, Category = "Pose Stream")
+	void StopListening();
+
+	UFUNCTION(BlueprintPure, Category = "Pose Stream")
+	bool IsListening() const { return Receiver.IsValid(); }
+
+	/** Smoothing applied to every frame after it is converted to Unreal space, resets the filter state */
+	UFUNCTION(BlueprintCallable, Category = "Pose Stream")
+	void SetFilterType(EPoseStreamFilterType Type) { Filter.SetFilterType(Type); }
+
+	UFUNCTION(BlueprintCallable, Category = "Pose Stream")
+	void SetFilterParams(const FPoseStreamFilterParams& Params) { Filter.SetAllJointParams(Params); }
+
+	/** Smoothing of a single keypoint, see PoseStream::EKeypoint */
+	UFUNCTION(BlueprintCallable, Category = "Pose Stream")
+	void SetKeypointFilterParams(int32 Keypoint, const FPoseStreamFilterParams& Params) { Filter.SetJointParams(Keypoint, Params); }
+
+	FPoseStreamFilter& GetFilter() { return Filter; }
+
+	/** Assigns the stable person ids while PoseStream.Tracking is set */
+	FPoseStreamTracker& GetTracker() { return Tracker; }
+
+	/**
+	 * Records every frame delivered on the game thread, before filtering, to a .posestream file.
+	 * Relative paths are in Saved/PoseStream. Replaces a recording in progress.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Pose Stream")
+	bool StartRecording(const FString& Filename);
+
+	/** Finishes the recording, it can't be played back before */
+	UFUNCTION(BlueprintCallable, Category = "Pose Stream")
+	void StopRecording();
+
+	UFUNCTION(BlueprintPure, Category = "Pose Stream")
+	bool IsRecording() const { return Recorder.IsValid(); }
+
+	/** Recording in progress, null while not recording */
+	const FPoseStreamRecordWriter* GetRecorder() const { return Recorder.Get(); }
+
+	/** Newest frame delivered to the game thread, in Unreal space */
+	const FPoseStreamFrame& GetLatestFrame() const { return LatestFrame; }
+
+	/**
+	 * Game thread, once per received frame in arrival order. Positions are in Unreal space.
+	 * While PoseStream.JitterDelay is set, once per tick with the people played out of the jitter buffers instead.
+	 */
+	FOnPoseStreamFrame OnFrame;
+
+	/** Jitter buffer counters of a person, null while the jitter buffer is off or the person isn't tracked */
+	const FPoseStreamJitterStats* GetJitterStats(int32 PersonId) const;
+
+	/** Receive thread counters, null while not listening */
+	const FPoseStreamReceiverStats* GetReceiverStats() const { return ReceiverStats.Get(); }
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Always; }
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual TStatId GetStatId() const override;
+
+private:
+	// shared pointers so the generated code doesn't need the complete private types
+	/** Frames the receive thread has parsed but the game thread hasn't seen */
+	TSharedPtr<TPoseStreamRing<FPoseStreamFrame, 64>> Ring;
+	TSharedPtr<FPoseStreamReceiverStats> ReceiverStats;
+	TSharedPtr<FPoseStreamReceiver> Receiver;
+	TSharedPtr<FPoseStreamLiveLinkSource> LiveLinkSource;
+
+	/** Fills LatestFrame from the jitter buffers, false if there are none */
+	bool PlayJitterBuffers(double Now);
+
+	/** Replaces the person ids of Frame with track ids */
+	void TrackFrame(FPoseStreamFrame& Frame);
+
+	/** Delivers LatestFrame to the recording, filter and OnFrame */
+	void DeliverFrame(double Time);
+
+	FPoseStreamTracker Tracker;
+	FPoseStreamFilter Filter;
+	FPoseStreamFrame LatestFrame;
+
+	/** Per person, only while PoseStream.JitterDelay is set */
+	TMap<int32, TUniquePtr<FPoseStreamJitterBuffer>> JitterBuffers;
+	FPoseStreamFrame ReceivedFrame;
+	uint64 PlayedSequence = 0;
+
+	TUniquePtr<FPoseStreamRecordWriter> Recorder;
+};
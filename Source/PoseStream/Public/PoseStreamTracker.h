@@ -0,0 +1,103 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PoseStreamTypes.h"
+
+/** Tuning of FPoseStreamTracker, distances in Unreal units */
+struct FPoseStreamTrackerSettings
+{
+	/** Largest mean keypoint distance from a track's prediction that can still be the same person */
+	float MaxDistance = 40.0f;
+	/** Growth of MaxDistance per second a track hasn't been seen, the prediction gets less certain */
+	float MaxDistanceGrowth = 150.0f;
+	/** Cost per unit of mean bone length difference, tells apart people of different build */
+	float BoneLengthWeight = 2.0f;
+	/** Keypoints below this confidence don't count towards distances and bone lengths */
+	float MinConfidence = 0.3f;
+	/** Detections needed in a row before a new track is reported, filters out spurious people */
+	int32 MinHits = 3;
+	/** Seconds a track survives without detections, people hidden for longer come back as new tracks */
+	float MaxMissedTime = 0.5f;
+};
+
+struct FPoseStreamTrackerStats
+{
+	int32 NumTracks = 0;
+	uint64 Births = 0;
+	uint64 Deaths = 0;
+	/** Detections that weren't reported because their track wasn't confirmed yet */
+	uint64 Tentative = 0;
+};
+
+/**
+ * Keeps person ids stable across frames when the pose estimator's indices swap.
+ * Every frame the detections are matched to the tracks by Hungarian assignment over a cost of the mean keypoint
+ * distance to the track's prediction, moved along its smoothed root velocity, plus the difference of a running
+ * bone length signature. Unmatched detections start tentative tracks, tracks unseen for MaxMissedTime end.
+ * Ids are the smallest ones not in use, so characters bound to an id pick up the next performer.
+ * Storage is fixed, updates don't allocate and the assignment is bounded by MaxTracks.
+ */
+class POSESTREAM_API FPoseStreamTracker
+{
+public:
+	/** Tracks kept at once, including those currently unseen */
+	static constexpr int32 MaxTracks = PoseStream::MaxPeople * 2;
+
+	FPoseStreamTracker();
+
+	void SetSettings(const FPoseStreamTrackerSettings& InSettings) { Settings = InSettings; }
+	const FPoseStreamTrackerSettings& GetSettings() const { return Settings; }
+
+	/** Replaces the person ids in Frame with track ids, people whose track isn't confirmed yet are removed */
+	void Update(FPoseStreamFrame& Frame);
+
+	const FPoseStreamTrackerStats& GetStats() const { return Stats; }
+
+	void Reset();
+
+private:
+	static constexpr int32 NumSignatureBones = 12;
+
+	struct FTrack
+	{
+		int32 Id;
+		int32 Hits;
+		bool bConfirmed;
+		double LastTime;
+		int32 NumKeypoints;
+		FVector Positions[PoseStream::MaxKeypoints];
+		float Confidences[PoseStream::MaxKeypoints];
+		FVector Root;
+		FVector RootVelocity;
+		float BoneLengths[NumSignatureBones];
+		/** Samples averaged into each bone length */
+		int32 BoneSamples[NumSignatureBones];
+	};
+
+	float GetCost(const FTrack& Track, const FPoseStreamPerson& Person, const float* PersonBoneLengths, double Time) const;
+	void UpdateTrack(FTrack& Track, const FPoseStreamPerson& Person, const float* PersonBoneLengths, double Time) const;
+	void GetBoneLengths(const FPoseStreamPerson& Person, float* OutLengths) const;
+	int32 AllocateId() const;
+
+	/** Minimum cost assignment of the rows to the columns of the Size x Size Costs, into RowAssignment */
+	void Solve(int32 Size);
+
+	FPoseStreamTrackerSettings Settings;
+	FPoseStreamTrackerStats Stats;
+
+	FTrack Tracks[MaxTracks];
+	int32 NumTracks = 0;
+
+	// assignment scratch, rows are tracks and columns detections
+	static constexpr int32 MaxSize = MaxTracks;
+	float Costs[MaxSize][MaxSize];
+	int32 RowAssignment[MaxSize];
+	double RowPotentials[MaxSize + 1];
+	double ColumnPotentials[MaxSize + 1];
+	int32 ColumnRow[MaxSize + 1];
+	int32 Way[MaxSize + 1];
+	double MinSlack[MaxSize + 1];
+	bool Used[MaxSize + 1];
+};
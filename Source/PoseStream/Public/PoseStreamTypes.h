@@ -0,0 +1,63 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace PoseStream
+{
+	/** Keypoints per person, the 33 landmark BlazePose topology */
+	constexpr int32 MaxKeypoints = 33;
+
+	/** People per frame, further people in a packet are dropped. Room for a crowd of about 20 performers. */
+	constexpr int32 MaxPeople = 24;
+
+	/** BlazePose landmark order */
+	enum EKeypoint : uint8
+	{
+		Nose,
+		LeftEyeInner, LeftEye, LeftEyeOuter,
+		RightEyeInner, RightEye, RightEyeOuter,
+		LeftEar, RightEar,
+		MouthLeft, MouthRight,
+		LeftShoulder, RightShoulder,
+		LeftElbow, RightElbow,
+		LeftWrist, RightWrist,
+		LeftPinky, RightPinky,
+		LeftIndex, RightIndex,
+		LeftThumb, RightThumb,
+		LeftHip, RightHip,
+		LeftKnee, RightKnee,
+		LeftAnkle, RightAnkle,
+		LeftHeel, RightHeel,
+		LeftFootIndex, RightFootIndex,
+		NumKeypoints
+	};
+	static_assert(NumKeypoints == MaxKeypoints, "Keypoint enum doesn't match MaxKeypoints");
+
+	POSESTREAM_API FName GetKeypointName(int32 Index);
+}
+
+/** Keypoints of one person as sent by the pose estimator */
+struct FPoseStreamPerson
+{
+	/** Person index of the estimator, not stable across frames */
+	int32 PersonId = INDEX_NONE;
+	int32 NumKeypoints = 0;
+	FVector Positions[PoseStream::MaxKeypoints];
+	/** 1 for keypoints that came without a confidence */
+	float Confidences[PoseStream::MaxKeypoints];
+};
+
+/** Everything one packet carried. Fixed size so frames can be handed between threads without allocating. */
+struct FPoseStreamFrame
+{
+	/** Increments per received frame */
+	uint64 Sequence = 0;
+	/** OSC time tag of the bundle in seconds, 0 for packets without one */
+	double SourceTime = 0.0;
+	/** FPlatformTime::Seconds() when the packet arrived */
+	double ReceiveTime = 0.0;
+	int32 NumPeople = 0;
+	FPoseStreamPerson People[PoseStream::MaxPeople];
+};
@@ -0,0 +1,26 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "AnimGraphNode_PoseStreamRetarget.h"
+
+#define LOCTEXT_NAMESPACE "AnimGraphNode_PoseStreamRetarget"
+
+FText UAnimGraphNode_PoseStreamRetarget::GetControllerDescription() const
+{
+	return LOCTEXT("ControllerDescription", "Pose Stream Retarget");
+}
+
+FText UAnimGraphNode_PoseStreamRetarget::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	if (TitleType == ENodeTitleType::ListView || TitleType == ENodeTitleType::MenuTitle)
+	{
+		return GetControllerDescription();
+	}
+	return FText::Format(LOCTEXT("NodeTitle", "{0}\nPerson {1}"), GetControllerDescription(), FText::AsNumber(Node.PersonId));
+}
+
+FText UAnimGraphNode_PoseStreamRetarget::GetTooltipText() const
+{
+	return LOCTEXT("Tooltip", "Poses the torso, head and limbs from a person of the pose stream, solving arms and legs with two bone IK scaled to the skeleton.");
+}
+
+#undef LOCTEXT_NAMESPACE
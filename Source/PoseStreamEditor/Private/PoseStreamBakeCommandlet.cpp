@@ -0,0 +1,767 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PoseStreamBakeCommandlet.h"
+#include "AnimNode_PoseStreamRetarget.h"
+#include "PoseStreamFilter.h"
+#include "PoseStreamRecording.h"
+#include "PoseStreamRetargetSolver.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/Skeleton.h"
+#include "AnimationRuntime.h"
+#include "AssetRegistryModule.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogPoseStreamBake, Log, All);
+
+namespace
+{
+	/** Seconds of recording a range filters before its first key, so the filters have settled where ranges meet */
+	constexpr double BakeWarmUpSeconds = 1.0;
+	/** Longest run of keys one reduced segment may replace, bounds the reduction's cost on nearly linear tracks */
+	constexpr int32 MaxReducedSegment = 256;
+
+	/** Read only inputs of the range tasks */
+	struct FBakeSetup
+	{
+		const FPoseStreamRecording* Recording = nullptr;
+		FPoseStreamRetargetSolver Solver;
+		FQuat KeypointToComponent = FQuat::Identity;
+		float MinConfidence = 0.3f;
+		EPoseStreamFilterType FilterType = EPoseStreamFilterType::OneEuro;
+		double FrameRate = 30.0;
+		int32 NumKeys = 0;
+		TArray<int32> PersonIds;
+
+		/** Solver bones that get tracks, the ones the node writes to the pose */
+		TArray<int32> KeyedBones;
+		TArray<FName> KeyedBoneNames;
+		/** Per keyed bone, the closest keyed solver bone above it, INDEX_NONE for none, and its skeleton parent relative to that bone in the reference pose */
+		TArray<int32> ParentBones;
+		TArray<FTransform> ParentOffsets;
+	};
+
+	/** Local transforms of one person's keyed bones, key major, and which keys were solved */
+	struct FBakePerson
+	{
+		TArray<FTransform> Locals;
+		TArray<bool> Solved;
+	};
+
+	const FPoseStreamPerson* FindBakePerson(const FPoseStreamFrame& Frame, int32 PersonId)
+	{
+		for (int32 PersonIndex = 0; PersonIndex < Frame.NumPeople; ++PersonIndex)
+		{
+			if (Frame.People[PersonIndex].PersonId == PersonId) return &Frame.People[PersonIndex];
+		}
+		return nullptr;
+	}
+
+	/** Keypoints of PersonId at Alpha between two frames, those of the nearer frame when only one of them has the person */
+	bool SampleKeypoints(const FPoseStreamFrame* Previous, const FPoseStreamFrame& Next, float Alpha, int32 PersonId, FVector (&OutKeypoints)[PoseStream::MaxKeypoints], float (&OutConfidences)[PoseStream::MaxKeypoints])
+	{
+		const FPoseStreamPerson* From = Previous != nullptr ? FindBakePerson(*Previous, PersonId) : nullptr;
+		const FPoseStreamPerson* To = FindBakePerson(Next, PersonId);
+		if (From == nullptr || To == nullptr || From->NumKeypoints != To->NumKeypoints)
+		{
+			From = To = Alpha < 0.5f ? From : To;
+			if (To == nullptr) return false;
+		}
+
+		const int32 NumKeypoints = FMath::Clamp(To->NumKeypoints, 0, (int32)PoseStream::MaxKeypoints);
+		for (int32 Keypoint = 0; Keypoint < NumKeypoints; ++Keypoint)
+		{
+			OutKeypoints[Keypoint] = FMath::Lerp(From->Positions[Keypoint], To->Positions[Keypoint], Alpha);
+			OutConfidences[Keypoint] = FMath::Lerp(From->Confidences[Keypoint], To->Confidences[Keypoint], Alpha);
+		}
+		for (int32 Keypoint = NumKeypoints; Keypoint < PoseStream::MaxKeypoints; ++Keypoint)
+		{
+			OutKeypoints[Keypoint] = FVector::ZeroVector;
+			OutConfidences[Keypoint] = 0.0f;
+		}
+		return true;
+	}
+
+	/**
+	 * Filters, retargets and keys [FirstKey, EndKey) for every person with its own filter and cursor, so ranges run
+	 * on any thread. Returns the recording frames decoded, including the warm up before the range.
+	 */
+	int32 BakeRange(const FBakeSetup& Setup, int32 FirstKey, int32 EndKey, TArray<FBakePerson>& People)
+	{
+		const FPoseStreamRecording& Recording = *Setup.Recording;
+		FPoseStreamFilter Filter;
+		Filter.SetFilterType(Setup.FilterType);
+		FPoseStreamRecordCursor Cursor;
+
+		// the frames on either side of the key, swapped as the cursor moves on
+		FPoseStreamFrame Frames[2];
+		double Times[2] = {};
+		int32 Current = 0;
+		bool bHasPrevious = false;
+		if (!Cursor.ReadAtTime(Recording, FirstKey / Setup.FrameRate - BakeWarmUpSeconds, Frames[Current], Times[Current])) return 0;
+		Filter.Apply(Frames[Current]);
+		int32 NumDecoded = 1;
+
+		const int32 NumKeyed = Setup.KeyedBones.Num();
+		FVector Keypoints[PoseStream::MaxKeypoints];
+		float Confidences[PoseStream::MaxKeypoints];
+		FTransform Solved[PoseStreamRetarget::NumBones];
+		for (int32 Key = FirstKey; Key < EndKey;)
+		{
+			const double KeyTime = Key / Setup.FrameRate;
+			if (KeyTime > Times[Current] && Cursor.GetFrameIndex() + 1 < Recording.GetNumFrames())
+			{
+				Current ^= 1;
+				if (!Cursor.ReadFrame(Recording, Cursor.GetFrameIndex() + 1, Frames[Current], Times[Current])) break;
+				Filter.Apply(Frames[Current]);
+				++NumDecoded;
+				bHasPrevious = true;
+				continue;
+			}
+
+			const double Span = Times[Current] - Times[Current ^ 1];
+			const float Alpha = bHasPrevious && Span > 0.0 ? (float)FMath::Clamp((KeyTime - Times[Current ^ 1]) / Span, 0.0, 1.0) : 1.0f;
+			for (int32 PersonIndex = 0; PersonIndex < Setup.PersonIds.Num(); ++PersonIndex)
+			{
+				FBakePerson& Person = People[PersonIndex];
+				Person.Solved[Key] = SampleKeypoints(bHasPrevious ? &Frames[Current ^ 1] : nullptr, Frames[Current], Alpha, Setup.PersonIds[PersonIndex], Keypoints, Confidences)
+					&& Setup.Solver.Solve(Keypoints, Confidences, Setup.KeypointToComponent, Setup.MinConfidence, Solved);
+				if (!Person.Solved[Key]) continue;
+
+				// the node sets component space transforms, bones between them keep their reference local transforms
+				FTransform* Locals = &Person.Locals[Key * NumKeyed];
+				for (int32 Index = 0; Index < NumKeyed; ++Index)
+				{
+					const int32 ParentBone = Setup.ParentBones[Index];
+					const FTransform Parent = ParentBone != INDEX_NONE ? Setup.ParentOffsets[Index] * Solved[ParentBone] : Setup.ParentOffsets[Index];
+					Locals[Index] = Solved[Setup.KeyedBones[Index]].GetRelativeTransform(Parent);
+				}
+			}
+			++Key;
+		}
+		return NumDecoded;
+	}
+
+	/** Bakes every key in NumRanges ranges on the task graph, returns the recording frames decoded */
+	int64 BakeRanges(const FBakeSetup& Setup, int32 NumRanges, TArray<FBakePerson>& People)
+	{
+		TArray<int32> Decoded;
+		Decoded.SetNumZeroed(NumRanges);
+		ParallelFor(NumRanges, [&](int32 Range)
+		{
+			const int32 FirstKey = (int32)((int64)Setup.NumKeys * Range / NumRanges);
+			const int32 EndKey = (int32)((int64)Setup.NumKeys * (Range + 1) / NumRanges);
+			Decoded[Range] = BakeRange(Setup, FirstKey, EndKey, People);
+		});
+
+		int64 NumDecoded = 0;
+		for (int32 Count : Decoded) NumDecoded += Count;
+		return NumDecoded;
+	}
+
+	/** Ids of everyone in the recording, the chunks are scanned in parallel */
+	TArray<int32> FindBakePeople(const FPoseStreamRecording& Recording)
+	{
+		const int32 FramesPerChunk = FMath::Max(Recording.GetFramesPerChunk(), 1);
+		const int32 NumBlocks = FMath::DivideAndRoundUp(Recording.GetNumFrames(), FramesPerChunk);
+		TArray<TSet<int32>> BlockIds;
+		BlockIds.SetNum(NumBlocks);
+		ParallelFor(NumBlocks, [&](int32 Block)
+		{
+			FPoseStreamRecordCursor Cursor;
+			FPoseStreamFrame Frame;
+			double Time;
+			const int32 EndFrame = FMath::Min((Block + 1) * FramesPerChunk, Recording.GetNumFrames());
+			for (int32 FrameIndex = Block * FramesPerChunk; FrameIndex < EndFrame; ++FrameIndex)
+			{
+				if (!Cursor.ReadFrame(Recording, FrameIndex, Frame, Time)) break;
+				for (int32 PersonIndex = 0; PersonIndex < Frame.NumPeople; ++PersonIndex) BlockIds[Block].Add(Frame.People[PersonIndex].PersonId);
+			}
+		});
+
+		TSet<int32> Ids;
+		for (const TSet<int32>& Block : BlockIds) Ids.Append(Block);
+		TArray<int32> Sorted = Ids.Array();
+		Sorted.Sort();
+		return Sorted;
+	}
+
+	FVector InterpolateKey(const FVector& A, const FVector& B, float Alpha) { return FMath::Lerp(A, B, Alpha); }
+	FQuat InterpolateKey(const FQuat& A, const FQuat& B, float Alpha) { return FQuat::Slerp(A, B, Alpha); }
+	float GetKeyError(const FVector& A, const FVector& B) { return FVector::Dist(A, B); }
+	float GetKeyError(const FQuat& A, const FQuat& B) { return A.AngularDistance(B); }
+
+	/**
+	 * Greedy linear key reduction. Segments grow while interpolating their end keys reproduces every key in between
+	 * within Tolerance. Raw animation data is sampled uniformly, so the keys in between are replaced by the
+	 * interpolation, which the engine's compression then drops exactly, and tracks within Tolerance of their first
+	 * key become a single key. Returns the keys kept.
+	 */
+	template <typename KeyType>
+	int32 ReduceKeys(TArray<KeyType>& Keys, float Tolerance)
+	{
+		const int32 NumKeys = Keys.Num();
+		if (NumKeys <= 2) return NumKeys;
+
+		bool bConstant = true;
+		for (int32 Key = 1; Key < NumKeys && bConstant; ++Key) bConstant = GetKeyError(Keys[0], Keys[Key]) <= Tolerance;
+		if (bConstant)
+		{
+			Keys.SetNum(1);
+			return 1;
+		}
+
+		int32 NumKept = 1;
+		int32 Start = 0;
+		auto Fill = [&Keys](int32 From, int32 To)
+		{
+			for (int32 Key = From + 1; Key < To; ++Key) Keys[Key] = InterpolateKey(Keys[From], Keys[To], float(Key - From) / (To - From));
+		};
+		for (int32 End = 2; End < NumKeys; ++End)
+		{
+			bool bFits = End - Start <= MaxReducedSegment;
+			for (int32 Key = Start + 1; Key < End && bFits; ++Key)
+			{
+				bFits = GetKeyError(InterpolateKey(Keys[Start], Keys[End], float(Key - Start) / (End - Start)), Keys[Key]) <= Tolerance;
+			}
+			if (!bFits)
+			{
+				Fill(Start, End - 1);
+				Start = End - 1;
+				++NumKept;
+			}
+		}
+		Fill(Start, NumKeys - 1);
+		return NumKept + 1;
+	}
+
+	struct FBakeTracks
+	{
+		TArray<FRawAnimSequenceTrack> Tracks;
+		int32 FirstKey = 0;
+		int32 NumKeys = 0;
+		int32 KeptPositions = 0;
+		int32 KeptRotations = 0;
+		int32 ConstantTracks = 0;
+	};
+
+	/**
+	 * Raw tracks of a person from their first to their last solved key, keys that weren't solved hold the pose before
+	 * them. The tracks are reduced in parallel. False if the person was never solved.
+	 */
+	bool MakeBakeTracks(const FBakeSetup& Setup, const FBakePerson& Person, float PositionTolerance, float AngleTolerance, FBakeTracks& Out)
+	{
+		const int32 FirstKey = Person.Solved.Find(true);
+		const int32 LastKey = Person.Solved.FindLast(true);
+		if (FirstKey == INDEX_NONE) return false;
+
+		const int32 NumKeyed = Setup.KeyedBones.Num();
+		Out.FirstKey = FirstKey;
+		Out.NumKeys = LastKey - FirstKey + 1;
+		Out.Tracks.SetNum(NumKeyed);
+		TArray<FIntPoint> Kept;
+		Kept.SetNum(NumKeyed);
+		ParallelFor(NumKeyed, [&](int32 Index)
+		{
+			FRawAnimSequenceTrack& Track = Out.Tracks[Index];
+			Track.PosKeys.SetNumUninitialized(Out.NumKeys);
+			Track.RotKeys.SetNumUninitialized(Out.NumKeys);
+			int32 Held = FirstKey;
+			for (int32 Key = FirstKey; Key <= LastKey; ++Key)
+			{
+				if (Person.Solved[Key]) Held = Key;
+				const FTransform& Local = Person.Locals[Held * NumKeyed + Index];
+				Track.PosKeys[Key - FirstKey] = Local.GetTranslation();
+				// neighbouring keys in the same hemisphere, so interpolation takes the short way
+				FQuat Rotation = Local.GetRotation();
+				if (Key > FirstKey && (Rotation | Track.RotKeys[Key - FirstKey - 1]) < 0.0f) Rotation = Rotation * -1.0f;
+				Track.RotKeys[Key - FirstKey] = Rotation;
+			}
+			Track.ScaleKeys.Add(Person.Locals[FirstKey * NumKeyed + Index].GetScale3D());
+			Kept[Index].X = ReduceKeys(Track.PosKeys, PositionTolerance);
+			Kept[Index].Y = ReduceKeys(Track.RotKeys, FMath::DegreesToRadians(AngleTolerance));
+		});
+
+		for (const FIntPoint& Count : Kept)
+		{
+			Out.KeptPositions += Count.X;
+			Out.KeptRotations += Count.Y;
+			Out.ConstantTracks += (Count.X == 1) + (Count.Y == 1);
+		}
+		return true;
+	}
+
+	/** Creates or replaces the sequence PackageName and saves it */
+	bool SaveBakedSequence(USkeleton* Skeleton, const FString& PackageName, double FrameRate, const TArray<FName>& BoneNames, FBakeTracks& Tracks)
+	{
+		UPackage* Package = CreatePackage(*PackageName);
+		Package->FullyLoad();
+		const FString AssetName = FPackageName::GetShortName(PackageName);
+		UAnimSequence* Sequence = FindObject<UAnimSequence>(Package, *AssetName);
+		const bool bCreated = Sequence == nullptr;
+		if (bCreated) Sequence = NewObject<UAnimSequence>(Package, *AssetName, RF_Public | RF_Standalone);
+
+		Sequence->CleanAnimSequenceForImport();
+		Sequence->SetSkeleton(Skeleton);
+		Sequence->SetRawNumberOfFrame(Tracks.NumKeys);
+		Sequence->SequenceLength = FMath::Max(Tracks.NumKeys - 1, 1) / (float)FrameRate;
+		Sequence->ImportFileFramerate = (float)FrameRate;
+		Sequence->ImportResampleFramerate = FMath::RoundToInt(FrameRate);
+		for (int32 Index = 0; Index < BoneNames.Num(); ++Index)
+		{
+			Sequence->AddNewRawTrack(BoneNames[Index], &Tracks.Tracks[Index]);
+		}
+		Sequence->MarkRawDataAsModified();
+		Sequence->PostProcessSequence();
+		Sequence->MarkPackageDirty();
+		if (bCreated) FAssetRegistryModule::AssetCreated(Sequence);
+
+		const FString Filename = FPackageName::LongPackageNameToFilename(PackageName, FPackageName::GetAssetPackageExtension());
+		return UPackage::SavePackage(Package, Sequence, RF_Public | RF_Standalone, *Filename);
+	}
+
+	/** Recording file names can have characters package names can't */
+	FString MakeBakeAssetName(const FString& Name)
+	{
+		FString Result = Name;
+		const FString Invalid = INVALID_LONGPACKAGE_CHARACTERS;
+		for (TCHAR& Character : Result)
+		{
+			int32 Found;
+			if (Invalid.FindChar(Character, Found)) Character = TEXT('_');
+		}
+		return Result;
+	}
+}
+
+UPoseStreamBakeCommandlet::UPoseStreamBakeCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+	ShowErrorCount = true;
+}
+
+int32 UPoseStreamBakeCommandlet::Main(const FString& Params)
+{
+	FString RecordingPath;
+	FParse::Value(*Params, TEXT("Recording="), RecordingPath);
+	FString SkeletonPath = TEXT("/Game/Mannequin/Character/Mesh/UE4_Mannequin_Skeleton");
+	FParse::Value(*Params, TEXT("Skeleton="), SkeletonPath);
+	FString OutputPath = TEXT("/Game/PoseStream/Baked");
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FString PeopleParam;
+	FParse::Value(*Params, TEXT("People="), PeopleParam);
+	float FrameRate = 30.0f;
+	FParse::Value(*Params, TEXT("FrameRate="), FrameRate);
+	FString FilterName = TEXT("OneEuro");
+	FParse::Value(*Params, TEXT("Filter="), FilterName);
+	float PositionTolerance = 0.1f;
+	FParse::Value(*Params, TEXT("Position="), PositionTolerance);
+	float AngleTolerance = 0.2f;
+	FParse::Value(*Params, TEXT("Angle="), AngleTolerance);
+	int32 NumRanges = 0;
+	FParse::Value(*Params, TEXT("Ranges="), NumRanges);
+	const bool bScaling = FParse::Param(*Params, TEXT("Scaling"));
+	const bool bSave = !FParse::Param(*Params, TEXT("NoSave"));
+
+	if (RecordingPath.IsEmpty())
+	{
+		UE_LOG(LogPoseStreamBake, Error, TEXT("Pose stream bake: no recording, pass -Recording=File.posestream"));
+		return 1;
+	}
+	// the same paths PoseStream.Record writes
+	if (FPaths::IsRelative(RecordingPath)) RecordingPath = FPaths::ProjectSavedDir() / TEXT("PoseStream") / RecordingPath;
+	if (FPaths::GetExtension(RecordingPath) != TEXT("posestream")) RecordingPath += TEXT(".posestream");
+	TSharedPtr<FPoseStreamRecording> Recording = FPoseStreamRecording::Open(RecordingPath);
+	if (!Recording.IsValid() || Recording->GetNumFrames() == 0)
+	{
+		UE_LOG(LogPoseStreamBake, Error, TEXT("Pose stream bake: couldn't open %s"), *RecordingPath);
+		return 1;
+	}
+
+	USkeleton* Skeleton = LoadObject<USkeleton>(nullptr, *SkeletonPath);
+	if (Skeleton == nullptr)
+	{
+		UE_LOG(LogPoseStreamBake, Error, TEXT("Pose stream bake: couldn't load skeleton %s"), *SkeletonPath);
+		return 1;
+	}
+
+	const int64 FilterValue = StaticEnum<EPoseStreamFilterType>()->GetValueByNameString(FilterName);
+	if (FilterValue == INDEX_NONE)
+	{
+		UE_LOG(LogPoseStreamBake, Error, TEXT("Pose stream bake: unknown filter %s, use None, OneEuro or Kalman"), *FilterName);
+		return 1;
+	}
+
+	// the retarget node's defaults, so baked assets match what the node shows live
+	const FAnimNode_PoseStreamRetarget NodeDefaults;
+	FBakeSetup Setup;
+	Setup.Recording = Recording.Get();
+	Setup.KeypointToComponent = NodeDefaults.KeypointRotation.Quaternion();
+	Setup.MinConfidence = NodeDefaults.MinConfidence;
+	Setup.FilterType = (EPoseStreamFilterType)FilterValue;
+	Setup.FrameRate = FMath::Clamp(FrameRate, 1.0f, 1000.0f);
+	Setup.NumKeys = FMath::FloorToInt(Recording->GetDuration() * Setup.FrameRate) + 1;
+
+	{
+		using namespace PoseStreamRetarget;
+
+		const FReferenceSkeleton& RefSkeleton = Skeleton->GetReferenceSkeleton();
+		FPoseStreamRetargetBoneMap BoneMap = NodeDefaults.Bones;
+		FTransform RefComponentSpace[NumBones];
+		int32 BoneIndices[NumBones];
+		for (int32 Bone = 0; Bone < NumBones; ++Bone)
+		{
+			const FName BoneName = BoneMap.Get(Bone).BoneName;
+			BoneIndices[Bone] = RefSkeleton.FindBoneIndex(BoneName);
+			if (BoneIndices[Bone] == INDEX_NONE)
+			{
+				UE_LOG(LogPoseStreamBake, Error, TEXT("Pose stream bake: skeleton %s has no bone %s"), *SkeletonPath, *BoneName.ToString());
+				return 1;
+			}
+			RefComponentSpace[Bone] = FAnimationRuntime::GetComponentSpaceTransformRefPose(RefSkeleton, BoneIndices[Bone]);
+		}
+		Setup.Solver.Initialize(RefComponentSpace);
+
+		// hands and feet are left to the incoming pose by the node, here they keep the reference pose
+		for (int32 Bone = 0; Bone < NumBones; ++Bone)
+		{
+			if (Bone == HandL || Bone == HandR || Bone == FootL || Bone == FootR) continue;
+			Setup.KeyedBones.Add(Bone);
+			Setup.KeyedBoneNames.Add(RefSkeleton.GetBoneName(BoneIndices[Bone]));
+		}
+		for (int32 Bone : Setup.KeyedBones)
+		{
+			FTransform Offset = FTransform::Identity;
+			int32 ParentBone = INDEX_NONE;
+			for (int32 Parent = RefSkeleton.GetParentIndex(BoneIndices[Bone]); Parent != INDEX_NONE; Parent = RefSkeleton.GetParentIndex(Parent))
+			{
+				ParentBone = Setup.KeyedBones.IndexOfByPredicate([&](int32 Keyed) { return BoneIndices[Keyed] == Parent; });
+				if (ParentBone != INDEX_NONE)
+				{
+					ParentBone = Setup.KeyedBones[ParentBone];
+					break;
+				}
+				Offset = Offset * RefSkeleton.GetRefBonePose()[Parent];
+			}
+			Setup.ParentBones.Add(ParentBone);
+			Setup.ParentOffsets.Add(Offset);
+		}
+	}
+
+	const double FindStart = FPlatformTime::Seconds();
+	if (PeopleParam.IsEmpty())
+	{
+		Setup.PersonIds = FindBakePeople(*Recording);
+	}
+	else
+	{
+		TArray<FString> Ids;
+		PeopleParam.ParseIntoArray(Ids, TEXT(","));
+		for (const FString& Id : Ids) Setup.PersonIds.AddUnique(FCString::Atoi(*Id));
+	}
+	const double FindSeconds = FPlatformTime::Seconds() - FindStart;
+	if (Setup.PersonIds.Num() == 0)
+	{
+		UE_LOG(LogPoseStreamBake, Error, TEXT("Pose stream bake: nobody in %s"), *RecordingPath);
+		return 1;
+	}
+
+	// a few ranges per thread evens out ranges with more people, but each range decodes its warm up again
+	const int32 NumThreads = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	const int32 MaxRanges = FMath::Max(FMath::FloorToInt(Recording->GetDuration() / (BakeWarmUpSeconds * 10.0)), 1);
+	NumRanges = NumRanges > 0 ? FMath::Min(NumRanges, Setup.NumKeys) : FMath::Clamp(NumThreads * 4, 1, FMath::Min(MaxRanges, Setup.NumKeys));
+
+	const int32 NumKeyed = Setup.KeyedBones.Num();
+	TArray<FBakePerson> People;
+	People.SetNum(Setup.PersonIds.Num());
+	for (FBakePerson& Person : People)
+	{
+		Person.Locals.SetNumUninitialized(Setup.NumKeys * NumKeyed);
+		Person.Solved.SetNumZeroed(Setup.NumKeys);
+	}
+
+	UE_LOG(LogPoseStreamBake, Display, TEXT("Baking %s: %.1f s, %d frames, %d people (found in %.3f s), %d keys at %.0f fps, %s filter, %d ranges on %d threads"),
+		*FPaths::GetCleanFilename(RecordingPath), Recording->GetDuration(), Recording->GetNumFrames(), Setup.PersonIds.Num(), FindSeconds,
+		Setup.NumKeys, Setup.FrameRate, *StaticEnum<EPoseStreamFilterType>()->GetNameStringByValue(FilterValue), NumRanges, NumThreads);
+
+	const double BakeStart = FPlatformTime::Seconds();
+	const int64 NumDecoded = BakeRanges(Setup, NumRanges, People);
+	const double BakeSeconds = FPlatformTime::Seconds() - BakeStart;
+
+	TArray<FBakeTracks> Tracks;
+	Tracks.SetNum(People.Num());
+	const double ReduceStart = FPlatformTime::Seconds();
+	TArray<bool> HasTracks;
+	HasTracks.SetNum(People.Num());
+	for (int32 PersonIndex = 0; PersonIndex < People.Num(); ++PersonIndex)
+	{
+		HasTracks[PersonIndex] = MakeBakeTracks(Setup, People[PersonIndex], PositionTolerance, AngleTolerance, Tracks[PersonIndex]);
+	}
+	const double ReduceSeconds = FPlatformTime::Seconds() - ReduceStart;
+
+	UE_LOG(LogPoseStreamBake, Display, TEXT("Baked %d frames in %.3f s: %.0f frames/s, %.0fx real time, %.0f person keys/s, %.1f%% of frames decoded again to warm up ranges, key reduction %.3f s"),
+		Recording->GetNumFrames(), BakeSeconds, Recording->GetNumFrames() / BakeSeconds, Recording->GetDuration() / BakeSeconds,
+		(double)Setup.NumKeys * Setup.PersonIds.Num() / BakeSeconds, 100.0 * (NumDecoded - Recording->GetNumFrames()) / Recording->GetNumFrames(), ReduceSeconds);
+
+	int32 NumFailed = 0;
+	const FString BaseName = MakeBakeAssetName(FPaths::GetBaseFilename(RecordingPath));
+	for (int32 PersonIndex = 0; PersonIndex < People.Num(); ++PersonIndex)
+	{
+		const int32 PersonId = Setup.PersonIds[PersonIndex];
+		FBakeTracks& Person = Tracks[PersonIndex];
+		if (!HasTracks[PersonIndex])
+		{
+			UE_LOG(LogPoseStreamBake, Warning, TEXT("  Person %d: never solved, the hips and shoulders weren't confident enough"), PersonId);
+			continue;
+		}
+
+		const FString PackageName = OutputPath / FString::Printf(TEXT("%s_Person%d"), *BaseName, PersonId);
+		const bool bSaved = bSave && SaveBakedSequence(Skeleton, PackageName, Setup.FrameRate, Setup.KeyedBoneNames, Person);
+		NumFailed += bSave && !bSaved;
+		const int32 NumTrackKeys = Person.NumKeys * NumKeyed;
+		const FString Saved = !bSave ? FString() : (bSaved ? TEXT(", saved ") : TEXT(", couldn't save ")) + PackageName;
+		UE_LOG(LogPoseStreamBake, Display, TEXT("  Person %d: %d keys from %.2f s, kept %.1f%% of position and %.1f%% of rotation keys, %d of %d tracks constant%s"),
+			PersonId, Person.NumKeys, Person.FirstKey / Setup.FrameRate, 100.0 * Person.KeptPositions / NumTrackKeys, 100.0 * Person.KeptRotations / NumTrackKeys,
+			Person.ConstantTracks, NumKeyed * 2, *Saved);
+	}
+
+	if (bScaling)
+	{
+		// one range per thread, so the speedup shows the cores and not the balancing
+		double SingleSeconds = 0.0;
+		for (int32 Threads = 1;; Threads = FMath::Min(Threads * 2, NumThreads))
+		{
+			const int32 Ranges = FMath::Min(Threads, Setup.NumKeys);
+			const double Start = FPlatformTime::Seconds();
+			BakeRanges(Setup, Ranges, People);
+			const double Seconds = FPlatformTime::Seconds() - Start;
+			if (Threads == 1) SingleSeconds = Seconds;
+			UE_LOG(LogPoseStreamBake, Display, TEXT("  %2d threads: %.3f s, %.0f frames/s, %.2fx, %.0f%% efficiency"),
+				Threads, Seconds, Recording->GetNumFrames() / Seconds, SingleSeconds / Seconds, 100.0 * SingleSeconds / (Seconds * Threads));
+			if (Threads == NumThreads) break;
+		}
+	}
+
+	return NumFailed > 0 ? 1 : 0;
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** The reference pose turning on the spot with the arms swinging, one person a little ahead of the other */
+	void MakeBakeTestPerson(const FTransform (&Ref)[PoseStreamRetarget::NumBones], int32 PersonId, double Time, FPoseStreamPerson& OutPerson)
+	{
+		using namespace PoseStream;
+		using namespace PoseStreamRetarget;
+
+		const FQuat Turn(FVector::UpVector, float(Time * 0.5 + PersonId));
+		const FQuat Swing(FVector::RightVector, FMath::Sin(float(Time) * 2.0f + PersonId) * 0.6f);
+		auto Joint = [&](int32 Bone, int32 Shoulder)
+		{
+			FVector Location = Ref[Bone].GetLocation();
+			if (Shoulder != INDEX_NONE) Location = Ref[Shoulder].GetLocation() + Swing.RotateVector(Location - Ref[Shoulder].GetLocation());
+			return Turn.RotateVector(Location) + FVector(PersonId * 200.0f, 0.0f, 0.0f);
+		};
+
+		OutPerson.PersonId = PersonId;
+		OutPerson.NumKeypoints = MaxKeypoints;
+		for (int32 Keypoint = 0; Keypoint < MaxKeypoints; ++Keypoint)
+		{
+			OutPerson.Positions[Keypoint] = Joint(Pelvis, INDEX_NONE);
+			OutPerson.Confidences[Keypoint] = 0.9f;
+		}
+		OutPerson.Positions[LeftHip] = Joint(ThighL, INDEX_NONE); OutPerson.Positions[RightHip] = Joint(ThighR, INDEX_NONE);
+		OutPerson.Positions[LeftKnee] = Joint(CalfL, INDEX_NONE); OutPerson.Positions[RightKnee] = Joint(CalfR, INDEX_NONE);
+		OutPerson.Positions[LeftAnkle] = Joint(FootL, INDEX_NONE); OutPerson.Positions[RightAnkle] = Joint(FootR, INDEX_NONE);
+		OutPerson.Positions[LeftShoulder] = Joint(UpperArmL, INDEX_NONE); OutPerson.Positions[RightShoulder] = Joint(UpperArmR, INDEX_NONE);
+		OutPerson.Positions[LeftElbow] = Joint(LowerArmL, UpperArmL); OutPerson.Positions[RightElbow] = Joint(LowerArmR, UpperArmR);
+		OutPerson.Positions[LeftWrist] = Joint(HandL, UpperArmL); OutPerson.Positions[RightWrist] = Joint(HandR, UpperArmR);
+		OutPerson.Positions[Nose] = Joint(Head, INDEX_NONE) + Turn.RotateVector(FVector(10.0f, 0.0f, 5.0f));
+		OutPerson.Positions[LeftEar] = Joint(Head, INDEX_NONE) + Turn.RotateVector(FVector(0.0f, -8.0f, 5.0f));
+		OutPerson.Positions[RightEar] = Joint(Head, INDEX_NONE) + Turn.RotateVector(FVector(0.0f, 8.0f, 5.0f));
+	}
+
+	/** Component space transforms of a baked key, rebuilt from the keyed local transforms */
+	void RebuildBakedKey(const FBakeSetup& Setup, const FBakePerson& Person, int32 Key, FTransform (&OutComponentSpace)[PoseStreamRetarget::NumBones])
+	{
+		const int32 NumKeyed = Setup.KeyedBones.Num();
+		for (int32 Index = 0; Index < NumKeyed; ++Index)
+		{
+			const int32 ParentBone = Setup.ParentBones[Index];
+			const FTransform Parent = ParentBone != INDEX_NONE ? Setup.ParentOffsets[Index] * OutComponentSpace[ParentBone] : Setup.ParentOffsets[Index];
+			OutComponentSpace[Setup.KeyedBones[Index]] = Person.Locals[Key * NumKeyed + Index] * Parent;
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPoseStreamBakeTest, "PoseStream.Bake.RoundTrip", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPoseStreamBakeTest::RunTest(const FString& Parameters)
+{
+	using namespace PoseStreamRetarget;
+
+	FTransform Ref[NumBones];
+	MakeTestReferencePose(Ref);
+
+	// 6 s at 60 Hz, the second person only between 1 s and 4 s
+	const FString Filename = FPaths::ProjectSavedDir() / TEXT("PoseStream") / TEXT("BakeTest.posestream");
+	const int32 NumFrames = 360;
+	{
+		FPoseStreamRecordWriter Writer;
+		if (!TestTrue(TEXT("Recording opened for writing"), Writer.Open(Filename, 0.01f))) return false;
+		TUniquePtr<FPoseStreamFrame> Frame = MakeUnique<FPoseStreamFrame>();
+		for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+		{
+			const double Time = FrameIndex / 60.0;
+			Frame->NumPeople = FrameIndex >= 60 && FrameIndex < 240 ? 2 : 1;
+			for (int32 PersonIndex = 0; PersonIndex < Frame->NumPeople; ++PersonIndex)
+			{
+				MakeBakeTestPerson(Ref, PersonIndex, Time, Frame->People[PersonIndex]);
+			}
+			Writer.Write(Time, *Frame);
+		}
+		if (!TestTrue(TEXT("Recording closed"), Writer.Close())) return false;
+	}
+	TSharedPtr<FPoseStreamRecording> Recording = FPoseStreamRecording::Open(Filename);
+	if (!TestTrue(TEXT("Recording opens"), Recording.IsValid())) return false;
+
+	// a skeleton whose hierarchy is the solver's, keyed like the commandlet keys it
+	FBakeSetup Setup;
+	Setup.Recording = Recording.Get();
+	Setup.FilterType = EPoseStreamFilterType::None;
+	Setup.FrameRate = 30.0;
+	Setup.NumKeys = FMath::FloorToInt(Recording->GetDuration() * Setup.FrameRate) + 1;
+	Setup.Solver.Initialize(Ref);
+	for (int32 Bone = 0; Bone < NumBones; ++Bone)
+	{
+		if (Bone == HandL || Bone == HandR || Bone == FootL || Bone == FootR) continue;
+		Setup.KeyedBones.Add(Bone);
+		Setup.ParentBones.Add(GetParent(Bone));
+		Setup.ParentOffsets.Add(FTransform::Identity);
+	}
+	Setup.PersonIds = FindBakePeople(*Recording);
+	TestTrue(TEXT("Both people found in the recording"), Setup.PersonIds == TArray<int32>({ 0, 1 }));
+
+	auto MakePeople = [&Setup]()
+	{
+		TArray<FBakePerson> People;
+		People.SetNum(Setup.PersonIds.Num());
+		for (FBakePerson& Person : People)
+		{
+			Person.Locals.SetNumZeroed(Setup.NumKeys * Setup.KeyedBones.Num());
+			Person.Solved.SetNumZeroed(Setup.NumKeys);
+		}
+		return People;
+	};
+
+	// every key lands on a recorded frame, the bake has to match solving that frame directly
+	TArray<FBakePerson> People = MakePeople();
+	BakeRanges(Setup, 1, People);
+	FPoseStreamRecordCursor Cursor;
+	TUniquePtr<FPoseStreamFrame> Frame = MakeUnique<FPoseStreamFrame>();
+	double FrameTime;
+	float LargestError = 0.0f;
+	int32 WrongSolved = 0;
+	for (int32 Key = 0; Key < Setup.NumKeys; ++Key)
+	{
+		if (!Cursor.ReadFrame(*Recording, Key * 2, *Frame, FrameTime)) break;
+		for (int32 PersonIndex = 0; PersonIndex < Setup.PersonIds.Num(); ++PersonIndex)
+		{
+			const FPoseStreamPerson* Person = FindBakePerson(*Frame, Setup.PersonIds[PersonIndex]);
+			WrongSolved += People[PersonIndex].Solved[Key] != (Person != nullptr);
+			if (Person == nullptr || !People[PersonIndex].Solved[Key]) continue;
+
+			FTransform Expected[NumBones];
+			FTransform Baked[NumBones];
+			Setup.Solver.Solve(Person->Positions, Person->Confidences, Setup.KeypointToComponent, Setup.MinConfidence, Expected);
+			RebuildBakedKey(Setup, People[PersonIndex], Key, Baked);
+			for (int32 Bone : Setup.KeyedBones)
+			{
+				LargestError = FMath::Max(LargestError, FVector::Dist(Baked[Bone].GetLocation(), Expected[Bone].GetLocation()));
+				LargestError = FMath::Max(LargestError, Baked[Bone].GetRotation().AngularDistance(Expected[Bone].GetRotation()) * 100.0f);
+			}
+		}
+	}
+	TestEqual(TEXT("Keys solved for people absent from their frame, or not solved for people in it"), WrongSolved, 0);
+	TestTrue(FString::Printf(TEXT("Baked keys match the solver on the recorded frames, largest error %.4f"), LargestError), LargestError < 0.05f);
+
+	// ranges decode their own warm up, without a filter they have to agree with a single range exactly
+	TArray<FBakePerson> RangedPeople = MakePeople();
+	BakeRanges(Setup, 5, RangedPeople);
+	int32 RangeMismatches = 0;
+	for (int32 PersonIndex = 0; PersonIndex < People.Num(); ++PersonIndex)
+	{
+		RangeMismatches += People[PersonIndex].Solved != RangedPeople[PersonIndex].Solved;
+		for (int32 Index = 0; Index < People[PersonIndex].Locals.Num(); ++Index)
+		{
+			RangeMismatches += !People[PersonIndex].Locals[Index].Equals(RangedPeople[PersonIndex].Locals[Index], 1e-4f);
+		}
+	}
+	TestEqual(TEXT("Keys that differ between one and five ranges"), RangeMismatches, 0);
+
+	// the vector filter path the bake runs by default, warmed up ranges stay close to one continuous pass
+	Setup.FilterType = EPoseStreamFilterType::OneEuro;
+	People = MakePeople();
+	RangedPeople = MakePeople();
+	BakeRanges(Setup, 1, People);
+	BakeRanges(Setup, 5, RangedPeople);
+	bool bFinite = true;
+	float LargestRangeError = 0.0f;
+	for (int32 PersonIndex = 0; PersonIndex < People.Num(); ++PersonIndex)
+	{
+		for (int32 Index = 0; Index < People[PersonIndex].Locals.Num(); ++Index)
+		{
+			const FTransform& Single = People[PersonIndex].Locals[Index];
+			const FTransform& Ranged = RangedPeople[PersonIndex].Locals[Index];
+			bFinite &= !Single.ContainsNaN() && !Ranged.ContainsNaN();
+			LargestRangeError = FMath::Max(LargestRangeError, FVector::Dist(Single.GetTranslation(), Ranged.GetTranslation()));
+		}
+	}
+	TestTrue(TEXT("Filtered keys are finite"), bFinite);
+	TestTrue(FString::Printf(TEXT("Filtered ranges agree with one pass, largest difference %.4f"), LargestRangeError), LargestRangeError < 0.5f);
+
+	// key reduction keeps every key within its tolerance, the second person's tracks span only their visit
+	const float PositionTolerance = 0.1f;
+	const float AngleTolerance = 0.2f;
+	for (int32 PersonIndex = 0; PersonIndex < People.Num(); ++PersonIndex)
+	{
+		FBakeTracks Tracks;
+		if (!TestTrue(TEXT("Person has tracks"), MakeBakeTracks(Setup, People[PersonIndex], PositionTolerance, AngleTolerance, Tracks))) continue;
+		TestEqual(TEXT("First key of the tracks"), Tracks.FirstKey, PersonIndex == 0 ? 0 : 30);
+		TestEqual(TEXT("Keys in the tracks"), Tracks.NumKeys, PersonIndex == 0 ? Setup.NumKeys : 90);
+		TestTrue(TEXT("Reduction drops keys"), Tracks.KeptPositions + Tracks.KeptRotations < 2 * Tracks.NumKeys * Setup.KeyedBones.Num());
+
+		float PositionError = 0.0f;
+		float AngleError = 0.0f;
+		const int32 NumKeyed = Setup.KeyedBones.Num();
+		for (int32 Index = 0; Index < NumKeyed; ++Index)
+		{
+			const FRawAnimSequenceTrack& Track = Tracks.Tracks[Index];
+			for (int32 Key = 0; Key < Tracks.NumKeys; ++Key)
+			{
+				const FTransform& Local = People[PersonIndex].Locals[(Tracks.FirstKey + Key) * NumKeyed + Index];
+				const FVector Position = Track.PosKeys[FMath::Min(Key, Track.PosKeys.Num() - 1)];
+				const FQuat Rotation = Track.RotKeys[FMath::Min(Key, Track.RotKeys.Num() - 1)];
+				PositionError = FMath::Max(PositionError, FVector::Dist(Position, Local.GetTranslation()));
+				AngleError = FMath::Max(AngleError, Rotation.AngularDistance(Local.GetRotation()));
+			}
+		}
+		TestTrue(FString::Printf(TEXT("Reduced positions within %.2f, largest error %.4f"), PositionTolerance, PositionError), PositionError <= PositionTolerance + KINDA_SMALL_NUMBER);
+		TestTrue(FString::Printf(TEXT("Reduced rotations within %.2f degrees, largest error %.4f"), AngleTolerance, FMath::RadiansToDegrees(AngleError)), FMath::RadiansToDegrees(AngleError) <= AngleTolerance + 0.01f);
+	}
+
+	Recording.Reset();
+	IFileManager::Get().Delete(*Filename);
+	return true;
+}
+
+#endif
@@ -0,0 +1,28 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AnimGraphNode_SkeletalControlBase.h"
+#include "AnimNode_PoseStreamRetarget.h"
+#include "AnimGraphNode_PoseStreamRetarget.generated.h"
+
+/** Anim graph node for FAnimNode_PoseStreamRetarget */
+UCLASS()
+class POSESTREAMEDITOR_API UAnimGraphNode_PoseStreamRetarget : public UAnimGraphNode_SkeletalControlBase
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = Settings)
+	FAnimNode_PoseStreamRetarget Node;
+
+public:
+	// UEdGraphNode interface
+	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
+	virtual FText GetTooltipText() const override;
+
+protected:
+	// UAnimGraphNode_SkeletalControlBase interface
+	virtual FText GetControllerDescription() const override;
+	virtual const FAnimNode_SkeletalControlBase* GetNode() const override { return &Node; }
+};
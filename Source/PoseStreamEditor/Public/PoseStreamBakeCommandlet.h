@@ -0,0 +1,33 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PoseStreamBakeCommandlet.generated.h"
+
+/*
+ * Bakes a recorded pose session (see PoseStream.Record) into AnimSequence assets, one per person in the recording.
+ * The keys are split into ranges that are filtered, retargeted with the PoseStreamRetarget node's solver and defaults
+ * and keyed in parallel on the task graph. Each range starts decoding a second before its first key so its filter has
+ * settled where it meets the previous range. Keys that linear interpolation of the kept ones reproduces within the
+ * tolerances are dropped before the assets are written, people missing for a while hold their last pose.
+ *
+ * UE4Editor-Cmd.exe Project.uproject -run=PoseStreamBake -Recording=Take.posestream [-People=0,1]
+ *     [-Skeleton=/Game/Mannequin/Character/Mesh/UE4_Mannequin_Skeleton] [-Output=/Game/PoseStream/Baked]
+ *     [-FrameRate=30] [-Filter=OneEuro] [-Position=0.1] [-Angle=0.2] [-Ranges=N] [-Scaling] [-NoSave]
+ *
+ * Relative recording paths are under Saved/PoseStream. Position is the key reduction tolerance in Unreal units,
+ * Angle in degrees. -Scaling bakes again with 1, 2, 4... ranges up to the number of worker threads and reports the
+ * speedup, -NoSave reports without writing assets.
+ */
+UCLASS()
+class POSESTREAMEDITOR_API UPoseStreamBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPoseStreamBakeCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};